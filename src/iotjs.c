@@ -261,6 +261,8 @@ void iotjs_terminate(iotjs_environment_t* env) {
 #endif
   // Release JerryScript engine.
   jerry_cleanup();
+  // Application modules may still run from the snapshot bundle until here.
+  iotjs_process_release_snapshot_bundle();
 }
 
 
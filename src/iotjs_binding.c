@@ -272,6 +272,29 @@ void iotjs_jval_set_method(jerry_value_t jobj, const char* name,
 }
 
 
+// Defines an accessor property whose value is returned by the handler.
+void iotjs_jval_set_getter(jerry_value_t jobj, const char* name,
+                           jerry_external_handler_t handler) {
+  IOTJS_ASSERT(jerry_value_is_object(jobj));
+
+  jerry_property_descriptor_t prop_desc;
+  jerry_init_property_descriptor_fields(&prop_desc);
+  prop_desc.is_get_defined = true;
+  prop_desc.getter = jerry_create_external_function(handler);
+  prop_desc.is_configurable_defined = true;
+  prop_desc.is_configurable = true;
+
+  jerry_value_t prop_name = jerry_create_string((const jerry_char_t*)(name));
+  jerry_value_t ret_val =
+      jerry_define_own_property(jobj, prop_name, &prop_desc);
+  jerry_release_value(prop_name);
+  jerry_free_property_descriptor_fields(&prop_desc);
+
+  IOTJS_ASSERT(!jerry_value_is_error(ret_val));
+  jerry_release_value(ret_val);
+}
+
+
 void iotjs_jval_set_property_jval(jerry_value_t jobj, const char* name,
                                   jerry_value_t value) {
   IOTJS_ASSERT(jerry_value_is_object(jobj));
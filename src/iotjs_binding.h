@@ -60,6 +60,8 @@ void iotjs_free_tmp_buffer(iotjs_tmp_buffer_t* tmp_buffer);
 /* Methods for General JavaScript Object */
 void iotjs_jval_set_method(jerry_value_t jobj, const char* name,
                            jerry_external_handler_t handler);
+void iotjs_jval_set_getter(jerry_value_t jobj, const char* name,
+                           jerry_external_handler_t handler);
 bool iotjs_jval_set_prototype(jerry_value_t jobj, jerry_value_t jproto);
 void iotjs_jval_set_property_jval(jerry_value_t jobj, const char* name,
                                   jerry_value_t value);
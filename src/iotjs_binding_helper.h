@@ -35,5 +35,6 @@ jerry_value_t iotjs_invoke_callback_with_result(jerry_value_t jfunc,
 
 int iotjs_process_exitcode(void);
 void iotjs_set_process_exitcode(int code);
+void iotjs_process_release_snapshot_bundle(void);
 
 #endif /* IOTJS_BINDING_HELPER_H */
@@ -23,19 +23,30 @@
 #define IOTJS_MAGIC_STRING_3 "3"
 #endif
 #define IOTJS_MAGIC_STRING_ABORT "abort"
+#define IOTJS_MAGIC_STRING_ADD "add"
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_ACKTYPE "type"
+#define IOTJS_MAGIC_STRING_ACQUIREID "acquireId"
 #endif
 #if ENABLE_MODULE_ADC
 #define IOTJS_MAGIC_STRING_ADC "Adc"
 #endif
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_ADDFILTER "addFilter"
+#endif
 #define IOTJS_MAGIC_STRING_ADDHEADER "addHeader"
 #if ENABLE_MODULE_UDP
 #define IOTJS_MAGIC_STRING_ADDMEMBERSHIP "addMembership"
 #endif
 #define IOTJS_MAGIC_STRING_ADDRESS "address"
+#define IOTJS_MAGIC_STRING_ANY_U "ANY"
 #define IOTJS_MAGIC_STRING_ARCH "arch"
 #define IOTJS_MAGIC_STRING_ARGV "argv"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_ASSIGNEDCLIENTIDENTIFIER "assignedClientIdentifier"
+#define IOTJS_MAGIC_STRING_AUTHENTICATIONDATA "authenticationData"
+#define IOTJS_MAGIC_STRING_AUTHENTICATIONMETHOD "authenticationMethod"
+#endif
 #define IOTJS_MAGIC_STRING_BASE64 "base64"
 #ifdef ENABLE_MODULE_CRYPTO
 #define IOTJS_MAGIC_STRING_BASE64ENCODE "base64Encode"
@@ -73,6 +84,7 @@
 #define IOTJS_MAGIC_STRING_CA "ca"
 #define IOTJS_MAGIC_STRING_CERT "cert"
 #endif
+#define IOTJS_MAGIC_STRING_CHANGE "change"
 #define IOTJS_MAGIC_STRING_CHDIR "chdir"
 #if ENABLE_MODULE_PWM
 #define IOTJS_MAGIC_STRING_CHIP "chip"
@@ -84,6 +96,10 @@
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_CLIENTID "clientId"
 #endif
+#if ENABLE_MODULE_WEBSOCKET
+#define IOTJS_MAGIC_STRING_CLIENTMAXWINDOWBITS "clientMaxWindowBits"
+#define IOTJS_MAGIC_STRING_CLIENTNOCONTEXTTAKEOVER "clientNoContextTakeover"
+#endif
 #define IOTJS_MAGIC_STRING_CLOSE "close"
 #define IOTJS_MAGIC_STRING_CLOSESYNC "closeSync"
 #define IOTJS_MAGIC_STRING_CODE "code"
@@ -92,7 +108,13 @@
 #define IOTJS_MAGIC_STRING_COMPILEMODULE "compileModule"
 #define IOTJS_MAGIC_STRING_CONFIG "config"
 #define IOTJS_MAGIC_STRING_CONNECT "connect"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_CONTENTTYPE "contentType"
+#endif
 #define IOTJS_MAGIC_STRING_COPY "copy"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_CORRELATIONDATA "correlationData"
+#endif
 #if ENABLE_MODULE_HTTPS
 #define IOTJS_MAGIC_STRING_CREATEREQUEST "createRequest"
 #endif
@@ -109,6 +131,9 @@
 #define IOTJS_MAGIC_STRING_DECODEFRAME "decodeFrame"
 #endif
 #define IOTJS_MAGIC_STRING_DEVICE "device"
+#if ENABLE_MODULE_CRYPTO
+#define IOTJS_MAGIC_STRING_DIGEST "digest"
+#endif
 #if ENABLE_MODULE_GPIO
 #define IOTJS_MAGIC_STRING_DIRECTION "direction"
 #define IOTJS_MAGIC_STRING_DIRECTION_U "DIRECTION"
@@ -134,13 +159,19 @@
 #endif
 #define IOTJS_MAGIC_STRING_ENV "env"
 #define IOTJS_MAGIC_STRING_ERRNAME "errname"
+#define IOTJS_MAGIC_STRING_EXECSNAPSHOT "execSnapshot"
 #define IOTJS_MAGIC_STRING_EXECUTE "execute"
 #define IOTJS_MAGIC_STRING_EXITCODE "exitCode"
 #define IOTJS_MAGIC_STRING_EXPORT "export"
+#if ENABLE_MODULE_WEBSOCKET
+#define IOTJS_MAGIC_STRING_EXTENSIONS "extensions"
+#endif
 #if ENABLE_MODULE_GPIO
 #define IOTJS_MAGIC_STRING_FALLING_U "FALLING"
 #endif
+#define IOTJS_MAGIC_STRING_FALLOCATE "fallocate"
 #define IOTJS_MAGIC_STRING_FAMILY "family"
+#define IOTJS_MAGIC_STRING_FDATASYNC "fdatasync"
 #define IOTJS_MAGIC_STRING_FINISH "finish"
 #if ENABLE_MODULE_HTTPS
 #define IOTJS_MAGIC_STRING_FINISHREQUEST "finishRequest"
@@ -148,7 +179,10 @@
 #if ENABLE_MODULE_GPIO
 #define IOTJS_MAGIC_STRING_FLOAT_U "FLOAT"
 #endif
+#define IOTJS_MAGIC_STRING_FSEVENT "FSEvent"
 #define IOTJS_MAGIC_STRING_FSTAT "fstat"
+#define IOTJS_MAGIC_STRING_FSYNC "fsync"
+#define IOTJS_MAGIC_STRING_FTRUNCATE "ftruncate"
 #if EXPOSE_GC
 #define IOTJS_MAGIC_STRING_GC "gc"
 #endif
@@ -158,6 +192,9 @@
 #define IOTJS_MAGIC_STRING_GPIO "Gpio"
 #endif
 #define IOTJS_MAGIC_STRING_HANDLER "handler"
+#if ENABLE_MODULE_CRYPTO
+#define IOTJS_MAGIC_STRING_HASH "Hash"
+#endif
 #define IOTJS_MAGIC_STRING_HANDLETIMEOUT "handleTimeout"
 #define IOTJS_MAGIC_STRING_HEADERS "headers"
 #define IOTJS_MAGIC_STRING_HEX "hex"
@@ -167,6 +204,7 @@
 #define IOTJS_MAGIC_STRING_HOME_U "HOME"
 #define IOTJS_MAGIC_STRING_HOST "host"
 #define IOTJS_MAGIC_STRING_HTTPPARSER "HTTPParser"
+#define IOTJS_MAGIC_STRING_HTTPROUTER "HTTPRouter"
 #define IOTJS_MAGIC_STRING_HTTP_VERSION_MAJOR "http_major"
 #define IOTJS_MAGIC_STRING_HTTP_VERSION_MINOR "http_minor"
 #if ENABLE_MODULE_GPIO
@@ -186,6 +224,7 @@
 #define IOTJS_MAGIC_STRING_ISFILE "isFile"
 #if ENABLE_MODULE_TLS
 #define IOTJS_MAGIC_STRING_ISSERVER "isServer"
+#define IOTJS_MAGIC_STRING_ISSESSIONREUSED "isSessionReused"
 #endif
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_KEEPALIVE "keepalive"
@@ -193,19 +232,30 @@
 #define IOTJS_MAGIC_STRING_KEY "key"
 #define IOTJS_MAGIC_STRING_LENGTH "length"
 #define IOTJS_MAGIC_STRING_LISTEN "listen"
+#define IOTJS_MAGIC_STRING_LOADSNAPSHOT "loadSnapshot"
 #define IOTJS_MAGIC_STRING_LOOPBACK "loopback"
 #if ENABLE_MODULE_SPI
 #define IOTJS_MAGIC_STRING_LSB "LSB"
+#endif
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_MAXIMUMPACKETSIZE "maximumPacketSize"
+#define IOTJS_MAGIC_STRING_MAXIMUMQOS "maximumQoS"
+#endif
+#if ENABLE_MODULE_SPI
 #define IOTJS_MAGIC_STRING_MAXSPEED "maxSpeed"
 #endif
 #if ENABLE_MODULE_MQTT || ENABLE_MODULE_WEBSOCKET
 #define IOTJS_MAGIC_STRING_MESSAGE "message"
 #endif
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_MESSAGEEXPIRYINTERVAL "messageExpiryInterval"
+#endif
 #define IOTJS_MAGIC_STRING_METHOD "method"
 #define IOTJS_MAGIC_STRING_METHODS "methods"
 #define IOTJS_MAGIC_STRING_MKDIR "mkdir"
-#define IOTJS_MAGIC_STRING_MODE "mode"
+#define IOTJS_MAGIC_STRING_MMAP "mmap"
 #if ENABLE_MODULE_SPI || ENABLE_MODULE_GPIO
+#define IOTJS_MAGIC_STRING_MODE "mode"
 #define IOTJS_MAGIC_STRING_MODE_U "MODE"
 #endif
 #if ENABLE_MODULE_MQTT
@@ -223,6 +273,7 @@
 #define IOTJS_MAGIC_STRING_ONACK "onack"
 #endif
 #define IOTJS_MAGIC_STRING_ONBODY "OnBody"
+#define IOTJS_MAGIC_STRING_ONCHANGE "onchange"
 #define IOTJS_MAGIC_STRING_ONCLOSE "onclose"
 #define IOTJS_MAGIC_STRING_ONCLOSED "onClosed"
 #define IOTJS_MAGIC_STRING_ONCONNECTION "onconnection"
@@ -263,11 +314,13 @@
 #define IOTJS_MAGIC_STRING_OUT_U "OUT"
 #endif
 #define IOTJS_MAGIC_STRING_OWNER "owner"
+#define IOTJS_MAGIC_STRING_PARAMS "params"
 #if ENABLE_MODULE_WEBSOCKET
 #define IOTJS_MAGIC_STRING_PARSEHANDSHAKEDATA "parseHandshakeData"
 #endif
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_PASSWORD "password"
+#define IOTJS_MAGIC_STRING_PAYLOADFORMATINDICATOR "payloadFormatIndicator"
 #endif
 #define IOTJS_MAGIC_STRING_PAUSE "pause"
 #define IOTJS_MAGIC_STRING_PERIOD "period"
@@ -285,6 +338,10 @@
 #define IOTJS_MAGIC_STRING_PREPAREHANDSHAKE "prepareHandshake"
 #endif
 #define IOTJS_MAGIC_STRING_PRIVATE "_private"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_PROPERTIES "properties"
+#define IOTJS_MAGIC_STRING_PROTOCOLVERSION "protocolVersion"
+#endif
 #define IOTJS_MAGIC_STRING_PROTOTYPE "prototype"
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_PUBLISH "publish"
@@ -298,34 +355,57 @@
 #define IOTJS_MAGIC_STRING_QOS "qos"
 #endif
 #define IOTJS_MAGIC_STRING_READDIR "readdir"
+#define IOTJS_MAGIC_STRING_READFILE "readFile"
 #define IOTJS_MAGIC_STRING_READ "read"
 #define IOTJS_MAGIC_STRING_READSOURCE "readSource"
 #define IOTJS_MAGIC_STRING_READSTART "readStart"
 #define IOTJS_MAGIC_STRING_READSYNC "readSync"
 #define IOTJS_MAGIC_STRING_READUINT8 "readUInt8"
+#define IOTJS_MAGIC_STRING_READV "readv"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_REASONCODE "reasonCode"
+#define IOTJS_MAGIC_STRING_REASONSTRING "reasonString"
+#define IOTJS_MAGIC_STRING_RECEIVEMAXIMUM "receiveMaximum"
+#endif
 #if ENABLE_MODULE_DGRAM
 #define IOTJS_MAGIC_STRING_RECVSTART "recvStart"
 #define IOTJS_MAGIC_STRING_RECVSTOP "recvStop"
 #endif
 #define IOTJS_MAGIC_STRING_REF "ref"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_REFRESHID "refreshId"
+#endif
 #if ENABLE_MODULE_TLS || ENABLE_MODULE_HTTPS
 #define IOTJS_MAGIC_STRING_REJECTUNAUTHORIZED "rejectUnauthorized"
 #endif
 #if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_RELEASEID "releaseId"
 #define IOTJS_MAGIC_STRING_REMAINING "remaining"
+#define IOTJS_MAGIC_STRING_REMOVEFILTER "removeFilter"
 #endif
 #define IOTJS_MAGIC_STRING_RENAME "rename"
 #define IOTJS_MAGIC_STRING_REQUEST_U "REQUEST"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_REQUESTPROBLEMINFORMATION "requestProblemInformation"
+#define IOTJS_MAGIC_STRING_REQUESTRESPONSEINFORMATION \
+  "requestResponseInformation"
+#endif
 #define IOTJS_MAGIC_STRING_RESPONSE_U "RESPONSE"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_RESPONSEINFORMATION "responseInformation"
+#define IOTJS_MAGIC_STRING_RESPONSETOPIC "responseTopic"
+#endif
 #define IOTJS_MAGIC_STRING_RESUME "resume"
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_RETAIN "retain"
+#define IOTJS_MAGIC_STRING_RETAINAVAILABLE "retainAvailable"
 #endif
 #define IOTJS_MAGIC_STRING__REUSEADDR "_reuseAddr"
 #if ENABLE_MODULE_GPIO
 #define IOTJS_MAGIC_STRING_RISING_U "RISING"
 #endif
 #define IOTJS_MAGIC_STRING_RMDIR "rmdir"
+#define IOTJS_MAGIC_STRING_ROUTE "route"
 #if ENABLE_MODULE_CRYPTO
 #define IOTJS_MAGIC_STRING_RSAVERIFY "rsaVerify"
 #endif
@@ -333,10 +413,27 @@
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_SENDACK "sendAck"
 #endif
+#define IOTJS_MAGIC_STRING_SENDFILE "sendFile"
 #define IOTJS_MAGIC_STRING_SENDREQUEST "sendRequest"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_SERVERKEEPALIVE "serverKeepAlive"
+#endif
+#if ENABLE_MODULE_WEBSOCKET
+#define IOTJS_MAGIC_STRING_SERVERMAXWINDOWBITS "serverMaxWindowBits"
+#endif
 #if ENABLE_MODULE_TLS
 #define IOTJS_MAGIC_STRING_SERVERNAME "servername"
 #endif
+#if ENABLE_MODULE_WEBSOCKET
+#define IOTJS_MAGIC_STRING_SERVERNOCONTEXTTAKEOVER "serverNoContextTakeover"
+#endif
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_SERVERREFERENCE "serverReference"
+#define IOTJS_MAGIC_STRING_SESSIONEXPIRYINTERVAL "sessionExpiryInterval"
+#endif
+#if ENABLE_MODULE_TLS
+#define IOTJS_MAGIC_STRING_SESSIONTIMEOUT "sessionTimeout"
+#endif
 #if ENABLE_MODULE_I2C
 #define IOTJS_MAGIC_STRING_SETADDRESS "setAddress"
 #endif
@@ -362,9 +459,11 @@
 #define IOTJS_MAGIC_STRING_SETPERIOD "setPeriod"
 #define IOTJS_MAGIC_STRING_SETPERIODSYNC "setPeriodSync"
 #endif
+#define IOTJS_MAGIC_STRING_SETROUTER "setRouter"
 #define IOTJS_MAGIC_STRING_SETTIMEOUT "setTimeout"
-#ifdef ENABLE_MODULE_CRYPTO
-#define IOTJS_MAGIC_STRING_SHAENCODE "shaEncode"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_SHAREDSUBSCRIPTIONAVAILABLE \
+  "sharedSubscriptionAvailable"
 #endif
 #define IOTJS_MAGIC_STRING_SHOULDKEEPALIVE "shouldkeepalive"
 #define IOTJS_MAGIC_STRING_SHUTDOWN "shutdown"
@@ -372,6 +471,11 @@
 #if ENABLE_MODULE_SPI
 #define IOTJS_MAGIC_STRING_SPI "Spi"
 #endif
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_SPOOLAPPEND "spoolAppend"
+#define IOTJS_MAGIC_STRING_SPOOLOPEN "spoolOpen"
+#define IOTJS_MAGIC_STRING_SPOOLREPLAY "spoolReplay"
+#endif
 #define IOTJS_MAGIC_STRING_START "start"
 #define IOTJS_MAGIC_STRING_STAT "stat"
 #define IOTJS_MAGIC_STRING_STATS "stats"
@@ -382,14 +486,21 @@
 #define IOTJS_MAGIC_STRING_STOP "stop"
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_SUBSCRIBE "subscribe"
+#define IOTJS_MAGIC_STRING_SUBSCRIPTIONIDENTIFIER "subscriptionIdentifier"
+#define IOTJS_MAGIC_STRING_SUBSCRIPTIONIDENTIFIERSAVAILABLE \
+  "subscriptionIdentifiersAvailable"
+#define IOTJS_MAGIC_STRING_TICK "tick"
 #endif
 #if ENABLE_MODULE_TLS
 #define IOTJS_MAGIC_STRING_TLSSOCKET "TLSSocket"
 #define IOTJS_MAGIC_STRING_TLSCONTEXT "TlsContext"
 #define IOTJS_MAGIC_STRING_TLSINIT "TlsInit"
 #endif
+#define IOTJS_MAGIC_STRING_TOJSON "toJSON"
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_TOPIC "topic"
+#define IOTJS_MAGIC_STRING_TOPICALIAS "topicAlias"
+#define IOTJS_MAGIC_STRING_TOPICALIASMAXIMUM "topicAliasMaximum"
 #endif
 #define IOTJS_MAGIC_STRING_TOSTRING "toString"
 #if ENABLE_MODULE_SPI
@@ -401,19 +512,33 @@
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_UNSUBSCRIBE "unsubscribe"
 #endif
+#if ENABLE_MODULE_CRYPTO
+#define IOTJS_MAGIC_STRING_UPDATE "update"
+#endif
 #define IOTJS_MAGIC_STRING_UPGRADE "upgrade"
 #if ENABLE_MODULE_MQTT
 #define IOTJS_MAGIC_STRING_USERNAME "username"
 #endif
 #define IOTJS_MAGIC_STRING_URL "url"
+#if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_USERPROPERTIES "userProperties"
+#endif
 #define IOTJS_MAGIC_STRING_VERSION "version"
+#define IOTJS_MAGIC_STRING_WALK "walk"
 #if ENABLE_MODULE_MQTT
+#define IOTJS_MAGIC_STRING_WILDCARDSUBSCRIPTIONAVAILABLE \
+  "wildcardSubscriptionAvailable"
 #define IOTJS_MAGIC_STRING_WILL "will"
+#define IOTJS_MAGIC_STRING_WILLDELAYINTERVAL "willDelayInterval"
+#define IOTJS_MAGIC_STRING_WILLPROPERTIES "willProperties"
 #endif
 #define IOTJS_MAGIC_STRING_WRITEUINT8 "writeUInt8"
 #define IOTJS_MAGIC_STRING_WRITE "write"
 #define IOTJS_MAGIC_STRING_WRITEDECODE "writeDecode"
+#define IOTJS_MAGIC_STRING_WRITEFILE "writeFile"
 #define IOTJS_MAGIC_STRING_WRITESYNC "writeSync"
+#define IOTJS_MAGIC_STRING_WRITESHARED "writeShared"
+#define IOTJS_MAGIC_STRING_WRITEV "writev"
 #if ENABLE_MODULE_HTTPS
 #define IOTJS_MAGIC_STRING__WRITE "_write"
 #endif
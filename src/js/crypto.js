@@ -13,12 +13,18 @@
  * limitations under the License.
  */
 
-var shaTypes = {
+var util = require('util');
+
+var hashTypes = {
+  'md5': 3,
   'sha1': 4,
   'sha256': 6,
+  'sha512': 8,
 };
 
-var hashes = ['sha1', 'sha256'];
+var hashes = ['md5', 'sha1', 'sha256', 'sha512'];
+
+var signatures = ['sha1', 'sha256'];
 
 function Verify(signtype) {
   if (!(this instanceof Verify)) {
@@ -27,7 +33,7 @@ function Verify(signtype) {
 
   signtype = signtype.toLowerCase();
 
-  if (hashes.indexOf(signtype) < 0) {
+  if (signatures.indexOf(signtype) < 0) {
     throw new Error('Unknown signing algorithm.' +
                     'Please use crypto.getSignatures()');
   }
@@ -37,40 +43,31 @@ function Verify(signtype) {
     value: signtype,
     enumerable: true,
   });
+
+  // The signed data is hashed as it arrives instead of being collected
+  this._hash = new Hash(signtype);
+  this._empty = true;
 }
 
 Verify.prototype.update = function(data) {
-  if (this.data) {
-    if (Buffer.isBuffer(data)) {
-      this.data = Buffer.concat([this.data, data]);
-      return;
-    }
-
-    this.data = Buffer.concat([this.data, new Buffer(data)]);
-    return;
-  }
-
-  if (Buffer.isBuffer(data)) {
-    this.data = data;
-    return;
-  }
-
-  this.data = new Buffer(data);
+  this._hash.update(data);
+  this._empty = false;
+  return this;
 };
 
 Verify.prototype.verify = function(publicKey, signature) {
-  if (this.data) {
-    var type = shaTypes[this.hashtype];
-    var hash = native.shaEncode(this.data, type);
-    return native.rsaVerify(type, hash, publicKey, signature);
+  if (this._empty) {
+    throw new Error('verify shouldn\'t be called on an empty Verify');
   }
 
-  throw new Error('verify shouldn\'t be called on an empty Verify');
+  var type = hashTypes[this.hashtype];
+  var hash = this._hash.digest();
+  return native.rsaVerify(type, hash, publicKey, signature);
 };
 
-function Hash(hashtype) {
+function Hash(hashtype, key) {
   if (!(this instanceof Hash)) {
-    return new Hash(hashtype);
+    return new Hash(hashtype, key);
   }
 
   if (hashes.indexOf(hashtype) < 0) {
@@ -81,19 +78,21 @@ function Hash(hashtype) {
     writable: false,
     enumerable: true,
   });
+
+  this._handle = new native.Hash(hashTypes[hashtype], key);
 }
 
 Hash.prototype.update = function(data) {
-  if (this.data) {
-    if (Buffer.isBuffer(data)) {
-      this.data = Buffer.concat(this.data, data);
-      return;
-    }
-
-    this.data = Buffer.concat([this.data, new Buffer(data)]);
-    return;
+  if (!util.isString(data) && !util.isBuffer(data)) {
+    throw new TypeError('Data must be a string or a buffer');
+  }
+
+  if (this._finished) {
+    throw new Error('Update can not be called after digest');
   }
-  this.data = new Buffer(data);
+
+  this._handle.update(data);
+  return this;
 };
 
 Hash.prototype.digest = function(encoding) {
@@ -101,9 +100,7 @@ Hash.prototype.digest = function(encoding) {
     throw new Error('Digest can not be called twice on the same Hash object');
   }
 
-  var result;
-  var type = shaTypes[this.hashtype];
-  result = native.shaEncode(this.data, type);
+  var result = this._handle.digest();
 
   if (encoding == 'base64') {
     result = native.base64Encode(result);
@@ -120,6 +117,20 @@ Hash.prototype.digest = function(encoding) {
   return result;
 };
 
+function Hmac(hashtype, key) {
+  if (!(this instanceof Hmac)) {
+    return new Hmac(hashtype, key);
+  }
+
+  if (!util.isString(key) && !util.isBuffer(key)) {
+    throw new TypeError('Key must be a string or a buffer');
+  }
+
+  Hash.call(this, hashtype, key);
+}
+
+util.inherits(Hmac, Hash);
+
 function getHashes() {
   return hashes;
 }
@@ -128,10 +139,15 @@ function createHash(hashtype) {
   return new Hash(hashtype);
 }
 
+function createHmac(hashtype, key) {
+  return new Hmac(hashtype, key);
+}
+
 function createVerify(signtype) {
   return new Verify(signtype);
 }
 
 exports.createHash = createHash;
+exports.createHmac = createHmac;
 exports.getHashes = getHashes;
 exports.createVerify = createVerify;
@@ -16,6 +16,7 @@
 
 var fs = exports;
 var constants = require('constants');
+var EventEmitter = require('events').EventEmitter;
 var util = require('util');
 var fsBuiltin = native;
 
@@ -170,150 +171,165 @@ fs.writeSync = function(fd, buffer, offset, length, position) {
 };
 
 
-fs.readFile = function(path, callback) {
-  checkArgString(path);
-  checkArgFunction(callback);
+fs.readv = function(fd, buffers, position, callback) {
+  if (util.isFunction(position)) {
+    callback = position;
+    position = -1;
+  } else if (util.isNullOrUndefined(position)) {
+    position = -1; // Read from the current position.
+  }
 
-  var fd;
-  var buffers;
+  callback = checkArgFunction(callback, 'callback');
 
-  fs.open(path, 'r', function(err, _fd) {
-    if (err) {
-      return callback(err);
-    }
+  var cb = function(err, bytesRead) {
+    callback(err, bytesRead || 0, buffers);
+  };
 
-    fd = _fd;
-    buffers = [];
+  fsBuiltin.readv(checkArgNumber(fd, 'fd'),
+                  checkArgArray(buffers, 'buffers'),
+                  checkArgNumber(position, 'position'),
+                  cb);
+};
 
-    // start read
-    read();
-  });
 
-  var read = function() {
-    // Read segment of data.
-    var buffer = new Buffer(1023);
-    fs.read(fd, buffer, 0, 1023, -1, afterRead);
-  };
+fs.readvSync = function(fd, buffers, position) {
+  if (util.isNullOrUndefined(position)) {
+    position = -1; // Read from the current position.
+  }
 
-  var afterRead = function(err, bytesRead, buffer) {
-    if (err) {
-      fs.close(fd, function(err) {
-        return callback(err);
-      });
-    }
+  return fsBuiltin.readv(checkArgNumber(fd, 'fd'),
+                         checkArgArray(buffers, 'buffers'),
+                         checkArgNumber(position, 'position'));
+};
 
-    if (bytesRead === 0) {
-      // End of file.
-      close();
-    } else {
-      // continue reading.
-      buffers.push(buffer.slice(0, bytesRead));
-      read();
-    }
-  };
 
-  var close = function() {
-    fs.close(fd, function(err) {
-      return callback(err, Buffer.concat(buffers));
-    });
+fs.writev = function(fd, buffers, position, callback) {
+  if (util.isFunction(position)) {
+    callback = position;
+    position = -1; // write at current position.
+  } else if (util.isNullOrUndefined(position)) {
+    position = -1; // write at current position.
+  }
+
+  callback = checkArgFunction(callback, 'callback');
+
+  // The closure keeps the buffers alive until the write is finished.
+  var cb = function(err, written) {
+    callback(err, written || 0, buffers);
   };
+
+  fsBuiltin.writev(checkArgNumber(fd, 'fd'),
+                   checkArgArray(buffers, 'buffers'),
+                   checkArgNumber(position, 'position'),
+                   cb);
 };
 
 
-fs.readFileSync = function(path) {
-  checkArgString(path);
+fs.writevSync = function(fd, buffers, position) {
+  if (util.isNullOrUndefined(position)) {
+    position = -1; // write at current position.
+  }
 
-  var fd = fs.openSync(path, 'r', 438);
-  var buffers = [];
+  return fsBuiltin.writev(checkArgNumber(fd, 'fd'),
+                          checkArgArray(buffers, 'buffers'),
+                          checkArgNumber(position, 'position'));
+};
 
-  while (true) {
-    try {
-      var buffer = new Buffer(1023);
-      var bytesRead = fs.readSync(fd, buffer, 0, 1023);
-      if (bytesRead) {
-        buffers.push(buffer.slice(0, bytesRead));
-      } else {
-        break;
-      }
-    } catch (e) {
-      break;
-    }
+
+fs.ftruncate = function(fd, len, callback) {
+  if (util.isFunction(len)) {
+    callback = len;
+    len = 0;
   }
-  fs.closeSync(fd);
 
-  return Buffer.concat(buffers);
+  fsBuiltin.ftruncate(checkArgNumber(fd, 'fd'),
+                      checkArgNumber(len || 0, 'len'),
+                      checkArgFunction(callback, 'callback'));
 };
 
 
-fs.writeFile = function(path, data, callback) {
-  checkArgString(path);
-  checkArgFunction(callback);
+fs.ftruncateSync = function(fd, len) {
+  fsBuiltin.ftruncate(checkArgNumber(fd, 'fd'),
+                      checkArgNumber(len || 0, 'len'));
+};
 
-  var fd;
-  var len;
-  var bytesWritten;
-  var buffer = ensureBuffer(data);
 
-  fs.open(path, 'w', function(err, _fd) {
-    if (err) {
-      return callback(err);
-    }
+fs.fsync = function(fd, callback) {
+  fsBuiltin.fsync(checkArgNumber(fd, 'fd'),
+                  checkArgFunction(callback, 'callback'));
+};
 
-    fd = _fd;
-    len = buffer.length;
-    bytesWritten = 0;
 
-    write();
-  });
+fs.fsyncSync = function(fd) {
+  fsBuiltin.fsync(checkArgNumber(fd, 'fd'));
+};
 
-  var write = function() {
-    var tryN = (len - bytesWritten) >= 1024 ? 1023 : (len - bytesWritten);
-    fs.write(fd, buffer, bytesWritten, tryN, bytesWritten, afterWrite);
-  };
 
-  var afterWrite = function(err, n) {
-    if (err) {
-      fs.close(fd, function(err) {
-        return callback(err);
-      });
-    }
+fs.fdatasync = function(fd, callback) {
+  fsBuiltin.fdatasync(checkArgNumber(fd, 'fd'),
+                      checkArgFunction(callback, 'callback'));
+};
 
-    if (n <= 0 || bytesWritten + n == len) {
-      // End of buffer
-      fs.close(fd, function(err) {
-        callback(err);
-      });
-    } else {
-      // continue writing
-      bytesWritten += n;
-      write();
-    }
-  };
+
+fs.fdatasyncSync = function(fd) {
+  fsBuiltin.fdatasync(checkArgNumber(fd, 'fd'));
 };
 
 
-fs.writeFileSync = function(path, data) {
-  checkArgString(path);
+fs.fallocate = function(fd, offset, len, callback) {
+  fsBuiltin.fallocate(checkArgNumber(fd, 'fd'),
+                      checkArgNumber(offset, 'offset'),
+                      checkArgNumber(len, 'len'),
+                      checkArgFunction(callback, 'callback'));
+};
 
-  var buffer = ensureBuffer(data);
-  var fd = fs.openSync(path, 'w');
-  var len = buffer.length;
-  var bytesWritten = 0;
-
-  while (true) {
-    try {
-      var tryN = (len - bytesWritten) >= 1024 ? 1023 : (len - bytesWritten);
-      var n = fs.writeSync(fd, buffer, bytesWritten, tryN, bytesWritten);
-      bytesWritten += n;
-      if (bytesWritten == len) {
-        break;
-      }
-    } catch (e) {
-      break;
-    }
+
+fs.fallocateSync = function(fd, offset, len) {
+  fsBuiltin.fallocate(checkArgNumber(fd, 'fd'),
+                      checkArgNumber(offset, 'offset'),
+                      checkArgNumber(len, 'len'));
+};
+
+
+fs.readFile = function(path, callback) {
+  // The file is opened, read at once into a buffer of its size and closed
+  // by a single native job.
+  fsBuiltin.readFile(checkArgString(path, 'path'),
+                     checkArgFunction(callback, 'callback'));
+};
+
+
+fs.readFileSync = function(path) {
+  return fsBuiltin.readFile(checkArgString(path, 'path'));
+};
+
+
+fs.mmapSync = function(path) {
+  checkArgString(path, 'path');
+
+  // Platforms without mmap get a copy of the file.
+  if (!fsBuiltin.mmap) {
+    return fsBuiltin.readFile(path);
   }
-  fs.closeSync(fd);
-  return bytesWritten;
+
+  return fsBuiltin.mmap(path);
+};
+
+
+fs.writeFile = function(path, data, callback) {
+  fsBuiltin.writeFile(checkArgString(path, 'path'),
+                      ensureBuffer(data),
+                      convertFlags('w'),
+                      438,
+                      checkArgFunction(callback, 'callback'));
+};
+
+
+fs.writeFileSync = function(path, data) {
+  return fsBuiltin.writeFile(checkArgString(path, 'path'),
+                             ensureBuffer(data),
+                             convertFlags('w'),
+                             438);
 };
 
 
@@ -370,15 +386,431 @@ fs.renameSync = function(oldPath, newPath) {
 };
 
 
-fs.readdir = function(path, callback) {
+// Types of directory entries, as reported by libuv (0 is unknown).
+var UV_DIRENT_FILE = 1;
+var UV_DIRENT_DIR = 2;
+var UV_DIRENT_LINK = 3;
+var UV_DIRENT_FIFO = 4;
+var UV_DIRENT_SOCKET = 5;
+var UV_DIRENT_CHAR = 6;
+var UV_DIRENT_BLOCK = 7;
+
+
+function Dirent(name, path, type) {
+  this.name = name;
+  this.path = path;
+  this._type = type;
+}
+
+
+Dirent.prototype.isFile = function() {
+  return this._type === UV_DIRENT_FILE;
+};
+
+
+Dirent.prototype.isDirectory = function() {
+  return this._type === UV_DIRENT_DIR;
+};
+
+
+Dirent.prototype.isSymbolicLink = function() {
+  return this._type === UV_DIRENT_LINK;
+};
+
+
+Dirent.prototype.isFIFO = function() {
+  return this._type === UV_DIRENT_FIFO;
+};
+
+
+Dirent.prototype.isSocket = function() {
+  return this._type === UV_DIRENT_SOCKET;
+};
+
+
+Dirent.prototype.isCharacterDevice = function() {
+  return this._type === UV_DIRENT_CHAR;
+};
+
+
+Dirent.prototype.isBlockDevice = function() {
+  return this._type === UV_DIRENT_BLOCK;
+};
+
+
+fs.Dirent = Dirent;
+
+
+// The native walker returns a flat array of (path, type[, size, mtimeMs])
+// where the path is relative to the root.
+function makeDirents(root, entries, withStats) {
+  var stride = withStats ? 4 : 2;
+  var dirents = new Array(entries.length / stride);
+
+  for (var i = 0, j = 0; i < entries.length; i += stride, j++) {
+    var path = entries[i];
+    var sep = path.lastIndexOf('/');
+    var dirent;
+    if (sep < 0) {
+      dirent = new Dirent(path, root, entries[i + 1]);
+    } else {
+      dirent = new Dirent(path.slice(sep + 1),
+                          root + '/' + path.slice(0, sep),
+                          entries[i + 1]);
+    }
+
+    if (withStats) {
+      dirent.size = entries[i + 2];
+      dirent.mtimeMs = entries[i + 3];
+    }
+    dirents[j] = dirent;
+  }
+
+  return dirents;
+}
+
+
+function makeNames(entries) {
+  var names = new Array(entries.length / 2);
+  for (var i = 0; i < names.length; i++) {
+    names[i] = entries[i * 2];
+  }
+  return names;
+}
+
+
+function walkArgs(path, options) {
+  options = options || {};
+
+  var maxDepth = options.maxDepth;
+  if (util.isNullOrUndefined(maxDepth)) {
+    maxDepth = Infinity;
+  }
+
+  return [
+    checkArgString(path, 'path'),
+    util.isNullOrUndefined(options.pattern) ?
+        '' : checkArgString(options.pattern, 'pattern'),
+    checkArgNumber(maxDepth, 'maxDepth'),
+    !!options.stats,
+  ];
+}
+
+
+fs.readdir = function(path, options, callback) {
+  if (util.isFunction(options)) {
+    callback = options;
+    options = {};
+  }
+  options = options || {};
   checkArgString(path);
   checkArgFunction(callback);
-  fsBuiltin.readdir(path, callback);
+
+  if (!options.withFileTypes && !options.recursive) {
+    fsBuiltin.readdir(path, callback);
+    return;
+  }
+
+  fsBuiltin.walk(path, '', options.recursive ? Infinity : 0, false,
+                 function(err, entries) {
+    if (err) {
+      callback(err);
+    } else if (options.withFileTypes) {
+      callback(null, makeDirents(path, entries, false));
+    } else {
+      callback(null, makeNames(entries));
+    }
+  });
 };
 
 
-fs.readdirSync = function(path) {
-  return fsBuiltin.readdir(checkArgString(path, 'path'));
+fs.readdirSync = function(path, options) {
+  options = options || {};
+  checkArgString(path, 'path');
+
+  if (!options.withFileTypes && !options.recursive) {
+    return fsBuiltin.readdir(path);
+  }
+
+  var entries = fsBuiltin.walk(path, '', options.recursive ? Infinity : 0,
+                               false);
+  if (options.withFileTypes) {
+    return makeDirents(path, entries, false);
+  }
+  return makeNames(entries);
+};
+
+
+fs.walk = function(path, options, callback) {
+  if (util.isFunction(options)) {
+    callback = options;
+    options = {};
+  }
+  checkArgFunction(callback, 'callback');
+
+  var args = walkArgs(path, options);
+
+  args.push(function(err, entries) {
+    if (err) {
+      callback(err);
+    } else {
+      callback(null, makeDirents(args[0], entries, args[3]));
+    }
+  });
+  fsBuiltin.walk.apply(fsBuiltin, args);
+};
+
+
+fs.walkSync = function(path, options) {
+  var args = walkArgs(path, options);
+  return makeDirents(args[0], fsBuiltin.walk.apply(fsBuiltin, args), args[3]);
+};
+
+
+// Events of the same file arriving within the debounce window are
+// coalesced into one 'change' event, a 'rename' wins over a 'change'.
+function FSWatcher(options) {
+  if (!(this instanceof FSWatcher)) {
+    return new FSWatcher(options);
+  }
+
+  EventEmitter.call(this);
+
+  options = options || {};
+  this._debounce = checkArgNumber(options.debounce || 0, 'debounce');
+  this._pending = null;
+  this._pendingOrder = null;
+  this._timer = null;
+
+  var self = this;
+  this._handle = new fsBuiltin.FSEvent();
+  this._handle.onchange = function(err, eventType, filename) {
+    if (err) {
+      self.close();
+      self.emit('error', err);
+    } else {
+      self._onchange(eventType, filename);
+    }
+  };
+}
+
+
+util.inherits(FSWatcher, EventEmitter);
+
+
+FSWatcher.prototype._start = function(filename, recursive) {
+  try {
+    this._handle.start(filename, recursive);
+  } catch (e) {
+    this._handle.close();
+    this._handle = null;
+    throw e;
+  }
+};
+
+
+FSWatcher.prototype._onchange = function(eventType, filename) {
+  if (this._debounce <= 0) {
+    this.emit('change', eventType, filename);
+    return;
+  }
+
+  if (!this._pending) {
+    this._pending = Object.create(null);
+    this._pendingOrder = [];
+    this._timer = setTimeout(this._flush.bind(this), this._debounce);
+  }
+
+  var key = util.isNull(filename) ? '' : filename;
+  var event = this._pending[key];
+  if (event) {
+    if (eventType === 'rename') {
+      event.eventType = eventType;
+    }
+  } else {
+    event = { eventType: eventType, filename: filename };
+    this._pending[key] = event;
+    this._pendingOrder.push(event);
+  }
+};
+
+
+FSWatcher.prototype._flush = function() {
+  var events = this._pendingOrder;
+
+  this._pending = null;
+  this._pendingOrder = null;
+  this._timer = null;
+
+  for (var i = 0; i < events.length && this._handle; i++) {
+    this.emit('change', events[i].eventType, events[i].filename);
+  }
+};
+
+
+FSWatcher.prototype.close = function() {
+  if (!this._handle) {
+    return;
+  }
+
+  if (this._timer) {
+    clearTimeout(this._timer);
+    this._pending = null;
+    this._pendingOrder = null;
+    this._timer = null;
+  }
+
+  this._handle.onchange = undefined;
+  this._handle.close();
+  this._handle = null;
+
+  var self = this;
+  process.nextTick(function() {
+    self.emit('close');
+  });
+};
+
+
+FSWatcher.prototype.ref = function() {
+  if (this._handle) {
+    this._handle.ref();
+  }
+  return this;
+};
+
+
+FSWatcher.prototype.unref = function() {
+  if (this._handle) {
+    this._handle.unref();
+  }
+  return this;
+};
+
+
+fs.FSWatcher = FSWatcher;
+
+
+fs.watch = function(filename, options, listener) {
+  if (util.isFunction(options)) {
+    listener = options;
+    options = {};
+  }
+  options = options || {};
+
+  var watcher = new FSWatcher(options);
+  watcher._start(checkArgString(filename, 'filename'), !!options.recursive);
+
+  if (listener) {
+    watcher.on('change', checkArgFunction(listener, 'listener'));
+  }
+  if (options.persistent === false) {
+    watcher.unref();
+  }
+  return watcher;
+};
+
+
+// Watchers of fs.watchFile by file name.
+var statWatchers = Object.create(null);
+
+
+/* Watches the directory of the file, so the file is still watched after
+ * it is replaced by a rename (e.g. an atomic save of a config file). */
+function StatWatcher(filename, options) {
+  EventEmitter.call(this);
+
+  var sep = filename.lastIndexOf('/');
+  var dir = sep < 0 ? '.' : filename.slice(0, sep) || '/';
+  var name = filename.slice(sep + 1);
+
+  var self = this;
+  this._filename = filename;
+  this._prev = null;
+  this._watcher = fs.watch(dir, options, function(eventType, changed) {
+    if (util.isNull(changed) || changed === name) {
+      self._check();
+    }
+  });
+  this._watcher.on('error', function(err) {
+    self._watcher = null;
+    self.emit('error', err);
+  });
+
+  fsBuiltin.stat(filename, function(err, stats) {
+    self._prev = err ? null : stats;
+  });
+}
+
+
+util.inherits(StatWatcher, EventEmitter);
+
+
+function isSameStats(a, b) {
+  if (!a || !b) {
+    return a === b;
+  }
+  return a.ino === b.ino && a.size === b.size && a.mtimeMs === b.mtimeMs &&
+         a.ctimeMs === b.ctimeMs;
+}
+
+
+StatWatcher.prototype._check = function() {
+  var self = this;
+  fsBuiltin.stat(this._filename, function(err, stats) {
+    var curr = err ? null : stats;
+    var prev = self._prev;
+
+    if (self._watcher && !isSameStats(curr, prev)) {
+      self._prev = curr;
+      self.emit('change', curr, prev);
+    }
+  });
+};
+
+
+StatWatcher.prototype.close = function() {
+  if (this._watcher) {
+    this._watcher.close();
+    this._watcher = null;
+  }
+};
+
+
+fs.watchFile = function(filename, options, listener) {
+  if (util.isFunction(options)) {
+    listener = options;
+    options = {};
+  }
+  checkArgString(filename, 'filename');
+  checkArgFunction(listener, 'listener');
+
+  var watcher = statWatchers[filename];
+  if (!watcher) {
+    watcher = new StatWatcher(filename, options || {});
+    statWatchers[filename] = watcher;
+  }
+
+  watcher.on('change', listener);
+  return watcher;
+};
+
+
+fs.unwatchFile = function(filename, listener) {
+  var watcher = statWatchers[checkArgString(filename, 'filename')];
+  if (!watcher) {
+    return;
+  }
+
+  if (util.isFunction(listener)) {
+    watcher.removeListener('change', listener);
+  } else {
+    watcher.removeAllListeners('change');
+  }
+
+  if (!watcher._events.change) {
+    watcher.close();
+    delete statWatchers[filename];
+  }
 };
 
 
@@ -515,7 +947,7 @@ try {
         }
         throw err;
       }
-      this.bytesWritten += bytes_written;
+      self.bytesWritten += bytes_written;
 
       if (callback) {
         callback();
@@ -525,6 +957,80 @@ try {
   };
 
 
+  // Limits of a single native writev, see IOTJS_FS_MAX_IOV and
+  // IOTJS_FS_MAX_IO_SIZE in iotjs_module_fs.c.
+  var writevMaxBuffers = 1024;
+  var writevMaxBytes = 0x7ffff000;
+
+
+  // Chunks queued while a write is in progress are written by writev, in
+  // batches that fit the native limits. A short write keeps the unwritten
+  // rest queued for the next batch, a write of no bytes is an error.
+  WriteStream.prototype._writev = function(reqs, onwrite) {
+    var self = this;
+    var chunks = [];
+    for (var i = 0; i < reqs.length; i++) {
+      if (reqs[i].chunk.length > 0) {
+        chunks.push(reqs[i].chunk);
+      }
+    }
+
+    var writeNext = function() {
+      if (chunks.length == 0) {
+        for (var i = 0; i < reqs.length; i++) {
+          if (reqs[i].callback) {
+            reqs[i].callback();
+          }
+        }
+        onwrite();
+        return;
+      }
+
+      var batch = [];
+      var bytes = 0;
+      while (batch.length < chunks.length &&
+             batch.length < writevMaxBuffers) {
+        var chunk = chunks[batch.length];
+        if (bytes + chunk.length > writevMaxBytes) {
+          if (batch.length == 0) {
+            batch.push(chunk.slice(0, writevMaxBytes));
+          }
+          break;
+        }
+        batch.push(chunk);
+        bytes += chunk.length;
+      }
+
+      fs.writev(self._fd, batch, null, function(err, bytes_written) {
+        if (!err && bytes_written == 0) {
+          err = new Error('writev wrote no bytes');
+        }
+
+        if (err) {
+          if (self._autoClose) {
+            closeFile(self);
+          }
+          throw err;
+        }
+        self.bytesWritten += bytes_written;
+
+        while (bytes_written > 0) {
+          if (bytes_written >= chunks[0].length) {
+            bytes_written -= chunks[0].length;
+            chunks.shift();
+          } else {
+            chunks[0] = chunks[0].slice(bytes_written);
+            bytes_written = 0;
+          }
+        }
+        writeNext();
+      });
+    };
+
+    writeNext();
+  };
+
+
   fs.createWriteStream = function(path, options) {
     return new WriteStream(path, options);
   };
@@ -613,6 +1119,11 @@ function checkArgType(value, name, checkFunc) {
 }
 
 
+function checkArgArray(value, name) {
+  return checkArgType(value, name, util.isArray);
+}
+
+
 function checkArgBuffer(value, name) {
   return checkArgType(value, name, util.isBuffer);
 }
@@ -50,6 +50,8 @@ Server.prototype.setTimeout = function(ms, cb) {
   }
 };
 
+Server.prototype.route = HTTPServer.route;
+
 exports.Server = Server;
 
 exports.createServer = function(options, requestListener) {
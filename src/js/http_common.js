@@ -76,7 +76,8 @@ function parserOnHeadersComplete(info) {
   }
 
   // For client side, if response to 'HEAD' request, we will skip parsing body
-  var skipBody = this.onIncoming(this.incoming, info.shouldkeepalive);
+  var skipBody = this.onIncoming(this.incoming, info.shouldkeepalive,
+                                 info.route, info.params);
 
   return skipBody;
 }
@@ -13,11 +13,13 @@
  * limitations under the License.
  */
 
+var fs = require('fs');
 var util = require('util');
 var IncomingMessage = require('http_incoming').IncomingMessage;
 var OutgoingMessage = require('http_outgoing').OutgoingMessage;
 var common = require('http_common');
 var HTTPParser = require('http_parser').HTTPParser;
+var HTTPRouter = require('http_parser').HTTPRouter;
 
 // RFC 7231 (http://tools.ietf.org/html/rfc7231#page-49)
 var STATUS_CODES = exports.STATUS_CODES = {
@@ -145,6 +147,137 @@ ServerResponse.prototype.detachSocket = function() {
 };
 
 
+// Sends the headers followed by the content of `file` (a path or an open
+// file descriptor) and ends the response. Plain connections move the file
+// with sendfile, secure ones read it in chunks.
+ServerResponse.prototype.sendFile = function(file, options, callback) {
+  if (util.isFunction(options)) {
+    callback = options;
+    options = undefined;
+  }
+  if (!util.isString(file) && !util.isNumber(file)) {
+    throw new TypeError('Bad arguments: file must be a path or a number');
+  }
+  options = options || {};
+
+  var start = util.isNullOrUndefined(options.start) ? 0 : options.start;
+  var end = util.isNullOrUndefined(options.end) ? Infinity : options.end;
+  if (!util.isNumber(start) || start < 0) {
+    throw new RangeError('start must be a non-negative number');
+  }
+  if (!util.isNumber(end) || end < start) {
+    throw new RangeError('end must be a number not less than start');
+  }
+
+  var self = this;
+  var ownFd = util.isString(file);
+  var fd = ownFd ? -1 : file;
+
+  var done = function(err) {
+    if (ownFd && fd >= 0) {
+      fs.close(fd, function() {});
+    }
+    // A partially sent body can not be recovered on this connection.
+    if (err && self._sentHeader && self.socket) {
+      self.socket.destroy();
+    }
+    if (util.isFunction(callback)) {
+      callback(err || null);
+    }
+  };
+
+  var send = function(err, stats) {
+    if (err) {
+      return done(err);
+    }
+    if (!self.socket) {
+      return done(new Error('socket is closed'));
+    }
+
+    var length = Math.max(Math.min(end + 1, stats.size) - start, 0);
+
+    if (!self._header) {
+      if (util.isNullOrUndefined(self.getHeader('content-length'))) {
+        self.setHeader('Content-Length', length);
+      }
+      self._implicitHeader();
+    }
+
+    if (!self._hasBody || length === 0) {
+      return self.end(function() {
+        done(null);
+      });
+    }
+
+    // Flush the headers, the body is queued right behind them.
+    self._send('');
+    sendFileBody(self.socket, fd, start, length, function(err) {
+      if (err) {
+        return done(err);
+      }
+      self.end(function() {
+        done(null);
+      });
+    });
+  };
+
+  if (!ownFd) {
+    fs.fstat(fd, send);
+  } else {
+    fs.open(file, 'r', function(err, openedFd) {
+      if (err) {
+        return done(err);
+      }
+      fd = openedFd;
+      fs.fstat(fd, send);
+    });
+  }
+};
+
+
+var SEND_FILE_CHUNK_SIZE = 16 * 1024;
+
+function sendFileBody(socket, fd, position, length, callback) {
+  if (util.isFunction(socket.sendFile)) {
+    socket.sendFile(fd, position, length, function(err, bytesSent) {
+      if (!err && bytesSent < length) {
+        err = new Error('file is shorter than the response body');
+      }
+      callback(err);
+    });
+    return;
+  }
+
+  // The socket transforms the data (e.g. TLS), copy it through buffers.
+  var readNext = function() {
+    if (length === 0) {
+      return callback(null);
+    }
+
+    var buffer = new Buffer(Math.min(length, SEND_FILE_CHUNK_SIZE));
+    fs.read(fd, buffer, 0, buffer.length, position, function(err, bytesRead) {
+      if (!err && bytesRead === 0) {
+        err = new Error('file is shorter than the response body');
+      }
+      if (err) {
+        return callback(err);
+      }
+
+      position += bytesRead;
+      length -= bytesRead;
+      socket.write(buffer.slice(0, bytesRead), function(status) {
+        if (status) {
+          return callback(new Error('write failed - status: ' + status));
+        }
+        readNext();
+      });
+    });
+  };
+
+  readNext();
+}
+
+
 function initServer(options, requestListener) {
   if (util.isFunction(options)) {
     requestListener = options;
@@ -162,6 +295,11 @@ function initServer(options, requestListener) {
   this._ServerResponse = options.ServerResponse || ServerResponse;
   this.httpAllowHalfOpen = false;
 
+  // Created up front so connections accepted before the first route() call
+  // still share the table routes are added to later.
+  this._router = new HTTPRouter();
+  this._routes = [];
+
   this.on('clientError', function(err, conn) {
     conn.destroy(err);
   });
@@ -171,6 +309,37 @@ function initServer(options, requestListener) {
 
 exports.initServer = initServer;
 
+
+// Registers `handler` for requests whose method and path match.
+// The path is matched natively, segments like ':name' are passed to the
+// handler as `params.name` and a trailing '*' matches the rest of the path.
+function route(method, path, handler) {
+  if (!util.isString(method)) {
+    throw new TypeError('Bad arguments: method must be a string');
+  }
+  if (!util.isString(path)) {
+    throw new TypeError('Bad arguments: path must be a string');
+  }
+  if (!util.isFunction(handler)) {
+    throw new TypeError('Bad arguments: handler must be a function');
+  }
+
+  var methodId = HTTPRouter.ANY;
+  if (method !== '*') {
+    methodId = HTTPParser.methods.indexOf(method.toUpperCase());
+    if (methodId < 0) {
+      throw new TypeError('Unknown HTTP method: ' + method);
+    }
+  }
+
+  this._router.add(methodId, path, this._routes.length);
+  this._routes.push(handler);
+
+  return this;
+}
+
+exports.route = route;
+
 function connectionListener(socket) {
   var server = this;
 
@@ -187,6 +356,9 @@ function connectionListener(socket) {
   parser.incoming = null;
   socket.parser = parser;
 
+  parser._router = server._router;
+  parser.setRouter(server._router);
+
   socket.on('data', socketOnData);
   socket.on('end', socketOnEnd);
   socket.on('close', socketOnClose);
@@ -266,8 +438,9 @@ function socketOnError(err) {
 
 
 // This is called by parserOnHeadersComplete after req header is parsed.
+// `route` is the index of the handler matched by the native router.
 // TODO: keepalive support
-function parserOnIncoming(req/* , shouldKeepAlive */) {
+function parserOnIncoming(req, shouldKeepAlive, route, params) {
   var socket = req.socket;
   var server = socket._server;
 
@@ -275,7 +448,19 @@ function parserOnIncoming(req/* , shouldKeepAlive */) {
   res.assignSocket(socket);
   res.on('prefinish', resOnFinish);
 
-  server.emit('request', req, res);
+  if (util.isNumber(route)) {
+    params = decodeParams(params);
+    if (!params) {
+      // A malformed percent escape in a captured segment.
+      res.writeHead(400);
+      res.end();
+      return false;
+    }
+    req.params = params;
+    server._routes[route].call(server, req, res, params);
+  } else {
+    server.emit('request', req, res);
+  }
 
   // In server, HTTPParser determines whether body should be parsed or not.
   // It is fine to return false
@@ -283,6 +468,21 @@ function parserOnIncoming(req/* , shouldKeepAlive */) {
 }
 
 
+// Returns the captured path segments percent-decoded,
+// or null if one of them has a malformed escape.
+function decodeParams(params) {
+  var keys = Object.keys(params);
+  for (var i = 0; i < keys.length; i++) {
+    try {
+      params[keys[i]] = decodeURIComponent(params[keys[i]]);
+    } catch (e) {
+      return null;
+    }
+  }
+  return params;
+}
+
+
 // This cb is called when response ended
 // (res.end emits 'prefinish' event)
 function resOnFinish() {
@@ -19,8 +19,33 @@ var ClientRequest = require('http_client').ClientRequest;
 var HTTPServer = require('http_server');
 var util = require('util');
 
+var defaultContext = null;
+var unverifiedContext = null;
+
+// Requests without their own credentials share a secure context, so the
+// default CA certificates are parsed once and TLS sessions are resumed.
+// Requests which skip the certificate check get a context of their own.
+function getSecureContext(options) {
+  if (options.secureContext || options.ca || options.cert || options.key) {
+    return options.secureContext;
+  }
+
+  if (options.rejectUnauthorized === false) {
+    if (!unverifiedContext) {
+      unverifiedContext = tls.createSecureContext({});
+    }
+    return unverifiedContext;
+  }
+
+  if (!defaultContext) {
+    defaultContext = tls.createSecureContext({});
+  }
+  return defaultContext;
+}
+
 exports.request = function(options, cb) {
   options.port = options.port || 443;
+  options.secureContext = getSecureContext(options);
   // Create socket.
   var socket = new tls.TLSSocket(new net.Socket(), options);
 
@@ -45,6 +70,8 @@ Server.prototype.setTimeout = function(ms, cb) {
   }
 };
 
+Server.prototype.route = HTTPServer.route;
+
 exports.createServer = function(options, requestListener) {
   return new Server(options, requestListener);
 };
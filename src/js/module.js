@@ -141,6 +141,113 @@ if (process.env.IOTJS_EXTRA_MODULE_PATH) {
   });
 }
 
+// Resolved paths of ids, or false for ids that were not found, keyed by the
+// directory of the requiring module and the id. Relative lookups depend on
+// the working directory, so the entries are dropped when it changes.
+var resolveCache = Object.create(null);
+var resolveCwd = null;
+
+// What an absolute candidate path (search directory + id) resolves to, or
+// false. Shared by all requiring modules, which mostly probe the same
+// search directories. A package's package.json is parsed once this way.
+var candidateCache = Object.create(null);
+
+// Optional resolution manifest. If the file exists its entries seed the
+// resolution cache, otherwise the resolutions of this run are written to it
+// on exit so later starts can skip the lookups.
+var manifestPath = process.env.IOTJS_MODULE_MANIFEST;
+
+if (manifestPath) {
+  if (fs.existsSync(manifestPath)) {
+    loadManifest(manifestPath);
+  } else {
+    process.on('exit', function() {
+      writeManifest(manifestPath);
+    });
+  }
+}
+
+function loadManifest(file) {
+  var manifest;
+  try {
+    manifest = JSON.parse(Builtin.readSource(file));
+    if (manifest.cwd !== path.cwd()) {
+      return;
+    }
+  } catch (e) {
+    // An unreadable manifest only loses the speed up.
+    return;
+  }
+
+  resolveCwd = manifest.cwd;
+  var resolved = manifest.resolved || {};
+  for (var dir in resolved) {
+    for (var id in resolved[dir]) {
+      resolveCache[dir + '\n' + id] = resolved[dir][id];
+    }
+  }
+}
+
+function writeManifest(file) {
+  var resolved = {};
+  for (var key in resolveCache) {
+    if (resolveCache[key]) {
+      var sep = key.indexOf('\n');
+      var dir = key.substring(0, sep);
+      resolved[dir] = resolved[dir] || {};
+      resolved[dir][key.substring(sep + 1)] = resolveCache[key];
+    }
+  }
+
+  try {
+    fs.writeFileSync(file, JSON.stringify({
+      cwd: resolveCwd,
+      resolved: resolved,
+    }));
+  } catch (e) {
+    // The manifest is only an optimization, do not fail the exit.
+  }
+}
+
+// Module indexes of the snapshot bundle (see `tools/js2c.py --app`) keyed
+// by absolute path. Paths in the bundle are relative to its directory.
+var snapshotModules = null;
+var snapshotPath = process.env.IOTJS_SNAPSHOT_BUNDLE;
+
+if (snapshotPath && Builtin.loadSnapshot) {
+  loadSnapshotBundle(snapshotPath);
+}
+
+function loadSnapshotBundle(file) {
+  var index;
+  try {
+    index = JSON.parse(Builtin.loadSnapshot(file));
+  } catch (e) {
+    // Fall back to the sources.
+    return;
+  }
+
+  if (!path.isDeviceRoot(file)) {
+    file = path.cwd() + '/' + file;
+  }
+  file = path.normalizePath(file);
+
+  var root = file.substring(0, file.lastIndexOf('/') + 1);
+  snapshotModules = Object.create(null);
+  for (var i = 0; i < index.modules.length; i++) {
+    snapshotModules[root + index.modules[i]] = i;
+  }
+}
+
+function snapshotIndex(filepath) {
+  if (!snapshotModules) {
+    return -1;
+  }
+
+  var idx = snapshotModules[path.normalizePath(filepath)];
+  return idx === undefined ? -1 : idx;
+}
+
 function tryPath(modulePath, ext) {
   return Module.tryPath(modulePath) ||
          Module.tryPath(modulePath + ext);
@@ -172,41 +279,55 @@ Module.resolveFilepath = function(id, directories) {
       modulePath = path.normalizePath(modulePath);
     }
 
-    var filepath,
-        ext = '.js';
+    var filepath = candidateCache[modulePath];
+    if (filepath === undefined) {
+      filepath = candidateCache[modulePath] = resolveCandidate(modulePath);
+    }
 
-    // id[.ext]
-    if ((filepath = tryPath(modulePath, ext))) {
+    if (filepath) {
       return filepath;
     }
+  }
 
-    // 3. package path id/
-    var jsonpath = modulePath + '/package.json';
+  return false;
+};
 
-    if (Module.tryPath(jsonpath)) {
-      var pkgSrc = Builtin.readSource(jsonpath);
-      var pkgMainFile = JSON.parse(pkgSrc).main;
 
-      // pkgmain[.ext]
-      if (pkgMainFile &&
-          (filepath = tryPath(modulePath + '/' + pkgMainFile, ext))) {
-        return filepath;
-      }
-    }
+function resolveCandidate(modulePath) {
+  var filepath,
+      ext = '.js';
 
-    // index[.ext] as default
-    if ((filepath = tryPath(modulePath + '/index', ext))) {
-      return filepath;
-    }
+  // id[.ext]
+  if ((filepath = tryPath(modulePath, ext))) {
+    return filepath;
+  }
+
+  // 3. package path id/
+  var jsonpath = modulePath + '/package.json';
 
-    // id[.node]
-    if (dynamicloader && (filepath = tryPath(modulePath, '.node'))) {
+  if (Module.tryPath(jsonpath)) {
+    var pkgSrc = Builtin.readSource(jsonpath);
+    var pkgMainFile = JSON.parse(pkgSrc).main;
+
+    // pkgmain[.ext]
+    if (pkgMainFile &&
+        (filepath = tryPath(modulePath + '/' + pkgMainFile, ext))) {
       return filepath;
     }
   }
 
+  // index[.ext] as default
+  if ((filepath = tryPath(modulePath + '/index', ext))) {
+    return filepath;
+  }
+
+  // id[.node]
+  if (dynamicloader && (filepath = tryPath(modulePath, '.node'))) {
+    return filepath;
+  }
+
   return false;
-};
+}
 
 
 Module.resolveModPath = function(id, parent) {
@@ -214,20 +335,47 @@ Module.resolveModPath = function(id, parent) {
     return false;
   }
 
+  var cwd = path.cwd();
+  if (cwd !== resolveCwd) {
+    resolveCache = Object.create(null);
+    resolveCwd = cwd;
+  }
+
+  var parentDir = (parent && parent.dirs && parent.dirs[0]) || '';
+  var key = parentDir + '\n' + id;
+  var cached = resolveCache[key];
+  if (cached !== undefined) {
+    return cached;
+  }
+
   // 0. resolve Directory for lookup
   var directories = Module.resolveDirectories(id, parent);
 
   var filepath = Module.resolveFilepath(id, directories);
 
   if (filepath) {
-    return path.normalizePath(filepath);
+    filepath = path.normalizePath(filepath);
   }
 
-  return false;
+  resolveCache[key] = filepath;
+  return filepath;
+};
+
+
+// Forgets every cached resolution, e.g. after modules were installed or
+// removed at runtime.
+Module.clearResolveCache = function() {
+  resolveCache = Object.create(null);
+  candidateCache = Object.create(null);
 };
 
 
 Module.tryPath = function(path) {
+  // Bundled modules do not need their sources on the device.
+  if (snapshotIndex(path) >= 0) {
+    return path;
+  }
+
   try {
     var stats = fs.statSync(path);
     if (stats && !stats.isDirectory()) {
@@ -269,8 +417,13 @@ Module.load = function(id, parent) {
   var source;
 
   if (ext === 'js') {
-    source = Builtin.readSource(modPath);
-    module.compile(modPath, source);
+    var snapshotIdx = snapshotIndex(modPath);
+    if (snapshotIdx >= 0) {
+      module.compileSnapshot(snapshotIdx);
+    } else {
+      source = Builtin.readSource(modPath);
+      module.compile(modPath, source);
+    }
   } else if (ext === 'json') {
     source = Builtin.readSource(modPath);
     module.exports = JSON.parse(source);
@@ -305,6 +458,13 @@ Module.prototype.compile = function(filename, source) {
 };
 
 
+// Runs a module precompiled into the snapshot bundle instead of parsing it.
+Module.prototype.compileSnapshot = function(index) {
+    var fn = Builtin.execSnapshot(index);
+    fn.call(this.exports, this.exports, this.require.bind(this), this);
+};
+
+
 Module.runMain = function() {
   if (Builtin.debuggerWaitSource) {
     var sources = Builtin.debuggerGetSource();
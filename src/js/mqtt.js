@@ -18,26 +18,52 @@ var EventEmitter = require('events').EventEmitter;
 var net, tls;
 
 var PacketTypeEnum = {
+  PUBLISH: 3,
   PUBACK: 4,
   PUBREC: 5,
   PUBREL: 6,
   PUBCOMP: 7,
 };
 
-// In seconds (should be divisible by 8)
-var MQTTTimeout = 64;
+// Maximum size of a batch of spooled packets written to the socket.
+var SpoolBatchSize = 16384;
 
-function MQTTHandle(client, keepalive) {
+var PacketTooLargeMessage = 'MQTT message exceeds the maximum packet size';
+
+function MQTTHandle(client, keepalive, options) {
   this.client = client;
   this.isConnected = false;
-  this.nextPacketId = 0;
   this.keepalive = keepalive;
   this.keepaliveCounter = 0;
   this.pingrespCounter = 0;
+  // Unacknowledged packets by packet id, the ids and the retransmit times
+  // are managed by the native in-flight window.
   this.storage = { };
   this.storageCount = 0;
+  // Packets waiting for a free slot in the in-flight window.
+  this.pending = [];
+  this.needDrain = false;
+  this.topicHandlers = { };
+  this.nextHandlerId = 0;
+  this.protocolVersion = (options.protocolVersion == 5) ? 5 : 4;
+
+  var properties = options.properties || {};
+
+  native.MqttInit(this, options.receiveMaximum, this.protocolVersion,
+                  properties.topicAliasMaximum, properties.maximumPacketSize);
+
+  // Limits of the broker, received in the MQTT 5 CONNACK packet.
+  this.topicAliases = null;
+  this.topicAliasCount = 0;
+  this.topicAliasMaximum = 0;
+  this.maximumPacketSize = 0;
+
+  this.spooled = false;
 
-  native.MqttInit(this);
+  if (options.spool) {
+    native.spoolOpen(this, options.spool, options.spoolSize);
+    this.spooled = true;
+  }
 }
 MQTTHandle.prototype = {};
 
@@ -50,11 +76,22 @@ MQTTHandle.prototype.sendAck = function(type, packet_id) {
   this.write(native.sendAck(type, packet_id));
 };
 
-MQTTHandle.prototype.onconnection = function() {
+// The properties are only present in MQTT 5.
+MQTTHandle.prototype.onconnection = function(properties) {
   this.isConnected = true;
   this.timer = setInterval(storageTimerHit.bind(this), 1000);
 
-  this.client.emit('connect');
+  // Topic aliases are valid for a single connection.
+  this.topicAliases = Object.create(null);
+  this.topicAliasCount = 0;
+
+  if (properties) {
+    this.topicAliasMaximum = properties.topicAliasMaximum || 0;
+    this.maximumPacketSize = properties.maximumPacketSize || 0;
+  }
+
+  this.replaySpool();
+  this.client.emit('connect', properties);
 };
 
 MQTTHandle.prototype.onEnd = function() {
@@ -62,13 +99,37 @@ MQTTHandle.prototype.onEnd = function() {
 
   // Abort outgoing messages.
   clearInterval(this.timer);
-  this.storage = null;
-  this.storageCount = 0;
+  this.abortPackets();
 
   this.client.emit('end');
 };
 
-MQTTHandle.prototype.onmessage = function(message, topic, qos, packet_id) {
+MQTTHandle.prototype.addTopicHandler = function(filter, handler) {
+  var id = this.nextHandlerId;
+
+  // Throws for invalid filters, before anything is sent to the broker.
+  var previous = native.addFilter(this, filter, id);
+
+  this.nextHandlerId = (id + 1) & 0x7fffffff;
+  this.topicHandlers[id] = handler;
+
+  if (previous >= 0) {
+    delete this.topicHandlers[previous];
+  }
+};
+
+MQTTHandle.prototype.removeTopicHandler = function(filter) {
+  var id = native.removeFilter(this, filter);
+
+  if (id >= 0) {
+    delete this.topicHandlers[id];
+  }
+};
+
+// The handlers argument holds the ids of the subscription handlers whose
+// topic filter matches the topic, it is undefined if there are none.
+MQTTHandle.prototype.onmessage = function(message, topic, qos, packet_id,
+                                          handlers, properties) {
   var data = {
     message: message,
     topic: topic,
@@ -76,36 +137,231 @@ MQTTHandle.prototype.onmessage = function(message, topic, qos, packet_id) {
     packet_id: packet_id,
   };
 
+  if (properties) {
+    data.properties = properties;
+  }
+
   if (qos >= 1) {
     var type = (qos == 1) ? PacketTypeEnum.PUBACK : PacketTypeEnum.PUBREC;
 
     this.sendAck(type, packet_id);
   }
 
+  if (handlers) {
+    for (var i = 0; i < handlers.length; i++) {
+      var handler = this.topicHandlers[handlers[i]];
+
+      if (handler) {
+        handler.call(this.client, data);
+      }
+    }
+  }
+
   this.client.emit('message', data);
 };
 
-MQTTHandle.prototype.getPacketId = function() {
-  while (true) {
-    var packet_id = this.nextPacketId;
-    this.nextPacketId = (this.nextPacketId + 1) & 0xffff;
+// Sends a packet which needs a packet id. The create function builds the
+// packet for the id. Returns with false if the in-flight window is full, the
+// packet is sent when an earlier one is acknowledged.
+MQTTHandle.prototype.sendPacket = function(create, callback) {
+  var packet_id = 0;
+
+  if (this.pending.length == 0) {
+    packet_id = native.acquireId(this);
+  }
+
+  if (packet_id == 0) {
+    this.pending.push({ create: create, callback: callback });
+    this.needDrain = true;
+    return false;
+  }
+
+  if (!this.sendWithId(packet_id, create, callback)) {
+    throw new Error(PacketTooLargeMessage);
+  }
 
-    if (!(packet_id in this.storage)) {
-      this.storage[packet_id] = { remainingTime: MQTTTimeout };
+  return true;
+};
+
+// Returns with false if the packet is too large to be sent.
+MQTTHandle.prototype.sendWithId = function(packet_id, create, callback) {
+  var buffer = create(packet_id);
+
+  if (!buffer) {
+    native.releaseId(this, packet_id);
+    return false;
+  }
+
+  // The packet is created again without topic alias if it is spooled.
+  this.storage[packet_id] = {
+    packet: buffer,
+    callback: callback,
+    create: create,
+  };
+  this.storageCount++;
+  this.write(buffer);
+  return true;
+};
+
+// Encodes a PUBLISH packet. In MQTT 5 the topic is replaced by a topic alias
+// after its first use on a connection. Returns with null if the packet is
+// larger than the broker accepts.
+MQTTHandle.prototype.encodePublish = function(topic, message, header,
+                                              properties) {
+  if (this.protocolVersion < 5) {
+    return native.publish(topic, message, header);
+  }
+
+  var alias = 0;
+  var key = null;
+
+  if (this.isConnected && this.topicAliasMaximum > 0) {
+    alias = this.topicAliases[topic.toString()];
+
+    if (alias) {
+      topic = '';
+    } else if (this.topicAliasCount < this.topicAliasMaximum) {
+      key = topic.toString();
+      alias = this.topicAliasCount + 1;
+    } else {
+      alias = 0;
+    }
+  }
+
+  var packet = native.publish(topic, message, header, alias, properties);
+
+  if (this.maximumPacketSize > 0 && packet.length > this.maximumPacketSize) {
+    return null;
+  }
+
+  // The alias is only assigned once the broker receives its topic.
+  if (key !== null) {
+    this.topicAliases[key] = alias;
+    this.topicAliasCount = alias;
+  }
+
+  return packet;
+};
+
+// Sends the queued packets as long as the in-flight window allows it. The
+// spooled packets are older, so they are sent first.
+MQTTHandle.prototype.flush = function() {
+  this.replaySpool();
+
+  while (this.pending.length > 0) {
+    var packet_id = native.acquireId(this);
+
+    if (packet_id == 0) {
+      return;
+    }
+
+    var next = this.pending.shift();
+
+    if (!this.sendWithId(packet_id, next.create, next.callback)) {
+      this.finishPacket(next.callback, new Error(PacketTooLargeMessage));
+    }
+  }
+
+  if (this.needDrain) {
+    this.needDrain = false;
+    this.client.emit('drain');
+  }
+};
+
+// Writes the packets published while offline in batches, copied straight
+// from the spool file without encoding them again.
+MQTTHandle.prototype.replaySpool = function() {
+  var batch;
+
+  while (this.spooled && this.isConnected &&
+         (batch = native.spoolReplay(this, SpoolBatchSize))) {
+    var buffer = batch[0];
+
+    // The QoS 1 and 2 packets are kept for retransmission.
+    for (var i = 1; i < batch.length; i += 3) {
+      this.storage[batch[i]] = {
+        packet: buffer.slice(batch[i + 1], batch[i + 2]),
+      };
       this.storageCount++;
+    }
+
+    this.write(buffer);
+  }
+};
+
+MQTTHandle.prototype.spoolPacket = function(buffer) {
+  return native.spoolAppend(this, buffer);
+};
 
-      return packet_id;
+// Finishes the unacknowledged and the queued packets when the connection is
+// lost, their packet ids are returned to the in-flight window. PUBLISH
+// packets are moved into the spool if there is one and their callbacks are
+// called as for messages published offline, the others fail with an error.
+MQTTHandle.prototype.abortPackets = function() {
+  var storage = this.storage || {};
+  var pending = this.pending;
+  var error = new Error('MQTT connection closed');
+
+  this.storage = {};
+  this.storageCount = 0;
+  this.pending = [];
+
+  var ids = Object.keys(storage).map(Number).sort(function(a, b) {
+    return a - b;
+  });
+
+  for (var i = 0; i < ids.length; i++) {
+    native.releaseId(this, ids[i]);
+    this.abortPacket(storage[ids[i]], error);
+  }
+
+  for (i = 0; i < pending.length; i++) {
+    this.abortPacket(pending[i], error);
+  }
+};
+
+MQTTHandle.prototype.abortPacket = function(entry, error) {
+  if (this.spooled) {
+    var packet = entry.packet;
+
+    // Topic aliases are not valid on the next connection. QoS 2 packets
+    // which were already received by the broker are stored as PUBREL.
+    if (entry.create && (!packet || isPublish(packet))) {
+      packet = entry.create(0);
+    }
+
+    if (packet && isPublish(packet) && this.spoolPacket(packet)) {
+      error = undefined;
     }
   }
+
+  if (typeof entry.callback == 'function') {
+    this.finishPacket(entry.callback, error);
+  }
 };
 
+function isPublish(packet) {
+  return (packet.readUInt8(0) >> 4) == PacketTypeEnum.PUBLISH;
+}
+
 MQTTHandle.prototype.releasePacket = function(packet_id, error) {
-  // callback will be invalid after delete
-  var callback = this.storage[packet_id].callback;
+  var packet = this.storage && this.storage[packet_id];
+
+  // Acknowledgements of unknown packets are ignored.
+  if (!packet || !native.releaseId(this, packet_id)) {
+    return;
+  }
 
   delete this.storage[packet_id];
   this.storageCount--;
 
+  this.finishPacket(packet.callback, error);
+  this.flush();
+};
+
+// Calls the callback of a finished packet. The error is emitted if there is
+// no callback.
+MQTTHandle.prototype.finishPacket = function(callback, error) {
   // This function should never fail.
   try {
     if (typeof callback == 'function') {
@@ -135,10 +391,13 @@ MQTTHandle.prototype.onpubrec = function(packet_id) {
   var buffer = native.sendAck(PacketTypeEnum.PUBREL, packet_id);
   this.write(buffer);
 
-  // Upodate packet rather than create a new one
+  // Update packet rather than create a new one
   var packet = this.storage[packet_id];
-  packet.remainingTime = MQTTTimeout;
-  packet.packet = buffer;
+
+  if (packet) {
+    native.refreshId(this, packet_id);
+    packet.packet = buffer;
+  }
 };
 
 MQTTHandle.prototype.onpubrel = function(data) {
@@ -228,7 +487,7 @@ function MQTTClient(url, options, callback) {
 
   // Since network transmission takes time, the
   // actual keepalive message is sent a bit earlier
-  this._handle = new MQTTHandle(this, keepalive - 5);
+  this._handle = new MQTTHandle(this, keepalive - 5, options);
 
   var connectionMessage = native.connect(options);
 
@@ -270,7 +529,7 @@ MQTTClient.prototype.end = function(force) {
 
   handle.isConnected = false;
 
-  if (force || handle.storageCount == 0) {
+  if (force || (handle.storageCount == 0 && handle.pending.length == 0)) {
     handle.socket.end(native.disconnect());
 
     // Abort ongoing messages.
@@ -287,15 +546,16 @@ MQTTClient.prototype.checkConnection = function() {
 };
 
 MQTTClient.prototype.publish = function(topic, message, options, callback) {
-  this.checkConnection();
-
   var handle = this._handle;
 
   // header bits: | 16 bit packet id | 4 bit PUBLISH header |
   var header = 0;
   var qos = 0;
+  var properties;
 
   if (options) {
+    properties = options.properties;
+
     if (options.retain) {
       header = 0x1;
     }
@@ -309,28 +569,47 @@ MQTTClient.prototype.publish = function(topic, message, options, callback) {
     header |= (qos << 1);
   }
 
-  if (qos > 0) {
-    var packet_id = handle.getPacketId();
-    header |= (packet_id << 4);
+  if (!handle.isConnected && handle.spooled) {
+    var spooled = handle.encodePublish(topic, message, header, properties);
 
-    var buffer = native.publish(topic, message, header);
-    handle.write(buffer);
+    if (!spooled) {
+      throw new Error(PacketTooLargeMessage);
+    }
 
-    // Set dup flag.
-    buffer.writeUInt8(buffer.readUInt8(0) | 0x08, 0);
+    // Kept in the spool file until the client is connected.
+    if (!handle.spoolPacket(spooled)) {
+      throw new Error('MQTT message does not fit into the spool');
+    }
 
-    var packet = handle.storage[packet_id];
+    if (typeof callback == 'function') {
+      process.nextTick(callback);
+    }
 
-    packet.packet = buffer;
-    packet.callback = callback;
-    return;
+    return false;
+  }
+
+  this.checkConnection();
+
+  if (qos > 0) {
+    return handle.sendPacket(function(packet_id) {
+      return handle.encodePublish(topic, message, header | (packet_id << 4),
+                                  properties);
+    }, callback);
   }
 
-  handle.write(native.publish(topic, message, header));
+  var packet = handle.encodePublish(topic, message, header, properties);
+
+  if (!packet) {
+    throw new Error(PacketTooLargeMessage);
+  }
+
+  handle.write(packet);
 
   if (typeof callback == 'function') {
     process.nextTick(callback);
   }
+
+  return true;
 };
 
 MQTTClient.prototype.subscribe = function(topic, options, callback) {
@@ -338,10 +617,12 @@ MQTTClient.prototype.subscribe = function(topic, options, callback) {
 
   var handle = this._handle;
 
-  var packet_id = handle.getPacketId();
+  if (options && typeof options.handler == 'function') {
+    handle.addTopicHandler(topic, options.handler);
+  }
 
   // header bits: | 2 bit qos | 16 bit packet id |
-  var header = packet_id;
+  var header = 0;
 
   var qos = 0;
 
@@ -355,14 +636,15 @@ MQTTClient.prototype.subscribe = function(topic, options, callback) {
     header |= (qos << 16);
   }
 
-  var buffer = native.subscribe(topic, header);
-
-  handle.write(buffer);
+  var properties = options && options.properties;
 
-  var packet = handle.storage[packet_id];
+  handle.sendPacket(function(packet_id) {
+    if (handle.protocolVersion < 5) {
+      return native.subscribe(topic, header | packet_id);
+    }
 
-  packet.packet = buffer;
-  packet.callback = callback;
+    return native.subscribe(topic, header | packet_id, properties);
+  }, callback);
 };
 
 MQTTClient.prototype.unsubscribe = function(topic, callback) {
@@ -370,19 +652,16 @@ MQTTClient.prototype.unsubscribe = function(topic, callback) {
 
   var handle = this._handle;
 
-  var packet_id = handle.getPacketId();
-
-  // header bits: | 16 bit packet id |
-  var header = packet_id;
+  handle.removeTopicHandler(topic);
 
-  var buffer = native.unsubscribe(topic, header);
-
-  handle.write(buffer);
-
-  var packet = handle.storage[packet_id];
+  handle.sendPacket(function(packet_id) {
+    // header bits: | 16 bit packet id |
+    if (handle.protocolVersion < 5) {
+      return native.unsubscribe(topic, packet_id);
+    }
 
-  packet.packet = buffer;
-  packet.callback = callback;
+    return native.unsubscribe(topic, packet_id, undefined);
+  }, callback);
 };
 
 function onerror(error) {
@@ -400,24 +679,33 @@ function onfinish() {
 function storageTimerHit() {
   // this: MQTTHandle
 
-  // eslint-disable-next-line guard-for-in
-  for (var packet_id in this.storage) {
-    var packet = this.storage[packet_id];
+  // Every 8 seconds, the unacknowledged packets are retransmitted. Only
+  // the packets whose time has come are returned.
+  var ids = native.tick(this);
 
-    packet.remainingTime--;
+  if (ids) {
+    for (var i = 0; i < ids.length; i++) {
+      var packet_id = ids[i];
 
-    if (packet.remainingTime <= 0) {
-      this.releasePacket(packet_id, new Error('Undelivered message'));
-      continue;
-    }
+      if (packet_id < 0) {
+        this.releasePacket(-packet_id, new Error('Undelivered message'));
+        continue;
+      }
+
+      var packet = this.storage[packet_id].packet;
+      var first_byte = packet.readUInt8(0);
+
+      // The stored packet is reused, only the dup flag is set in place.
+      if ((first_byte >> 4) == PacketTypeEnum.PUBLISH) {
+        packet.writeUInt8(first_byte | 0x08, 0);
+      }
 
-    // Every 8 seconds, the message is retransmitted.
-    if (!(packet.remainingTime & 0x7)) {
-      this.write(packet.packet);
+      this.write(packet);
     }
   }
 
-  if (this.storageCount == 0 && !this.isConnected) {
+  if (this.storageCount == 0 && this.pending.length == 0 &&
+      !this.isConnected) {
     // Graceful disconnect after all messages transmitted.
     this.socket.end(native.disconnect());
 
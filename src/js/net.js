@@ -64,6 +64,8 @@ function Socket(options) {
   this._timer = null;
   this._timeout = 0;
 
+  this.bytesWritten = 0;
+
   this._socketState = new SocketState(options);
 
   if (options.handle) {
@@ -149,13 +151,41 @@ Socket.prototype.write = function(data, callback) {
 };
 
 
+// A region of an open file, queued in place of a buffer by sendFile().
+function FileChunk(fd, offset, length) {
+  this.fd = fd;
+  this.offset = offset;
+  this.length = length;
+}
+
+
+Socket.prototype.sendFile = function(fd, offset, length, callback) {
+  if (!util.isNumber(fd) || fd < 0) {
+    throw new TypeError('Bad arguments: fd must be a non-negative number');
+  }
+  if (!util.isNumber(offset) || offset < 0) {
+    throw new TypeError('Bad arguments: offset must be a non-negative number');
+  }
+  if (!util.isNumber(length) || length < 0) {
+    throw new TypeError('Bad arguments: length must be a non-negative number');
+  }
+
+  // The chunk is queued like any other write so it stays ordered with
+  // the data written before and after it.
+  var chunk = new FileChunk(fd, offset, length);
+  return stream.Duplex.prototype.write.call(this, chunk, callback);
+};
+
+
 Socket.prototype._write = function(chunk, callback, afterWrite) {
-  assert(util.isBuffer(chunk));
+  assert(util.isBuffer(chunk) || chunk instanceof FileChunk);
   assert(util.isFunction(afterWrite));
 
   var self = this;
 
-  if (self.errored) {
+  if (chunk instanceof FileChunk) {
+    sendFileChunk(self, chunk, callback, afterWrite);
+  } else if (self.errored) {
     process.nextTick(afterWrite, 1);
     if (util.isFunction(callback)) {
       process.nextTick(function(self, status) {
@@ -168,6 +198,9 @@ Socket.prototype._write = function(chunk, callback, afterWrite) {
     self._handle.owner = self;
 
     self._handle.write(chunk, function(status) {
+      if (!status) {
+        self.bytesWritten += chunk.length;
+      }
       afterWrite(status);
       if (util.isFunction(callback)) {
         callback.call(self, status);
@@ -305,6 +338,41 @@ function connect(socket, ip, port) {
 }
 
 
+function sendFileChunk(socket, chunk, callback, afterWrite) {
+  var onSent = function(status, bytesSent) {
+    socket.bytesWritten += bytesSent;
+    afterWrite(status);
+    if (util.isFunction(callback)) {
+      var err = null;
+      if (status) {
+        err = new Error('sendFile failed - status: ' + Tcp.errname(status));
+      }
+      callback.call(socket, err, bytesSent);
+    }
+  };
+
+  if (socket.errored) {
+    process.nextTick(afterWrite, 1);
+    if (util.isFunction(callback)) {
+      process.nextTick(function() {
+        callback.call(socket, new Error('sendFile failed - socket errored'), 0);
+      });
+    }
+    return;
+  }
+
+  resetSocketTimeout(socket);
+
+  socket._handle.owner = socket;
+
+  var err = socket._handle.sendFile(chunk.fd, chunk.offset, chunk.length,
+                                    onSent);
+  if (err) {
+    process.nextTick(onSent, err, 0);
+  }
+}
+
+
 function close(socket) {
   socket._handle.owner = socket;
   socket._handle.onclose = function() {
@@ -679,5 +747,82 @@ exports.connect = exports.createConnection = function() {
 };
 
 
+// Writes `data` to all of the `sockets`. Sockets whose write queue is idle
+// get one native write request each, all pointing to the same buffer.
+// The others, like sockets with pending writes or TLS sockets, fall back
+// to write() so their output stays ordered.
+exports.writeShared = function(sockets, data, callback) {
+  if (!util.isArray(sockets)) {
+    throw new TypeError('Bad arguments: sockets must be an array');
+  }
+  if (util.isString(data)) {
+    data = new Buffer(data);
+  }
+  if (!util.isBuffer(data)) {
+    throw new TypeError('Bad arguments: data must be a Buffer or a string');
+  }
+
+  var handles = [];
+  var shared = [];
+  var pending = 1;
+  var done = function() {
+    if (--pending === 0 && util.isFunction(callback)) {
+      callback();
+    }
+  };
+
+  for (var i = 0; i < sockets.length; i++) {
+    var socket = sockets[i];
+    if (canWriteShared(socket)) {
+      resetSocketTimeout(socket);
+      socket._handle.owner = socket;
+      handles.push(socket._handle);
+      shared.push(socket);
+    } else {
+      pending++;
+      socket.write(data, done);
+    }
+  }
+
+  var onWritten = function(statuses) {
+    for (var i = 0; i < shared.length; i++) {
+      afterWriteShared(shared[i], data.length, statuses[i]);
+    }
+    done();
+  };
+
+  if (handles.length > 0) {
+    pending++;
+    var statuses = Tcp.writeShared(handles, data, onWritten);
+    // The native callback is only called when a write was started.
+    if (statuses.indexOf(0) < 0) {
+      process.nextTick(onWritten, statuses);
+    }
+  }
+  done();
+};
+
+
+function afterWriteShared(socket, length, status) {
+  if (!status) {
+    socket.bytesWritten += length;
+  } else if (!socket.errored && socket._handle) {
+    emitError(socket, new Error('write failed - status: ' +
+      Tcp.errname(status)));
+  }
+}
+
+
+function canWriteShared(socket) {
+  if (!(socket instanceof Socket) || !socket._handle || socket.errored) {
+    return false;
+  }
+
+  var state = socket._writableState;
+  return socket._socketState.writable && state.ready && !state.writing &&
+         !state.ending && state.buffer.length === 0;
+}
+
+
 module.exports.Socket = Socket;
 module.exports.Server = Server;
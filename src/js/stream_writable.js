@@ -19,6 +19,9 @@ var util = require('util');
 
 var defaultHighWaterMark = 128;
 
+// Largest number of queued requests handed to a single _writev call.
+var maxWritevRequests = 1024;
+
 
 function WriteReq(chunk, callback) {
   this.chunk = chunk;
@@ -105,6 +108,11 @@ Writable.prototype._write = function(/* chunk, callback, onwrite */) {
 };
 
 
+// Concrete streams may also define _writev(reqs, onwrite) to write all the
+// buffered requests ({chunk, callback} objects) at once.
+Writable.prototype._writev = null;
+
+
 Writable.prototype.end = function(chunk, callback) {
   var state = this._writableState;
 
@@ -197,6 +205,8 @@ function writeBuffered(stream) {
   if (!state.writing) {
     if (state.buffer.length == 0) {
       onEmptyBuffer(stream);
+    } else if (stream._writev && state.buffer.length > 1) {
+      doWritev(stream, state.buffer.splice(0, maxWritevRequests));
     } else {
       var req = state.buffer.shift();
       doWrite(stream, req.chunk, req.callback);
@@ -221,6 +231,20 @@ function doWrite(stream, chunk, callback) {
 }
 
 
+function doWritev(stream, reqs) {
+  var state = stream._writableState;
+
+  state.writing = true;
+  state.writingLength = 0;
+  for (var i = 0; i < reqs.length; i++) {
+    state.writingLength += reqs[i].chunk.length;
+  }
+
+  // Write down all the chunks at once.
+  stream._writev(reqs, stream._onwrite.bind(stream));
+}
+
+
 // No more data to write. if this stream is being finishing, emit 'finish'.
 function onEmptyBuffer(stream) {
   var state = stream._writableState;
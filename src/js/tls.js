@@ -17,6 +17,19 @@ var net = require('net');
 var util = require('util');
 var Duplex = require('stream').Duplex;
 
+function serverName(options) {
+  return options.servername || options.host || 'localhost';
+}
+
+// Sessions of a secure context are reused by connections to the same
+// server, the key is unknown when the caller connects the socket.
+function sessionKey(options) {
+  if (options.port === undefined) {
+    return undefined;
+  }
+  return serverName(options) + ':' + options.port;
+}
+
 function TLSSocket(socket, options) {
   if (!(this instanceof TLSSocket)) {
     return new TLSSocket(socket, options);
@@ -33,6 +46,11 @@ function TLSSocket(socket, options) {
 
   this.authorized = false;
 
+  // The native handle verifies the server unless it is told otherwise
+  this._rejectUnauthorized = !options.isServer &&
+                             (options.rejectUnauthorized === undefined ||
+                              !!options.rejectUnauthorized);
+
   this._socket.on('connect', this.onconnect);
   this._socket.on('data', this.ondata);
   this._socket.on('error', this.onerror);
@@ -56,7 +74,7 @@ function TLSSocket(socket, options) {
   var self = this;
   if (socket._writableState.ready && !options.isServer) {
     process.nextTick(function() {
-      self._native_connect(options.servername || options.host || 'localhost');
+      self._native_connect(serverName(options), sessionKey(options));
       self._native_read(null);
     });
   }
@@ -67,8 +85,10 @@ TLSSocket.prototype._native_read = native.read;
 TLSSocket.prototype._native_write = native.write;
 TLSSocket.prototype._native_connect = native.connect;
 
+TLSSocket.prototype.isSessionReused = native.isSessionReused;
+
 TLSSocket.prototype.connect = function(options, callback) {
-  this._native_connect(options.servername || options.host || 'localhost');
+  this._native_connect(serverName(options), sessionKey(options));
 
   if (util.isFunction(callback)) {
     this.on('secureConnect', callback);
@@ -152,7 +172,11 @@ TLSSocket.prototype.onhandshakedone = function(error, authorized) {
 
   if (error) {
     error = Error('handshake failed');
+  } else if (!authorized && this._rejectUnauthorized) {
+    error = Error('certificate verification failed');
+  }
 
+  if (error) {
     if (server) {
       server.emit('tlsClientError', error, this);
     } else {
@@ -185,7 +209,8 @@ function Server(options, listener) {
     return new Server(options, listener);
   }
 
-  this._secureContext = createSecureContext(options);
+  this._secureContext = options.secureContext ||
+                        createSecureContext(options);
 
   // constructor call
   net.Server.call(this, options, tlsConnectionListener);
@@ -26,8 +26,9 @@ function WebSocketHandle(client) {
   this.client = client;
   this.pings = [];
   this.connected = false;
+  this.failed = false;
 
-  native.wsInit(this);
+  native.wsInit(this, client._options.maxPayload);
 }
 
 function Websocket(options) {
@@ -37,8 +38,10 @@ function Websocket(options) {
 
   EventEmitter.call(this);
   this._firstMessage = true;
+  this._options = options || {};
   this._handle = new WebSocketHandle(this);
   this._secure = false;
+  this.extensions = '';
 }
 
 function WebsocketClient(socket, handle) {
@@ -55,6 +58,7 @@ function WebsocketClient(socket, handle) {
     this._firstMessage = true;
   }
   this._handle = handle;
+  this.extensions = '';
 
   EventEmitter.call(this);
 }
@@ -67,6 +71,8 @@ function ServerHandle() {
 
 function connectionListener(socket) {
   var ws = new WebsocketClient(socket, this._serverHandle);
+  // Each connection has its own native receive state.
+  native.wsInit(ws, this.maxPayload);
   this._serverHandle.clients.push(ws);
   var self = this;
 
@@ -104,8 +110,12 @@ function parseServerHandshakeData(data, client, server) {
       headers['Upgrade'] === 'websocket' &&
       headers['Sec-WebSocket-Version'] === '13') {
     response = native.ReceiveHandshakeData(
-      headers['Sec-WebSocket-Key']
+      headers['Sec-WebSocket-Key'],
+      headers['Sec-WebSocket-Extensions'],
+      client,
+      server.perMessageDeflate
     ).toString();
+    client.extensions = native.extensions(client);
     client.readyState = 'OPEN';
     client._socket.write(response);
     server.emit('open', client);
@@ -149,6 +159,8 @@ function Server(options, listener) {
     throw new Error('One of port or server must be provided as option');
   }
   this._netserver.path = options.path || '/';
+  this._netserver.perMessageDeflate = options.perMessageDeflate || false;
+  this._netserver.maxPayload = options.maxPayload;
 
   this._netserver.on('error', this.onError);
   this._netserver.on(emit_type, connectionListener);
@@ -162,7 +174,17 @@ function Server(options, listener) {
 }
 
 ServerHandle.prototype.ondata = function(data, client) {
-  native.wsReceive(this, data, client);
+  try {
+    native.wsReceive(this, data, client);
+  } catch (err) {
+    // The receive state is undefined after a protocol error,
+    // the connection is failed with the status code of the error.
+    if (client._events.error) {
+      client.emit('error', err);
+    }
+    client.readyState = 'CLOSING';
+    client.close({ code: err.code, reason: err.message });
+  }
 };
 
 ServerHandle.prototype.onmessage = function(msg, client) {
@@ -222,24 +244,52 @@ Server.prototype.close = function(reason, code) {
   this.emit('close', msg);
 };
 
+/*
+ * An encoded, unmasked data frame which can be sent to any number of
+ * clients without encoding the payload again.
+ */
+function PreparedFrame(frame, message, options) {
+  this.frame = frame;
+  this._message = message;
+  this._options = options;
+}
+
+Server.prototype.prepareFrame = function(msg, options) {
+  options = options || {};
+  // Frames sent by a server must not be masked (RFC 6455, section 5.1).
+  var frame = native.send(msg, options.binary || false, options.mask || false);
+  return new PreparedFrame(frame, msg, options);
+};
+
 Server.prototype.broadcast = function(msg, options) {
-  if (options) {
-    var mask = options.mask || true;
-    var binary = options.binary || false;
-    var compress = options.compress;
-    if (compress) {
-      // Currently not supported, needs zlib
-      this.onError('Compression is not supported');
-    }
+  if (!(msg instanceof PreparedFrame)) {
+    msg = this.prepareFrame(msg, options);
+  }
+  if (!msg.frame) {
+    return;
   }
-  var buff = native.send(msg, binary, mask);
 
-  var self = this;
-  this._netserver._serverHandle.clients.forEach(function each(client) {
-    if (client.readyState === 'OPEN') {
-      self._netserver._serverHandle.sendFrame(buff, client);
+  // The frame is handed to the sockets at once, idle TCP sockets get a
+  // native write request each pointing to the same buffer. Compressed
+  // messages are encoded per client.
+  var clients = this._netserver._serverHandle.clients.slice();
+  var sockets = [];
+  for (var i = 0; i < clients.length; i++) {
+    var client = clients[i];
+    if (client.readyState !== 'OPEN') {
+      continue;
     }
-  });
+    if ((msg._options.compress && client.extensions) ||
+        !client._socket._socketState.writable) {
+      client.send(msg);
+    } else {
+      sockets.push(client._socket);
+    }
+  }
+
+  if (sockets.length > 0) {
+    net.writeShared(sockets, msg.frame);
+  }
 };
 
 Server.prototype.address = function() {
@@ -251,16 +301,23 @@ Server.prototype.onError = function(err) {
 };
 
 WebsocketClient.prototype.send = function(message, opts) {
+  if (message instanceof PreparedFrame) {
+    if (!message._options.compress || !this.extensions) {
+      if (message.frame) {
+        this._handle.sendFrame(message.frame, this);
+      }
+      return;
+    }
+    // The compressed payload depends on the context of the connection.
+    opts = message._options;
+    message = message._message;
+  }
   if (opts) {
     var mask = opts.mask;
     var binary = opts.binary;
     var compress = opts.compress;
-    if (compress) {
-      // Currently not supported, needs zlib
-      this._handle.onError('Compression is not supported');
-    }
   }
-  var buff = native.send(message, binary, mask, compress);
+  var buff = native.send(message, binary, mask, compress, this);
   if (buff) {
     this._handle.sendFrame(buff, this);
   }
@@ -289,7 +346,34 @@ WebSocketHandle.prototype.onmessage = function(msg) {
 };
 
 WebSocketHandle.prototype.ondata = function(data) {
-  native.wsReceive(this, data, this);
+  if (this.failed) {
+    return;
+  }
+
+  try {
+    native.wsReceive(this, data, this);
+  } catch (err) {
+    this.fail(err);
+  }
+};
+
+// Fails the connection after a protocol error: the close frame carries
+// the status code of the error and no more data is processed.
+WebSocketHandle.prototype.fail = function(err) {
+  var msg = { code: err.code, reason: err.message };
+  this.failed = true;
+
+  if (this.client._events.error) {
+    this.client.emit('error', err);
+  }
+  if (this.connected) {
+    this.client._socket.write(native.close(msg.reason, msg.code));
+  }
+  for (var i = 0; i < this.pings.length; i++) {
+    clearInterval(this.pings[i].timer);
+  }
+  this.client._socket.end();
+  this.client.emit('close', msg);
 };
 
 WebSocketHandle.prototype.onhandshakedone = function(remaining) {
@@ -352,8 +436,8 @@ WebSocketHandle.prototype.onpingresp = function(msg) {
   }
 };
 
-function sendHandshake(jsref, host, path) {
-  return native.prepareHandshake(jsref, host, path);
+function sendHandshake(jsref, host, path, perMessageDeflate) {
+  return native.prepareHandshake(jsref, host, path, perMessageDeflate);
 }
 
 Websocket.prototype.connect = function(url, port, path, callback) {
@@ -388,7 +472,8 @@ Websocket.prototype.connect = function(url, port, path, callback) {
 
   this._socket.on(emit_type, function() {
     self._handle.connected = true;
-    self._socket.write(sendHandshake(self._handle, host, path));
+    self._socket.write(sendHandshake(self._handle, host, path,
+                                     self._options.perMessageDeflate));
   });
 
   this._socket.on('end', function() {
@@ -400,7 +485,18 @@ Websocket.prototype.connect = function(url, port, path, callback) {
 
   this._socket.on('data', function(data) {
     if (self._firstMessage) {
-      var remaining_data = native.parseHandshakeData(data, self._handle);
+      var remaining_data;
+      try {
+        remaining_data = native.parseHandshakeData(data, self._handle);
+      } catch (err) {
+        // The connection never opened, it is dropped without a close frame.
+        self._firstMessage = false;
+        self._handle.connected = false;
+        err.code = 1006;
+        self._handle.fail(err);
+        return;
+      }
+      self.extensions = native.extensions(self._handle);
       self._handle.onhandshakedone(remaining_data);
     } else {
       self._handle.ondata(data);
@@ -430,12 +526,8 @@ Websocket.prototype.send = function(message, opts, cb) {
     var mask = opts.mask;
     var binary = opts.binary;
     var compress = opts.compress;
-    if (compress) {
-      // Currently not supported, needs zlib
-      this._handle.onError('Compression is not supported');
-    }
   }
-  var buff = native.send(message, binary, mask, compress);
+  var buff = native.send(message, binary, mask, compress, this._handle);
   if (buff) {
     this._handle.sendFrame(buff, cb);
   }
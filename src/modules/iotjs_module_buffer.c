@@ -29,19 +29,53 @@ typedef enum {
 IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(bufferwrap);
 
 
-iotjs_bufferwrap_t* iotjs_bufferwrap_create(const jerry_value_t jobject,
-                                            size_t length) {
+iotjs_bufferwrap_t* iotjs_bufferwrap_alloc(size_t length) {
   iotjs_bufferwrap_t* bufferwrap = (iotjs_bufferwrap_t*)iotjs_buffer_allocate(
       sizeof(iotjs_bufferwrap_t) + length);
 
+  bufferwrap->length = length;
+  bufferwrap->buffer = (char*)(bufferwrap + 1);
+  return bufferwrap;
+}
+
+
+iotjs_bufferwrap_t* iotjs_bufferwrap_realloc(iotjs_bufferwrap_t* bufferwrap,
+                                             size_t length) {
+  IOTJS_ASSERT(bufferwrap->external_info == NULL);
+
+  bufferwrap = (iotjs_bufferwrap_t*)iotjs_buffer_reallocate(
+      (char*)bufferwrap, sizeof(iotjs_bufferwrap_t) + length);
+
+  bufferwrap->length = length;
+  bufferwrap->buffer = (char*)(bufferwrap + 1);
+  return bufferwrap;
+}
+
+
+iotjs_bufferwrap_t* iotjs_bufferwrap_alloc_external(char* data, size_t length) {
+  iotjs_bufferwrap_t* bufferwrap = IOTJS_ALLOC(iotjs_bufferwrap_t);
+
+  bufferwrap->length = length;
+  bufferwrap->buffer = data;
+  return bufferwrap;
+}
+
+
+static void iotjs_bufferwrap_attach(const jerry_value_t jobject,
+                                    iotjs_bufferwrap_t* bufferwrap) {
   bufferwrap->jobject = jobject;
   jerry_set_object_native_pointer(jobject, bufferwrap,
                                   &this_module_native_info);
 
-  bufferwrap->length = length;
-
   IOTJS_ASSERT(
       jerry_get_object_native_pointer(jobject, NULL, &this_module_native_info));
+}
+
+
+iotjs_bufferwrap_t* iotjs_bufferwrap_create(const jerry_value_t jobject,
+                                            size_t length) {
+  iotjs_bufferwrap_t* bufferwrap = iotjs_bufferwrap_alloc(length);
+  iotjs_bufferwrap_attach(jobject, bufferwrap);
   return bufferwrap;
 }
 
@@ -119,68 +153,154 @@ static size_t bound_range(size_t index, size_t low, size_t upper) {
 }
 
 
-static int8_t hex_to_bin(char c) {
-  if (c >= '0' && c <= '9') {
-    return (int8_t)(c - '0');
-  }
-  if (c >= 'A' && c <= 'F') {
-    return (int8_t)(10 + (c - 'A'));
-  }
-  if (c >= 'a' && c <= 'f') {
-    return (int8_t)(10 + (c - 'a'));
-  }
-
-  return (int8_t)(-1);
-}
+/* Lookup tables of the decoders. Invalid characters are mapped to 0xff,
+ * so a whole group of characters can be checked with a single test. */
+static const uint8_t hex_dec_map[256] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 255, 255, 255, 255, 255, 255,
+  255, 10, 11, 12, 13, 14, 15, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 10, 11, 12, 13, 14, 15, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255,
+};
 
 
 static size_t hex_decode(char* buf, size_t len, const char* src,
                          const size_t srcLen) {
-  const char* bufStart = buf;
-  const char* bufEnd = buf + len;
-  const char* srcEnd = src + srcLen;
+  const uint8_t* in = (const uint8_t*)src;
+  const uint8_t* inEnd = in + srcLen;
+  size_t bufLen = srcLen / 2;
 
   if ((srcLen & 0x1) != 0) {
     return 0;
   }
 
-  while (src < srcEnd) {
-    int8_t a = hex_to_bin(src[0]);
-    int8_t b = hex_to_bin(src[1]);
+  if (bufLen > len) {
+    bufLen = len;
+  }
+
+  uint8_t* out = (uint8_t*)buf;
+  uint8_t* outEnd = out + bufLen;
+
+  while (out < outEnd) {
+    uint8_t a = hex_dec_map[in[0]];
+    uint8_t b = hex_dec_map[in[1]];
 
-    if (a == -1 || b == -1) {
+    if ((a | b) & 0xf0) {
       return 0;
     }
 
-    if (buf < bufEnd) {
-      *buf++ = (a << 4) | b;
-    }
+    *out++ = (uint8_t)((a << 4) | b);
+    in += 2;
+  }
 
-    src += 2;
+  /* The rest of the input is validated even if it does not fit. */
+  while (in < inEnd) {
+    if (hex_dec_map[*in++] & 0xf0) {
+      return 0;
+    }
   }
 
-  return (size_t)((buf - bufStart) + 1);
+  return bufLen + 1;
 }
 
 
-static int32_t base64_to_bin(char c) {
-  if (c >= 'A' && c <= 'Z') {
-    return (int32_t)(c - 'A');
+static const uint8_t base64_dec_map[256] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 62, 255, 255,
+  255, 63, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 255, 255, 255, 255, 255, 255,
+  255, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+  21, 22, 23, 24, 25, 255, 255, 255, 255, 255, 255, 26, 27, 28, 29, 30, 31, 32,
+  33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+
+/* Returns the number of decoded bytes and strips the padding of the
+ * source, or returns SIZE_MAX when the source is invalid. The whole source
+ * is checked before anything is written to the destination. */
+static size_t base64_decoded_length(const char* src, size_t* srcLen) {
+  size_t length = *srcLen;
+
+  if ((length & 0x3) != 0 || length == 0) {
+    return SIZE_MAX;
   }
-  if (c >= 'a' && c <= 'z') {
-    return (int32_t)(26 + (c - 'a'));
+
+  size_t decoded_len = 3 * (length / 4);
+
+  for (int i = 0; i < 2 && src[length - 1] == '='; i++) {
+    length--;
+    decoded_len--;
   }
-  if (c >= '0' && c <= '9') {
-    return (int32_t)(52 + (c - '0'));
+
+  for (size_t i = 0; i < length; i++) {
+    if (base64_dec_map[(uint8_t)src[i]] & 0xc0) {
+      return SIZE_MAX;
+    }
   }
-  if (c == '+') {
-    return 62;
+
+  *srcLen = length;
+  return decoded_len;
+}
+
+
+static size_t base64_decode_to(uint8_t* out, const uint8_t* in,
+                               size_t srcLen) {
+  const uint8_t* inEnd = in + (srcLen & ~(size_t)0x3);
+  uint8_t* outStart = out;
+
+  while (in < inEnd) {
+    uint32_t a = base64_dec_map[in[0]];
+    uint32_t b = base64_dec_map[in[1]];
+    uint32_t c = base64_dec_map[in[2]];
+    uint32_t d = base64_dec_map[in[3]];
+
+    uint32_t bits = (a << 18) | (b << 12) | (c << 6) | d;
+    out[0] = (uint8_t)(bits >> 16);
+    out[1] = (uint8_t)(bits >> 8);
+    out[2] = (uint8_t)bits;
+
+    in += 4;
+    out += 3;
   }
-  if (c == '/') {
-    return 63;
+
+  /* Two or three characters are left when the input was padded. */
+  size_t rest = srcLen & 0x3;
+
+  if (rest != 0) {
+    uint32_t a = base64_dec_map[in[0]];
+    uint32_t b = base64_dec_map[in[1]];
+    uint32_t c = rest == 3 ? base64_dec_map[in[2]] : 0;
+
+    uint32_t bits = (a << 18) | (b << 12) | (c << 6);
+    *out++ = (uint8_t)(bits >> 16);
+
+    if (rest == 3) {
+      *out++ = (uint8_t)(bits >> 8);
+    }
   }
 
-  return (int32_t)(-1);
+  return (size_t)(out - outStart);
 }
 
 
@@ -190,18 +310,24 @@ static size_t base64_decode(char* dst, size_t len, const char* src,
     return 1;
   }
 
+  size_t length = srcLen;
+  size_t decoded_len = base64_decoded_length(src, &length);
+
+  if (decoded_len == SIZE_MAX) {
+    return 0;
+  }
+
+  /* Decode in place when the whole result fits into the buffer. */
+  if (decoded_len <= len) {
+    return base64_decode_to((uint8_t*)dst, (const uint8_t*)src, length) + 1;
+  }
+
   char* decoded_base64 = NULL;
-  size_t decoded_len = iotjs_base64_decode(&decoded_base64, src, srcLen);
+  decoded_len = iotjs_base64_decode(&decoded_base64, src, srcLen);
   size_t ret_val = 0;
   if (decoded_len) {
-    char* buf = dst;
-    char* bufEnd = len > decoded_len ? dst + decoded_len : dst + len;
-
-    char* pos = decoded_base64;
-    while (buf < bufEnd) {
-      *buf++ = *pos++;
-    }
-    ret_val = (size_t)(buf - dst) + 1;
+    memcpy(dst, decoded_base64, len);
+    ret_val = len + 1;
   }
 
   IOTJS_RELEASE(decoded_base64);
@@ -211,62 +337,18 @@ static size_t base64_decode(char* dst, size_t len, const char* src,
 
 size_t iotjs_base64_decode(char** out_buff, const char* src,
                            const size_t srcLen) {
-  if ((srcLen & 0x3) != 0 || srcLen == 0) {
-    return 0;
-  }
-
-  size_t len = (3 * (srcLen / 4));
+  size_t length = srcLen;
+  size_t len = base64_decoded_length(src, &length);
 
-  const char* srcEnd = src + srcLen;
-
-  if (srcEnd[-1] == '=') {
-    srcEnd--;
-    len--;
-    if (srcEnd[-1] == '=') {
-      srcEnd--;
-      len--;
-    }
+  if (len == SIZE_MAX) {
+    return 0;
   }
 
   if (*out_buff == NULL) {
     *out_buff = IOTJS_CALLOC(len, char);
   }
 
-  char* buf = *out_buff;
-
-  const char* bufStart = buf;
-  const char* bufEnd = buf + len;
-
-  int32_t current_bits = 0;
-  int32_t shift = 8;
-
-  while (src < srcEnd) {
-    int32_t value = base64_to_bin(*src++);
-
-    if (value == -1) {
-      return 0;
-    }
-
-    current_bits = (current_bits << 6) | value;
-    shift -= 2;
-
-    if (shift == 6) {
-      continue;
-    }
-
-    int32_t byte = (current_bits >> shift);
-    current_bits &= (1 << shift) - 1;
-
-    if (shift == 0) {
-      shift = 8;
-    }
-
-    if (buf <= bufEnd) {
-      *buf++ = byte;
-    }
-  }
-
-  return (size_t)((buf - bufStart));
+  return base64_decode_to((uint8_t*)*out_buff, (const uint8_t*)src, length);
 }
 
 
@@ -342,11 +424,18 @@ static size_t index_normalizer(int64_t index, size_t max_length) {
 }
 
 jerry_value_t iotjs_bufferwrap_create_buffer(size_t len) {
+  return iotjs_bufferwrap_create_buffer_from(iotjs_bufferwrap_alloc(len));
+}
+
+
+jerry_value_t iotjs_bufferwrap_create_buffer_from(
+    iotjs_bufferwrap_t* bufferwrap) {
   jerry_value_t jres_buffer = jerry_create_object();
 
-  iotjs_bufferwrap_create(jres_buffer, len);
+  iotjs_bufferwrap_attach(jres_buffer, bufferwrap);
 
-  iotjs_jval_set_property_number(jres_buffer, IOTJS_MAGIC_STRING_LENGTH, len);
+  iotjs_jval_set_property_number(jres_buffer, IOTJS_MAGIC_STRING_LENGTH,
+                                 bufferwrap->length);
 
   // Support for 'instanceof' operator
   jerry_value_t native_buffer = iotjs_module_get("buffer");
@@ -547,9 +636,7 @@ JS_FUNCTION(Slice) {
 }
 
 
-static char to_hex_char(uint8_t digit) {
-  return (char)((digit < 10) ? (digit + '0') : (digit + 'a' - 10));
-}
+static const char hex_enc_map[17] = "0123456789abcdef";
 
 
 static jerry_value_t to_hex_string(const uint8_t* data, size_t length) {
@@ -564,8 +651,8 @@ static jerry_value_t to_hex_string(const uint8_t* data, size_t length) {
   const jerry_char_t* str = (const jerry_char_t*)buffer;
 
   while (data < end) {
-    *buffer++ = to_hex_char(*data >> 4);
-    *buffer++ = to_hex_char(*data & 0xf);
+    *buffer++ = hex_enc_map[*data >> 4];
+    *buffer++ = hex_enc_map[*data & 0xf];
     data++;
   }
 
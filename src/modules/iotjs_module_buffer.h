@@ -26,7 +26,9 @@ typedef struct {
   jerry_value_t jobject;
   size_t length;
   iotjs_bufferwrap_external_info_t* external_info;
-  char buffer[];
+  // Points to the data stored right after this structure, or to external
+  // memory released by the free_hint of external_info.
+  char* buffer;
 } iotjs_bufferwrap_t;
 
 size_t iotjs_base64_decode(char** out_buff, const char* src,
@@ -36,6 +38,13 @@ size_t iotjs_base64_encode(unsigned char** out_buff, const uint8_t* data,
 iotjs_bufferwrap_t* iotjs_bufferwrap_create(const jerry_value_t jbuiltin,
                                             size_t length);
 
+// Allocation of a buffer which is not bound to a JS object yet. It does not
+// touch the JS engine, so it may be used on worker threads.
+iotjs_bufferwrap_t* iotjs_bufferwrap_alloc(size_t length);
+iotjs_bufferwrap_t* iotjs_bufferwrap_realloc(iotjs_bufferwrap_t* bufferwrap,
+                                             size_t length);
+iotjs_bufferwrap_t* iotjs_bufferwrap_alloc_external(char* data, size_t length);
+
 void iotjs_bufferwrap_set_external_callback(iotjs_bufferwrap_t* bufferwrap,
                                             void* free_hint, void* free_info);
 
@@ -53,6 +62,9 @@ iotjs_bufferwrap_t* iotjs_jbuffer_get_bufferwrap_ptr(const jerry_value_t);
 
 // Fail-safe creation of Buffer object.
 jerry_value_t iotjs_bufferwrap_create_buffer(size_t len);
+// Creates a Buffer object which takes ownership of the allocated bufferwrap.
+jerry_value_t iotjs_bufferwrap_create_buffer_from(
+    iotjs_bufferwrap_t* bufferwrap);
 
 
 #endif /* IOTJS_MODULE_BUFFER_H */
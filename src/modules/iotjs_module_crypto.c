@@ -45,10 +45,12 @@
 #include "iotjs_module_buffer.h"
 
 /* These enum values are the same as the ones in crypto.js as well as the
-   corresponding ones in sha.h in mbedTLS.*/
+   corresponding ones in md.h in mbedTLS.*/
 typedef enum {
+  IOTJS_CRYPTO_MD5 = 3,
   IOTJS_CRYPTO_SHA1 = 4,
   IOTJS_CRYPTO_SHA256 = 6,
+  IOTJS_CRYPTO_SHA512 = 8,
 } iotjs_crypto_sha_t;
 
 #if !ENABLE_MODULE_TLS
@@ -275,9 +277,12 @@ static int iotjs_sha1_update(uint32_t total[2], uint32_t state[5],
   }
 
   while (buff_len >= 64) {
-    if ((ret = iotjs_sha1_process(state, buffer)) != 0) {
+    if ((ret = iotjs_sha1_process(state, in_buff)) != 0) {
       return ret;
     }
+
+    in_buff += 64;
+    buff_len -= 64;
   }
 
   if (buff_len > 0) {
@@ -324,6 +329,7 @@ static int iotjs_sha1_finish(uint32_t total[2], uint32_t state[5],
 }
 #else /* ENABLE_MODULE_TLS */
 
+#include "mbedtls/md.h"
 #include "mbedtls/pk.h"
 #include "mbedtls/sha1.h"
 #include "mbedtls/sha256.h"
@@ -393,57 +399,247 @@ size_t iotjs_sha256_encode(unsigned char **out_buff,
 #endif /* ENABLE_MODULE_TLS */
 
 
-JS_FUNCTION(ShaEncode) {
-  DJS_CHECK_THIS();
-  DJS_CHECK_ARGS(2, any, number);
+/* Hash and HMAC state of a crypto.Hash object. The input is hashed as
+ * it is passed to update, so it does not need to be kept in memory. */
+typedef struct {
+  iotjs_crypto_sha_t type;
+  bool hmac;
+  bool finished;
+#if ENABLE_MODULE_TLS
+  mbedtls_md_context_t md_ctx;
+#else  /* !ENABLE_MODULE_TLS */
+  uint32_t total[2];
+  uint32_t state[5];
+  unsigned char buffer[64];
+  // Key of the outer HMAC hash, xor-ed with the outer pad
+  unsigned char hmac_opad[64];
+#endif /* ENABLE_MODULE_TLS */
+} iotjs_crypto_hash_t;
 
-  uint8_t type = JS_GET_ARG(1, number);
+IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(crypto_hash);
 
-  jerry_value_t jstring = JS_GET_ARG(0, any);
-  iotjs_string_t user_str = iotjs_string_create();
 
-  if (!iotjs_jbuffer_as_string(jstring, &user_str)) {
-    return jerry_create_undefined();
+static void iotjs_crypto_hash_destroy(iotjs_crypto_hash_t *hash) {
+#if ENABLE_MODULE_TLS
+  mbedtls_md_free(&hash->md_ctx);
+#else  /* !ENABLE_MODULE_TLS */
+  memset(hash->hmac_opad, 0, sizeof(hash->hmac_opad));
+#endif /* ENABLE_MODULE_TLS */
+  IOTJS_RELEASE(hash);
+}
+
+
+#if !ENABLE_MODULE_TLS
+static void iotjs_crypto_sha1_starts(iotjs_crypto_hash_t *hash) {
+  hash->total[0] = 0;
+  hash->total[1] = 0;
+
+  hash->state[0] = 0x67452301;
+  hash->state[1] = 0xEFCDAB89;
+  hash->state[2] = 0x98BADCFE;
+  hash->state[3] = 0x10325476;
+  hash->state[4] = 0xC3D2E1F0;
+}
+
+
+static void iotjs_crypto_sha1_hmac_starts(iotjs_crypto_hash_t *hash,
+                                          const unsigned char *key,
+                                          size_t key_len) {
+  unsigned char key_hash[20];
+  unsigned char ipad[64];
+
+  // Keys longer than the block size are hashed first
+  if (key_len > 64) {
+    iotjs_crypto_sha1_starts(hash);
+    iotjs_sha1_update(hash->total, hash->state, hash->buffer, key, key_len);
+    iotjs_sha1_finish(hash->total, hash->state, hash->buffer, key_hash);
+    key = key_hash;
+    key_len = 20;
   }
 
-  const unsigned char *user_str_data =
-      (const unsigned char *)iotjs_string_data(&user_str);
-  size_t user_str_sz = iotjs_string_size(&user_str);
+  memset(ipad, 0x36, 64);
+  memset(hash->hmac_opad, 0x5C, 64);
+
+  for (size_t i = 0; i < key_len; i++) {
+    ipad[i] ^= key[i];
+    hash->hmac_opad[i] ^= key[i];
+  }
+
+  iotjs_crypto_sha1_starts(hash);
+  iotjs_sha1_update(hash->total, hash->state, hash->buffer, ipad, 64);
+
+  memset(ipad, 0, sizeof(ipad));
+  memset(key_hash, 0, sizeof(key_hash));
+}
+
+
+static void iotjs_crypto_sha1_hmac_finish(iotjs_crypto_hash_t *hash,
+                                          unsigned char *out_buff) {
+  unsigned char inner[20];
+
+  iotjs_sha1_finish(hash->total, hash->state, hash->buffer, inner);
+
+  iotjs_crypto_sha1_starts(hash);
+  iotjs_sha1_update(hash->total, hash->state, hash->buffer, hash->hmac_opad,
+                    64);
+  iotjs_sha1_update(hash->total, hash->state, hash->buffer, inner, 20);
+  iotjs_sha1_finish(hash->total, hash->state, hash->buffer, out_buff);
+}
+#endif /* !ENABLE_MODULE_TLS */
+
+
+JS_FUNCTION(HashCons) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, number);
+
+  iotjs_crypto_sha_t type = (iotjs_crypto_sha_t)JS_GET_ARG(0, number);
+  bool hmac = jargc >= 2 && !jerry_value_is_undefined(jargv[1]);
 
-  size_t sha_sz = 0;
+  iotjs_tmp_buffer_t key;
+  iotjs_jval_as_tmp_buffer(hmac ? jargv[1] : jerry_create_undefined(), &key);
 
-  unsigned char *sha_ret = NULL;
+  if (jerry_value_is_error(key.jval)) {
+    return key.jval;
+  }
+
+#if ENABLE_MODULE_TLS
+  const mbedtls_md_info_t *md_info = NULL;
 
   switch (type) {
-    case IOTJS_CRYPTO_SHA1: {
-      sha_sz = iotjs_sha1_encode(&sha_ret, user_str_data, user_str_sz);
+    case IOTJS_CRYPTO_MD5:
+    case IOTJS_CRYPTO_SHA1:
+    case IOTJS_CRYPTO_SHA256:
+    case IOTJS_CRYPTO_SHA512: {
+      md_info = mbedtls_md_info_from_type((mbedtls_md_type_t)type);
       break;
     }
-    case IOTJS_CRYPTO_SHA256: {
-#if !ENABLE_MODULE_TLS
-      iotjs_string_destroy(&user_str);
-      return JS_CREATE_ERROR(COMMON, no_tls_err_str);
-#else  /* ENABLE_MODULE_TLS */
-      sha_sz = iotjs_sha256_encode(&sha_ret, user_str_data, user_str_sz);
+    default: {
       break;
-#endif /* !ENABLE_MODULE_TLS */
     }
-    default: {
-      iotjs_string_destroy(&user_str);
-      return JS_CREATE_ERROR(COMMON, "Unknown SHA hashing algorithm");
+  }
+
+  if (md_info == NULL) {
+    iotjs_free_tmp_buffer(&key);
+    return JS_CREATE_ERROR(COMMON, "Unknown hashing algorithm");
+  }
+#else  /* !ENABLE_MODULE_TLS */
+  if (type != IOTJS_CRYPTO_SHA1) {
+    iotjs_free_tmp_buffer(&key);
+    return JS_CREATE_ERROR(COMMON, no_tls_err_str);
+  }
+#endif /* ENABLE_MODULE_TLS */
+
+  iotjs_crypto_hash_t *hash = IOTJS_ALLOC(iotjs_crypto_hash_t);
+  hash->type = type;
+  hash->hmac = hmac;
+  hash->finished = false;
+
+  jerry_value_t jhash = JS_GET_THIS();
+  jerry_set_object_native_pointer(jhash, hash, &this_module_native_info);
+
+#if ENABLE_MODULE_TLS
+  mbedtls_md_init(&hash->md_ctx);
+
+  int ret = mbedtls_md_setup(&hash->md_ctx, md_info, hmac ? 1 : 0);
+
+  if (ret == 0) {
+    if (hmac) {
+      ret = mbedtls_md_hmac_starts(&hash->md_ctx,
+                                   (const unsigned char *)key.buffer,
+                                   key.length);
+    } else {
+      ret = mbedtls_md_starts(&hash->md_ctx);
     }
   }
 
-  iotjs_string_destroy(&user_str);
+  iotjs_free_tmp_buffer(&key);
 
-  jerry_value_t ret_val;
-  ret_val = iotjs_bufferwrap_create_buffer(sha_sz);
-  iotjs_bufferwrap_t *ret_wrap = iotjs_bufferwrap_from_jbuffer(ret_val);
-  memcpy(ret_wrap->buffer, sha_ret, sha_sz);
-  ret_wrap->length = sha_sz;
+  if (ret != 0) {
+    return JS_CREATE_ERROR(COMMON, "Hash initialization failed");
+  }
+#else  /* !ENABLE_MODULE_TLS */
+  if (hmac) {
+    iotjs_crypto_sha1_hmac_starts(hash, (const unsigned char *)key.buffer,
+                                  key.length);
+  } else {
+    iotjs_crypto_sha1_starts(hash);
+  }
 
-  IOTJS_RELEASE(sha_ret);
-  return ret_val;
+  iotjs_free_tmp_buffer(&key);
+#endif /* ENABLE_MODULE_TLS */
+
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(HashUpdate) {
+  JS_DECLARE_THIS_PTR(crypto_hash, hash);
+  DJS_CHECK_ARGS(1, any);
+
+  if (hash->finished) {
+    return JS_CREATE_ERROR(COMMON, "Hash is already finished");
+  }
+
+  // Buffers are hashed in place, strings are converted once
+  iotjs_tmp_buffer_t data;
+  iotjs_jval_as_tmp_buffer(jargv[0], &data);
+
+  if (jerry_value_is_error(data.jval)) {
+    return data.jval;
+  }
+
+  const unsigned char *input = (const unsigned char *)data.buffer;
+
+#if ENABLE_MODULE_TLS
+  if (hash->hmac) {
+    mbedtls_md_hmac_update(&hash->md_ctx, input, data.length);
+  } else {
+    mbedtls_md_update(&hash->md_ctx, input, data.length);
+  }
+#else  /* !ENABLE_MODULE_TLS */
+  iotjs_sha1_update(hash->total, hash->state, hash->buffer, input,
+                    data.length);
+#endif /* ENABLE_MODULE_TLS */
+
+  iotjs_free_tmp_buffer(&data);
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(HashDigest) {
+  JS_DECLARE_THIS_PTR(crypto_hash, hash);
+
+  if (hash->finished) {
+    return JS_CREATE_ERROR(COMMON, "Hash is already finished");
+  }
+
+  hash->finished = true;
+
+#if ENABLE_MODULE_TLS
+  size_t digest_size = mbedtls_md_get_size(hash->md_ctx.md_info);
+#else  /* !ENABLE_MODULE_TLS */
+  size_t digest_size = 20;
+#endif /* ENABLE_MODULE_TLS */
+
+  jerry_value_t jdigest = iotjs_bufferwrap_create_buffer(digest_size);
+  iotjs_bufferwrap_t *digest_wrap = iotjs_bufferwrap_from_jbuffer(jdigest);
+  unsigned char *output = (unsigned char *)digest_wrap->buffer;
+
+#if ENABLE_MODULE_TLS
+  if (hash->hmac) {
+    mbedtls_md_hmac_finish(&hash->md_ctx, output);
+  } else {
+    mbedtls_md_finish(&hash->md_ctx, output);
+  }
+#else  /* !ENABLE_MODULE_TLS */
+  if (hash->hmac) {
+    iotjs_crypto_sha1_hmac_finish(hash, output);
+  } else {
+    iotjs_sha1_finish(hash->total, hash->state, hash->buffer, output);
+  }
+#endif /* ENABLE_MODULE_TLS */
+
+  return jdigest;
 }
 
 
@@ -533,7 +729,18 @@ JS_FUNCTION(Base64Encode) {
 jerry_value_t InitCrypto() {
   jerry_value_t jcrypto = jerry_create_object();
 
-  iotjs_jval_set_method(jcrypto, IOTJS_MAGIC_STRING_SHAENCODE, ShaEncode);
+  jerry_value_t jhash_cons = jerry_create_external_function(HashCons);
+  jerry_value_t jprototype = jerry_create_object();
+
+  iotjs_jval_set_method(jprototype, IOTJS_MAGIC_STRING_DIGEST, HashDigest);
+  iotjs_jval_set_method(jprototype, IOTJS_MAGIC_STRING_UPDATE, HashUpdate);
+  iotjs_jval_set_property_jval(jhash_cons, IOTJS_MAGIC_STRING_PROTOTYPE,
+                               jprototype);
+  iotjs_jval_set_property_jval(jcrypto, IOTJS_MAGIC_STRING_HASH, jhash_cons);
+
+  jerry_release_value(jprototype);
+  jerry_release_value(jhash_cons);
+
   iotjs_jval_set_method(jcrypto, IOTJS_MAGIC_STRING_BASE64ENCODE, Base64Encode);
   iotjs_jval_set_method(jcrypto, IOTJS_MAGIC_STRING_RSAVERIFY, RsaVerify);
 
@@ -16,8 +16,44 @@
 #include "iotjs_def.h"
 
 #include "iotjs_module_buffer.h"
+#include "iotjs_uv_handle.h"
 #include "iotjs_uv_request.h"
 
+#if defined(__linux__) || defined(__APPLE__)
+#define IOTJS_FS_HAS_MMAP 1
+#include <errno.h>
+#include <sys/mman.h>
+#endif
+
+/* Stats objects keep the uv_stat_t in native memory and read the fields
+ * through getters of the prototype, so making one does not set a property
+ * per field. */
+typedef struct { uv_stat_t statbuf; } iotjs_fs_stats_t;
+
+#define IOTJS_FS_STATS_FIELDS(X) \
+  X(dev)                         \
+  X(mode)                        \
+  X(nlink)                       \
+  X(uid)                         \
+  X(gid)                         \
+  X(rdev)                        \
+  X(blksize)                     \
+  X(ino)                         \
+  X(size)                        \
+  X(blocks)
+
+#define IOTJS_FS_STATS_TIMES(X) \
+  X(atime, atim)                \
+  X(mtime, mtim)                \
+  X(ctime, ctim)                \
+  X(birthtime, birthtim)
+
+IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(fs_stats);
+
+static void iotjs_fs_stats_destroy(iotjs_fs_stats_t* stats) {
+  IOTJS_RELEASE(stats);
+}
+
 jerry_value_t MakeStatObject(uv_stat_t* statbuf);
 
 
@@ -107,6 +143,9 @@ static jerry_value_t AfterSync(uv_fs_t* req, int err,
     case UV_FS_RMDIR:
     case UV_FS_UNLINK:
     case UV_FS_RENAME:
+    case UV_FS_FTRUNCATE:
+    case UV_FS_FSYNC:
+    case UV_FS_FDATASYNC:
       return jerry_create_undefined();
     case UV_FS_SCANDIR: {
       int r;
@@ -202,7 +241,18 @@ JS_FUNCTION(Open) {
 }
 
 
-typedef enum { IOTJS_FS_READ, IOTJS_FS_WRITE } iotjs_fs_op_t;
+typedef enum {
+  IOTJS_FS_READ,
+  IOTJS_FS_WRITE,
+  IOTJS_FS_FALLOCATE,
+  IOTJS_FS_WALK,
+} iotjs_fs_op_t;
+
+// Largest amount of data passed to a single read or write syscall.
+#define IOTJS_FS_MAX_IO_SIZE 0x7ffff000
+
+// Positions are exact up to 2^53, the largest integer of a JS number.
+#define IOTJS_FS_MAX_POSITION 9007199254740992.0
 
 jerry_value_t fs_do_read_or_write(const jerry_value_t jfunc,
                                   const jerry_value_t jthis,
@@ -217,9 +267,9 @@ jerry_value_t fs_do_read_or_write(const jerry_value_t jfunc,
 
   int fd = JS_GET_ARG(0, number);
   const jerry_value_t jbuffer = JS_GET_ARG(1, object);
-  size_t offset = JS_GET_ARG(2, number);
-  size_t length = JS_GET_ARG(3, number);
-  int position = JS_GET_ARG(4, number);
+  double offset = JS_GET_ARG(2, number);
+  double length = JS_GET_ARG(3, number);
+  double position = JS_GET_ARG(4, number);
   const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(5, function);
 
   iotjs_bufferwrap_t* buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
@@ -227,24 +277,32 @@ jerry_value_t fs_do_read_or_write(const jerry_value_t jfunc,
   size_t data_length = iotjs_bufferwrap_length(buffer_wrap);
   JS_CHECK(data != NULL && data_length > 0);
 
-  if (!IsWithinBounds(offset, length, data_length)) {
+  if (!(offset >= 0 && offset < data_length) ||
+      !(length >= 0 && length <= IOTJS_FS_MAX_IO_SIZE) ||
+      !IsWithinBounds((size_t)offset, (size_t)length, data_length)) {
     return JS_CREATE_ERROR(RANGE, "length out of bound");
   }
 
-  uv_buf_t uvbuf = uv_buf_init(data + offset, length);
+  // Negative positions read or write at the current file position
+  if (!(position < IOTJS_FS_MAX_POSITION)) {
+    return JS_CREATE_ERROR(RANGE, "position out of bound");
+  }
+
+  uv_buf_t uvbuf = uv_buf_init(data + (size_t)offset, (unsigned int)length);
+  int64_t pos = position < 0 ? -1 : (int64_t)position;
 
   jerry_value_t ret_value;
   if (fs_op == IOTJS_FS_READ) {
     if (!jerry_value_is_null(jcallback)) {
-      FS_ASYNC(env, read, jcallback, fd, &uvbuf, 1, position);
+      FS_ASYNC(env, read, jcallback, fd, &uvbuf, 1, pos);
     } else {
-      FS_SYNC(env, read, fd, &uvbuf, 1, position);
+      FS_SYNC(env, read, fd, &uvbuf, 1, pos);
     }
   } else {
     if (!jerry_value_is_null(jcallback)) {
-      FS_ASYNC(env, write, jcallback, fd, &uvbuf, 1, position);
+      FS_ASYNC(env, write, jcallback, fd, &uvbuf, 1, pos);
     } else {
-      FS_SYNC(env, write, fd, &uvbuf, 1, position);
+      FS_SYNC(env, write, fd, &uvbuf, 1, pos);
     }
   }
   return ret_value;
@@ -261,6 +319,907 @@ JS_FUNCTION(Write) {
 }
 
 
+// Largest number of buffers passed to a single readv or writev syscall.
+#define IOTJS_FS_MAX_IOV 1024
+
+/* Reads into or writes an array of buffers with one request. libuv copies
+ * the uv_buf_t array, so it is only needed during the call; the buffers
+ * themselves are kept alive by the JS side. */
+jerry_value_t fs_do_readv_or_writev(const jerry_value_t jfunc,
+                                    const jerry_value_t jthis,
+                                    const jerry_value_t jargv[],
+                                    const jerry_length_t jargc,
+                                    const iotjs_fs_op_t fs_op) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(3, number, array, number);
+  DJS_CHECK_ARG_IF_EXIST(3, function);
+
+  const iotjs_environment_t* env = iotjs_environment_get();
+
+  int fd = JS_GET_ARG(0, number);
+  const jerry_value_t jbuffers = JS_GET_ARG(1, array);
+  double position = JS_GET_ARG(2, number);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(3, function);
+
+  uint32_t count = jerry_get_array_length(jbuffers);
+
+  if (count == 0 || count > IOTJS_FS_MAX_IOV) {
+    return JS_CREATE_ERROR(RANGE, "number of buffers out of bound");
+  }
+
+  if (!(position < IOTJS_FS_MAX_POSITION)) {
+    return JS_CREATE_ERROR(RANGE, "position out of bound");
+  }
+
+  uv_buf_t* bufs = IOTJS_CALLOC(count, uv_buf_t);
+  size_t total = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    jerry_value_t jbuffer = iotjs_jval_get_property_by_index(jbuffers, i);
+    iotjs_bufferwrap_t* buffer_wrap = iotjs_jbuffer_get_bufferwrap_ptr(jbuffer);
+    jerry_release_value(jbuffer);
+
+    if (buffer_wrap == NULL) {
+      IOTJS_RELEASE(bufs);
+      return JS_CREATE_ERROR(TYPE, "Bad arguments: buffers");
+    }
+
+    total += buffer_wrap->length;
+    bufs[i] = uv_buf_init(buffer_wrap->buffer,
+                          (unsigned int)buffer_wrap->length);
+  }
+
+  if (total > IOTJS_FS_MAX_IO_SIZE) {
+    IOTJS_RELEASE(bufs);
+    return JS_CREATE_ERROR(RANGE, "length out of bound");
+  }
+
+  int64_t pos = position < 0 ? -1 : (int64_t)position;
+
+  jerry_value_t ret_value;
+  if (fs_op == IOTJS_FS_READ) {
+    if (!jerry_value_is_null(jcallback)) {
+      FS_ASYNC(env, read, jcallback, fd, bufs, count, pos);
+    } else {
+      FS_SYNC(env, read, fd, bufs, count, pos);
+    }
+  } else {
+    if (!jerry_value_is_null(jcallback)) {
+      FS_ASYNC(env, write, jcallback, fd, bufs, count, pos);
+    } else {
+      FS_SYNC(env, write, fd, bufs, count, pos);
+    }
+  }
+
+  IOTJS_RELEASE(bufs);
+  return ret_value;
+}
+
+
+JS_FUNCTION(Readv) {
+  return fs_do_readv_or_writev(jfunc, jthis, jargv, jargc, IOTJS_FS_READ);
+}
+
+
+JS_FUNCTION(Writev) {
+  return fs_do_readv_or_writev(jfunc, jthis, jargv, jargc, IOTJS_FS_WRITE);
+}
+
+
+// Initial buffer size for files which do not report their size (e.g. procfs).
+#define IOTJS_FS_READ_FILE_CHUNK 4096
+
+// Entry of a directory tree found by a walk job.
+typedef struct {
+  // Path relative to the root of the walk
+  char* path;
+  int depth;
+  uv_dirent_type_t type;
+  double size;
+  double mtime_ms;
+} iotjs_fs_walk_entry_t;
+
+
+/* A whole file read or written, a range of an open file allocated, or a
+ * directory tree walked by a single job. The job runs on a worker thread
+ * for the asynchronous calls, so it must not touch the JS engine. */
+typedef struct {
+  uv_loop_t* loop;
+  iotjs_fs_op_t op;
+  char* path;
+  int flags;
+  int mode;
+  // Contents of the file (read), or the data to write
+  iotjs_bufferwrap_t* bufferwrap;
+  size_t length;
+  // Range of an open file (fallocate)
+  int fd;
+  int64_t offset;
+  int64_t range;
+  // Entries of a directory tree (walk)
+  char* pattern;
+  int max_depth;
+  bool with_stats;
+  iotjs_fs_walk_entry_t* entries;
+  size_t count;
+  size_t capacity;
+  // Error of the failed syscall
+  int err;
+  const char* syscall;
+} iotjs_fs_file_job_t;
+
+
+static int fs_file_open(iotjs_fs_file_job_t* job) {
+  uv_fs_t req;
+  int fd = uv_fs_open(job->loop, &req, job->path, job->flags, job->mode, NULL);
+  uv_fs_req_cleanup(&req);
+
+  if (fd < 0) {
+    job->err = fd;
+    job->syscall = "open";
+  }
+  return fd;
+}
+
+
+static void fs_file_close(iotjs_fs_file_job_t* job, int fd) {
+  uv_fs_t req;
+  int err = uv_fs_close(job->loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+
+  if (err < 0 && job->err == 0) {
+    job->err = err;
+    job->syscall = "close";
+  }
+}
+
+
+static void fs_read_file_job(iotjs_fs_file_job_t* job) {
+  int fd = fs_file_open(job);
+  if (fd < 0) {
+    return;
+  }
+
+  uv_fs_t req;
+  int err = uv_fs_fstat(job->loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+
+  if (err < 0) {
+    job->err = err;
+    job->syscall = "fstat";
+    fs_file_close(job, fd);
+    return;
+  }
+
+  size_t size = (size_t)req.statbuf.st_size;
+
+  // The buffer is allocated once with the size of the file
+  size_t capacity = size > 0 ? size : IOTJS_FS_READ_FILE_CHUNK;
+  iotjs_bufferwrap_t* bufferwrap = iotjs_bufferwrap_alloc(capacity);
+  size_t length = 0;
+
+  while (true) {
+    if (length == capacity) {
+      if (size > 0) {
+        break;
+      }
+      capacity *= 2;
+      bufferwrap = iotjs_bufferwrap_realloc(bufferwrap, capacity);
+    }
+
+    size_t chunk = capacity - length;
+    if (chunk > IOTJS_FS_MAX_IO_SIZE) {
+      chunk = IOTJS_FS_MAX_IO_SIZE;
+    }
+
+    uv_buf_t buf =
+        uv_buf_init(bufferwrap->buffer + length, (unsigned int)chunk);
+    int nread = uv_fs_read(job->loop, &req, fd, &buf, 1, -1, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (nread < 0) {
+      job->err = nread;
+      job->syscall = "read";
+      break;
+    }
+
+    if (nread == 0) {
+      break;
+    }
+
+    length += (size_t)nread;
+  }
+
+  fs_file_close(job, fd);
+
+  if (job->err < 0) {
+    IOTJS_RELEASE(bufferwrap);
+    return;
+  }
+
+  if (length != capacity) {
+    bufferwrap = iotjs_bufferwrap_realloc(bufferwrap, length);
+  }
+  job->bufferwrap = bufferwrap;
+  job->length = length;
+}
+
+
+static void fs_write_file_job(iotjs_fs_file_job_t* job) {
+  int fd = fs_file_open(job);
+  if (fd < 0) {
+    return;
+  }
+
+  size_t written = 0;
+
+  while (written < job->length) {
+    size_t chunk = job->length - written;
+    if (chunk > IOTJS_FS_MAX_IO_SIZE) {
+      chunk = IOTJS_FS_MAX_IO_SIZE;
+    }
+
+    uv_fs_t req;
+    uv_buf_t buf =
+        uv_buf_init(job->bufferwrap->buffer + written, (unsigned int)chunk);
+    int nwritten = uv_fs_write(job->loop, &req, fd, &buf, 1, -1, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (nwritten < 0) {
+      job->err = nwritten;
+      job->syscall = "write";
+      break;
+    }
+
+    written += (size_t)nwritten;
+  }
+
+  fs_file_close(job, fd);
+  job->length = written;
+}
+
+
+/* Reserves the disk space of a range of the file, so later writes into
+ * the range do not fail or fragment the file. Without posix_fallocate the
+ * file is only extended to cover the range. */
+static void fs_fallocate_job(iotjs_fs_file_job_t* job) {
+#if defined(__linux__)
+  // off_t is 32 bits wide on 32-bit targets built without large file
+  // support, a range beyond it would be truncated by the cast.
+  const int64_t off_max =
+      sizeof(off_t) < sizeof(int64_t) ? (int64_t)INT32_MAX : INT64_MAX;
+
+  if (job->offset > off_max || job->range > off_max - job->offset) {
+    job->err = UV_EFBIG;
+    job->syscall = "fallocate";
+    return;
+  }
+
+  int err = posix_fallocate(job->fd, (off_t)job->offset, (off_t)job->range);
+
+  if (err != 0) {
+    job->err = -err;
+    job->syscall = "fallocate";
+  }
+#else  /* !__linux__ */
+  int64_t end = job->offset + job->range;
+
+  uv_fs_t req;
+  int err = uv_fs_fstat(job->loop, &req, job->fd, NULL);
+  uv_fs_req_cleanup(&req);
+
+  if (err < 0) {
+    job->err = err;
+    job->syscall = "fstat";
+    return;
+  }
+
+  if ((int64_t)req.statbuf.st_size < end) {
+    err = uv_fs_ftruncate(job->loop, &req, job->fd, end, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (err < 0) {
+      job->err = err;
+      job->syscall = "ftruncate";
+    }
+  }
+#endif /* __linux__ */
+}
+
+
+static char* fs_walk_join(const char* dir, const char* name) {
+  if (dir == NULL) {
+    dir = name;
+    name = NULL;
+  }
+
+  size_t dir_size = strlen(dir);
+  size_t name_size = name != NULL ? strlen(name) + 1 : 0;
+  char* path = iotjs_buffer_allocate(dir_size + name_size + 1);
+
+  memcpy(path, dir, dir_size);
+  if (name != NULL) {
+    path[dir_size] = '/';
+    memcpy(path + dir_size + 1, name, name_size - 1);
+  }
+  return path;
+}
+
+
+static uv_dirent_type_t fs_walk_type_of(uint64_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG:
+      return UV_DIRENT_FILE;
+    case S_IFDIR:
+      return UV_DIRENT_DIR;
+#ifdef S_IFLNK
+    case S_IFLNK:
+      return UV_DIRENT_LINK;
+#endif
+#ifdef S_IFIFO
+    case S_IFIFO:
+      return UV_DIRENT_FIFO;
+#endif
+#ifdef S_IFSOCK
+    case S_IFSOCK:
+      return UV_DIRENT_SOCKET;
+#endif
+    case S_IFCHR:
+      return UV_DIRENT_CHAR;
+#ifdef S_IFBLK
+    case S_IFBLK:
+      return UV_DIRENT_BLOCK;
+#endif
+    default:
+      return UV_DIRENT_UNKNOWN;
+  }
+}
+
+
+/* Matches a path against a glob pattern: '*' and '?' do not match '/',
+ * '**' matches any number of directories. */
+static bool fs_glob_match(const char* pattern, const char* str) {
+  while (*pattern != '\0') {
+    switch (*pattern) {
+      case '*': {
+        bool any_dir = pattern[1] == '*';
+        pattern += any_dir ? 2 : 1;
+
+        // "**/" also matches no directory at all
+        if (any_dir && *pattern == '/' && fs_glob_match(pattern + 1, str)) {
+          return true;
+        }
+
+        while (true) {
+          if (fs_glob_match(pattern, str)) {
+            return true;
+          }
+          if (*str == '\0' || (*str == '/' && !any_dir)) {
+            return false;
+          }
+          str++;
+        }
+      }
+      case '?': {
+        if (*str == '\0' || *str == '/') {
+          return false;
+        }
+        break;
+      }
+      default: {
+        if (*pattern != *str) {
+          return false;
+        }
+        break;
+      }
+    }
+    pattern++;
+    str++;
+  }
+
+  return *str == '\0';
+}
+
+
+// Patterns without a '/' are matched against the name of the entry only.
+static bool fs_walk_match(iotjs_fs_file_job_t* job, const char* path) {
+  if (job->pattern == NULL) {
+    return true;
+  }
+
+  if (strchr(job->pattern, '/') == NULL) {
+    const char* name = strrchr(path, '/');
+    if (name != NULL) {
+      path = name + 1;
+    }
+  }
+  return fs_glob_match(job->pattern, path);
+}
+
+
+static int fs_walk_lstat(iotjs_fs_file_job_t* job, const char* path,
+                         uv_stat_t* statbuf) {
+  char* full_path = fs_walk_join(job->path, path);
+
+  uv_fs_t req;
+  int err = uv_fs_lstat(job->loop, &req, full_path, NULL);
+  *statbuf = req.statbuf;
+  uv_fs_req_cleanup(&req);
+  IOTJS_RELEASE(full_path);
+
+  if (err < 0 && err != UV_ENOENT) {
+    job->err = err;
+    job->syscall = "lstat";
+  }
+  return err;
+}
+
+
+// Appends the entries of a directory (the root when dir is NULL).
+static int fs_walk_scan(iotjs_fs_file_job_t* job, const char* dir,
+                        int depth) {
+  char* dir_path = fs_walk_join(job->path, dir);
+
+  uv_fs_t req;
+  int err = uv_fs_scandir(job->loop, &req, dir_path, 0, NULL);
+  IOTJS_RELEASE(dir_path);
+
+  if (err < 0) {
+    uv_fs_req_cleanup(&req);
+    // A directory removed while the tree is walked is skipped
+    if (err == UV_ENOENT && dir != NULL) {
+      return 0;
+    }
+    job->err = err;
+    job->syscall = "scandir";
+    return err;
+  }
+
+  uv_dirent_t ent;
+  while (uv_fs_scandir_next(&req, &ent) != UV_EOF) {
+    if (job->count == job->capacity) {
+      job->capacity = job->capacity > 0 ? job->capacity * 2 : 64;
+      job->entries = (iotjs_fs_walk_entry_t*)
+          iotjs_buffer_reallocate((char*)job->entries,
+                                  job->capacity *
+                                      sizeof(iotjs_fs_walk_entry_t));
+    }
+
+    iotjs_fs_walk_entry_t* entry = &job->entries[job->count++];
+    entry->path = fs_walk_join(dir, ent.name);
+    entry->depth = depth;
+    entry->type = ent.type;
+    entry->size = 0;
+    entry->mtime_ms = 0;
+
+    // Some file systems do not report the type of the entries
+    if (entry->type == UV_DIRENT_UNKNOWN) {
+      uv_stat_t statbuf;
+      err = fs_walk_lstat(job, entry->path, &statbuf);
+      if (err == 0) {
+        entry->type = fs_walk_type_of(statbuf.st_mode);
+      } else if (err != UV_ENOENT) {
+        break;
+      }
+    }
+  }
+
+  uv_fs_req_cleanup(&req);
+  return job->err;
+}
+
+
+/* Walks the tree below job->path. Entries are appended while directories
+ * are scanned, so visiting them in order walks the tree breadth first
+ * without a separate queue. Only the entries matching the pattern are kept
+ * and stat'ed afterwards. Symbolic links are not followed. */
+static void fs_walk_job(iotjs_fs_file_job_t* job) {
+  if (fs_walk_scan(job, NULL, 0) < 0) {
+    return;
+  }
+
+  for (size_t i = 0; i < job->count; i++) {
+    // The scan may move the entries, so the pointer is not used after it
+    iotjs_fs_walk_entry_t* entry = &job->entries[i];
+    if (entry->type == UV_DIRENT_DIR && entry->depth < job->max_depth &&
+        fs_walk_scan(job, entry->path, entry->depth + 1) < 0) {
+      return;
+    }
+  }
+
+  // The kept entries are moved to the front. Every slot is cleared once its
+  // entry is taken, so job->entries[0..count) always owns the paths.
+  size_t count = 0;
+
+  for (size_t i = 0; i < job->count; i++) {
+    iotjs_fs_walk_entry_t entry = job->entries[i];
+    job->entries[i].path = NULL;
+    bool keep = fs_walk_match(job, entry.path);
+
+    if (keep && job->with_stats) {
+      uv_stat_t statbuf;
+      int err = fs_walk_lstat(job, entry.path, &statbuf);
+      if (err == 0) {
+        entry.size = (double)statbuf.st_size;
+        entry.mtime_ms = (double)statbuf.st_mtim.tv_sec * 1000 +
+                         (double)statbuf.st_mtim.tv_nsec / 1000000;
+      } else if (err == UV_ENOENT) {
+        keep = false;
+      } else {
+        // The entries not visited yet are dropped with the failed one
+        for (size_t j = i; j < job->count; j++) {
+          IOTJS_RELEASE(job->entries[j].path);
+        }
+        IOTJS_RELEASE(entry.path);
+        job->count = count;
+        return;
+      }
+    }
+
+    if (keep) {
+      job->entries[count++] = entry;
+    } else {
+      IOTJS_RELEASE(entry.path);
+    }
+  }
+  job->count = count;
+}
+
+
+// Returns the entries as a flat array of (path, type[, size, mtimeMs]).
+static jerry_value_t fs_walk_result(iotjs_fs_file_job_t* job) {
+  uint32_t stride = job->with_stats ? 4 : 2;
+  jerry_value_t jentries = jerry_create_array((uint32_t)job->count * stride);
+  uint32_t idx = 0;
+
+  for (size_t i = 0; i < job->count; i++) {
+    iotjs_fs_walk_entry_t* entry = &job->entries[i];
+    jerry_value_t jvalue =
+        jerry_create_string((const jerry_char_t*)entry->path);
+    iotjs_jval_set_property_by_index(jentries, idx++, jvalue);
+    jerry_release_value(jvalue);
+
+    jvalue = jerry_create_number(entry->type);
+    iotjs_jval_set_property_by_index(jentries, idx++, jvalue);
+    jerry_release_value(jvalue);
+
+    if (job->with_stats) {
+      jvalue = jerry_create_number(entry->size);
+      iotjs_jval_set_property_by_index(jentries, idx++, jvalue);
+      jerry_release_value(jvalue);
+
+      jvalue = jerry_create_number(entry->mtime_ms);
+      iotjs_jval_set_property_by_index(jentries, idx++, jvalue);
+      jerry_release_value(jvalue);
+    }
+  }
+
+  return jentries;
+}
+
+
+static void fs_file_job_release(iotjs_fs_file_job_t* job) {
+  for (size_t i = 0; i < job->count; i++) {
+    IOTJS_RELEASE(job->entries[i].path);
+  }
+  IOTJS_RELEASE(job->entries);
+  IOTJS_RELEASE(job->pattern);
+  IOTJS_RELEASE(job->path);
+}
+
+
+static jerry_value_t fs_file_job_result(iotjs_fs_file_job_t* job) {
+  if (job->err < 0) {
+    return iotjs_create_uv_exception(job->err, job->syscall);
+  }
+
+  switch (job->op) {
+    case IOTJS_FS_READ:
+      return iotjs_bufferwrap_create_buffer_from(job->bufferwrap);
+    case IOTJS_FS_WRITE:
+      return jerry_create_number((double)job->length);
+    case IOTJS_FS_WALK:
+      return fs_walk_result(job);
+    default:
+      return jerry_create_undefined();
+  }
+}
+
+
+static void fs_file_job_run(iotjs_fs_file_job_t* job) {
+  switch (job->op) {
+    case IOTJS_FS_READ:
+      fs_read_file_job(job);
+      break;
+    case IOTJS_FS_WRITE:
+      fs_write_file_job(job);
+      break;
+    case IOTJS_FS_FALLOCATE:
+      fs_fallocate_job(job);
+      break;
+    case IOTJS_FS_WALK:
+      fs_walk_job(job);
+      break;
+  }
+}
+
+
+static void fs_file_job_worker(uv_work_t* work_req) {
+  fs_file_job_run((iotjs_fs_file_job_t*)IOTJS_UV_REQUEST_EXTRA_DATA(work_req));
+}
+
+
+static void fs_file_job_after_worker(uv_work_t* work_req, int status) {
+  iotjs_fs_file_job_t* job =
+      (iotjs_fs_file_job_t*)IOTJS_UV_REQUEST_EXTRA_DATA(work_req);
+
+  if (status < 0 && job->err == 0) {
+    job->err = status;
+    job->syscall = "uv_queue_work";
+  }
+
+  jerry_value_t jargs[2];
+  size_t jargc = 0;
+  jerry_value_t jresult = fs_file_job_result(job);
+
+  if (job->err < 0) {
+    jargs[jargc++] = jresult;
+  } else {
+    jargs[jargc++] = jerry_create_null();
+    jargs[jargc++] = jresult;
+  }
+
+  if (job->op == IOTJS_FS_WRITE) {
+    jerry_release_value(job->bufferwrap->jobject);
+  }
+  fs_file_job_release(job);
+
+  const jerry_value_t jcallback = *IOTJS_UV_REQUEST_JSCALLBACK(work_req);
+  iotjs_invoke_callback(jcallback, jerry_create_undefined(), jargs, jargc);
+
+  for (size_t i = 0; i < jargc; i++) {
+    jerry_release_value(jargs[i]);
+  }
+
+  iotjs_uv_request_destroy((uv_req_t*)work_req);
+}
+
+
+static jerry_value_t fs_do_file_job(iotjs_fs_file_job_t* job,
+                                    const jerry_value_t jcallback) {
+  uv_loop_t* loop = iotjs_environment_loop(iotjs_environment_get());
+  job->loop = loop;
+
+  if (jerry_value_is_null(jcallback)) {
+    fs_file_job_run(job);
+    jerry_value_t jresult = fs_file_job_result(job);
+    fs_file_job_release(job);
+
+    if (job->err < 0) {
+      return jerry_create_error_from_value(jresult, true);
+    }
+    return jresult;
+  }
+
+  uv_req_t* work_req = iotjs_uv_request_create(sizeof(uv_work_t), jcallback,
+                                               sizeof(iotjs_fs_file_job_t));
+  memcpy(IOTJS_UV_REQUEST_EXTRA_DATA(work_req), job, sizeof(*job));
+
+  if (job->op == IOTJS_FS_WRITE) {
+    // Keeps the data alive while the worker writes it
+    jerry_acquire_value(job->bufferwrap->jobject);
+  }
+
+  uv_queue_work(loop, (uv_work_t*)work_req, fs_file_job_worker,
+                fs_file_job_after_worker);
+  return jerry_create_null();
+}
+
+
+static char* fs_copy_path(iotjs_string_t* path) {
+  size_t size = iotjs_string_size(path);
+  char* copy = iotjs_buffer_allocate(size + 1);
+  memcpy(copy, iotjs_string_data(path), size);
+  iotjs_string_destroy(path);
+  return copy;
+}
+
+
+#if IOTJS_FS_HAS_MMAP
+static void fs_munmap_buffer(void* data) {
+  iotjs_bufferwrap_t* bufferwrap = (iotjs_bufferwrap_t*)data;
+  munmap(bufferwrap->buffer, bufferwrap->length);
+}
+
+
+/* Maps a file into a Buffer. The mapping is private, so writing to the
+ * Buffer copies the touched pages and never changes the file. */
+JS_FUNCTION(Mmap) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, string);
+
+  iotjs_string_t path = JS_GET_ARG(0, string);
+
+  iotjs_fs_file_job_t job = { 0 };
+  job.loop = iotjs_environment_loop(iotjs_environment_get());
+  job.path = fs_copy_path(&path);
+  job.flags = O_RDONLY;
+
+  int fd = fs_file_open(&job);
+  IOTJS_RELEASE(job.path);
+
+  if (fd < 0) {
+    jerry_value_t jerror = iotjs_create_uv_exception(job.err, job.syscall);
+    return jerry_create_error_from_value(jerror, true);
+  }
+
+  uv_fs_t req;
+  int err = uv_fs_fstat(job.loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+
+  size_t size = err < 0 ? 0 : (size_t)req.statbuf.st_size;
+  void* data = NULL;
+
+  // Empty files cannot be mapped
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED) {
+      err = -errno;
+      job.syscall = "mmap";
+    }
+  } else if (err < 0) {
+    job.syscall = "fstat";
+  }
+
+  fs_file_close(&job, fd);
+
+  if (err < 0) {
+    jerry_value_t jerror = iotjs_create_uv_exception(err, job.syscall);
+    return jerry_create_error_from_value(jerror, true);
+  }
+
+  if (size == 0) {
+    return iotjs_bufferwrap_create_buffer(0);
+  }
+
+  iotjs_bufferwrap_t* bufferwrap =
+      iotjs_bufferwrap_alloc_external((char*)data, size);
+  iotjs_bufferwrap_set_external_callback(bufferwrap, fs_munmap_buffer,
+                                         bufferwrap);
+
+  return iotjs_bufferwrap_create_buffer_from(bufferwrap);
+}
+#endif /* IOTJS_FS_HAS_MMAP */
+
+
+JS_FUNCTION(ReadFile) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, string);
+  DJS_CHECK_ARG_IF_EXIST(1, function);
+
+  iotjs_string_t path = JS_GET_ARG(0, string);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(1, function);
+
+  iotjs_fs_file_job_t job = { 0 };
+  job.op = IOTJS_FS_READ;
+  job.path = fs_copy_path(&path);
+  job.flags = O_RDONLY;
+
+  return fs_do_file_job(&job, jcallback);
+}
+
+
+JS_FUNCTION(WriteFile) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(4, string, object, number, number);
+  DJS_CHECK_ARG_IF_EXIST(4, function);
+
+  iotjs_string_t path = JS_GET_ARG(0, string);
+  const jerry_value_t jbuffer = JS_GET_ARG(1, object);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(4, function);
+
+  iotjs_fs_file_job_t job = { 0 };
+  job.op = IOTJS_FS_WRITE;
+  job.path = fs_copy_path(&path);
+  job.flags = JS_GET_ARG(2, number);
+  job.mode = JS_GET_ARG(3, number);
+  job.bufferwrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+  job.length = iotjs_bufferwrap_length(job.bufferwrap);
+
+  return fs_do_file_job(&job, jcallback);
+}
+
+
+JS_FUNCTION(Ftruncate) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, number, number);
+  DJS_CHECK_ARG_IF_EXIST(2, function);
+
+  const iotjs_environment_t* env = iotjs_environment_get();
+
+  int fd = JS_GET_ARG(0, number);
+  double length = JS_GET_ARG(1, number);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(2, function);
+
+  if (!(length >= 0 && length < IOTJS_FS_MAX_POSITION)) {
+    return JS_CREATE_ERROR(RANGE, "length out of bound");
+  }
+
+  jerry_value_t ret_value;
+  if (!jerry_value_is_null(jcallback)) {
+    FS_ASYNC(env, ftruncate, jcallback, fd, (int64_t)length);
+  } else {
+    FS_SYNC(env, ftruncate, fd, (int64_t)length);
+  }
+  return ret_value;
+}
+
+
+JS_FUNCTION(Fsync) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, number);
+  DJS_CHECK_ARG_IF_EXIST(1, function);
+
+  const iotjs_environment_t* env = iotjs_environment_get();
+
+  int fd = JS_GET_ARG(0, number);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(1, function);
+
+  jerry_value_t ret_value;
+  if (!jerry_value_is_null(jcallback)) {
+    FS_ASYNC(env, fsync, jcallback, fd);
+  } else {
+    FS_SYNC(env, fsync, fd);
+  }
+  return ret_value;
+}
+
+
+JS_FUNCTION(Fdatasync) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, number);
+  DJS_CHECK_ARG_IF_EXIST(1, function);
+
+  const iotjs_environment_t* env = iotjs_environment_get();
+
+  int fd = JS_GET_ARG(0, number);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(1, function);
+
+  jerry_value_t ret_value;
+  if (!jerry_value_is_null(jcallback)) {
+    FS_ASYNC(env, fdatasync, jcallback, fd);
+  } else {
+    FS_SYNC(env, fdatasync, fd);
+  }
+  return ret_value;
+}
+
+
+JS_FUNCTION(Fallocate) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(3, number, number, number);
+  DJS_CHECK_ARG_IF_EXIST(3, function);
+
+  double offset = JS_GET_ARG(1, number);
+  double length = JS_GET_ARG(2, number);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(3, function);
+
+  if (!(offset >= 0 && length > 0 &&
+        offset + length < IOTJS_FS_MAX_POSITION)) {
+    return JS_CREATE_ERROR(RANGE, "range out of bound");
+  }
+
+  iotjs_fs_file_job_t job = { 0 };
+  job.op = IOTJS_FS_FALLOCATE;
+  job.fd = JS_GET_ARG(0, number);
+  job.offset = (int64_t)offset;
+  job.range = (int64_t)length;
+
+  return fs_do_file_job(&job, jcallback);
+}
+
+
 jerry_value_t MakeStatObject(uv_stat_t* statbuf) {
   const jerry_value_t fs = iotjs_module_get("fs");
 
@@ -273,22 +1232,9 @@ jerry_value_t MakeStatObject(uv_stat_t* statbuf) {
 
   jerry_release_value(stat_prototype);
 
-
-#define X(statobj, name) \
-  iotjs_jval_set_property_number(statobj, #name, statbuf->st_##name);
-
-  X(jstat, dev)
-  X(jstat, mode)
-  X(jstat, nlink)
-  X(jstat, uid)
-  X(jstat, gid)
-  X(jstat, rdev)
-  X(jstat, blksize)
-  X(jstat, ino)
-  X(jstat, size)
-  X(jstat, blocks)
-
-#undef X
+  iotjs_fs_stats_t* stats = IOTJS_ALLOC(iotjs_fs_stats_t);
+  stats->statbuf = *statbuf;
+  jerry_set_object_native_pointer(jstat, stats, &this_module_native_info);
 
   return jstat;
 }
@@ -448,28 +1394,205 @@ JS_FUNCTION(ReadDir) {
   return ret_value;
 }
 
-static jerry_value_t StatsIsTypeOf(jerry_value_t stats, int type) {
-  jerry_value_t mode = iotjs_jval_get_property(stats, IOTJS_MAGIC_STRING_MODE);
+JS_FUNCTION(Walk) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(4, string, string, number, boolean);
+  DJS_CHECK_ARG_IF_EXIST(4, function);
 
-  int mode_number = (int)iotjs_jval_as_number(mode);
+  iotjs_string_t path = JS_GET_ARG(0, string);
+  iotjs_string_t pattern = JS_GET_ARG(1, string);
+  double max_depth = JS_GET_ARG(2, number);
+  const jerry_value_t jcallback = JS_GET_ARG_IF_EXIST(4, function);
+
+  iotjs_fs_file_job_t job = { 0 };
+  job.op = IOTJS_FS_WALK;
+  job.path = fs_copy_path(&path);
+  if (iotjs_string_is_empty(&pattern)) {
+    iotjs_string_destroy(&pattern);
+  } else {
+    job.pattern = fs_copy_path(&pattern);
+  }
+  job.max_depth = max_depth < INT_MAX ? (int)max_depth : INT_MAX;
+  job.with_stats = JS_GET_ARG(3, boolean);
+
+  return fs_do_file_job(&job, jcallback);
+}
+
+
+#define X(name)                                                   \
+  JS_FUNCTION(StatsGet_##name) {                                  \
+    JS_DECLARE_THIS_PTR(fs_stats, stats);                         \
+    return jerry_create_number((double)stats->statbuf.st_##name); \
+  }
+
+IOTJS_FS_STATS_FIELDS(X)
+
+#undef X
+
+static double StatsTimeMs(const uv_timespec_t* time) {
+  return (double)time->tv_sec * 1000 + (double)time->tv_nsec / 1000000;
+}
+
+#define X(name, field)                                                   \
+  JS_FUNCTION(StatsGet_##name##Ms) {                                     \
+    JS_DECLARE_THIS_PTR(fs_stats, stats);                                \
+    return jerry_create_number(StatsTimeMs(&stats->statbuf.st_##field)); \
+  }
+
+IOTJS_FS_STATS_TIMES(X)
 
-  jerry_release_value(mode);
+#undef X
 
-  return jerry_create_boolean((mode_number & S_IFMT) == type);
+static jerry_value_t StatsIsTypeOf(const jerry_value_t jthis, int type) {
+  JS_DECLARE_THIS_PTR(fs_stats, stats);
+  return jerry_create_boolean((stats->statbuf.st_mode & S_IFMT) == type);
 }
 
 JS_FUNCTION(StatsIsDirectory) {
   DJS_CHECK_THIS();
-  jerry_value_t stats = JS_GET_THIS();
-  return StatsIsTypeOf(stats, S_IFDIR);
+  return StatsIsTypeOf(jthis, S_IFDIR);
 }
 
 JS_FUNCTION(StatsIsFile) {
   DJS_CHECK_THIS();
-  jerry_value_t stats = JS_GET_THIS();
-  return StatsIsTypeOf(stats, S_IFREG);
+  return StatsIsTypeOf(jthis, S_IFREG);
+}
+
+// The fields are getters of the prototype, JSON.stringify gets them from
+// a plain object instead.
+JS_FUNCTION(StatsToJSON) {
+  JS_DECLARE_THIS_PTR(fs_stats, stats);
+  jerry_value_t jstats = jerry_create_object();
+
+#define X(name)                                 \
+  iotjs_jval_set_property_number(jstats, #name, \
+                                 (double)stats->statbuf.st_##name);
+  IOTJS_FS_STATS_FIELDS(X)
+#undef X
+
+#define X(name, field)                               \
+  iotjs_jval_set_property_number(jstats, #name "Ms", \
+                                 StatsTimeMs(&stats->statbuf.st_##field));
+  IOTJS_FS_STATS_TIMES(X)
+#undef X
+
+  return jstats;
+}
+
+
+// The handle memory is released when the handle is closed.
+static const jerry_object_native_info_t fs_event_native_info = { NULL };
+
+
+static uv_handle_t* FsEventHandle(const jerry_value_t jobject) {
+  uv_handle_t* handle = NULL;
+  if (!jerry_get_object_native_pointer(jobject, (void**)&handle,
+                                       &fs_event_native_info)) {
+    return NULL;
+  }
+  return handle;
+}
+
+
+static void OnFsEvent(uv_fs_event_t* handle, const char* filename, int events,
+                      int status) {
+  jerry_value_t jwatcher = IOTJS_UV_HANDLE_DATA(handle)->jobject;
+  jerry_value_t jonchange =
+      iotjs_jval_get_property(jwatcher, IOTJS_MAGIC_STRING_ONCHANGE);
+
+  if (!jerry_value_is_function(jonchange)) {
+    jerry_release_value(jonchange);
+    return;
+  }
+
+  jerry_value_t jargs[3];
+  size_t jargc = 0;
+
+  if (status < 0) {
+    jargs[jargc++] = iotjs_create_uv_exception(status, "watch");
+  } else {
+    const char* type = (events & UV_RENAME) ? IOTJS_MAGIC_STRING_RENAME
+                                            : IOTJS_MAGIC_STRING_CHANGE;
+    jargs[jargc++] = jerry_create_null();
+    jargs[jargc++] = jerry_create_string((const jerry_char_t*)type);
+    jargs[jargc++] = filename != NULL
+                         ? jerry_create_string((const jerry_char_t*)filename)
+                         : jerry_create_null();
+  }
+
+  iotjs_invoke_callback(jonchange, jwatcher, jargs, jargc);
+
+  for (size_t i = 0; i < jargc; i++) {
+    jerry_release_value(jargs[i]);
+  }
+  jerry_release_value(jonchange);
+}
+
+
+JS_FUNCTION(FsEvent) {
+  DJS_CHECK_THIS();
+
+  const jerry_value_t jwatcher = JS_GET_THIS();
+  uv_handle_t* handle = iotjs_uv_handle_create(sizeof(uv_fs_event_t), jwatcher,
+                                               &fs_event_native_info, 0);
+
+  const iotjs_environment_t* env = iotjs_environment_get();
+  uv_fs_event_init(iotjs_environment_loop(env), (uv_fs_event_t*)handle);
+
+  return jerry_create_undefined();
 }
 
+
+JS_FUNCTION(FsEventStart) {
+  DJS_CHECK_ARGS(2, string, boolean);
+
+  uv_handle_t* handle = FsEventHandle(jthis);
+  if (handle == NULL) {
+    return JS_CREATE_ERROR(COMMON, "Internal");
+  }
+
+  iotjs_string_t path = JS_GET_ARG(0, string);
+  unsigned int flags = JS_GET_ARG(1, boolean) ? UV_FS_EVENT_RECURSIVE : 0;
+
+  int err = uv_fs_event_start((uv_fs_event_t*)handle, OnFsEvent,
+                              iotjs_string_data(&path), flags);
+  iotjs_string_destroy(&path);
+
+  if (err < 0) {
+    jerry_value_t jerror = iotjs_create_uv_exception(err, "watch");
+    return jerry_create_error_from_value(jerror, true);
+  }
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(FsEventClose) {
+  uv_handle_t* handle = FsEventHandle(jthis);
+  if (handle != NULL) {
+    iotjs_uv_handle_close(handle, NULL);
+  }
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(FsEventRef) {
+  uv_handle_t* handle = FsEventHandle(jthis);
+  if (handle != NULL) {
+    uv_ref(handle);
+  }
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(FsEventUnref) {
+  uv_handle_t* handle = FsEventHandle(jthis);
+  if (handle != NULL) {
+    uv_unref(handle);
+  }
+  return jerry_create_undefined();
+}
+
+
 jerry_value_t InitFs(void) {
   jerry_value_t fs = jerry_create_object();
 
@@ -477,6 +1600,17 @@ jerry_value_t InitFs(void) {
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_OPEN, Open);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_READ, Read);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_WRITE, Write);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_READV, Readv);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_WRITEV, Writev);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_READFILE, ReadFile);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_FTRUNCATE, Ftruncate);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_FSYNC, Fsync);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_FDATASYNC, Fdatasync);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_FALLOCATE, Fallocate);
+#if IOTJS_FS_HAS_MMAP
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_MMAP, Mmap);
+#endif
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_WRITEFILE, WriteFile);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_STAT, Stat);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_FSTAT, Fstat);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_MKDIR, MkDir);
@@ -484,6 +1618,7 @@ jerry_value_t InitFs(void) {
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_UNLINK, Unlink);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_RENAME, Rename);
   iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_READDIR, ReadDir);
+  iotjs_jval_set_method(fs, IOTJS_MAGIC_STRING_WALK, Walk);
 
   jerry_value_t stats_prototype = jerry_create_object();
 
@@ -491,9 +1626,38 @@ jerry_value_t InitFs(void) {
                         StatsIsDirectory);
   iotjs_jval_set_method(stats_prototype, IOTJS_MAGIC_STRING_ISFILE,
                         StatsIsFile);
+  iotjs_jval_set_method(stats_prototype, IOTJS_MAGIC_STRING_TOJSON,
+                        StatsToJSON);
+
+#define X(name) iotjs_jval_set_getter(stats_prototype, #name, StatsGet_##name);
+  IOTJS_FS_STATS_FIELDS(X)
+#undef X
+
+#define X(name, field) \
+  iotjs_jval_set_getter(stats_prototype, #name "Ms", StatsGet_##name##Ms);
+  IOTJS_FS_STATS_TIMES(X)
+#undef X
 
   iotjs_jval_set_property_jval(fs, IOTJS_MAGIC_STRING_STATS, stats_prototype);
   jerry_release_value(stats_prototype);
 
+  jerry_value_t fs_event = jerry_create_external_function(FsEvent);
+  jerry_value_t fs_event_prototype = jerry_create_object();
+  iotjs_jval_set_property_jval(fs_event, IOTJS_MAGIC_STRING_PROTOTYPE,
+                               fs_event_prototype);
+
+  iotjs_jval_set_method(fs_event_prototype, IOTJS_MAGIC_STRING_START,
+                        FsEventStart);
+  iotjs_jval_set_method(fs_event_prototype, IOTJS_MAGIC_STRING_CLOSE,
+                        FsEventClose);
+  iotjs_jval_set_method(fs_event_prototype, IOTJS_MAGIC_STRING_REF,
+                        FsEventRef);
+  iotjs_jval_set_method(fs_event_prototype, IOTJS_MAGIC_STRING_UNREF,
+                        FsEventUnref);
+
+  iotjs_jval_set_property_jval(fs, IOTJS_MAGIC_STRING_FSEVENT, fs_event);
+  jerry_release_value(fs_event_prototype);
+  jerry_release_value(fs_event);
+
   return fs;
 }
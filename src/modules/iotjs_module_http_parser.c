@@ -32,6 +32,51 @@
 // Increase this to minimize inter JS-C call
 #define HEADER_MAX 10
 
+// Maximum number of `:name` parameters a single route pattern may contain.
+#define HTTP_ROUTE_MAX_PARAMS 8
+
+// Matches any http-parser method when used as the method of a route.
+#define HTTP_ROUTE_ANY_METHOD -1
+
+
+typedef enum {
+  HTTP_ROUTE_LITERAL = 0,
+  HTTP_ROUTE_PARAM = 1,
+  HTTP_ROUTE_WILDCARD = 2
+} iotjs_http_route_kind_t;
+
+
+typedef struct iotjs_http_route_handler_s iotjs_http_route_handler_t;
+typedef struct iotjs_http_route_node_s iotjs_http_route_node_t;
+
+struct iotjs_http_route_handler_s {
+  int method;
+  uint32_t id;
+  iotjs_http_route_handler_t* next;
+};
+
+// A node of the route trie represents one path segment. Children are kept
+// ordered by kind so literal segments are always tried before parameters
+// and parameters before the trailing wildcard.
+struct iotjs_http_route_node_s {
+  iotjs_http_route_kind_t kind;
+  char* segment;
+  size_t segment_len;
+  iotjs_http_route_node_t* children;
+  iotjs_http_route_node_t* next;
+  iotjs_http_route_handler_t* handlers;
+};
+
+typedef struct {
+  iotjs_http_route_node_t root;
+} iotjs_http_router_t;
+
+typedef struct {
+  const iotjs_http_route_node_t* node;
+  const char* at;
+  size_t length;
+} iotjs_http_route_capture_t;
+
 
 typedef struct {
   jerry_value_t jobject;
@@ -51,6 +96,10 @@ typedef struct {
   size_t cur_buf_len;
 
   bool flushed;
+
+  iotjs_http_router_t* router;
+  int route_id;
+  jerry_value_t jroute_params;
 } iotjs_http_parserwrap_t;
 
 
@@ -68,6 +117,291 @@ static void iotjs_http_parserwrap_initialize(
   http_parserwrap->cur_jbuf = jerry_create_null();
   http_parserwrap->cur_buf = NULL;
   http_parserwrap->cur_buf_len = 0;
+  http_parserwrap->route_id = -1;
+  http_parserwrap->jroute_params = jerry_create_undefined();
+}
+
+
+static void iotjs_http_router_destroy(iotjs_http_router_t* router);
+
+static const jerry_object_native_info_t http_router_native_info = {
+  .free_cb = (jerry_object_native_free_callback_t)iotjs_http_router_destroy
+};
+
+
+static void iotjs_http_route_node_free(iotjs_http_route_node_t* node) {
+  iotjs_http_route_node_t* child = node->children;
+  while (child != NULL) {
+    iotjs_http_route_node_t* next = child->next;
+    iotjs_http_route_node_free(child);
+    IOTJS_RELEASE(child);
+    child = next;
+  }
+
+  iotjs_http_route_handler_t* handler = node->handlers;
+  while (handler != NULL) {
+    iotjs_http_route_handler_t* next = handler->next;
+    IOTJS_RELEASE(handler);
+    handler = next;
+  }
+
+  IOTJS_RELEASE(node->segment);
+}
+
+
+static void iotjs_http_router_destroy(iotjs_http_router_t* router) {
+  iotjs_http_route_node_free(&router->root);
+  IOTJS_RELEASE(router);
+}
+
+
+static iotjs_http_route_node_t* iotjs_http_route_node_child(
+    iotjs_http_route_node_t* parent, iotjs_http_route_kind_t kind,
+    const char* segment, size_t segment_len) {
+  iotjs_http_route_node_t** link = &parent->children;
+
+  while (*link != NULL && (*link)->kind <= kind) {
+    iotjs_http_route_node_t* node = *link;
+    if (node->kind == kind && node->segment_len == segment_len &&
+        memcmp(node->segment, segment, segment_len) == 0) {
+      return node;
+    }
+    link = &node->next;
+  }
+
+  iotjs_http_route_node_t* node = IOTJS_ALLOC(iotjs_http_route_node_t);
+  node->kind = kind;
+  node->segment = iotjs_buffer_allocate(segment_len + 1);
+  memcpy(node->segment, segment, segment_len);
+  node->segment_len = segment_len;
+  node->next = *link;
+  *link = node;
+  return node;
+}
+
+
+// Inserts `path` into the trie. Segments starting with ':' are named
+// parameters, a final '*' segment matches the rest of the path.
+static bool iotjs_http_router_add(iotjs_http_router_t* router, int method,
+                                  const char* path, size_t path_len,
+                                  uint32_t id) {
+  iotjs_http_route_node_t* node = &router->root;
+  const char* end = path + path_len;
+  const char* p = path;
+  size_t n_params = 0;
+
+  if (p == end || *p != '/') {
+    return false;
+  }
+
+  while (p < end) {
+    // Skip the separator, an empty trailing segment maps to the parent.
+    p++;
+    if (p == end) {
+      break;
+    }
+
+    const char* seg_end = memchr(p, '/', (size_t)(end - p));
+    if (seg_end == NULL) {
+      seg_end = end;
+    }
+    size_t seg_len = (size_t)(seg_end - p);
+
+    if (seg_len == 0) {
+      return false;
+    }
+
+    if (*p == ':') {
+      if (seg_len == 1 || ++n_params > HTTP_ROUTE_MAX_PARAMS) {
+        return false;
+      }
+      node = iotjs_http_route_node_child(node, HTTP_ROUTE_PARAM, p + 1,
+                                         seg_len - 1);
+    } else if (*p == '*' && seg_len == 1) {
+      if (seg_end != end) {
+        return false;
+      }
+      node = iotjs_http_route_node_child(node, HTTP_ROUTE_WILDCARD, p, 1);
+    } else {
+      node = iotjs_http_route_node_child(node, HTTP_ROUTE_LITERAL, p, seg_len);
+    }
+
+    p = seg_end;
+  }
+
+  iotjs_http_route_handler_t** link = &node->handlers;
+  while (*link != NULL) {
+    if ((*link)->method == method) {
+      // Re-registering a route replaces the previous handler.
+      (*link)->id = id;
+      return true;
+    }
+    link = &(*link)->next;
+  }
+
+  iotjs_http_route_handler_t* handler = IOTJS_ALLOC(iotjs_http_route_handler_t);
+  handler->method = method;
+  handler->id = id;
+  *link = handler;
+  return true;
+}
+
+
+static int iotjs_http_route_node_handler(const iotjs_http_route_node_t* node,
+                                         int method) {
+  int id = -1;
+  for (iotjs_http_route_handler_t* handler = node->handlers; handler != NULL;
+       handler = handler->next) {
+    if (handler->method == method) {
+      return (int)handler->id;
+    }
+    if (handler->method == HTTP_ROUTE_ANY_METHOD) {
+      id = (int)handler->id;
+    }
+  }
+  return id;
+}
+
+
+// Matches the remaining path `p` (starting at a '/' or at the end) against
+// the children of `node`. Returns the route id or -1.
+static int iotjs_http_route_match(const iotjs_http_route_node_t* node,
+                                  const char* p, const char* end, int method,
+                                  iotjs_http_route_capture_t* captures,
+                                  size_t* n_captures) {
+  if (p == end || (p + 1 == end && *p == '/')) {
+    int id = iotjs_http_route_node_handler(node, method);
+    if (id >= 0) {
+      return id;
+    }
+  }
+
+  if (p == end) {
+    return -1;
+  }
+
+  IOTJS_ASSERT(*p == '/');
+  p++;
+
+  const char* seg_end = memchr(p, '/', (size_t)(end - p));
+  if (seg_end == NULL) {
+    seg_end = end;
+  }
+  size_t seg_len = (size_t)(seg_end - p);
+  size_t n_saved = *n_captures;
+
+  for (const iotjs_http_route_node_t* child = node->children; child != NULL;
+       child = child->next) {
+    int id = -1;
+
+    switch (child->kind) {
+      case HTTP_ROUTE_LITERAL:
+        if (child->segment_len == seg_len &&
+            memcmp(child->segment, p, seg_len) == 0) {
+          id = iotjs_http_route_match(child, seg_end, end, method, captures,
+                                      n_captures);
+        }
+        break;
+      case HTTP_ROUTE_PARAM:
+        if (seg_len > 0) {
+          captures[n_saved].node = child;
+          captures[n_saved].at = p;
+          captures[n_saved].length = seg_len;
+          *n_captures = n_saved + 1;
+          id = iotjs_http_route_match(child, seg_end, end, method, captures,
+                                      n_captures);
+        }
+        break;
+      case HTTP_ROUTE_WILDCARD:
+        id = iotjs_http_route_node_handler(child, method);
+        if (id >= 0) {
+          captures[n_saved].node = child;
+          captures[n_saved].at = p;
+          captures[n_saved].length = (size_t)(end - p);
+          *n_captures = n_saved + 1;
+        }
+        break;
+    }
+
+    if (id >= 0) {
+      return id;
+    }
+    *n_captures = n_saved;
+  }
+
+  return -1;
+}
+
+
+// Matches the url collected so far against the attached router, before any
+// JS string is created for it, and keeps the extracted parameters until
+// the headers complete callback hands them to JS.
+static void iotjs_http_parserwrap_route(
+    iotjs_http_parserwrap_t* http_parserwrap) {
+  if (http_parserwrap->router == NULL ||
+      http_parserwrap->parser.type != HTTP_REQUEST ||
+      http_parserwrap->route_id >= 0) {
+    return;
+  }
+
+  const char* url = iotjs_string_data(&http_parserwrap->url);
+  const char* end = url + iotjs_string_size(&http_parserwrap->url);
+
+  // Only the path takes part in the match.
+  for (const char* p = url; p < end; p++) {
+    if (*p == '?' || *p == '#') {
+      end = p;
+      break;
+    }
+  }
+
+  if (url == end || *url != '/') {
+    return;
+  }
+
+  iotjs_http_route_capture_t captures[HTTP_ROUTE_MAX_PARAMS + 1];
+  size_t n_captures = 0;
+  int id = iotjs_http_route_match(&http_parserwrap->router->root, url, end,
+                                  (int)http_parserwrap->parser.method,
+                                  captures, &n_captures);
+  if (id < 0) {
+    return;
+  }
+
+  jerry_value_t jparams = jerry_create_object();
+  for (size_t i = 0; i < n_captures; i++) {
+    const iotjs_http_route_node_t* node = captures[i].node;
+    jerry_value_t jname =
+        jerry_create_string_sz((const jerry_char_t*)node->segment,
+                               node->segment_len);
+    jerry_value_t jvalue =
+        jerry_create_string_sz((const jerry_char_t*)captures[i].at,
+                               captures[i].length);
+    jerry_release_value(jerry_set_property(jparams, jname, jvalue));
+    jerry_release_value(jname);
+    jerry_release_value(jvalue);
+  }
+
+  http_parserwrap->route_id = id;
+  jerry_release_value(http_parserwrap->jroute_params);
+  http_parserwrap->jroute_params = jparams;
+}
+
+
+// Hands the matched route and its parameters over to the info object.
+static void iotjs_http_parserwrap_take_route(
+    iotjs_http_parserwrap_t* http_parserwrap, jerry_value_t info) {
+  if (http_parserwrap->route_id < 0) {
+    return;
+  }
+
+  iotjs_jval_set_property_number(info, IOTJS_MAGIC_STRING_ROUTE,
+                                 http_parserwrap->route_id);
+  iotjs_jval_set_property_jval(info, IOTJS_MAGIC_STRING_PARAMS,
+                               http_parserwrap->jroute_params);
+  jerry_release_value(http_parserwrap->jroute_params);
+  http_parserwrap->jroute_params = jerry_create_undefined();
+  http_parserwrap->route_id = -1;
 }
 
 
@@ -88,6 +422,7 @@ static void iotjs_http_parserwrap_create(const jerry_value_t jparser,
     http_parserwrap->fields[i] = iotjs_string_create();
     http_parserwrap->values[i] = iotjs_string_create();
   }
+  http_parserwrap->router = NULL;
 
   iotjs_http_parserwrap_initialize(http_parserwrap, type);
   http_parserwrap->parser.data = http_parserwrap;
@@ -104,6 +439,7 @@ static void iotjs_http_parserwrap_destroy(
     iotjs_string_destroy(&http_parserwrap->fields[i]);
     iotjs_string_destroy(&http_parserwrap->values[i]);
   }
+  jerry_release_value(http_parserwrap->jroute_params);
 
   IOTJS_RELEASE(http_parserwrap);
 }
@@ -137,6 +473,7 @@ static void iotjs_http_parserwrap_flush(
 
   if (http_parserwrap->parser.type == HTTP_REQUEST &&
       !iotjs_string_is_empty(&http_parserwrap->url)) {
+    iotjs_http_parserwrap_route(http_parserwrap);
     argv[argc++] = iotjs_jval_create_string(&http_parserwrap->url);
   }
 
@@ -166,6 +503,9 @@ static int iotjs_http_parserwrap_on_message_begin(http_parser* parser) {
       (iotjs_http_parserwrap_t*)(parser->data);
   iotjs_string_destroy(&http_parserwrap->url);
   iotjs_string_destroy(&http_parserwrap->status_msg);
+  jerry_release_value(http_parserwrap->jroute_params);
+  http_parserwrap->jroute_params = jerry_create_undefined();
+  http_parserwrap->route_id = -1;
   return 0;
 }
 
@@ -257,6 +597,7 @@ static int iotjs_http_parserwrap_on_headers_complete(http_parser* parser) {
     jerry_release_value(jheader);
     if (http_parserwrap->parser.type == HTTP_REQUEST) {
       IOTJS_ASSERT(!iotjs_string_is_empty(&http_parserwrap->url));
+      iotjs_http_parserwrap_route(http_parserwrap);
       iotjs_jval_set_property_string(info, IOTJS_MAGIC_STRING_URL,
                                      &http_parserwrap->url);
     }
@@ -268,8 +609,12 @@ static int iotjs_http_parserwrap_on_headers_complete(http_parser* parser) {
     iotjs_jval_set_property_number(info, IOTJS_MAGIC_STRING_METHOD,
                                    http_parserwrap->parser.method);
   }
+
+  // Matched route
+  iotjs_http_parserwrap_take_route(http_parserwrap, info);
+
   // Status
-  else if (http_parserwrap->parser.type == HTTP_RESPONSE) {
+  if (http_parserwrap->parser.type == HTTP_RESPONSE) {
     iotjs_jval_set_property_number(info, IOTJS_MAGIC_STRING_STATUS,
                                    http_parserwrap->parser.status_code);
     iotjs_jval_set_property_string(info, IOTJS_MAGIC_STRING_STATUS_MSG,
@@ -436,6 +781,57 @@ JS_FUNCTION(Resume) {
 }
 
 
+JS_FUNCTION(SetRouter) {
+  JS_DECLARE_THIS_PTR(http_parserwrap, parser);
+  DJS_CHECK_ARGS(1, object);
+
+  iotjs_http_router_t* router = NULL;
+  if (!jerry_get_object_native_pointer(jargv[0], (void**)&router,
+                                       &http_router_native_info)) {
+    return JS_CREATE_ERROR(TYPE, "Invalid router");
+  }
+
+  parser->router = router;
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(HTTPRouterAdd) {
+  DJS_CHECK_ARGS(3, number, string, number);
+
+  iotjs_http_router_t* router = NULL;
+  if (!jerry_get_object_native_pointer(jthis, (void**)&router,
+                                       &http_router_native_info)) {
+    return JS_CREATE_ERROR(COMMON, "Internal");
+  }
+
+  int method = (int)JS_GET_ARG(0, number);
+  iotjs_string_t path = JS_GET_ARG(1, string);
+  uint32_t id = (uint32_t)JS_GET_ARG(2, number);
+
+  bool ok = iotjs_http_router_add(router, method, iotjs_string_data(&path),
+                                  iotjs_string_size(&path), id);
+  iotjs_string_destroy(&path);
+
+  if (!ok) {
+    return JS_CREATE_ERROR(TYPE, "Invalid route path");
+  }
+
+  return jerry_create_undefined();
+}
+
+
+JS_FUNCTION(HTTPRouterCons) {
+  DJS_CHECK_THIS();
+
+  iotjs_http_router_t* router = IOTJS_ALLOC(iotjs_http_router_t);
+  jerry_set_object_native_pointer(JS_GET_THIS(), router,
+                                  &http_router_native_info);
+
+  return jerry_create_undefined();
+}
+
+
 JS_FUNCTION(HTTPParserCons) {
   DJS_CHECK_THIS();
   DJS_CHECK_ARGS(1, number);
@@ -489,6 +885,7 @@ jerry_value_t InitHttpParser(void) {
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_FINISH, Finish);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_PAUSE, Pause);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_RESUME, Resume);
+  iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_SETROUTER, SetRouter);
 
   iotjs_jval_set_property_jval(jParserCons, IOTJS_MAGIC_STRING_PROTOTYPE,
                                prototype);
@@ -496,5 +893,20 @@ jerry_value_t InitHttpParser(void) {
   jerry_release_value(jParserCons);
   jerry_release_value(prototype);
 
+  jerry_value_t jRouterCons = jerry_create_external_function(HTTPRouterCons);
+  iotjs_jval_set_property_jval(http_parser, IOTJS_MAGIC_STRING_HTTPROUTER,
+                               jRouterCons);
+  iotjs_jval_set_property_number(jRouterCons, IOTJS_MAGIC_STRING_ANY_U,
+                                 HTTP_ROUTE_ANY_METHOD);
+
+  jerry_value_t router_prototype = jerry_create_object();
+  iotjs_jval_set_method(router_prototype, IOTJS_MAGIC_STRING_ADD,
+                        HTTPRouterAdd);
+  iotjs_jval_set_property_jval(jRouterCons, IOTJS_MAGIC_STRING_PROTOTYPE,
+                               router_prototype);
+
+  jerry_release_value(jRouterCons);
+  jerry_release_value(router_prototype);
+
   return http_parser;
 }
@@ -22,8 +22,18 @@
 
 IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(mqttclient);
 
+static void iotjs_mqtt_filter_release(iotjs_mqtt_topic_node_t *node);
+
 static void iotjs_mqttclient_destroy(iotjs_mqttclient_t *mqttclient) {
-  IOTJS_RELEASE(mqttclient->buffer);
+  IOTJS_RELEASE(mqttclient->buffer.data);
+  iotjs_mqtt_filter_release(mqttclient->filters);
+  IOTJS_RELEASE(mqttclient->window.entries);
+  iotjs_mqtt_spool_close(mqttclient->spool);
+
+  for (uint16_t i = 0; i < mqttclient->topic_alias_maximum; i++) {
+    IOTJS_RELEASE(mqttclient->topic_aliases[i].data);
+  }
+  IOTJS_RELEASE(mqttclient->topic_aliases);
   IOTJS_RELEASE(mqttclient);
 }
 
@@ -54,44 +64,48 @@ static uint8_t *iotjs_encode_remaining_length(unsigned char *buffer,
 
 static size_t get_remaining_length_size(uint32_t len) {
   uint8_t n = 0;
-  while (len != 0) {
+  do {
     len >>= 7;
     n++;
-  }
+  } while (len != 0);
 
   return n;
 }
 
 
-static uint32_t iotjs_decode_remaining_length(char *buffer,
-                                              uint32_t *out_length) {
-  // There must be at least 2 bytes to decode
-  uint32_t c = (uint32_t)(*buffer);
-  uint32_t decoded_length = (c & 0x7F);
-  uint32_t length = 1;
-  uint32_t shift = 7;
+// Decodes the fixed header at the start of `data`. Returns with 1 and sets
+// the header and the remaining length if the header is complete, with 0 if
+// more data is needed, and with -1 if the header is malformed.
+static int iotjs_mqtt_decode_fixed_header(const char *data, size_t size,
+                                          uint32_t *header_size,
+                                          uint32_t *remaining_length) {
+  uint32_t decoded_length = 0;
+  uint32_t shift = 0;
+
+  for (size_t i = 1; i < size; i++) {
+    uint32_t c = (uint8_t)data[i];
+    decoded_length |= (c & 0x7F) << shift;
+
+    if ((c & 0x80) == 0) {
+      if (c == 0 && i > 1) {
+        // The length must be encoded with the least amount of bytes.
+        // This rule is not fulfilled if the last byte is zero.
+        return -1;
+      }
 
-  buffer++;
+      *header_size = (uint32_t)i + 1;
+      *remaining_length = decoded_length;
+      return 1;
+    }
 
-  do {
-    if (++length > IOTJS_MODULE_MQTT_MAX_REMAINING_LENGTH_BYTES) {
-      return 0;
+    if (i >= IOTJS_MODULE_MQTT_MAX_REMAINING_LENGTH_BYTES) {
+      return -1;
     }
-    c = (uint32_t)(*buffer);
-    decoded_length += (c & 0x7F) << shift;
 
     shift += 7;
-    buffer++;
-  } while ((c & 0x80) != 0);
-
-  if (c == 0) {
-    // The length must be encoded with the least amount of bytes.
-    // This rule is not fulfilled if the last byte is zero.
-    return 0;
   }
 
-  *out_length = length;
-  return decoded_length;
+  return 0;
 }
 
 
@@ -109,8 +123,204 @@ static uint8_t *iotjs_mqtt_string_serialize(uint8_t *dst_buffer,
   return (dst_buffer + 2 + src_buffer->length);
 }
 
+// Writes the length field and the encoded properties of MQTT 5 packets.
+static uint8_t *iotjs_mqtt_properties_serialize(
+    uint8_t *dst_buffer, const iotjs_mqtt_buffer_t *properties) {
+  dst_buffer =
+      iotjs_encode_remaining_length(dst_buffer, (uint32_t)properties->length);
+
+  if (properties->length > 0) {
+    memcpy(dst_buffer, properties->data, properties->length);
+  }
+
+  return dst_buffer + properties->length;
+}
+
+
+// Returns with the length of the first level of `topic`.
+static size_t iotjs_mqtt_level_length(const char *topic, size_t length) {
+  const char *end = memchr(topic, '/', length);
+  return end != NULL ? (size_t)(end - topic) : length;
+}
+
+
+static bool iotjs_mqtt_level_equals(const iotjs_mqtt_topic_node_t *node,
+                                    const char *level, size_t length) {
+  return node->length == length && memcmp(node->level, level, length) == 0;
+}
+
+
+static bool iotjs_mqtt_is_wildcard(const iotjs_mqtt_topic_node_t *node,
+                                   char wildcard) {
+  return node->length == 1 && node->level[0] == wildcard;
+}
+
+
+static bool iotjs_mqtt_filter_is_valid(const char *filter, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (filter[i] != '+' && filter[i] != '#') {
+      continue;
+    }
+
+    // Wildcards must occupy an entire level, '#' must be the last one.
+    if (i > 0 && filter[i - 1] != '/') {
+      return false;
+    }
+
+    if (i + 1 < length && (filter[i] == '#' || filter[i + 1] != '/')) {
+      return false;
+    }
+  }
+
+  return length > 0;
+}
+
+
+// Sets the handler of `filter`. Returns with the id of the handler it
+// replaced, or -1.
+static int32_t iotjs_mqtt_filter_add(iotjs_mqtt_topic_node_t **nodes,
+                                     const char *filter, size_t length,
+                                     int32_t handler) {
+  while (true) {
+    size_t level_length = iotjs_mqtt_level_length(filter, length);
+    iotjs_mqtt_topic_node_t *node = *nodes;
+
+    while (node != NULL &&
+           !iotjs_mqtt_level_equals(node, filter, level_length)) {
+      node = node->next;
+    }
+
+    if (node == NULL) {
+      node = (iotjs_mqtt_topic_node_t *)iotjs_buffer_allocate(
+          sizeof(iotjs_mqtt_topic_node_t) + level_length);
+      node->next = *nodes;
+      node->handler = -1;
+      node->length = (uint16_t)level_length;
+      memcpy(node->level, filter, level_length);
+      *nodes = node;
+    }
+
+    if (level_length == length) {
+      int32_t previous = node->handler;
+      node->handler = handler;
+      return previous;
+    }
+
+    filter += level_length + 1;
+    length -= level_length + 1;
+    nodes = &node->children;
+  }
+}
+
+
+// Clears the handler of `filter` and frees the levels which are no longer
+// used. Returns with the id of the removed handler, or -1.
+static int32_t iotjs_mqtt_filter_remove(iotjs_mqtt_topic_node_t **nodes,
+                                        const char *filter, size_t length) {
+  size_t level_length = iotjs_mqtt_level_length(filter, length);
+
+  while (*nodes != NULL &&
+         !iotjs_mqtt_level_equals(*nodes, filter, level_length)) {
+    nodes = &(*nodes)->next;
+  }
+
+  iotjs_mqtt_topic_node_t *node = *nodes;
+
+  if (node == NULL) {
+    return -1;
+  }
+
+  int32_t handler;
+
+  if (level_length == length) {
+    handler = node->handler;
+    node->handler = -1;
+  } else {
+    handler = iotjs_mqtt_filter_remove(&node->children,
+                                       filter + level_length + 1,
+                                       length - level_length - 1);
+  }
+
+  if (node->handler < 0 && node->children == NULL) {
+    *nodes = node->next;
+    IOTJS_RELEASE(node);
+  }
+
+  return handler;
+}
+
+
+static void iotjs_mqtt_filter_release(iotjs_mqtt_topic_node_t *node) {
+  while (node != NULL) {
+    iotjs_mqtt_topic_node_t *next = node->next;
+    iotjs_mqtt_filter_release(node->children);
+    IOTJS_RELEASE(node);
+    node = next;
+  }
+}
+
+
+static void iotjs_mqtt_match_add(jerry_value_t *jhandlers, int32_t handler) {
+  if (handler < 0) {
+    return;
+  }
+
+  if (jerry_value_is_undefined(*jhandlers)) {
+    *jhandlers = jerry_create_array(0);
+  }
+
+  jerry_value_t jid = jerry_create_number(handler);
+  iotjs_jval_set_property_by_index(*jhandlers,
+                                   jerry_get_array_length(*jhandlers), jid);
+  jerry_release_value(jid);
+}
+
+
+// Collects the handlers of the filters matching the raw `topic` bytes into
+// the `jhandlers` array. The array is only created if a filter matches.
+static void iotjs_mqtt_filter_match(const iotjs_mqtt_topic_node_t *node,
+                                    const char *topic, size_t length,
+                                    bool first_level,
+                                    jerry_value_t *jhandlers) {
+  size_t level_length = iotjs_mqtt_level_length(topic, length);
+  bool last_level = (level_length == length);
+  // Wildcards do not match the topics starting with '$'.
+  bool wildcards = !first_level || length == 0 || topic[0] != '$';
+
+  for (; node != NULL; node = node->next) {
+    if (iotjs_mqtt_is_wildcard(node, '#')) {
+      if (wildcards) {
+        iotjs_mqtt_match_add(jhandlers, node->handler);
+      }
+      continue;
+    }
+
+    if (!iotjs_mqtt_level_equals(node, topic, level_length) &&
+        !(wildcards && iotjs_mqtt_is_wildcard(node, '+'))) {
+      continue;
+    }
+
+    if (!last_level) {
+      iotjs_mqtt_filter_match(node->children, topic + level_length + 1,
+                              length - level_length - 1, false, jhandlers);
+      continue;
+    }
+
+    iotjs_mqtt_match_add(jhandlers, node->handler);
+
+    // The 'a/#' filter matches the 'a' topic as well.
+    const iotjs_mqtt_topic_node_t *child = node->children;
+    for (; child != NULL; child = child->next) {
+      if (iotjs_mqtt_is_wildcard(child, '#')) {
+        iotjs_mqtt_match_add(jhandlers, child->handler);
+      }
+    }
+  }
+}
+
+
 void iotjs_mqtt_ack(char *buffer, char *name, jerry_value_t jsref,
-                    char *error) {
+                    const char *error, uint8_t reason_code) {
   uint16_t package_id =
       iotjs_mqtt_calculate_length((uint8_t)buffer[0], (uint8_t)buffer[1]);
 
@@ -120,6 +330,8 @@ void iotjs_mqtt_ack(char *buffer, char *name, jerry_value_t jsref,
 
   if (error) {
     args[1] = iotjs_jval_create_error_without_error_flag(error);
+    iotjs_jval_set_property_number(args[1], IOTJS_MAGIC_STRING_REASONCODE,
+                                   reason_code);
   }
 
   jerry_value_t fn = iotjs_jval_get_property(jsref, name);
@@ -130,19 +342,258 @@ void iotjs_mqtt_ack(char *buffer, char *name, jerry_value_t jsref,
 }
 
 
+static iotjs_mqttclient_t *iotjs_mqtt_get_client(jerry_value_t jnat) {
+  iotjs_mqttclient_t *mqttclient = NULL;
+  jerry_get_object_native_pointer(jnat, (void **)&mqttclient,
+                                  &this_module_native_info);
+  return mqttclient;
+}
+
+
+static void iotjs_mqtt_window_init(iotjs_mqtt_window_t *window,
+                                   uint16_t size) {
+  iotjs_mqtt_inflight_t *entries =
+      IOTJS_CALLOC((size_t)size + 1, iotjs_mqtt_inflight_t);
+
+  // The packet ids are handed out in increasing order first.
+  for (uint16_t id = 1; id < size; id++) {
+    entries[id].next = id + 1;
+  }
+
+  window->entries = entries;
+  window->size = size;
+  window->limit = size;
+  window->available = size;
+  window->free_head = 1;
+  window->ticks = 0;
+}
+
+
+static void iotjs_mqtt_window_unlink(iotjs_mqtt_inflight_t *entries,
+                                     uint16_t id) {
+  entries[entries[id].prev].next = entries[id].next;
+  entries[entries[id].next].prev = entries[id].prev;
+}
+
+
+// Every packet waits the same amount of time, so appending to the tail
+// keeps the retransmit queue ordered by deadline.
+static void iotjs_mqtt_window_enqueue(iotjs_mqtt_window_t *window,
+                                      uint16_t id) {
+  iotjs_mqtt_inflight_t *entries = window->entries;
+  uint16_t tail = entries[0].prev;
+
+  entries[id].prev = tail;
+  entries[id].next = 0;
+  entries[id].deadline = window->ticks + IOTJS_MQTT_RETRANSMIT_TICKS;
+  entries[id].state = MQTT_INFLIGHT_QUEUED;
+  entries[tail].next = id;
+  entries[0].prev = id;
+}
+
+
+// Returns with a free packet id, or 0 if the window is full.
+static uint16_t iotjs_mqtt_window_acquire(iotjs_mqtt_window_t *window) {
+  uint16_t id = window->free_head;
+
+  if (window->size - window->available >= window->limit) {
+    return 0;
+  }
+
+  if (id != 0) {
+    window->free_head = window->entries[id].next;
+    window->available--;
+    window->entries[id].attempts = 0;
+    iotjs_mqtt_window_enqueue(window, id);
+  }
+
+  return id;
+}
+
+
+static uint16_t iotjs_mqtt_window_get_id(iotjs_mqtt_window_t *window,
+                                         jerry_value_t jid) {
+  double id = iotjs_jval_as_number(jid);
+
+  if (id < 1 || id > window->size) {
+    return 0;
+  }
+
+  return (uint16_t)id;
+}
+
+
+static double iotjs_mqtt_get_limit(jerry_value_t jlimit, double max,
+                                   double default_value) {
+  if (!jerry_value_is_null(jlimit)) {
+    double value = iotjs_jval_as_number(jlimit);
+
+    if (value >= 1 && value <= max) {
+      return value;
+    }
+  }
+
+  return default_value;
+}
+
+
+// Arguments: handle, receive maximum, protocol version, topic alias maximum
+// and maximum packet size. The last two are the limits of the client which
+// are sent to the broker in MQTT 5.
 JS_FUNCTION(MqttInit) {
   DJS_CHECK_THIS();
 
   const jerry_value_t jmqtt = JS_GET_ARG(0, object);
 
+  uint16_t receive_maximum = (uint16_t)
+      iotjs_mqtt_get_limit(JS_GET_ARG_IF_EXIST(1, number), UINT16_MAX,
+                           IOTJS_MQTT_DEFAULT_RECEIVE_MAXIMUM);
+  uint8_t protocol_version = (uint8_t)
+      iotjs_mqtt_get_limit(JS_GET_ARG_IF_EXIST(2, number),
+                           IOTJS_MQTT_PROTOCOL_V5, IOTJS_MQTT_PROTOCOL_V4);
+  uint16_t topic_alias_maximum = (uint16_t)
+      iotjs_mqtt_get_limit(JS_GET_ARG_IF_EXIST(3, number), UINT16_MAX, 0);
+  uint32_t maximum_packet_size = (uint32_t)
+      iotjs_mqtt_get_limit(JS_GET_ARG_IF_EXIST(4, number), UINT32_MAX, 0);
+
   iotjs_mqttclient_t *mqttclient = iotjs_mqttclient_create(jmqtt);
-  mqttclient->buffer = NULL;
-  mqttclient->buffer_length = 0;
+  iotjs_mqtt_window_init(&mqttclient->window, receive_maximum);
+
+  if (protocol_version == IOTJS_MQTT_PROTOCOL_V5) {
+    mqttclient->protocol_version = IOTJS_MQTT_PROTOCOL_V5;
+    mqttclient->maximum_packet_size = maximum_packet_size;
+
+    if (topic_alias_maximum > 0) {
+      mqttclient->topic_aliases =
+          IOTJS_CALLOC(topic_alias_maximum, iotjs_mqtt_buffer_t);
+      mqttclient->topic_alias_maximum = topic_alias_maximum;
+    }
+  } else {
+    mqttclient->protocol_version = IOTJS_MQTT_PROTOCOL_V4;
+  }
 
   return jerry_create_undefined();
 }
 
 
+// Returns with a free packet id, or 0 if the in-flight window is full.
+JS_FUNCTION(MqttAcquireId) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, object);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  return jerry_create_number(iotjs_mqtt_window_acquire(&mqttclient->window));
+}
+
+
+// Returns the packet id to the free ids. Returns with false if the id
+// was not in flight.
+JS_FUNCTION(MqttReleaseId) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, object, number);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  iotjs_mqtt_window_t *window = &mqttclient->window;
+  uint16_t id = iotjs_mqtt_window_get_id(window, JS_GET_ARG(1, number));
+
+  if (id == 0 || window->entries[id].state == MQTT_INFLIGHT_FREE) {
+    return jerry_create_boolean(false);
+  }
+
+  if (window->entries[id].state == MQTT_INFLIGHT_QUEUED) {
+    iotjs_mqtt_window_unlink(window->entries, id);
+  }
+
+  window->entries[id].state = MQTT_INFLIGHT_FREE;
+  window->entries[id].next = window->free_head;
+  window->free_head = id;
+  window->available++;
+
+  return jerry_create_boolean(true);
+}
+
+
+// Restarts the retransmit period of a packet id when the packet stored for
+// it is replaced, e.g. by a PUBREL.
+JS_FUNCTION(MqttRefreshId) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, object, number);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  iotjs_mqtt_window_t *window = &mqttclient->window;
+  uint16_t id = iotjs_mqtt_window_get_id(window, JS_GET_ARG(1, number));
+
+  if (id == 0 || window->entries[id].state != MQTT_INFLIGHT_QUEUED) {
+    return jerry_create_boolean(false);
+  }
+
+  iotjs_mqtt_window_unlink(window->entries, id);
+  window->entries[id].attempts = 0;
+  iotjs_mqtt_window_enqueue(window, id);
+
+  return jerry_create_boolean(true);
+}
+
+
+// Advances the clock of the retransmit queue by one tick. Only the packets
+// whose deadline has passed are visited. Returns with undefined if there is
+// nothing to do, otherwise with an array of the packet ids to retransmit.
+// The ids of the undelivered packets are negated.
+JS_FUNCTION(MqttTick) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, object);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  iotjs_mqtt_window_t *window = &mqttclient->window;
+  iotjs_mqtt_inflight_t *entries = window->entries;
+  jerry_value_t jids = jerry_create_undefined();
+  uint32_t length = 0;
+
+  window->ticks++;
+
+  while (entries[0].next != 0 &&
+         (int32_t)(entries[entries[0].next].deadline - window->ticks) <= 0) {
+    uint16_t id = entries[0].next;
+    double jid_value = id;
+
+    iotjs_mqtt_window_unlink(entries, id);
+
+    if (++entries[id].attempts >= IOTJS_MQTT_MAX_ATTEMPTS) {
+      entries[id].state = MQTT_INFLIGHT_EXPIRED;
+      jid_value = -jid_value;
+    } else {
+      iotjs_mqtt_window_enqueue(window, id);
+    }
+
+    if (jerry_value_is_undefined(jids)) {
+      jids = jerry_create_array(0);
+    }
+
+    jerry_value_t jid = jerry_create_number(jid_value);
+    iotjs_jval_set_property_by_index(jids, length++, jid);
+    jerry_release_value(jid);
+  }
+
+  return jids;
+}
+
+
 JS_FUNCTION(MqttConnect) {
   DJS_CHECK_THIS();
 
@@ -185,6 +636,45 @@ JS_FUNCTION(MqttConnect) {
       iotjs_jval_get_property(joptions, IOTJS_MAGIC_STRING_QOS);
   jerry_value_t jretain =
       iotjs_jval_get_property(joptions, IOTJS_MAGIC_STRING_RETAIN);
+  jerry_value_t jversion =
+      iotjs_jval_get_property(joptions, IOTJS_MAGIC_STRING_PROTOCOLVERSION);
+
+  uint8_t protocol_version = IOTJS_MQTT_PROTOCOL_V4;
+  iotjs_mqtt_buffer_t properties = { 0 };
+  iotjs_mqtt_buffer_t will_properties = { 0 };
+
+  if (jerry_value_is_number(jversion) &&
+      jerry_get_number_value(jversion) == IOTJS_MQTT_PROTOCOL_V5) {
+    protocol_version = IOTJS_MQTT_PROTOCOL_V5;
+
+    jerry_value_t jproperties =
+        iotjs_jval_get_property(joptions, IOTJS_MAGIC_STRING_PROPERTIES);
+    jerry_value_t jwill_properties =
+        iotjs_jval_get_property(joptions, IOTJS_MAGIC_STRING_WILLPROPERTIES);
+
+    bool valid = iotjs_mqtt_properties_encode(jproperties, 0, &properties) &&
+                 iotjs_mqtt_properties_encode(jwill_properties, 0,
+                                              &will_properties);
+
+    jerry_release_value(jproperties);
+    jerry_release_value(jwill_properties);
+
+    if (!valid) {
+      IOTJS_RELEASE(properties.data);
+      IOTJS_RELEASE(will_properties.data);
+      iotjs_free_tmp_buffer(&client_id);
+      iotjs_free_tmp_buffer(&username);
+      iotjs_free_tmp_buffer(&password);
+      iotjs_free_tmp_buffer(&message);
+      iotjs_free_tmp_buffer(&topic);
+      jerry_release_value(jkeepalive);
+      jerry_release_value(jwill);
+      jerry_release_value(jqos);
+      jerry_release_value(jretain);
+      jerry_release_value(jversion);
+      return JS_CREATE_ERROR(COMMON, "MQTT: Invalid property");
+    }
+  }
 
   uint8_t connect_flags = 0;
   connect_flags |= MQTT_FLAG_CLEANSESSION;
@@ -234,11 +724,16 @@ JS_FUNCTION(MqttConnect) {
   variable_header_protocol[3] = 'Q';
   variable_header_protocol[4] = 'T';
   variable_header_protocol[5] = 'T';
-  variable_header_protocol[6] = 4;
+  variable_header_protocol[6] = protocol_version;
 
   size_t variable_header_len = sizeof(variable_header_protocol) +
                                sizeof(connect_flags) + IOTJS_MQTT_LSB_MSB_SIZE;
 
+  if (protocol_version == IOTJS_MQTT_PROTOCOL_V5) {
+    variable_header_len +=
+        get_remaining_length_size(properties.length) + properties.length;
+  }
+
   size_t payload_len = IOTJS_MQTT_LSB_MSB_SIZE + client_id.length;
 
   if (connect_flags & MQTT_FLAG_USERNAME) {
@@ -250,6 +745,11 @@ JS_FUNCTION(MqttConnect) {
   if (connect_flags & MQTT_FLAG_WILL) {
     payload_len += IOTJS_MQTT_LSB_MSB_SIZE + topic.length;
     payload_len += IOTJS_MQTT_LSB_MSB_SIZE + message.length;
+
+    if (protocol_version == IOTJS_MQTT_PROTOCOL_V5) {
+      payload_len += get_remaining_length_size(will_properties.length) +
+                     will_properties.length;
+    }
   }
 
   uint32_t remaining_length = payload_len + variable_header_len;
@@ -271,9 +771,17 @@ JS_FUNCTION(MqttConnect) {
   *buff_ptr++ = (uint8_t)(keepalive >> 8);
   *buff_ptr++ = (uint8_t)(keepalive & 0x00FF);
 
+  if (protocol_version == IOTJS_MQTT_PROTOCOL_V5) {
+    buff_ptr = iotjs_mqtt_properties_serialize(buff_ptr, &properties);
+  }
+
   buff_ptr = iotjs_mqtt_string_serialize(buff_ptr, &client_id);
 
   if (connect_flags & MQTT_FLAG_WILL) {
+    if (protocol_version == IOTJS_MQTT_PROTOCOL_V5) {
+      buff_ptr = iotjs_mqtt_properties_serialize(buff_ptr, &will_properties);
+    }
+
     buff_ptr = iotjs_mqtt_string_serialize(buff_ptr, &topic);
     buff_ptr = iotjs_mqtt_string_serialize(buff_ptr, &message);
   }
@@ -295,15 +803,29 @@ JS_FUNCTION(MqttConnect) {
   jerry_release_value(jwill);
   jerry_release_value(jqos);
   jerry_release_value(jretain);
+  jerry_release_value(jversion);
+
+  IOTJS_RELEASE(properties.data);
+  IOTJS_RELEASE(will_properties.data);
 
   return jbuff;
 }
 
 
+// Arguments: topic, message, header and for MQTT 5 the topic alias and the
+// properties. The topic can be empty if a topic alias is given.
 JS_FUNCTION(MqttPublish) {
   DJS_CHECK_THIS();
 
   DJS_CHECK_ARGS(3, any, any, number);
+  DJS_CHECK_ARG_IF_EXIST(3, number);
+
+  bool is_v5 = jargc > 3;
+  uint16_t topic_alias = 0;
+
+  if (is_v5) {
+    topic_alias = (uint16_t)JS_GET_ARG(3, number);
+  }
 
   iotjs_tmp_buffer_t topic;
   iotjs_jval_as_tmp_buffer(JS_GET_ARG(0, any), &topic);
@@ -312,16 +834,31 @@ JS_FUNCTION(MqttPublish) {
     return topic.jval;
   }
 
-  if (topic.buffer == NULL || topic.length >= UINT16_MAX) {
+  if ((topic.buffer == NULL && topic_alias == 0) ||
+      topic.length >= UINT16_MAX) {
     iotjs_free_tmp_buffer(&topic);
 
     return JS_CREATE_ERROR(COMMON, "Topic for PUBLISH is empty or too long.");
   }
 
+  iotjs_mqtt_buffer_t properties = { 0 };
+
+  // Undefined properties are skipped by the encoder.
+  jerry_value_t jproperties = jargc > 4 ? jargv[4] : jerry_create_undefined();
+
+  if (is_v5 &&
+      !iotjs_mqtt_properties_encode(jproperties, topic_alias, &properties)) {
+    IOTJS_RELEASE(properties.data);
+    iotjs_free_tmp_buffer(&topic);
+
+    return JS_CREATE_ERROR(COMMON, "MQTT: Invalid property");
+  }
+
   iotjs_tmp_buffer_t message;
   iotjs_jval_as_tmp_buffer(JS_GET_ARG(1, any), &message);
 
   if (jerry_value_is_error(message.jval)) {
+    IOTJS_RELEASE(properties.data);
     iotjs_free_tmp_buffer(&topic);
     return message.jval;
   }
@@ -335,13 +872,18 @@ JS_FUNCTION(MqttPublish) {
 
   const uint8_t qos_mask = (0x3 << 1);
 
-  size_t payload_len = message.length + IOTJS_MQTT_LSB_MSB_SIZE;
+  size_t payload_len = message.length;
   size_t variable_header_len = topic.length + IOTJS_MQTT_LSB_MSB_SIZE;
 
   if (header_byte & qos_mask) {
     variable_header_len += IOTJS_MQTT_LSB_MSB_SIZE;
   }
 
+  if (is_v5) {
+    variable_header_len +=
+        get_remaining_length_size(properties.length) + properties.length;
+  }
+
   uint32_t remaining_length = payload_len + variable_header_len;
   size_t full_len = sizeof(header_byte) +
                     get_remaining_length_size(remaining_length) +
@@ -362,6 +904,11 @@ JS_FUNCTION(MqttPublish) {
     *buff_ptr++ = (uint8_t)(packet_identifier & 0x00FF);
   }
 
+  if (is_v5) {
+    buff_ptr = iotjs_mqtt_properties_serialize(buff_ptr, &properties);
+    IOTJS_RELEASE(properties.data);
+  }
+
   // Don't need to put length before the payload, so we can't use the
   // iotjs_mqtt_string_serialize. The broker and the other clients calculate
   // the payload length from remaining length and the topic length.
@@ -373,13 +920,83 @@ JS_FUNCTION(MqttPublish) {
 }
 
 
-static int iotjs_mqtt_handle(jerry_value_t jsref, char first_byte, char *buffer,
-                             uint32_t packet_size) {
+// Decodes the reason code and the properties following the packet id of
+// the acknowledgements. The reason code is zero in MQTT 3.1.1.
+static int iotjs_mqtt_ack_reason(const iotjs_mqttclient_t *mqttclient,
+                                 const char *buffer, uint32_t packet_size,
+                                 uint8_t *reason_code) {
+  *reason_code = 0;
+
+  if (mqttclient->protocol_version != IOTJS_MQTT_PROTOCOL_V5) {
+    return packet_size == 2 ? 0 : MQTT_ERR_CORRUPTED_PACKET;
+  }
+
+  if (packet_size < 2) {
+    return MQTT_ERR_CORRUPTED_PACKET;
+  }
+
+  if (packet_size > 2) {
+    *reason_code = (uint8_t)buffer[2];
+  }
+
+  if (packet_size > 3) {
+    iotjs_mqtt_properties_t properties;
+    int32_t used = iotjs_mqtt_properties_decode(buffer + 3, packet_size - 3,
+                                                &properties, NULL);
+
+    if (used != (int32_t)(packet_size - 3)) {
+      return MQTT_ERR_CORRUPTED_PACKET;
+    }
+  }
+
+  return 0;
+}
+
+
+// Decodes the acknowledgement of a SUBSCRIBE or UNSUBSCRIBE packet with a
+// single topic filter.
+static int iotjs_mqtt_suback_reason(const iotjs_mqttclient_t *mqttclient,
+                                    const char *buffer, uint32_t packet_size,
+                                    uint8_t *reason_code) {
+  uint32_t offset = IOTJS_MQTT_LSB_MSB_SIZE;
+
+  if (packet_size < offset) {
+    return MQTT_ERR_CORRUPTED_PACKET;
+  }
+
+  if (mqttclient->protocol_version == IOTJS_MQTT_PROTOCOL_V5) {
+    iotjs_mqtt_properties_t properties;
+    int32_t used = iotjs_mqtt_properties_decode(buffer + offset,
+                                                packet_size - offset,
+                                                &properties, NULL);
+
+    if (used < 0) {
+      return MQTT_ERR_CORRUPTED_PACKET;
+    }
+
+    offset += (uint32_t)used;
+  }
+
+  if (packet_size != offset + 1) {
+    return MQTT_ERR_CORRUPTED_PACKET;
+  }
+
+  *reason_code = (uint8_t)buffer[offset];
+  return 0;
+}
+
+
+static int iotjs_mqtt_handle(jerry_value_t jsref,
+                             iotjs_mqttclient_t *mqttclient, char first_byte,
+                             char *buffer, uint32_t packet_size) {
   char packet_type = (first_byte >> 4) & 0x0F;
+  bool is_v5 = mqttclient->protocol_version == IOTJS_MQTT_PROTOCOL_V5;
+  uint8_t reason_code = 0;
+  int error;
 
   switch (packet_type) {
     case CONNACK: {
-      if (packet_size != 2) {
+      if (packet_size < 2 || (!is_v5 && packet_size != 2)) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
@@ -389,11 +1006,35 @@ static int iotjs_mqtt_handle(jerry_value_t jsref, char first_byte, char *buffer,
         return return_code;
       }
 
+      // The CONNACK properties are passed to the connect event.
+      jerry_value_t jproperties = jerry_create_undefined();
+
+      if (packet_size > 2) {
+        iotjs_mqtt_properties_t properties;
+        int32_t used = iotjs_mqtt_properties_decode(buffer + 2,
+                                                    packet_size - 2,
+                                                    &properties, &jproperties);
+
+        if (used != (int32_t)(packet_size - 2)) {
+          jerry_release_value(jproperties);
+          return MQTT_ERR_CORRUPTED_PACKET;
+        }
+
+        // The broker limits the number of packets in flight.
+        iotjs_mqtt_window_t *window = &mqttclient->window;
+
+        if (properties.receive_maximum > 0 &&
+            properties.receive_maximum < window->limit) {
+          window->limit = properties.receive_maximum;
+        }
+      }
+
       jerry_value_t fn =
           iotjs_jval_get_property(jsref, IOTJS_MAGIC_STRING_ONCONNECTION);
-      iotjs_invoke_callback(fn, jsref, NULL, 0);
+      iotjs_invoke_callback(fn, jsref, &jproperties, 1);
 
       jerry_release_value(fn);
+      jerry_release_value(jproperties);
       break;
     }
     case PUBLISH: {
@@ -403,113 +1044,226 @@ static int iotjs_mqtt_handle(jerry_value_t jsref, char first_byte, char *buffer,
       header.bits.qos = (first_byte & 0x06) >> 1;
       header.bits.retain = first_byte & 0x01;
 
+      if (packet_size < IOTJS_MQTT_LSB_MSB_SIZE) {
+        return MQTT_ERR_CORRUPTED_PACKET;
+      }
+
       uint8_t topic_length_MSB = (uint8_t)buffer[0];
       uint8_t topic_length_LSB = (uint8_t)buffer[1];
-      buffer += 2;
 
-      uint16_t topic_length =
+      const char *topic = buffer + 2;
+      size_t topic_length =
           iotjs_mqtt_calculate_length(topic_length_MSB, topic_length_LSB);
+      uint32_t header_length = IOTJS_MQTT_LSB_MSB_SIZE + topic_length;
+
+      if (header.bits.qos > 0) {
+        header_length += IOTJS_MQTT_LSB_MSB_SIZE;
+      }
 
-      if (!jerry_is_valid_utf8_string((const uint8_t *)buffer, topic_length)) {
+      if (header_length > packet_size) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
-      const jerry_char_t *topic = (const jerry_char_t *)buffer;
-      jerry_value_t jtopic = jerry_create_string_sz(topic, topic_length);
-      buffer += topic_length;
+      if (!jerry_is_valid_utf8_string((const uint8_t *)topic,
+                                      (jerry_size_t)topic_length)) {
+        return MQTT_ERR_CORRUPTED_PACKET;
+      }
 
       // The Packet Identifier field is only present in PUBLISH packets
       // where the QoS level is 1 or 2.
       uint16_t packet_identifier = 0;
       if (header.bits.qos > 0) {
-        uint8_t packet_identifier_MSB = (uint8_t)buffer[0];
-        uint8_t packet_identifier_LSB = (uint8_t)buffer[1];
-        buffer += 2;
+        uint8_t packet_identifier_MSB = (uint8_t)topic[topic_length];
+        uint8_t packet_identifier_LSB = (uint8_t)topic[topic_length + 1];
 
         packet_identifier = iotjs_mqtt_calculate_length(packet_identifier_MSB,
                                                         packet_identifier_LSB);
       }
 
-      size_t payload_length =
-          (size_t)packet_size - topic_length - sizeof(topic_length);
-
-      if (header.bits.qos > 0) {
-        payload_length -= sizeof(packet_identifier);
+      jerry_value_t jproperties = jerry_create_undefined();
+
+      if (is_v5) {
+        iotjs_mqtt_properties_t properties;
+        int32_t used =
+            iotjs_mqtt_properties_decode(buffer + header_length,
+                                         packet_size - header_length,
+                                         &properties, &jproperties);
+
+        if (used < 0) {
+          return MQTT_ERR_CORRUPTED_PACKET;
+        }
+
+        header_length += (uint32_t)used;
+
+        // A topic alias either sets the topic of the alias or stands for
+        // the topic which was set earlier.
+        uint16_t alias = properties.topic_alias;
+
+        if (alias != 0 || topic_length == 0) {
+          iotjs_mqtt_buffer_t *aliased = NULL;
+
+          if (alias != 0 && alias <= mqttclient->topic_alias_maximum) {
+            aliased = mqttclient->topic_aliases + alias - 1;
+          }
+
+          if (aliased == NULL || (topic_length == 0 && aliased->length == 0)) {
+            jerry_release_value(jproperties);
+            return MQTT_ERR_TOPIC_ALIAS_INVALID;
+          }
+
+          if (topic_length > 0) {
+            aliased->length = 0;
+            iotjs_mqtt_buffer_append(aliased, topic, topic_length);
+          } else {
+            topic = aliased->data;
+            topic_length = aliased->length;
+          }
+        }
       }
 
+      // The handlers are selected on the raw topic bytes.
+      jerry_value_t jhandlers = jerry_create_undefined();
+      iotjs_mqtt_filter_match(mqttclient->filters, topic, topic_length, true,
+                              &jhandlers);
+
+      jerry_value_t jtopic =
+          jerry_create_string_sz((const jerry_char_t *)topic,
+                                 (jerry_size_t)topic_length);
+
+      size_t payload_length = (size_t)(packet_size - header_length);
+
       jerry_value_t jmessage = iotjs_bufferwrap_create_buffer(payload_length);
       iotjs_bufferwrap_t *msg_wrap = iotjs_bufferwrap_from_jbuffer(jmessage);
 
-      memcpy(msg_wrap->buffer, buffer, payload_length);
+      memcpy(msg_wrap->buffer, buffer + header_length, payload_length);
 
-      jerry_value_t args[4] = { jmessage, jtopic,
+      jerry_value_t args[6] = { jmessage,
+                                jtopic,
                                 jerry_create_number(header.bits.qos),
-                                jerry_create_number(packet_identifier) };
+                                jerry_create_number(packet_identifier),
+                                jhandlers,
+                                jproperties };
 
       jerry_value_t fn =
           iotjs_jval_get_property(jsref, IOTJS_MAGIC_STRING_ONMESSAGE);
-      iotjs_invoke_callback(fn, jsref, args, 4);
+      iotjs_invoke_callback(fn, jsref, args, 6);
       jerry_release_value(fn);
 
-      for (uint8_t i = 0; i < 4; i++) {
+      for (uint8_t i = 0; i < 6; i++) {
         jerry_release_value(args[i]);
       }
 
       break;
     }
-    case PUBACK: {
-      if (packet_size != 2 || (first_byte & 0x0F) != 0x0) {
+    case PUBACK:
+    case PUBCOMP: {
+      if ((first_byte & 0x0F) != 0x0) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
-      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, NULL);
+      error = iotjs_mqtt_ack_reason(mqttclient, buffer, packet_size,
+                                    &reason_code);
+
+      if (error != 0) {
+        return error;
+      }
+
+      const char *reason = NULL;
+
+      if (reason_code >= MQTT_REASON_FAILURE) {
+        reason = iotjs_mqtt_reason_string(reason_code);
+      }
+
+      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, reason,
+                     reason_code);
       break;
     }
     case PUBREC: {
-      if (packet_size != 2 || (first_byte & 0x0F) != 0x0) {
+      if ((first_byte & 0x0F) != 0x0) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
-      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONPUBREC, jsref, NULL);
+      error = iotjs_mqtt_ack_reason(mqttclient, buffer, packet_size,
+                                    &reason_code);
+
+      if (error != 0) {
+        return error;
+      }
+
+      // A failed PUBREC ends the QoS 2 flow without a PUBREL.
+      if (reason_code >= MQTT_REASON_FAILURE) {
+        iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref,
+                       iotjs_mqtt_reason_string(reason_code), reason_code);
+        break;
+      }
+
+      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONPUBREC, jsref, NULL, 0);
       break;
     }
     case PUBREL: {
-      if (packet_size != 2 || (first_byte & 0x0F) != 0x2) {
+      if ((first_byte & 0x0F) != 0x2) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
-      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONPUBREL, jsref, NULL);
-      break;
-    }
-    case PUBCOMP: {
-      if (packet_size != 2 || (first_byte & 0x0F) != 0x0) {
-        return MQTT_ERR_CORRUPTED_PACKET;
+      error = iotjs_mqtt_ack_reason(mqttclient, buffer, packet_size,
+                                    &reason_code);
+
+      if (error != 0) {
+        return error;
       }
 
-      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, NULL);
+      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONPUBREL, jsref, NULL, 0);
       break;
     }
     case SUBACK: {
       // We assume that only one topic was in the SUBSCRIBE packet.
-      if (packet_size != 3 || (first_byte & 0x0F) != 0x0) {
+      if ((first_byte & 0x0F) != 0x0) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
-      char *error = NULL;
+      error = iotjs_mqtt_suback_reason(mqttclient, buffer, packet_size,
+                                       &reason_code);
+
+      if (error != 0) {
+        return error;
+      }
+
+      const char *reason = NULL;
 
-      if ((uint8_t)buffer[2] == 0x80) {
-        error = "Subscribe failed";
+      if (reason_code >= MQTT_REASON_FAILURE) {
+        reason = is_v5 ? iotjs_mqtt_reason_string(reason_code)
+                       : "Subscribe failed";
       }
 
-      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, error);
+      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, reason,
+                     reason_code);
       break;
     }
     case UNSUBACK: {
-      if (packet_size != 2 || (first_byte & 0x0F) != 0x0) {
+      if ((first_byte & 0x0F) != 0x0) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
-      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, NULL);
+      // There are no reason codes in MQTT 3.1.1.
+      if (is_v5) {
+        error = iotjs_mqtt_suback_reason(mqttclient, buffer, packet_size,
+                                         &reason_code);
+      } else {
+        error = packet_size == 2 ? 0 : MQTT_ERR_CORRUPTED_PACKET;
+      }
+
+      if (error != 0) {
+        return error;
+      }
+
+      const char *reason = NULL;
+
+      if (reason_code >= MQTT_REASON_FAILURE) {
+        reason = iotjs_mqtt_reason_string(reason_code);
+      }
+
+      iotjs_mqtt_ack(buffer, IOTJS_MAGIC_STRING_ONACK, jsref, reason,
+                     reason_code);
       break;
     }
     case PINGRESP: {
@@ -524,10 +1278,22 @@ static int iotjs_mqtt_handle(jerry_value_t jsref, char first_byte, char *buffer,
       break;
     }
     case DISCONNECT: {
-      if (packet_size != 0 || (first_byte & 0x0F) != 0x0) {
+      if ((first_byte & 0x0F) != 0x0 || (!is_v5 && packet_size != 0)) {
         return MQTT_ERR_CORRUPTED_PACKET;
       }
 
+      // The reason code of the broker is followed by the properties.
+      if (packet_size > 1) {
+        iotjs_mqtt_properties_t properties;
+        int32_t used = iotjs_mqtt_properties_decode(buffer + 1,
+                                                    packet_size - 1,
+                                                    &properties, NULL);
+
+        if (used != (int32_t)(packet_size - 1)) {
+          return MQTT_ERR_CORRUPTED_PACKET;
+        }
+      }
+
       jerry_value_t fn =
           iotjs_jval_get_property(jsref, IOTJS_MAGIC_STRING_ONEND);
       iotjs_invoke_callback(fn, jsref, NULL, 0);
@@ -546,21 +1312,51 @@ static int iotjs_mqtt_handle(jerry_value_t jsref, char first_byte, char *buffer,
 }
 
 
-static void iotjs_mqtt_concat_buffers(iotjs_mqttclient_t *mqttclient,
-                                      iotjs_bufferwrap_t *buff_recv) {
-  char *tmp_buf = mqttclient->buffer;
-  mqttclient->buffer =
-      IOTJS_CALLOC(mqttclient->buffer_length + buff_recv->length, char);
-  memcpy(mqttclient->buffer, tmp_buf, mqttclient->buffer_length);
-  memcpy(mqttclient->buffer + mqttclient->buffer_length, buff_recv->buffer,
-         buff_recv->length);
-  mqttclient->buffer_length += buff_recv->length;
-  IOTJS_RELEASE(tmp_buf);
+void iotjs_mqtt_buffer_append(iotjs_mqtt_buffer_t *buff, const char *data,
+                              size_t size) {
+  size_t required = buff->length + size;
+
+  if (required > buff->capacity) {
+    size_t capacity =
+        buff->capacity ? buff->capacity : IOTJS_MQTT_BUFFER_MIN_SIZE;
+    while (capacity < required) {
+      capacity *= 2;
+    }
+
+    if (buff->data == NULL) {
+      buff->data = iotjs_buffer_allocate(capacity);
+    } else {
+      buff->data = iotjs_buffer_reallocate(buff->data, capacity);
+    }
+    buff->capacity = capacity;
+  }
+
+  memcpy(buff->data + buff->length, data, size);
+  buff->length += size;
+}
+
+
+static void iotjs_mqtt_buffer_clear(iotjs_mqtt_buffer_t *buff) {
+  buff->length = 0;
+
+  if (buff->capacity > IOTJS_MQTT_BUFFER_KEEP_SIZE) {
+    // Do not hold on to the memory of an occasional large packet.
+    IOTJS_RELEASE(buff->data);
+    buff->capacity = 0;
+  }
 }
 
 
 static jerry_value_t iotjs_mqtt_handle_error(
     iotjs_mqtt_packet_error_t error_code) {
+  if (error_code >= MQTT_REASON_FAILURE) {
+    // Reason code of a refused MQTT 5 connection.
+    char message[96];
+    snprintf(message, sizeof(message), "MQTT: Connection refused: %s",
+             iotjs_mqtt_reason_string((uint8_t)error_code));
+    return JS_CREATE_ERROR(COMMON, message);
+  }
+
   switch (error_code) {
     case MQTT_ERR_UNACCEPTABLE_PROTOCOL:
       return JS_CREATE_ERROR(COMMON,
@@ -582,12 +1378,63 @@ static jerry_value_t iotjs_mqtt_handle_error(
       return JS_CREATE_ERROR(COMMON, "MQTT: Broker sent an unallowed packet");
     case MQTT_ERR_SUBSCRIPTION_FAILED:
       return JS_CREATE_ERROR(COMMON, "MQTT: Subscription failed");
+    case MQTT_ERR_PACKET_TOO_LARGE:
+      return JS_CREATE_ERROR(COMMON, "MQTT: Packet too large");
+    case MQTT_ERR_TOPIC_ALIAS_INVALID:
+      return JS_CREATE_ERROR(COMMON, "MQTT: Topic alias invalid");
     default:
       return JS_CREATE_ERROR(COMMON, "MQTT: Unknown error");
   }
 }
 
 
+// Handles the complete packets of `data` in place. Returns with the number
+// of processed bytes, the rest is the beginning of an incomplete packet.
+static size_t iotjs_mqtt_process(jerry_value_t jnat,
+                                 iotjs_mqttclient_t *mqttclient, char *data,
+                                 size_t size, int *error) {
+  size_t offset = 0;
+
+  while (offset < size) {
+    uint32_t header_size;
+    uint32_t packet_size;
+    int ret_val = iotjs_mqtt_decode_fixed_header(data + offset, size - offset,
+                                                 &header_size, &packet_size);
+
+    if (ret_val < 0) {
+      *error = MQTT_ERR_CORRUPTED_PACKET;
+      break;
+    }
+
+    // Oversized packets are refused before they are buffered.
+    if (ret_val > 0 && mqttclient->maximum_packet_size > 0 &&
+        (uint64_t)header_size + packet_size >
+            mqttclient->maximum_packet_size) {
+      *error = MQTT_ERR_PACKET_TOO_LARGE;
+      break;
+    }
+
+    if (ret_val == 0 || size - offset < (size_t)header_size + packet_size) {
+      break;
+    }
+
+    char first_byte = data[offset];
+    offset += header_size;
+
+    *error = iotjs_mqtt_handle(jnat, mqttclient, first_byte, data + offset,
+                               packet_size);
+
+    if (*error != 0) {
+      break;
+    }
+
+    offset += packet_size;
+  }
+
+  return offset;
+}
+
+
 JS_FUNCTION(MqttReceive) {
   DJS_CHECK_THIS();
   DJS_CHECK_ARGS(2, object, object);
@@ -606,90 +1453,313 @@ JS_FUNCTION(MqttReceive) {
     return jerry_create_undefined();
   }
 
-  char *current_buffer = buff_recv->buffer;
-  char *current_buffer_end = current_buffer + buff_recv->length;
+  iotjs_mqtt_buffer_t *pending = &mqttclient->buffer;
+  char *data = buff_recv->buffer;
+  size_t length = buff_recv->length;
+  int error = 0;
+
+  // Complete the packet kept from the previous reads. Only the bytes of that
+  // packet are copied, the packets after it are parsed straight from the
+  // received data.
+  while (pending->length > 0 && length > 0) {
+    uint32_t header_size;
+    uint32_t packet_size;
+    int ret_val = iotjs_mqtt_decode_fixed_header(pending->data, pending->length,
+                                                 &header_size, &packet_size);
+
+    // The fixed header is at most five bytes long, so it is completed
+    // byte by byte.
+    size_t needed = 1;
+
+    if (ret_val > 0) {
+      needed = (size_t)header_size + packet_size - pending->length;
+    }
+
+    if (needed > length) {
+      needed = length;
+    }
+
+    iotjs_mqtt_buffer_append(pending, data, needed);
+    data += needed;
+    length -= needed;
 
-  // Concat the buffers if we previously needed to
-  if (mqttclient->buffer_length > 0) {
-    iotjs_mqtt_concat_buffers(mqttclient, buff_recv);
-    current_buffer = mqttclient->buffer;
-    current_buffer_end = current_buffer + mqttclient->buffer_length;
+    if (iotjs_mqtt_process(jnat, mqttclient, pending->data, pending->length,
+                           &error) > 0 ||
+        error != 0) {
+      iotjs_mqtt_buffer_clear(pending);
+    }
   }
 
-  // Keep on going, if data remains just continue looping
-  while (true) {
-    if (current_buffer >= current_buffer_end) {
-      if (mqttclient->buffer_length > 0) {
-        IOTJS_RELEASE(mqttclient->buffer);
-        mqttclient->buffer_length = 0;
-      }
-      return jerry_create_undefined();
+  if (pending->length == 0 && length > 0 && error == 0) {
+    size_t consumed =
+        iotjs_mqtt_process(jnat, mqttclient, data, length, &error);
+
+    if (consumed < length && error == 0) {
+      iotjs_mqtt_buffer_append(pending, data + consumed, length - consumed);
     }
+  }
 
-    if (current_buffer + 2 > current_buffer_end) {
-      break;
+  if (error != 0) {
+    iotjs_mqtt_buffer_clear(pending);
+    return iotjs_mqtt_handle_error(error);
+  }
+
+  return jerry_create_undefined();
+}
+
+// Opens the spool file which keeps the packets published while offline.
+JS_FUNCTION(MqttSpoolOpen) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, object, string);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  jerry_value_t jsize = JS_GET_ARG_IF_EXIST(2, number);
+  uint32_t size = IOTJS_MQTT_SPOOL_DEFAULT_SIZE;
+
+  if (!jerry_value_is_null(jsize)) {
+    double value = iotjs_jval_as_number(jsize);
+
+    if (value > 0 && value <= IOTJS_MQTT_SPOOL_MAX_SIZE) {
+      size = (uint32_t)value;
     }
+  }
 
-    uint32_t packet_size;
-    uint32_t packet_size_length;
+  iotjs_string_t path = JS_GET_ARG(1, string);
 
-    if ((uint8_t)current_buffer[1] <= 0x7f) {
-      packet_size = (uint32_t)current_buffer[1];
-      packet_size_length = 1;
+  iotjs_mqtt_spool_close(mqttclient->spool);
+  mqttclient->spool = iotjs_mqtt_spool_open(iotjs_string_data(&path), size);
+  iotjs_string_destroy(&path);
 
-      if (current_buffer + 2 + packet_size > current_buffer_end) {
-        break;
-      }
-    } else {
-      // At least 128 bytes arrived
-      if (current_buffer + 5 >= current_buffer_end) {
-        break;
-      }
+  if (mqttclient->spool == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT: Cannot open the spool file");
+  }
 
-      packet_size = iotjs_decode_remaining_length(current_buffer + 1,
-                                                  &packet_size_length);
+  return jerry_create_number(iotjs_mqtt_spool_count(mqttclient->spool));
+}
+
+
+// Appends an encoded PUBLISH packet to the spool. Returns with false if
+// the packet does not fit into the spool.
+JS_FUNCTION(MqttSpoolAppend) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, object, object);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  iotjs_bufferwrap_t *packet =
+      iotjs_jbuffer_get_bufferwrap_ptr(JS_GET_ARG(1, object));
+
+  if (mqttclient->spool == NULL || packet == NULL) {
+    return jerry_create_boolean(false);
+  }
+
+  uint32_t header_size;
+  uint32_t packet_size;
+
+  if (iotjs_mqtt_decode_fixed_header(packet->buffer, packet->length,
+                                     &header_size, &packet_size) <= 0 ||
+      ((uint8_t)packet->buffer[0] >> 4) != PUBLISH ||
+      packet_size < IOTJS_MQTT_LSB_MSB_SIZE ||
+      header_size + packet_size != packet->length) {
+    return JS_CREATE_ERROR(COMMON, "MQTT: Only PUBLISH packets are spooled");
+  }
+
+  // The packet id is assigned when the packet is replayed.
+  uint16_t id_offset = 0;
+
+  if (packet->buffer[0] & 0x06) {
+    const uint8_t *topic = (const uint8_t *)packet->buffer + header_size;
+    id_offset = (uint16_t)(header_size + IOTJS_MQTT_LSB_MSB_SIZE +
+                           iotjs_mqtt_calculate_length(topic[0], topic[1]));
+  }
+
+  return jerry_create_boolean(
+      iotjs_mqtt_spool_append(mqttclient->spool, packet->buffer,
+                              (uint32_t)packet->length, id_offset));
+}
 
-      if (packet_size == 0) {
-        return iotjs_mqtt_handle_error(MQTT_ERR_CORRUPTED_PACKET);
-      }
 
-      if (current_buffer + 1 + packet_size_length + packet_size >
-          current_buffer_end) {
+// Copies the oldest spooled packets into a single Buffer, up to `max_bytes`
+// and as long as the in-flight window and its limit allow more packets. The
+// copied packets are removed from the spool. Returns with undefined if
+// nothing can be replayed, otherwise with an array of the Buffer followed by
+// the packet id, start and end offset of each QoS 1 or 2 packet.
+JS_FUNCTION(MqttSpoolReplay) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, object, number);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  iotjs_mqtt_spool_t *spool = mqttclient->spool;
+  iotjs_mqtt_window_t *window = &mqttclient->window;
+  double max_bytes = JS_GET_ARG(1, number);
+
+  if (spool == NULL) {
+    return jerry_create_undefined();
+  }
+
+  // The broker's Receive Maximum may allow fewer packets in flight than
+  // there are free ids.
+  uint16_t in_flight = window->size - window->available;
+  uint16_t max_ids = 0;
+  if (in_flight < window->limit) {
+    max_ids = window->limit - in_flight;
+    if (max_ids > window->available) {
+      max_ids = window->available;
+    }
+  }
+
+  iotjs_mqtt_spool_iter_t iter;
+  const char *packet;
+  uint32_t length;
+  uint16_t id_offset;
+  size_t total = 0;
+  uint32_t records = 0;
+  uint16_t ids = 0;
+  uint16_t *packet_ids = IOTJS_CALLOC((size_t)max_ids + 1, uint16_t);
+
+  iotjs_mqtt_spool_iter_init(spool, &iter);
+
+  // The ids are taken before anything is removed from the spool, the
+  // packets after the first one without a free id stay spooled.
+  while ((packet = iotjs_mqtt_spool_iter_next(spool, &iter, &length,
+                                              &id_offset)) != NULL) {
+    if ((id_offset != 0 && ids == max_ids) ||
+        (records > 0 && (double)(total + length) > max_bytes)) {
+      break;
+    }
+
+    if (id_offset != 0) {
+      uint16_t id = iotjs_mqtt_window_acquire(window);
+      if (id == 0) {
         break;
       }
+      packet_ids[ids++] = id;
     }
 
-    char first_byte = current_buffer[0];
-    current_buffer += 1 + packet_size_length;
+    total += length;
+    records++;
+  }
 
-    int ret_val =
-        iotjs_mqtt_handle(jnat, first_byte, current_buffer, packet_size);
+  if (records == 0) {
+    IOTJS_RELEASE(packet_ids);
+    return jerry_create_undefined();
+  }
 
-    if (ret_val != 0) {
-      return iotjs_mqtt_handle_error(ret_val);
+  jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(total);
+  iotjs_bufferwrap_t *buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+  jerry_value_t jresult = jerry_create_array(1 + 3 * (uint32_t)ids);
+  uint32_t index = 0;
+  size_t offset = 0;
+  uint16_t next_id = 0;
+
+  iotjs_jval_set_property_by_index(jresult, index++, jbuffer);
+  jerry_release_value(jbuffer);
+
+  while (records-- > 0) {
+    iotjs_mqtt_spool_iter_init(spool, &iter);
+    packet = iotjs_mqtt_spool_iter_next(spool, &iter, &length, &id_offset);
+
+    uint8_t *dst = (uint8_t *)buffer_wrap->buffer + offset;
+    memcpy(dst, packet, length);
+    iotjs_mqtt_spool_shift(spool);
+
+    // The packet is sent for the first time in this session.
+    dst[0] &= (uint8_t)~0x08;
+
+    if (id_offset != 0) {
+      uint16_t id = packet_ids[next_id++];
+      dst[id_offset] = (uint8_t)(id >> 8);
+      dst[id_offset + 1] = (uint8_t)(id & 0x00FF);
+
+      double values[3] = { id, (double)offset, (double)(offset + length) };
+      for (uint8_t i = 0; i < 3; i++) {
+        jerry_value_t jvalue = jerry_create_number(values[i]);
+        iotjs_jval_set_property_by_index(jresult, index++, jvalue);
+        jerry_release_value(jvalue);
+      }
     }
 
-    current_buffer += packet_size;
+    offset += length;
   }
 
-  if (current_buffer == mqttclient->buffer) {
-    return jerry_create_undefined();
+  IOTJS_RELEASE(packet_ids);
+  return jresult;
+}
+
+
+// Registers the handler id of a topic filter. Returns with the id of the
+// handler it replaced, or -1.
+JS_FUNCTION(MqttAddFilter) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(3, object, any, number);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
+  }
+
+  iotjs_tmp_buffer_t filter;
+  iotjs_jval_as_tmp_buffer(JS_GET_ARG(1, any), &filter);
+
+  if (jerry_value_is_error(filter.jval)) {
+    return filter.jval;
+  }
+
+  if (filter.length >= UINT16_MAX ||
+      !iotjs_mqtt_filter_is_valid(filter.buffer, filter.length)) {
+    iotjs_free_tmp_buffer(&filter);
+    return JS_CREATE_ERROR(COMMON, "Invalid MQTT topic filter.");
+  }
+
+  int32_t handler = (int32_t)JS_GET_ARG(2, number);
+  int32_t previous = iotjs_mqtt_filter_add(&mqttclient->filters, filter.buffer,
+                                           filter.length, handler);
+
+  iotjs_free_tmp_buffer(&filter);
+  return jerry_create_number(previous);
+}
+
+
+// Removes a topic filter. Returns with the id of its handler, or -1.
+JS_FUNCTION(MqttRemoveFilter) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(2, object, any);
+
+  iotjs_mqttclient_t *mqttclient = iotjs_mqtt_get_client(JS_GET_ARG(0, object));
+  if (mqttclient == NULL) {
+    return JS_CREATE_ERROR(COMMON, "MQTT native pointer not available");
   }
 
-  uint32_t remaining_size = (uint32_t)(current_buffer_end - current_buffer);
-  char *buffer = IOTJS_CALLOC(remaining_size, char);
-  memcpy(buffer, current_buffer, remaining_size);
+  iotjs_tmp_buffer_t filter;
+  iotjs_jval_as_tmp_buffer(JS_GET_ARG(1, any), &filter);
 
-  if (mqttclient->buffer != NULL) {
-    IOTJS_RELEASE(mqttclient->buffer);
+  if (jerry_value_is_error(filter.jval)) {
+    return filter.jval;
   }
 
-  mqttclient->buffer = buffer;
-  mqttclient->buffer_length = remaining_size;
+  int32_t handler = -1;
 
-  return jerry_create_undefined();
+  if (filter.buffer != NULL) {
+    handler = iotjs_mqtt_filter_remove(&mqttclient->filters, filter.buffer,
+                                       filter.length);
+  }
+
+  iotjs_free_tmp_buffer(&filter);
+  return jerry_create_number(handler);
 }
 
+
 static jerry_value_t iotjs_mqtt_subscribe_handler(
     const jerry_value_t jthis, const jerry_value_t jargv[],
     const jerry_value_t jargc,
@@ -717,6 +1787,17 @@ static jerry_value_t iotjs_mqtt_subscribe_handler(
   uint32_t header = (uint32_t)JS_GET_ARG(1, number);
   uint32_t packet_identifier = (header & 0xFFFF);
 
+  // The properties are only passed for MQTT 5.
+  bool is_v5 = jargc > 2;
+  iotjs_mqtt_buffer_t properties = { 0 };
+
+  if (is_v5 && !iotjs_mqtt_properties_encode(jargv[2], 0, &properties)) {
+    IOTJS_RELEASE(properties.data);
+    iotjs_free_tmp_buffer(&topic);
+
+    return JS_CREATE_ERROR(COMMON, "MQTT: Invalid property");
+  }
+
   // Low 4 bits must be 0,0,1,0
   uint8_t header_byte = (packet_type << 4) | (1 << 1);
 
@@ -728,6 +1809,12 @@ static jerry_value_t iotjs_mqtt_subscribe_handler(
   }
 
   size_t variable_header_len = IOTJS_MQTT_LSB_MSB_SIZE;
+
+  if (is_v5) {
+    variable_header_len +=
+        get_remaining_length_size(properties.length) + properties.length;
+  }
+
   uint32_t remaining_length = payload_len + variable_header_len;
   size_t full_len = sizeof(header_byte) +
                     get_remaining_length_size(remaining_length) +
@@ -746,6 +1833,11 @@ static jerry_value_t iotjs_mqtt_subscribe_handler(
   *buff_ptr++ = (uint8_t)(packet_identifier >> 8);
   *buff_ptr++ = (uint8_t)(packet_identifier & 0x00FF);
 
+  if (is_v5) {
+    buff_ptr = iotjs_mqtt_properties_serialize(buff_ptr, &properties);
+    IOTJS_RELEASE(properties.data);
+  }
+
   buff_ptr = iotjs_mqtt_string_serialize(buff_ptr, &topic);
 
   if (packet_type == SUBSCRIBE) {
@@ -842,14 +1934,24 @@ JS_FUNCTION(MqttSendAck) {
 
 jerry_value_t InitMQTT() {
   jerry_value_t jMQTT = jerry_create_object();
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_ACQUIREID, MqttAcquireId);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_ADDFILTER, MqttAddFilter);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_CONNECT, MqttConnect);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_DISCONNECT, MqttDisconnect);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_PING, MqttPing);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_PUBLISH, MqttPublish);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_REFRESHID, MqttRefreshId);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_RELEASEID, MqttReleaseId);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_REMOVEFILTER,
+                        MqttRemoveFilter);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_MQTTINIT, MqttInit);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_MQTTRECEIVE, MqttReceive);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_SENDACK, MqttSendAck);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_SPOOLAPPEND, MqttSpoolAppend);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_SPOOLOPEN, MqttSpoolOpen);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_SPOOLREPLAY, MqttSpoolReplay);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_SUBSCRIBE, MqttSubscribe);
+  iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_TICK, MqttTick);
   iotjs_jval_set_method(jMQTT, IOTJS_MAGIC_STRING_UNSUBSCRIBE, MqttUnsubscribe);
 
   return jMQTT;
@@ -20,6 +20,23 @@
 
 #define IOTJS_MODULE_MQTT_MAX_REMAINING_LENGTH_BYTES 4
 #define IOTJS_MQTT_LSB_MSB_SIZE 2
+// First allocation of the receive buffer.
+#define IOTJS_MQTT_BUFFER_MIN_SIZE 256
+// A drained receive buffer above this capacity is released.
+#define IOTJS_MQTT_BUFFER_KEEP_SIZE 4096
+// Default number of packets waiting for acknowledgement.
+#define IOTJS_MQTT_DEFAULT_RECEIVE_MAXIMUM 64
+// Unacknowledged packets are retransmitted after this many ticks.
+#define IOTJS_MQTT_RETRANSMIT_TICKS 8
+// An unacknowledged packet is dropped after this many retransmit periods.
+#define IOTJS_MQTT_MAX_ATTEMPTS 8
+// Size limits of the spool file, in bytes.
+#define IOTJS_MQTT_SPOOL_DEFAULT_SIZE (64 * 1024)
+#define IOTJS_MQTT_SPOOL_MIN_SIZE 256
+#define IOTJS_MQTT_SPOOL_MAX_SIZE (64 * 1024 * 1024)
+// Protocol levels of MQTT 3.1.1 and MQTT 5.
+#define IOTJS_MQTT_PROTOCOL_V4 4
+#define IOTJS_MQTT_PROTOCOL_V5 5
 
 /*
  * The types of the control packet.
@@ -52,6 +69,10 @@ typedef enum {
   MQTT_ERR_CORRUPTED_PACKET = 6,
   MQTT_ERR_UNALLOWED_PACKET = 7,
   MQTT_ERR_SUBSCRIPTION_FAILED = 8,
+  MQTT_ERR_PACKET_TOO_LARGE = 9,
+  MQTT_ERR_TOPIC_ALIAS_INVALID = 10,
+  // MQTT 5 reason codes from 0x80 are failures reported by the broker.
+  MQTT_REASON_FAILURE = 0x80,
 } iotjs_mqtt_packet_error_t;
 
 /*
@@ -131,9 +152,137 @@ enum {
   MQTT_FLAG_USERNAME = 1 << 7
 } iotjs_mqtt_connect_flag_t;
 
+// Growable byte buffer, the capacity is doubled when it runs out of space
+// so a packet arriving in many reads is copied only once.
 typedef struct {
-  char *buffer;
-  uint32_t buffer_length;
+  char *data;
+  size_t length;
+  size_t capacity;
+} iotjs_mqtt_buffer_t;
+
+/*
+ * A level of a topic filter in the subscription trie. The levels of the
+ * subscribed filters sharing the same prefix are chained by `next`.
+ */
+typedef struct iotjs_mqtt_topic_node_s {
+  struct iotjs_mqtt_topic_node_s *next;
+  struct iotjs_mqtt_topic_node_s *children;
+  // Id of the handler of the filter ending at this level, or -1.
+  int32_t handler;
+  uint16_t length;
+  char level[];
+} iotjs_mqtt_topic_node_t;
+
+typedef enum {
+  MQTT_INFLIGHT_FREE = 0,
+  // Waiting for an acknowledgement in the retransmit queue.
+  MQTT_INFLIGHT_QUEUED,
+  // Undelivered, the id is reused once the packet is released.
+  MQTT_INFLIGHT_EXPIRED,
+} iotjs_mqtt_inflight_state_t;
+
+/*
+ * Entry of the in-flight table, indexed by packet id. Entry 0 is the head of
+ * the retransmit queue, which is a circular list ordered by deadline. Free
+ * entries are chained by `next`.
+ */
+typedef struct {
+  uint16_t prev;
+  uint16_t next;
+  uint32_t deadline;
+  uint8_t attempts;
+  uint8_t state;
+} iotjs_mqtt_inflight_t;
+
+typedef struct {
+  iotjs_mqtt_inflight_t *entries;
+  uint16_t size;
+  // Packets in flight allowed by the broker, at most `size`.
+  uint16_t limit;
+  uint16_t available;
+  uint16_t free_head;
+  uint32_t ticks;
+} iotjs_mqtt_window_t;
+
+/*
+ * Types of the MQTT 5 property values.
+ */
+typedef enum {
+  MQTT_PROPERTY_BYTE,
+  MQTT_PROPERTY_UINT16,
+  MQTT_PROPERTY_UINT32,
+  MQTT_PROPERTY_VARINT,
+  MQTT_PROPERTY_STRING,
+  MQTT_PROPERTY_BINARY,
+  MQTT_PROPERTY_PAIR,
+} iotjs_mqtt_property_type_t;
+
+enum {
+  MQTT_PROPERTY_SUBSCRIPTION_IDENTIFIER = 0x0B,
+  MQTT_PROPERTY_RECEIVE_MAXIMUM = 0x21,
+  MQTT_PROPERTY_TOPIC_ALIAS_MAXIMUM = 0x22,
+  MQTT_PROPERTY_TOPIC_ALIAS = 0x23,
+  MQTT_PROPERTY_MAXIMUM_PACKET_SIZE = 0x27,
+};
+
+/*
+ * The properties which are processed by the client itself, zero if absent.
+ */
+typedef struct {
+  uint32_t maximum_packet_size;
+  uint16_t receive_maximum;
+  uint16_t topic_alias_maximum;
+  uint16_t topic_alias;
+} iotjs_mqtt_properties_t;
+
+void iotjs_mqtt_buffer_append(iotjs_mqtt_buffer_t *buff, const char *data,
+                              size_t size);
+bool iotjs_mqtt_properties_encode(jerry_value_t jproperties,
+                                  uint16_t topic_alias,
+                                  iotjs_mqtt_buffer_t *out);
+int32_t iotjs_mqtt_properties_decode(const char *data, uint32_t size,
+                                     iotjs_mqtt_properties_t *properties,
+                                     jerry_value_t *jproperties);
+const char *iotjs_mqtt_reason_string(uint8_t reason_code);
+
+/*
+ * Memory-mapped file of the packets published while offline.
+ */
+typedef struct iotjs_mqtt_spool_s iotjs_mqtt_spool_t;
+
+typedef struct {
+  uint32_t offset;
+  uint32_t remaining;
+} iotjs_mqtt_spool_iter_t;
+
+iotjs_mqtt_spool_t *iotjs_mqtt_spool_open(const char *path,
+                                          uint32_t capacity);
+void iotjs_mqtt_spool_close(iotjs_mqtt_spool_t *spool);
+uint32_t iotjs_mqtt_spool_count(const iotjs_mqtt_spool_t *spool);
+void iotjs_mqtt_spool_shift(iotjs_mqtt_spool_t *spool);
+bool iotjs_mqtt_spool_append(iotjs_mqtt_spool_t *spool, const char *packet,
+                             uint32_t length, uint16_t id_offset);
+void iotjs_mqtt_spool_iter_init(const iotjs_mqtt_spool_t *spool,
+                                iotjs_mqtt_spool_iter_t *iter);
+const char *iotjs_mqtt_spool_iter_next(const iotjs_mqtt_spool_t *spool,
+                                       iotjs_mqtt_spool_iter_t *iter,
+                                       uint32_t *length, uint16_t *id_offset);
+
+typedef struct {
+  // Holds the beginning of a packet until the rest of it arrives.
+  iotjs_mqtt_buffer_t buffer;
+  // First level of the topic filters with a handler.
+  iotjs_mqtt_topic_node_t *filters;
+  // Packet ids of the unacknowledged QoS 1, QoS 2 and subscribe packets.
+  iotjs_mqtt_window_t window;
+  // Optional persistent queue of the packets published while offline.
+  iotjs_mqtt_spool_t *spool;
+  // Topics of the aliases chosen by the broker, indexed by alias - 1.
+  iotjs_mqtt_buffer_t *topic_aliases;
+  uint16_t topic_alias_maximum;
+  uint8_t protocol_version;
+  // Larger incoming packets are rejected, zero means no limit.
+  uint32_t maximum_packet_size;
 } iotjs_mqttclient_t;
 
 #endif /* IOTJS_MODULE_MQTT_H */
@@ -0,0 +1,524 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * MQTT 5 properties.
+ *
+ * The properties of a packet are a variable byte integer length followed
+ * by identifier / value pairs. They are converted from and to plain
+ * JavaScript objects whose keys are the property names of the table below.
+ */
+
+#include <string.h>
+
+#include "iotjs_def.h"
+#include "iotjs_module_buffer.h"
+#include "iotjs_module_mqtt.h"
+
+typedef struct {
+  uint8_t id;
+  uint8_t type;
+  const char *name;
+} iotjs_mqtt_property_t;
+
+static const iotjs_mqtt_property_t iotjs_mqtt_property_table[] = {
+  { 0x01, MQTT_PROPERTY_BYTE, IOTJS_MAGIC_STRING_PAYLOADFORMATINDICATOR },
+  { 0x02, MQTT_PROPERTY_UINT32, IOTJS_MAGIC_STRING_MESSAGEEXPIRYINTERVAL },
+  { 0x03, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_CONTENTTYPE },
+  { 0x08, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_RESPONSETOPIC },
+  { 0x09, MQTT_PROPERTY_BINARY, IOTJS_MAGIC_STRING_CORRELATIONDATA },
+  { 0x0B, MQTT_PROPERTY_VARINT, IOTJS_MAGIC_STRING_SUBSCRIPTIONIDENTIFIER },
+  { 0x11, MQTT_PROPERTY_UINT32, IOTJS_MAGIC_STRING_SESSIONEXPIRYINTERVAL },
+  { 0x12, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_ASSIGNEDCLIENTIDENTIFIER },
+  { 0x13, MQTT_PROPERTY_UINT16, IOTJS_MAGIC_STRING_SERVERKEEPALIVE },
+  { 0x15, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_AUTHENTICATIONMETHOD },
+  { 0x16, MQTT_PROPERTY_BINARY, IOTJS_MAGIC_STRING_AUTHENTICATIONDATA },
+  { 0x17, MQTT_PROPERTY_BYTE, IOTJS_MAGIC_STRING_REQUESTPROBLEMINFORMATION },
+  { 0x18, MQTT_PROPERTY_UINT32, IOTJS_MAGIC_STRING_WILLDELAYINTERVAL },
+  { 0x19, MQTT_PROPERTY_BYTE, IOTJS_MAGIC_STRING_REQUESTRESPONSEINFORMATION },
+  { 0x1A, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_RESPONSEINFORMATION },
+  { 0x1C, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_SERVERREFERENCE },
+  { 0x1F, MQTT_PROPERTY_STRING, IOTJS_MAGIC_STRING_REASONSTRING },
+  { 0x21, MQTT_PROPERTY_UINT16, IOTJS_MAGIC_STRING_RECEIVEMAXIMUM },
+  { 0x22, MQTT_PROPERTY_UINT16, IOTJS_MAGIC_STRING_TOPICALIASMAXIMUM },
+  { 0x23, MQTT_PROPERTY_UINT16, IOTJS_MAGIC_STRING_TOPICALIAS },
+  { 0x24, MQTT_PROPERTY_BYTE, IOTJS_MAGIC_STRING_MAXIMUMQOS },
+  { 0x25, MQTT_PROPERTY_BYTE, IOTJS_MAGIC_STRING_RETAINAVAILABLE },
+  { 0x26, MQTT_PROPERTY_PAIR, IOTJS_MAGIC_STRING_USERPROPERTIES },
+  { 0x27, MQTT_PROPERTY_UINT32, IOTJS_MAGIC_STRING_MAXIMUMPACKETSIZE },
+  { 0x28, MQTT_PROPERTY_BYTE,
+    IOTJS_MAGIC_STRING_WILDCARDSUBSCRIPTIONAVAILABLE },
+  { 0x29, MQTT_PROPERTY_BYTE,
+    IOTJS_MAGIC_STRING_SUBSCRIPTIONIDENTIFIERSAVAILABLE },
+  { 0x2A, MQTT_PROPERTY_BYTE,
+    IOTJS_MAGIC_STRING_SHAREDSUBSCRIPTIONAVAILABLE },
+};
+
+#define IOTJS_MQTT_PROPERTY_COUNT \
+  (sizeof(iotjs_mqtt_property_table) / sizeof(iotjs_mqtt_property_t))
+
+// Largest value of a variable byte integer.
+#define IOTJS_MQTT_VARINT_MAX 268435455
+
+
+static const iotjs_mqtt_property_t *iotjs_mqtt_property_find(uint8_t id) {
+  for (size_t i = 0; i < IOTJS_MQTT_PROPERTY_COUNT; i++) {
+    if (iotjs_mqtt_property_table[i].id == id) {
+      return iotjs_mqtt_property_table + i;
+    }
+  }
+
+  return NULL;
+}
+
+
+static void iotjs_mqtt_put_uint(iotjs_mqtt_buffer_t *out, uint32_t value,
+                                size_t size) {
+  char bytes[4];
+
+  // Multi-byte integers are big endian.
+  for (size_t i = size; i > 0; i--) {
+    bytes[i - 1] = (char)(value & 0xFF);
+    value >>= 8;
+  }
+
+  iotjs_mqtt_buffer_append(out, bytes, size);
+}
+
+
+static void iotjs_mqtt_put_varint(iotjs_mqtt_buffer_t *out, uint32_t value) {
+  char bytes[4];
+  size_t size = 0;
+
+  do {
+    uint8_t digit = value & 0x7F;
+    value >>= 7;
+    bytes[size++] = (char)(value > 0 ? (digit | 0x80) : digit);
+  } while (value > 0);
+
+  iotjs_mqtt_buffer_append(out, bytes, size);
+}
+
+
+// Returns with the number of bytes of the variable byte integer at the
+// start of `data`, or -1 if it is malformed or incomplete.
+static int32_t iotjs_mqtt_get_varint(const uint8_t *data, size_t size,
+                                     uint32_t *value) {
+  uint32_t result = 0;
+
+  for (size_t i = 0; i < size && i < 4; i++) {
+    result |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+
+    if ((data[i] & 0x80) == 0) {
+      *value = result;
+      return (int32_t)i + 1;
+    }
+  }
+
+  return -1;
+}
+
+
+static bool iotjs_mqtt_put_string(iotjs_mqtt_buffer_t *out,
+                                  jerry_value_t jvalue) {
+  iotjs_tmp_buffer_t value;
+  iotjs_jval_as_tmp_buffer(jvalue, &value);
+
+  bool valid = !jerry_value_is_error(value.jval) && value.length <= UINT16_MAX;
+
+  if (valid) {
+    iotjs_mqtt_put_uint(out, (uint32_t)value.length, 2);
+    iotjs_mqtt_buffer_append(out, value.buffer, value.length);
+  }
+
+  iotjs_free_tmp_buffer(&value);
+  return valid;
+}
+
+
+static bool iotjs_mqtt_put_pairs(iotjs_mqtt_buffer_t *out, uint8_t id,
+                                 jerry_value_t jpairs) {
+  if (!jerry_value_is_object(jpairs)) {
+    return false;
+  }
+
+  jerry_value_t jkeys = jerry_get_object_keys(jpairs);
+  uint32_t length = jerry_get_array_length(jkeys);
+  bool valid = true;
+
+  for (uint32_t i = 0; i < length && valid; i++) {
+    jerry_value_t jkey = iotjs_jval_get_property_by_index(jkeys, i);
+    jerry_value_t jvalue = jerry_get_property(jpairs, jkey);
+
+    // Every pair is a separate property with the same identifier.
+    iotjs_mqtt_put_uint(out, id, 1);
+    valid = iotjs_mqtt_put_string(out, jkey) &&
+            iotjs_mqtt_put_string(out, jvalue);
+
+    jerry_release_value(jvalue);
+    jerry_release_value(jkey);
+  }
+
+  jerry_release_value(jkeys);
+  return valid;
+}
+
+
+static bool iotjs_mqtt_put_property(iotjs_mqtt_buffer_t *out,
+                                    const iotjs_mqtt_property_t *property,
+                                    jerry_value_t jvalue) {
+  if (property->type == MQTT_PROPERTY_PAIR) {
+    return iotjs_mqtt_put_pairs(out, property->id, jvalue);
+  }
+
+  if (property->type == MQTT_PROPERTY_STRING ||
+      property->type == MQTT_PROPERTY_BINARY) {
+    iotjs_mqtt_put_uint(out, property->id, 1);
+    return iotjs_mqtt_put_string(out, jvalue);
+  }
+
+  double value;
+
+  if (jerry_value_is_boolean(jvalue)) {
+    value = jerry_get_boolean_value(jvalue) ? 1 : 0;
+  } else if (jerry_value_is_number(jvalue)) {
+    value = jerry_get_number_value(jvalue);
+  } else {
+    return false;
+  }
+
+  double max = IOTJS_MQTT_VARINT_MAX;
+
+  if (property->type == MQTT_PROPERTY_BYTE) {
+    max = UINT8_MAX;
+  } else if (property->type == MQTT_PROPERTY_UINT16) {
+    max = UINT16_MAX;
+  } else if (property->type == MQTT_PROPERTY_UINT32) {
+    max = UINT32_MAX;
+  }
+
+  if (!(value >= 0 && value <= max) || value != (uint32_t)value) {
+    return false;
+  }
+
+  iotjs_mqtt_put_uint(out, property->id, 1);
+
+  switch (property->type) {
+    case MQTT_PROPERTY_BYTE:
+      iotjs_mqtt_put_uint(out, (uint32_t)value, 1);
+      break;
+    case MQTT_PROPERTY_UINT16:
+      iotjs_mqtt_put_uint(out, (uint32_t)value, 2);
+      break;
+    case MQTT_PROPERTY_UINT32:
+      iotjs_mqtt_put_uint(out, (uint32_t)value, 4);
+      break;
+    default:
+      iotjs_mqtt_put_varint(out, (uint32_t)value);
+      break;
+  }
+
+  return true;
+}
+
+
+// Appends the properties of `jproperties` to `out` without the length
+// field. The topic alias is managed by the client, so it is taken from
+// `topic_alias` instead of the object. Returns with false if a property
+// has an invalid value.
+bool iotjs_mqtt_properties_encode(jerry_value_t jproperties,
+                                  uint16_t topic_alias,
+                                  iotjs_mqtt_buffer_t *out) {
+  if (jerry_value_is_object(jproperties)) {
+    for (size_t i = 0; i < IOTJS_MQTT_PROPERTY_COUNT; i++) {
+      const iotjs_mqtt_property_t *property = iotjs_mqtt_property_table + i;
+
+      if (property->id == MQTT_PROPERTY_TOPIC_ALIAS) {
+        continue;
+      }
+
+      jerry_value_t jvalue =
+          iotjs_jval_get_property(jproperties, property->name);
+      bool valid = !jerry_value_is_error(jvalue);
+
+      if (valid && !jerry_value_is_undefined(jvalue)) {
+        valid = iotjs_mqtt_put_property(out, property, jvalue);
+      }
+
+      jerry_release_value(jvalue);
+
+      if (!valid) {
+        return false;
+      }
+    }
+  }
+
+  if (topic_alias != 0) {
+    iotjs_mqtt_put_uint(out, MQTT_PROPERTY_TOPIC_ALIAS, 1);
+    iotjs_mqtt_put_uint(out, topic_alias, 2);
+  }
+
+  return true;
+}
+
+
+// Decodes the properties at the start of `data`, including the length
+// field. The values used by the client are stored in `properties`, and if
+// `jproperties` is not NULL, all of them are collected into an object.
+// Returns with the number of bytes used, or -1 if the properties are
+// malformed.
+int32_t iotjs_mqtt_properties_decode(const char *data, uint32_t size,
+                                     iotjs_mqtt_properties_t *properties,
+                                     jerry_value_t *jproperties) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint32_t length;
+  int32_t header_size = iotjs_mqtt_get_varint(bytes, size, &length);
+
+  if (header_size < 0 || length > size - (uint32_t)header_size) {
+    return -1;
+  }
+
+  const uint8_t *current = bytes + header_size;
+  const uint8_t *end = current + length;
+  jerry_value_t jobject = jerry_create_undefined();
+  jerry_value_t juser = jerry_create_undefined();
+
+  memset(properties, 0, sizeof(iotjs_mqtt_properties_t));
+
+  if (jproperties != NULL && length > 0) {
+    jobject = jerry_create_object();
+  }
+
+  // Only user properties and subscription identifiers may be repeated.
+  uint64_t seen = 0;
+
+  while (current < end) {
+    const iotjs_mqtt_property_t *property = iotjs_mqtt_property_find(*current);
+    size_t available = (size_t)(end - current) - 1;
+    uint32_t value = 0;
+    jerry_value_t jvalue = jerry_create_undefined();
+
+    if (property == NULL) {
+      goto malformed;
+    }
+
+    if (property->type != MQTT_PROPERTY_PAIR &&
+        property->id != MQTT_PROPERTY_SUBSCRIPTION_IDENTIFIER) {
+      uint64_t bit = (uint64_t)1 << property->id;
+      if (seen & bit) {
+        goto malformed;
+      }
+      seen |= bit;
+    }
+
+    current++;
+
+    switch (property->type) {
+      case MQTT_PROPERTY_BYTE:
+      case MQTT_PROPERTY_UINT16:
+      case MQTT_PROPERTY_UINT32: {
+        size_t value_size = 4;
+
+        if (property->type == MQTT_PROPERTY_BYTE) {
+          value_size = 1;
+        } else if (property->type == MQTT_PROPERTY_UINT16) {
+          value_size = 2;
+        }
+
+        if (available < value_size) {
+          goto malformed;
+        }
+
+        for (size_t i = 0; i < value_size; i++) {
+          value = (value << 8) | current[i];
+        }
+        current += value_size;
+        break;
+      }
+      case MQTT_PROPERTY_VARINT: {
+        int32_t used = iotjs_mqtt_get_varint(current, available, &value);
+
+        if (used < 0) {
+          goto malformed;
+        }
+        current += used;
+        break;
+      }
+      default: {
+        // Strings, binary data and the two strings of a user property.
+        uint32_t count = property->type == MQTT_PROPERTY_PAIR ? 2 : 1;
+        jerry_value_t jstrings[2] = { jerry_create_undefined(),
+                                      jerry_create_undefined() };
+
+        for (uint32_t i = 0; i < count; i++) {
+          size_t string_length = SIZE_MAX;
+
+          if (available >= IOTJS_MQTT_LSB_MSB_SIZE) {
+            string_length = ((size_t)current[0] << 8) | current[1];
+            current += IOTJS_MQTT_LSB_MSB_SIZE;
+            available -= IOTJS_MQTT_LSB_MSB_SIZE;
+          }
+
+          if (available < string_length ||
+              (property->type != MQTT_PROPERTY_BINARY &&
+               !jerry_is_valid_utf8_string(current,
+                                           (jerry_size_t)string_length))) {
+            jerry_release_value(jstrings[0]);
+            goto malformed;
+          }
+
+          if (jproperties == NULL) {
+            jstrings[i] = jerry_create_undefined();
+          } else if (property->type == MQTT_PROPERTY_BINARY) {
+            jstrings[i] = iotjs_bufferwrap_create_buffer(string_length);
+            iotjs_bufferwrap_t *buffer_wrap =
+                iotjs_bufferwrap_from_jbuffer(jstrings[i]);
+            memcpy(buffer_wrap->buffer, current, string_length);
+          } else {
+            jstrings[i] =
+                jerry_create_string_sz(current, (jerry_size_t)string_length);
+          }
+
+          current += string_length;
+          available -= string_length;
+        }
+
+        if (property->type != MQTT_PROPERTY_PAIR) {
+          jvalue = jstrings[0];
+          break;
+        }
+
+        if (jproperties != NULL) {
+          if (jerry_value_is_undefined(juser)) {
+            juser = jerry_create_object();
+          }
+
+          jerry_release_value(jerry_set_property(juser, jstrings[0],
+                                                 jstrings[1]));
+        }
+
+        jerry_release_value(jstrings[0]);
+        jerry_release_value(jstrings[1]);
+        continue;
+      }
+    }
+
+    switch (property->id) {
+      case MQTT_PROPERTY_RECEIVE_MAXIMUM:
+        properties->receive_maximum = (uint16_t)value;
+        break;
+      case MQTT_PROPERTY_TOPIC_ALIAS_MAXIMUM:
+        properties->topic_alias_maximum = (uint16_t)value;
+        break;
+      case MQTT_PROPERTY_TOPIC_ALIAS:
+        properties->topic_alias = (uint16_t)value;
+        break;
+      case MQTT_PROPERTY_MAXIMUM_PACKET_SIZE:
+        properties->maximum_packet_size = value;
+        break;
+    }
+
+    if (jproperties != NULL) {
+      if (jerry_value_is_undefined(jvalue)) {
+        jvalue = jerry_create_number(value);
+      }
+
+      iotjs_jval_set_property_jval(jobject, property->name, jvalue);
+    }
+
+    jerry_release_value(jvalue);
+  }
+
+  if (jproperties != NULL) {
+    if (!jerry_value_is_undefined(juser)) {
+      iotjs_jval_set_property_jval(jobject, IOTJS_MAGIC_STRING_USERPROPERTIES,
+                                   juser);
+      jerry_release_value(juser);
+    }
+
+    *jproperties = jobject;
+  }
+
+  return header_size + (int32_t)length;
+
+malformed:
+  jerry_release_value(juser);
+  jerry_release_value(jobject);
+  return -1;
+}
+
+
+const char *iotjs_mqtt_reason_string(uint8_t reason_code) {
+  switch (reason_code) {
+    case 0x81:
+      return "Malformed packet";
+    case 0x82:
+      return "Protocol error";
+    case 0x83:
+      return "Implementation specific error";
+    case 0x84:
+      return "Unsupported protocol version";
+    case 0x85:
+      return "Client identifier not valid";
+    case 0x86:
+      return "Bad user name or password";
+    case 0x87:
+      return "Not authorized";
+    case 0x88:
+      return "Server unavailable";
+    case 0x89:
+      return "Server busy";
+    case 0x8A:
+      return "Banned";
+    case 0x8C:
+      return "Bad authentication method";
+    case 0x8F:
+      return "Topic filter invalid";
+    case 0x90:
+      return "Topic name invalid";
+    case 0x91:
+      return "Packet identifier in use";
+    case 0x92:
+      return "Packet identifier not found";
+    case 0x93:
+      return "Receive maximum exceeded";
+    case 0x94:
+      return "Topic alias invalid";
+    case 0x95:
+      return "Packet too large";
+    case 0x97:
+      return "Quota exceeded";
+    case 0x99:
+      return "Payload format invalid";
+    case 0x9A:
+      return "Retain not supported";
+    case 0x9B:
+      return "QoS not supported";
+    case 0x9C:
+      return "Use another server";
+    case 0x9D:
+      return "Server moved";
+    case 0x9E:
+      return "Shared subscriptions not supported";
+    case 0x9F:
+      return "Connection rate exceeded";
+    case 0xA1:
+      return "Subscription identifiers not supported";
+    case 0xA2:
+      return "Wildcard subscriptions not supported";
+    default:
+      return "Unspecified error";
+  }
+}
@@ -0,0 +1,454 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Persistent queue of the PUBLISH packets which could not be sent.
+ *
+ * The spool file is a header followed by a ring of records. The records
+ * are appended at the tail and the oldest ones are evicted from the head
+ * when the ring is full. A record never wraps around the end of the ring,
+ * the unused space at the end is skipped by a wrap record.
+ *
+ * Each record carries a sequence number and its commit marker is written
+ * last. When the file is opened, the records are scanned from the head and
+ * the scan stops at the first record which is not committed or which has
+ * an unexpected sequence number, so a record torn by a crash and the stale
+ * records of earlier rounds are dropped.
+ */
+
+#include "iotjs_def.h"
+#include "iotjs_module_mqtt.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+enum {
+  MQTT_SPOOL_MAGIC = 0x514d4a49, // "IJMQ"
+  MQTT_SPOOL_VERSION = 1,
+  MQTT_SPOOL_COMMIT = 0x434f4d54,
+  MQTT_SPOOL_WRAP = 0x57524150,
+  MQTT_SPOOL_ALIGN = 8,
+};
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;
+  uint32_t reserved;
+  // Offset of the oldest record in the low, and its sequence number in
+  // the high 32 bits. Updated with a single store.
+  uint64_t head;
+} iotjs_mqtt_spool_header_t;
+
+typedef struct {
+  uint32_t marker;
+  uint32_t sequence;
+  uint32_t length;
+  // Offset of the packet id in the packet, 0 for QoS 0 packets.
+  uint16_t id_offset;
+  uint16_t reserved;
+} iotjs_mqtt_spool_record_t;
+
+struct iotjs_mqtt_spool_s {
+  int fd;
+  char *map;
+  size_t map_size;
+  iotjs_mqtt_spool_header_t *header;
+  char *data;
+  uint32_t capacity;
+  uint32_t head;
+  uint32_t head_sequence;
+  uint32_t tail;
+  uint32_t tail_sequence;
+  // Bytes between the head and the tail, including skipped space.
+  uint32_t used;
+  uint32_t count;
+};
+
+
+static uint32_t iotjs_mqtt_spool_align(uint32_t size) {
+  return (size + MQTT_SPOOL_ALIGN - 1) & ~(uint32_t)(MQTT_SPOOL_ALIGN - 1);
+}
+
+
+static uint32_t iotjs_mqtt_spool_record_size(uint32_t length) {
+  return iotjs_mqtt_spool_align((uint32_t)sizeof(iotjs_mqtt_spool_record_t) +
+                                length);
+}
+
+
+static iotjs_mqtt_spool_record_t *iotjs_mqtt_spool_record(
+    const iotjs_mqtt_spool_t *spool, uint32_t offset) {
+  return (iotjs_mqtt_spool_record_t *)(spool->data + offset);
+}
+
+
+// There is no room for a record header at the end of the ring, the
+// next record is at the beginning.
+static bool iotjs_mqtt_spool_at_end(const iotjs_mqtt_spool_t *spool,
+                                    uint32_t offset) {
+  return spool->capacity - offset < sizeof(iotjs_mqtt_spool_record_t);
+}
+
+
+static void iotjs_mqtt_spool_store_head(iotjs_mqtt_spool_t *spool) {
+  spool->header->head =
+      ((uint64_t)spool->head_sequence << 32) | (uint64_t)spool->head;
+}
+
+
+// Finds the committed records starting from the head.
+static void iotjs_mqtt_spool_recover(iotjs_mqtt_spool_t *spool) {
+  uint32_t offset = spool->head;
+  uint32_t sequence = spool->head_sequence;
+  uint32_t used = 0;
+  uint32_t count = 0;
+
+  while (used < spool->capacity) {
+    if (iotjs_mqtt_spool_at_end(spool, offset)) {
+      if (spool->capacity - offset > spool->capacity - used) {
+        break;
+      }
+
+      used += spool->capacity - offset;
+      offset = 0;
+      continue;
+    }
+
+    iotjs_mqtt_spool_record_t *record = iotjs_mqtt_spool_record(spool, offset);
+
+    if (record->sequence != sequence) {
+      break;
+    }
+
+    uint32_t size;
+
+    if (record->marker == MQTT_SPOOL_WRAP) {
+      size = spool->capacity - offset;
+    } else if (record->marker == MQTT_SPOOL_COMMIT &&
+               record->length <= spool->capacity) {
+      size = iotjs_mqtt_spool_record_size(record->length);
+    } else {
+      break;
+    }
+
+    if (size > spool->capacity - offset || size > spool->capacity - used) {
+      break;
+    }
+
+    if (record->marker == MQTT_SPOOL_COMMIT) {
+      count++;
+    }
+
+    used += size;
+    offset += size;
+    sequence++;
+
+    if (offset == spool->capacity) {
+      offset = 0;
+    }
+  }
+
+  spool->tail = offset;
+  spool->tail_sequence = sequence;
+  spool->used = used;
+  spool->count = count;
+}
+
+
+iotjs_mqtt_spool_t *iotjs_mqtt_spool_open(const char *path,
+                                          uint32_t capacity) {
+  capacity = iotjs_mqtt_spool_align(capacity);
+
+  if (capacity < IOTJS_MQTT_SPOOL_MIN_SIZE) {
+    capacity = IOTJS_MQTT_SPOOL_MIN_SIZE;
+  } else if (capacity > IOTJS_MQTT_SPOOL_MAX_SIZE) {
+    capacity = IOTJS_MQTT_SPOOL_MAX_SIZE;
+  }
+
+  int fd = open(path, O_RDWR | O_CREAT, 0600);
+
+  if (fd < 0) {
+    return NULL;
+  }
+
+  // An existing spool keeps its size, anything else is reinitialized.
+  iotjs_mqtt_spool_header_t header;
+  struct stat st;
+  bool valid =
+      fstat(fd, &st) == 0 &&
+      pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+      header.magic == MQTT_SPOOL_MAGIC &&
+      header.version == MQTT_SPOOL_VERSION &&
+      header.capacity >= IOTJS_MQTT_SPOOL_MIN_SIZE &&
+      header.capacity <= IOTJS_MQTT_SPOOL_MAX_SIZE &&
+      (header.capacity & (MQTT_SPOOL_ALIGN - 1)) == 0 &&
+      (uint32_t)header.head < header.capacity &&
+      st.st_size == (off_t)(sizeof(header) + header.capacity);
+
+  if (valid) {
+    capacity = header.capacity;
+  }
+
+  size_t map_size = sizeof(iotjs_mqtt_spool_header_t) + capacity;
+
+  if (!valid &&
+      (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)map_size) != 0)) {
+    close(fd);
+    return NULL;
+  }
+
+  void *map =
+      mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (map == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+
+  iotjs_mqtt_spool_t *spool = IOTJS_ALLOC(iotjs_mqtt_spool_t);
+  spool->fd = fd;
+  spool->map = (char *)map;
+  spool->map_size = map_size;
+  spool->header = (iotjs_mqtt_spool_header_t *)map;
+  spool->data = spool->map + sizeof(iotjs_mqtt_spool_header_t);
+  spool->capacity = capacity;
+
+  if (!valid) {
+    spool->header->magic = MQTT_SPOOL_MAGIC;
+    spool->header->version = MQTT_SPOOL_VERSION;
+    spool->header->capacity = capacity;
+    spool->header->head = 0;
+  }
+
+  spool->head = (uint32_t)spool->header->head;
+  spool->head_sequence = (uint32_t)(spool->header->head >> 32);
+  iotjs_mqtt_spool_recover(spool);
+
+  return spool;
+}
+
+
+void iotjs_mqtt_spool_close(iotjs_mqtt_spool_t *spool) {
+  if (spool == NULL) {
+    return;
+  }
+
+  munmap(spool->map, spool->map_size);
+  close(spool->fd);
+  IOTJS_RELEASE(spool);
+}
+
+
+uint32_t iotjs_mqtt_spool_count(const iotjs_mqtt_spool_t *spool) {
+  return spool->count;
+}
+
+
+// Drops the oldest record.
+void iotjs_mqtt_spool_shift(iotjs_mqtt_spool_t *spool) {
+  while (spool->count > 0) {
+    uint32_t size;
+    bool wrap = iotjs_mqtt_spool_at_end(spool, spool->head);
+
+    if (wrap) {
+      size = spool->capacity - spool->head;
+    } else {
+      iotjs_mqtt_spool_record_t *record =
+          iotjs_mqtt_spool_record(spool, spool->head);
+
+      wrap = (record->marker == MQTT_SPOOL_WRAP);
+      size = wrap ? spool->capacity - spool->head
+                  : iotjs_mqtt_spool_record_size(record->length);
+      spool->head_sequence++;
+    }
+
+    spool->used -= size;
+    spool->head += size;
+
+    if (spool->head == spool->capacity) {
+      spool->head = 0;
+    }
+
+    if (!wrap) {
+      spool->count--;
+      break;
+    }
+  }
+
+  if (spool->count == 0) {
+    // Restart from the beginning of the ring when it becomes empty.
+    spool->head = 0;
+    spool->head_sequence = spool->tail_sequence;
+    spool->tail = 0;
+    spool->used = 0;
+  }
+
+  iotjs_mqtt_spool_store_head(spool);
+}
+
+
+// Appends a packet, the oldest records are evicted if there is not enough
+// space. Returns with false if the packet is larger than the spool.
+bool iotjs_mqtt_spool_append(iotjs_mqtt_spool_t *spool, const char *packet,
+                             uint32_t length, uint16_t id_offset) {
+  uint32_t size = iotjs_mqtt_spool_record_size(length);
+
+  if (size > spool->capacity) {
+    return false;
+  }
+
+  uint32_t contiguous;
+
+  while (true) {
+    contiguous = spool->capacity - spool->tail;
+    uint32_t required = contiguous < size ? contiguous + size : size;
+
+    if (spool->capacity - spool->used >= required) {
+      break;
+    }
+
+    // The ring is reset when it becomes empty, so this terminates.
+    iotjs_mqtt_spool_shift(spool);
+  }
+
+  if (contiguous < size) {
+    if (!iotjs_mqtt_spool_at_end(spool, spool->tail)) {
+      iotjs_mqtt_spool_record_t *wrap =
+          iotjs_mqtt_spool_record(spool, spool->tail);
+      wrap->marker = 0;
+      wrap->sequence = spool->tail_sequence++;
+      __sync_synchronize();
+      wrap->marker = MQTT_SPOOL_WRAP;
+    }
+
+    spool->used += contiguous;
+    spool->tail = 0;
+  }
+
+  iotjs_mqtt_spool_record_t *record =
+      iotjs_mqtt_spool_record(spool, spool->tail);
+
+  // The marker of the stale record is cleared before the new content is
+  // written, and the commit marker is written last.
+  record->marker = 0;
+  __sync_synchronize();
+  record->sequence = spool->tail_sequence;
+  record->length = length;
+  record->id_offset = id_offset;
+  record->reserved = 0;
+  memcpy(record + 1, packet, length);
+  __sync_synchronize();
+  record->marker = MQTT_SPOOL_COMMIT;
+
+  spool->tail += size;
+  spool->tail_sequence++;
+  spool->used += size;
+  spool->count++;
+
+  if (spool->tail == spool->capacity) {
+    spool->tail = 0;
+  }
+
+  return true;
+}
+
+
+void iotjs_mqtt_spool_iter_init(const iotjs_mqtt_spool_t *spool,
+                                iotjs_mqtt_spool_iter_t *iter) {
+  iter->offset = spool->head;
+  iter->remaining = spool->count;
+}
+
+
+// Returns with the next packet, or NULL after the last one.
+const char *iotjs_mqtt_spool_iter_next(const iotjs_mqtt_spool_t *spool,
+                                       iotjs_mqtt_spool_iter_t *iter,
+                                       uint32_t *length, uint16_t *id_offset) {
+  while (iter->remaining > 0) {
+    if (iotjs_mqtt_spool_at_end(spool, iter->offset)) {
+      iter->offset = 0;
+      continue;
+    }
+
+    iotjs_mqtt_spool_record_t *record =
+        iotjs_mqtt_spool_record(spool, iter->offset);
+
+    if (record->marker == MQTT_SPOOL_WRAP) {
+      iter->offset = 0;
+      continue;
+    }
+
+    iter->offset += iotjs_mqtt_spool_record_size(record->length);
+    iter->remaining--;
+
+    if (iter->offset == spool->capacity) {
+      iter->offset = 0;
+    }
+
+    *length = record->length;
+    *id_offset = record->id_offset;
+    return (const char *)(record + 1);
+  }
+
+  return NULL;
+}
+
+#else /* !__linux__ && !__APPLE__ */
+
+iotjs_mqtt_spool_t *iotjs_mqtt_spool_open(const char *path,
+                                          uint32_t capacity) {
+  return NULL;
+}
+
+
+void iotjs_mqtt_spool_close(iotjs_mqtt_spool_t *spool) {
+}
+
+
+uint32_t iotjs_mqtt_spool_count(const iotjs_mqtt_spool_t *spool) {
+  return 0;
+}
+
+
+void iotjs_mqtt_spool_shift(iotjs_mqtt_spool_t *spool) {
+}
+
+
+bool iotjs_mqtt_spool_append(iotjs_mqtt_spool_t *spool, const char *packet,
+                             uint32_t length, uint16_t id_offset) {
+  return false;
+}
+
+
+void iotjs_mqtt_spool_iter_init(const iotjs_mqtt_spool_t *spool,
+                                iotjs_mqtt_spool_iter_t *iter) {
+  iter->offset = 0;
+  iter->remaining = 0;
+}
+
+
+const char *iotjs_mqtt_spool_iter_next(const iotjs_mqtt_spool_t *spool,
+                                       iotjs_mqtt_spool_iter_t *iter,
+                                       uint32_t *length, uint16_t *id_offset) {
+  return NULL;
+}
+
+#endif /* __linux__ || __APPLE__ */
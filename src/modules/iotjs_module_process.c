@@ -21,6 +21,10 @@
 #ifndef WIN32
 #include <unistd.h>
 #endif /* !WIN32 */
+#if defined(ENABLE_SNAPSHOT) && (defined(__linux__) || defined(__APPLE__))
+#define IOTJS_SNAPSHOT_BUNDLE_MMAP 1
+#include <sys/mman.h>
+#endif
 
 
 static jerry_value_t WrapEval(const char* name, size_t name_len,
@@ -202,6 +206,169 @@ JS_FUNCTION(ReadSource) {
 }
 
 
+#ifdef ENABLE_SNAPSHOT
+/* Application modules precompiled by `tools/js2c.py --app`. Layout:
+ *
+ *   char     magic[4]        "IJSB"
+ *   uint32_t version         IOTJS_SNAPSHOT_BUNDLE_VERSION
+ *   uint32_t index_size      multiple of 4
+ *   char     index[]         JSON, `{ "modules": [<path>, ...] }`
+ *   uint32_t snapshot[]      merged snapshot, one function per module
+ *
+ * The module functions run from the bundle memory without copying their
+ * byte code, so the bundle stays loaded until the engine is released.
+ */
+#define IOTJS_SNAPSHOT_BUNDLE_MAGIC "IJSB"
+#define IOTJS_SNAPSHOT_BUNDLE_VERSION 1
+#define IOTJS_SNAPSHOT_BUNDLE_HEADER_SIZE 12
+
+static struct {
+  char* data;
+  size_t size;
+  bool mapped;
+  const uint32_t* snapshot;
+  size_t snapshot_size;
+} app_bundle;
+
+
+static bool ReadSnapshotBundle(const char* path) {
+  uv_loop_t* loop = iotjs_environment_loop(iotjs_environment_get());
+  uv_fs_t req;
+
+  int fd = uv_fs_open(loop, &req, path, O_RDONLY, 0, NULL);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0) {
+    return false;
+  }
+
+  int err = uv_fs_fstat(loop, &req, fd, NULL);
+  size_t size = err < 0 ? 0 : (size_t)req.statbuf.st_size;
+  uv_fs_req_cleanup(&req);
+
+  char* data = NULL;
+  bool mapped = false;
+
+  if (size > 0) {
+#if IOTJS_SNAPSHOT_BUNDLE_MMAP
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      data = (char*)map;
+      mapped = true;
+    }
+#endif
+
+    if (data == NULL) {
+      data = iotjs_buffer_allocate(size);
+
+      size_t nread = 0;
+      while (nread < size) {
+        uv_buf_t buf = uv_buf_init(data + nread, (unsigned)(size - nread));
+        int result =
+            uv_fs_read(loop, &req, fd, &buf, 1, (int64_t)nread, NULL);
+        uv_fs_req_cleanup(&req);
+        if (result <= 0) {
+          break;
+        }
+        nread += (size_t)result;
+      }
+
+      if (nread < size) {
+        iotjs_buffer_release(data);
+        data = NULL;
+      }
+    }
+  }
+
+  uv_fs_close(loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+
+  app_bundle.data = data;
+  app_bundle.size = size;
+  app_bundle.mapped = mapped;
+
+  return data != NULL;
+}
+
+
+void iotjs_process_release_snapshot_bundle(void) {
+  if (app_bundle.data == NULL) {
+    return;
+  }
+
+#if IOTJS_SNAPSHOT_BUNDLE_MMAP
+  if (app_bundle.mapped) {
+    munmap(app_bundle.data, app_bundle.size);
+  } else {
+    iotjs_buffer_release(app_bundle.data);
+  }
+#else
+  iotjs_buffer_release(app_bundle.data);
+#endif
+
+  memset(&app_bundle, 0, sizeof(app_bundle));
+}
+
+
+// Loads the snapshot bundle and returns its JSON index.
+JS_FUNCTION(LoadSnapshot) {
+  DJS_CHECK_ARGS(1, string);
+
+  if (app_bundle.data != NULL) {
+    return JS_CREATE_ERROR(COMMON, "A snapshot bundle is already loaded");
+  }
+
+  iotjs_string_t path = JS_GET_ARG(0, string);
+  bool loaded = ReadSnapshotBundle(iotjs_string_data(&path));
+  iotjs_string_destroy(&path);
+
+  if (!loaded) {
+    return JS_CREATE_ERROR(COMMON, "Cannot read the snapshot bundle");
+  }
+
+  uint32_t header[3];
+  bool valid = app_bundle.size >= IOTJS_SNAPSHOT_BUNDLE_HEADER_SIZE;
+
+  if (valid) {
+    memcpy(header, app_bundle.data, sizeof(header));
+    valid = !memcmp(header, IOTJS_SNAPSHOT_BUNDLE_MAGIC, 4) &&
+            header[1] == IOTJS_SNAPSHOT_BUNDLE_VERSION &&
+            header[2] % 4 == 0 &&
+            header[2] < app_bundle.size - IOTJS_SNAPSHOT_BUNDLE_HEADER_SIZE;
+  }
+
+  if (!valid) {
+    iotjs_process_release_snapshot_bundle();
+    return JS_CREATE_ERROR(COMMON, "Invalid snapshot bundle");
+  }
+
+  const char* index = app_bundle.data + IOTJS_SNAPSHOT_BUNDLE_HEADER_SIZE;
+  app_bundle.snapshot = (const uint32_t*)(index + header[2]);
+  app_bundle.snapshot_size =
+      app_bundle.size - IOTJS_SNAPSHOT_BUNDLE_HEADER_SIZE - header[2];
+
+  return jerry_create_string_sz_from_utf8((const jerry_char_t*)index,
+                                          header[2]);
+}
+
+
+// Returns the module function stored at the given index of the bundle.
+JS_FUNCTION(ExecSnapshot) {
+  DJS_CHECK_ARGS(1, number);
+
+  if (app_bundle.snapshot == NULL) {
+    return JS_CREATE_ERROR(COMMON, "No snapshot bundle is loaded");
+  }
+
+  size_t index = (size_t)JS_GET_ARG(0, number);
+  return jerry_exec_snapshot(app_bundle.snapshot, app_bundle.snapshot_size,
+                             index, JERRY_SNAPSHOT_EXEC_ALLOW_STATIC);
+}
+#else
+void iotjs_process_release_snapshot_bundle(void) {
+}
+#endif /* ENABLE_SNAPSHOT */
+
+
 JS_FUNCTION(Cwd) {
   char path[IOTJS_MAX_PATH_SIZE];
   size_t size_path = sizeof(path);
@@ -357,6 +524,12 @@ static void SetProcessPrivate(jerry_value_t process, bool wait_source) {
   iotjs_jval_set_method(private, IOTJS_MAGIC_STRING_COMPILEMODULE,
                         CompileModule);
   iotjs_jval_set_method(private, IOTJS_MAGIC_STRING_READSOURCE, ReadSource);
+#ifdef ENABLE_SNAPSHOT
+  iotjs_jval_set_method(private, IOTJS_MAGIC_STRING_LOADSNAPSHOT,
+                        LoadSnapshot);
+  iotjs_jval_set_method(private, IOTJS_MAGIC_STRING_EXECSNAPSHOT,
+                        ExecSnapshot);
+#endif
 
 #ifdef JERRY_DEBUGGER
   // debugger
@@ -21,13 +21,47 @@
 #include "iotjs_uv_handle.h"
 #include "iotjs_uv_request.h"
 
+#include <errno.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+// Linux copies the region with sendfile(2), macOS with pread and write.
+// Other platforms lack the poll handle the job is driven by.
+#if defined(__linux__) || defined(__APPLE__)
+#define IOTJS_TCP_HAS_SENDFILE 1
+#endif
+
+// Largest region copied by one call where sendfile(2) is not available.
+#define IOTJS_TCP_SENDFILE_CHUNK 16384
+
 static const jerry_object_native_info_t this_module_native_info = { NULL };
 
 
+typedef struct iotjs_tcp_sendfile_s iotjs_tcp_sendfile_t;
+
+// Extra data of every TCP handle.
+typedef struct {
+  // The sendfile job using the socket, the stream runs one at a time.
+  iotjs_tcp_sendfile_t* sendfile;
+  // Close was requested while a sendfile job was still running.
+  bool close_pending;
+} iotjs_tcp_state_t;
+
+#define IOTJS_TCP_STATE(UV_HANDLE) \
+  ((iotjs_tcp_state_t*)IOTJS_UV_HANDLE_EXTRA_DATA((uv_handle_t*)(UV_HANDLE)))
+
+#if IOTJS_TCP_HAS_SENDFILE
+static void iotjs_tcp_sendfile_finish(iotjs_tcp_sendfile_t* job, int err);
+#endif
+
+
 void iotjs_tcp_object_init(jerry_value_t jtcp) {
   // uv_tcp_t* can be handled as uv_handle_t* or even as uv_stream_t*
-  uv_handle_t* handle = iotjs_uv_handle_create(sizeof(uv_tcp_t), jtcp,
-                                               &this_module_native_info, 0);
+  uv_handle_t* handle =
+      iotjs_uv_handle_create(sizeof(uv_tcp_t), jtcp, &this_module_native_info,
+                             sizeof(iotjs_tcp_state_t));
 
   const iotjs_environment_t* env = iotjs_environment_get();
   uv_tcp_init(iotjs_environment_loop(env), (uv_tcp_t*)handle);
@@ -80,6 +114,16 @@ void AfterClose(uv_handle_t* handle) {
 JS_FUNCTION(Close) {
   JS_DECLARE_PTR(jthis, uv_handle_t, uv_handle);
 
+#if IOTJS_TCP_HAS_SENDFILE
+  iotjs_tcp_state_t* state = IOTJS_TCP_STATE(uv_handle);
+  if (state->sendfile != NULL) {
+    // The socket is closed once the sendfile job has let go of it.
+    state->close_pending = true;
+    iotjs_tcp_sendfile_finish(state->sendfile, UV_ECANCELED);
+    return jerry_create_undefined();
+  }
+#endif
+
   iotjs_uv_handle_close(uv_handle, AfterClose);
   return jerry_create_undefined();
 }
@@ -245,6 +289,305 @@ JS_FUNCTION(Write) {
 }
 
 
+// A buffer written to several sockets. Every write request points to the
+// same data, the buffer is released when the last of them completes.
+typedef struct {
+  jerry_value_t jbuffer;
+  // Result of the write to every handle, 0 on success
+  jerry_value_t jstatuses;
+  unsigned pending;
+} iotjs_tcp_shared_write_t;
+
+// Extra data of a write request of a shared buffer.
+typedef struct {
+  iotjs_tcp_shared_write_t* shared;
+  uint32_t index;
+} iotjs_tcp_shared_req_t;
+
+
+static void AfterWriteShared(uv_write_t* req, int status) {
+  iotjs_tcp_shared_req_t* shared_req =
+      (iotjs_tcp_shared_req_t*)IOTJS_UV_REQUEST_EXTRA_DATA(req);
+  iotjs_tcp_shared_write_t* shared = shared_req->shared;
+
+  if (status < 0) {
+    jerry_value_t jstatus = jerry_create_number(status);
+    iotjs_jval_set_property_by_index(shared->jstatuses, shared_req->index,
+                                     jstatus);
+    jerry_release_value(jstatus);
+  }
+
+  if (--shared->pending == 0) {
+    jerry_value_t jcallback = *IOTJS_UV_REQUEST_JSCALLBACK(req);
+    iotjs_invoke_callback(jcallback, jerry_create_undefined(),
+                          &shared->jstatuses, 1);
+    jerry_release_value(shared->jstatuses);
+    jerry_release_value(shared->jbuffer);
+    IOTJS_RELEASE(shared);
+  }
+
+  iotjs_uv_request_destroy((uv_req_t*)req);
+}
+
+
+// Queues the same buffer on every handle of the array without copying it.
+// Returns the result of starting every write. When any of them started,
+// the callback is called once they all completed, with the same array
+// updated by the results of the writes.
+JS_FUNCTION(WriteShared) {
+  DJS_CHECK_ARGS(3, array, object, function);
+
+  const jerry_value_t jhandles = JS_GET_ARG(0, array);
+  const jerry_value_t jbuffer = JS_GET_ARG(1, object);
+  const jerry_value_t jcallback = JS_GET_ARG(2, function);
+
+  iotjs_bufferwrap_t* buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+
+  uv_buf_t buf;
+  buf.base = buffer_wrap->buffer;
+  buf.len = iotjs_bufferwrap_length(buffer_wrap);
+
+  uint32_t count = jerry_get_array_length(jhandles);
+
+  iotjs_tcp_shared_write_t* shared = IOTJS_ALLOC(iotjs_tcp_shared_write_t);
+  shared->jbuffer = jerry_acquire_value(jbuffer);
+  shared->jstatuses = jerry_create_array(count);
+  shared->pending = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    jerry_value_t jhandle = jerry_get_property_by_index(jhandles, i);
+    uv_stream_t* tcp_handle = NULL;
+    bool is_tcp =
+        jerry_value_is_object(jhandle) &&
+        jerry_get_object_native_pointer(jhandle, (void**)&tcp_handle,
+                                        &this_module_native_info);
+    jerry_release_value(jhandle);
+
+    int err = UV_EINVAL;
+    if (is_tcp) {
+      uv_req_t* req_write =
+          iotjs_uv_request_create(sizeof(uv_write_t), jcallback,
+                                  sizeof(iotjs_tcp_shared_req_t));
+      iotjs_tcp_shared_req_t* shared_req =
+          (iotjs_tcp_shared_req_t*)IOTJS_UV_REQUEST_EXTRA_DATA(req_write);
+      shared_req->shared = shared;
+      shared_req->index = i;
+
+      err = uv_write((uv_write_t*)req_write, tcp_handle, &buf, 1,
+                     AfterWriteShared);
+      if (err) {
+        iotjs_uv_request_destroy(req_write);
+      } else {
+        shared->pending++;
+      }
+    }
+
+    jerry_value_t jstatus = jerry_create_number(err);
+    iotjs_jval_set_property_by_index(shared->jstatuses, i, jstatus);
+    jerry_release_value(jstatus);
+  }
+
+  jerry_value_t jresult = jerry_acquire_value(shared->jstatuses);
+  if (shared->pending == 0) {
+    jerry_release_value(shared->jstatuses);
+    jerry_release_value(shared->jbuffer);
+    IOTJS_RELEASE(shared);
+  }
+
+  return jresult;
+}
+
+
+#if IOTJS_TCP_HAS_SENDFILE
+/* A file region sent on a socket. The job is driven by the loop: it waits
+ * until the socket is writable and then lets the kernel copy as much as the
+ * socket takes without blocking. The TCP handle already watches the socket
+ * descriptor, so the poll handle watches a duplicate of it. */
+struct iotjs_tcp_sendfile_s {
+  uv_poll_t poll;
+  uv_stream_t* handle;
+  jerry_value_t jcallback;
+  uv_os_fd_t out_fd;
+  uv_os_fd_t poll_fd;
+  uv_file in_fd;
+  int64_t offset;
+  size_t remaining;
+  size_t sent;
+  int err;
+};
+
+
+// Sends the next part of the region without blocking, returns the number of
+// bytes sent, 0 at the end of the file or an error code.
+static ssize_t iotjs_tcp_sendfile_some(iotjs_tcp_sendfile_t* job) {
+#if defined(__linux__)
+  off_t offset = (off_t)job->offset;
+  ssize_t result = sendfile(job->out_fd, job->in_fd, &offset, job->remaining);
+#else
+  char buffer[IOTJS_TCP_SENDFILE_CHUNK];
+  size_t length = job->remaining < sizeof(buffer) ? job->remaining
+                                                  : sizeof(buffer);
+  ssize_t result = pread(job->in_fd, buffer, length, (off_t)job->offset);
+  if (result > 0) {
+    result = write(job->out_fd, buffer, (size_t)result);
+  }
+#endif
+  return result < 0 ? -errno : result;
+}
+
+
+static void AfterSendFile(uv_handle_t* handle) {
+  iotjs_tcp_sendfile_t* job = (iotjs_tcp_sendfile_t*)handle->data;
+  iotjs_tcp_state_t* state = IOTJS_TCP_STATE(job->handle);
+
+  close(job->poll_fd);
+  state->sendfile = NULL;
+
+  // The callback takes two parameters
+  // [0] status
+  // [1] number of bytes sent
+  jerry_value_t jargs[2] = { jerry_create_number(job->err),
+                             jerry_create_number((double)job->sent) };
+  iotjs_invoke_callback(job->jcallback, jerry_create_undefined(), jargs, 2);
+  jerry_release_value(jargs[0]);
+  jerry_release_value(jargs[1]);
+  jerry_release_value(job->jcallback);
+
+  if (state->close_pending) {
+    state->close_pending = false;
+    iotjs_uv_handle_close((uv_handle_t*)job->handle, AfterClose);
+  }
+
+  IOTJS_RELEASE(job);
+}
+
+
+static void iotjs_tcp_sendfile_finish(iotjs_tcp_sendfile_t* job, int err) {
+  if (uv_is_closing((uv_handle_t*)&job->poll)) {
+    return;
+  }
+
+  job->err = err;
+  uv_poll_stop(&job->poll);
+  uv_close((uv_handle_t*)&job->poll, AfterSendFile);
+}
+
+
+static void OnSendFileWritable(uv_poll_t* poll, int status, int events) {
+  iotjs_tcp_sendfile_t* job = (iotjs_tcp_sendfile_t*)poll->data;
+
+  if (status < 0) {
+    iotjs_tcp_sendfile_finish(job, status);
+    return;
+  }
+
+  // One call per event, a fast socket does not keep the loop to itself.
+  ssize_t result = job->remaining > 0 ? iotjs_tcp_sendfile_some(job) : 0;
+
+  if (result > 0) {
+    job->offset += result;
+    job->remaining -= (size_t)result;
+    job->sent += (size_t)result;
+    if (job->remaining > 0) {
+      return;
+    }
+    result = 0;
+  } else if (result == UV_EAGAIN) {
+    return;
+  }
+
+  iotjs_tcp_sendfile_finish(job, (int)result);
+}
+#endif
+
+
+// Send a region of a file through the socket. The data is moved by the
+// kernel and never enters the JavaScript heap.
+// [0] file descriptor
+// [1] offset
+// [2] length
+// [3] callback
+JS_FUNCTION(SendFile) {
+  JS_DECLARE_PTR(jthis, uv_stream_t, tcp_handle);
+
+  DJS_CHECK_ARGS(4, number, number, number, function);
+
+  // The stream sends one region at a time.
+  if (IOTJS_TCP_STATE(tcp_handle)->sendfile != NULL) {
+    return jerry_create_number(UV_EBUSY);
+  }
+
+  double offset = JS_GET_ARG(1, number);
+  double length = JS_GET_ARG(2, number);
+
+  if (!(offset >= 0) || !(length >= 0)) {
+    return jerry_create_number(UV_EINVAL);
+  }
+
+  // off_t is 32 bits wide on 32-bit targets built without large file
+  // support, an offset beyond it would be truncated by the casts.
+  const int64_t off_max =
+      sizeof(off_t) < sizeof(int64_t) ? (int64_t)INT32_MAX : INT64_MAX;
+
+  if (offset >= (double)off_max) {
+    return jerry_create_number(UV_EFBIG);
+  }
+
+  // Nothing past the largest offset can be read.
+  if (length > (double)off_max - offset) {
+    length = (double)off_max - offset;
+  }
+  if (length > (double)SIZE_MAX) {
+    length = (double)SIZE_MAX;
+  }
+
+#if !IOTJS_TCP_HAS_SENDFILE
+  return jerry_create_number(UV_ENOSYS);
+#else
+  uv_os_fd_t out_fd;
+  int err = uv_fileno((uv_handle_t*)tcp_handle, &out_fd);
+  if (err) {
+    return jerry_create_number(err);
+  }
+
+  uv_os_fd_t poll_fd = dup(out_fd);
+  if (poll_fd < 0) {
+    return jerry_create_number(-errno);
+  }
+
+  iotjs_tcp_sendfile_t* job = IOTJS_ALLOC(iotjs_tcp_sendfile_t);
+  uv_loop_t* loop = iotjs_environment_loop(iotjs_environment_get());
+
+  err = uv_poll_init(loop, &job->poll, poll_fd);
+  if (err) {
+    close(poll_fd);
+    IOTJS_RELEASE(job);
+    return jerry_create_number(err);
+  }
+
+  job->poll.data = job;
+  job->handle = tcp_handle;
+  job->jcallback = jerry_acquire_value(JS_GET_ARG(3, function));
+  job->out_fd = out_fd;
+  job->poll_fd = poll_fd;
+  job->in_fd = (uv_file)JS_GET_ARG(0, number);
+  job->offset = (int64_t)offset;
+  job->remaining = (size_t)length;
+  job->sent = 0;
+  job->err = 0;
+
+  IOTJS_TCP_STATE(tcp_handle)->sendfile = job;
+
+  err = uv_poll_start(&job->poll, UV_WRITABLE, OnSendFileWritable);
+  if (err) {
+    iotjs_tcp_sendfile_finish(job, err);
+  }
+
+  return jerry_create_number(0);
+#endif
+}
+
+
 void OnAlloc(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
   if (suggested_size > IOTJS_MAX_READ_BUFFER_SIZE) {
     suggested_size = IOTJS_MAX_READ_BUFFER_SIZE;
@@ -418,12 +761,14 @@ jerry_value_t InitTcp(void) {
 
   iotjs_jval_set_property_jval(tcp, IOTJS_MAGIC_STRING_PROTOTYPE, prototype);
   iotjs_jval_set_method(tcp, IOTJS_MAGIC_STRING_ERRNAME, ErrName);
+  iotjs_jval_set_method(tcp, IOTJS_MAGIC_STRING_WRITESHARED, WriteShared);
 
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_CLOSE, Close);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_CONNECT, Connect);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_BIND, Bind);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_LISTEN, Listen);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_WRITE, Write);
+  iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_SENDFILE, SendFile);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_READSTART, ReadStart);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_SHUTDOWN, Shutdown);
   iotjs_jval_set_method(prototype, IOTJS_MAGIC_STRING_SETKEEPALIVE,
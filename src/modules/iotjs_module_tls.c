@@ -20,18 +20,174 @@
 
 static void iotjs_tls_context_destroy(iotjs_tls_context_t *tls_context);
 
+// Trust stores shared by all contexts of the process
+static iotjs_tls_trust_store_t *iotjs_tls_trust_stores = NULL;
+
 static const jerry_object_native_info_t tls_context_native_info = {
   .free_cb = (jerry_object_native_free_callback_t)iotjs_tls_context_destroy
 };
 
 
+static void iotjs_tls_sha256(const unsigned char *data, size_t size,
+                             unsigned char *digest) {
+  mbedtls_sha256_context sha_ctx;
+  mbedtls_sha256_init(&sha_ctx);
+#if defined(__TIZENRT__)
+  mbedtls_sha256_starts(&sha_ctx, 0);
+  mbedtls_sha256_update(&sha_ctx, data, size);
+  mbedtls_sha256_finish(&sha_ctx, digest);
+#else  /* !__TIZENRT__ */
+  mbedtls_sha256_starts_ret(&sha_ctx, 0);
+  mbedtls_sha256_update_ret(&sha_ctx, data, size);
+  mbedtls_sha256_finish_ret(&sha_ctx, digest);
+#endif /* __TIZENRT__ */
+  mbedtls_sha256_free(&sha_ctx);
+}
+
+
+// Returns the size of the DER encoded certificate at the start of data,
+// or 0 if data does not start with a certificate.
+static size_t iotjs_tls_der_size(const unsigned char *data, size_t size) {
+  // Certificates are ASN.1 sequences with a definite length
+  if (size < 2 || data[0] != 0x30) {
+    return 0;
+  }
+
+  size_t header_size = 2;
+  size_t length = data[1];
+
+  if (length & 0x80) {
+    size_t length_size = length & 0x7f;
+
+    if (length_size == 0 || length_size > 3 || size < 2 + length_size) {
+      return 0;
+    }
+
+    length = 0;
+    for (size_t i = 0; i < length_size; i++) {
+      length = (length << 8) | data[2 + i];
+    }
+    header_size += length_size;
+  }
+
+  if (length > size - header_size) {
+    return 0;
+  }
+
+  return header_size + length;
+}
+
+
+static int iotjs_tls_parse_bundle(mbedtls_x509_crt *certs,
+                                  const unsigned char *data, size_t size) {
+  if (size == 0 || data[0] != 0x30) {
+    // PEM bundles must include the terminating zero
+    return mbedtls_x509_crt_parse(certs, data, size + 1);
+  }
+
+  // Concatenated DER certificates need no base64 decoding
+  while (size > 0) {
+    size_t der_size = iotjs_tls_der_size(data, size);
+
+    if (der_size == 0) {
+      return -1;
+    }
+
+    int ret = mbedtls_x509_crt_parse_der(certs, data, der_size);
+
+    if (ret != 0) {
+      return ret;
+    }
+
+    data += der_size;
+    size -= der_size;
+  }
+
+  return 0;
+}
+
+
+/* Trust stores are parsed once and shared by every context using the
+ * same bundle. They are identified by the SHA-256 digest of the bundle,
+ * and freed when the last context using them is destroyed. */
+static iotjs_tls_trust_store_t *iotjs_tls_trust_store_acquire(
+    const unsigned char *data, size_t size) {
+  unsigned char digest[IOTJS_TLS_TRUST_STORE_DIGEST_SIZE];
+  iotjs_tls_sha256(data, size, digest);
+
+  iotjs_tls_trust_store_t *trust_store = iotjs_tls_trust_stores;
+
+  while (trust_store != NULL) {
+    if (memcmp(trust_store->digest, digest, sizeof(digest)) == 0) {
+      trust_store->ref_count++;
+      return trust_store;
+    }
+    trust_store = trust_store->next;
+  }
+
+  trust_store = IOTJS_ALLOC(iotjs_tls_trust_store_t);
+  mbedtls_x509_crt_init(&trust_store->certs);
+
+  if (iotjs_tls_parse_bundle(&trust_store->certs, data, size) != 0) {
+    mbedtls_x509_crt_free(&trust_store->certs);
+    IOTJS_RELEASE(trust_store);
+    return NULL;
+  }
+
+  memcpy(trust_store->digest, digest, sizeof(digest));
+  trust_store->ref_count = 1;
+  trust_store->next = iotjs_tls_trust_stores;
+  iotjs_tls_trust_stores = trust_store;
+  return trust_store;
+}
+
+
+static void iotjs_tls_trust_store_release(
+    iotjs_tls_trust_store_t *trust_store) {
+  if (trust_store == NULL || --trust_store->ref_count > 0) {
+    return;
+  }
+
+  iotjs_tls_trust_store_t **prev = &iotjs_tls_trust_stores;
+
+  while (*prev != trust_store) {
+    prev = &(*prev)->next;
+  }
+  *prev = trust_store->next;
+
+  mbedtls_x509_crt_free(&trust_store->certs);
+  IOTJS_RELEASE(trust_store);
+}
+
+
 static void iotjs_tls_context_destroy(iotjs_tls_context_t *tls_context) {
   if (tls_context->ref_count > 1) {
     tls_context->ref_count--;
     return;
   }
 
-  mbedtls_x509_crt_free(&tls_context->cert_auth);
+  for (int i = 0; i < IOTJS_TLS_ENDPOINTS; i++) {
+    for (int j = 0; j < IOTJS_TLS_AUTH_MODES; j++) {
+      if (tls_context->configs[i][j] != NULL) {
+        mbedtls_ssl_config_free(tls_context->configs[i][j]);
+        IOTJS_RELEASE(tls_context->configs[i][j]);
+      }
+    }
+  }
+
+  for (int i = 0; i < IOTJS_TLS_CLIENT_SESSIONS; i++) {
+    mbedtls_ssl_session_free(&tls_context->sessions[i].session);
+    IOTJS_RELEASE(tls_context->sessions[i].key);
+  }
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+  mbedtls_ssl_cache_free(&tls_context->session_cache);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+  mbedtls_ssl_ticket_free(&tls_context->ticket);
+#endif
+
+  iotjs_tls_trust_store_release(tls_context->trust_store);
   mbedtls_x509_crt_free(&tls_context->own_cert);
   mbedtls_pk_free(&tls_context->pkey);
   mbedtls_ctr_drbg_free(&tls_context->ctr_drbg);
@@ -51,7 +207,29 @@ static iotjs_tls_context_t *iotjs_tls_context_create(
   mbedtls_ctr_drbg_init(&tls_context->ctr_drbg);
   mbedtls_pk_init(&tls_context->pkey);
   mbedtls_x509_crt_init(&tls_context->own_cert);
-  mbedtls_x509_crt_init(&tls_context->cert_auth);
+  tls_context->trust_store = NULL;
+
+  for (int i = 0; i < IOTJS_TLS_ENDPOINTS; i++) {
+    for (int j = 0; j < IOTJS_TLS_AUTH_MODES; j++) {
+      tls_context->configs[i][j] = NULL;
+    }
+  }
+
+  for (int i = 0; i < IOTJS_TLS_CLIENT_SESSIONS; i++) {
+    tls_context->sessions[i].key = NULL;
+    tls_context->sessions[i].last_used = 0;
+    mbedtls_ssl_session_init(&tls_context->sessions[i].session);
+  }
+
+  tls_context->session_clock = 0;
+  tls_context->session_timeout = IOTJS_TLS_SESSION_TIMEOUT;
+  tls_context->session_resumed = false;
+#if defined(MBEDTLS_SSL_CACHE_C)
+  mbedtls_ssl_cache_init(&tls_context->session_cache);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+  mbedtls_ssl_ticket_init(&tls_context->ticket);
+#endif
 
   jerry_set_object_native_pointer(jobject, tls_context,
                                   &tls_context_native_info);
@@ -60,130 +238,294 @@ static iotjs_tls_context_t *iotjs_tls_context_create(
 }
 
 
-IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(tls);
+static iotjs_tls_session_t *iotjs_tls_session_find(
+    iotjs_tls_context_t *tls_context, const char *key) {
+  for (int i = 0; i < IOTJS_TLS_CLIENT_SESSIONS; i++) {
+    iotjs_tls_session_t *entry = tls_context->sessions + i;
 
+    if (entry->key != NULL && strcmp(entry->key, key) == 0) {
+      entry->last_used = ++tls_context->session_clock;
+      return entry;
+    }
+  }
 
-static void iotjs_tls_destroy(iotjs_tls_t *tls_data) {
-  mbedtls_ssl_free(&tls_data->ssl);
-  mbedtls_ssl_config_free(&tls_data->conf);
-  iotjs_tls_context_destroy(tls_data->tls_context);
+  return NULL;
+}
 
-  IOTJS_RELEASE(tls_data->bio.receive_bio.mem);
-  IOTJS_RELEASE(tls_data->bio.send_bio.mem);
 
-  IOTJS_RELEASE(tls_data);
+static iotjs_tls_session_t *iotjs_tls_session_insert(
+    iotjs_tls_context_t *tls_context, const char *key) {
+  iotjs_tls_session_t *entry = iotjs_tls_session_find(tls_context, key);
+
+  if (entry != NULL) {
+    return entry;
+  }
+
+  // Reuse the least recently used slot
+  entry = tls_context->sessions;
+
+  for (int i = 1; i < IOTJS_TLS_CLIENT_SESSIONS; i++) {
+    if (tls_context->sessions[i].last_used < entry->last_used) {
+      entry = tls_context->sessions + i;
+    }
+  }
+
+  mbedtls_ssl_session_free(&entry->session);
+  IOTJS_RELEASE(entry->key);
+
+  size_t key_length = strlen(key);
+  entry->key = IOTJS_CALLOC(key_length + 1, char);
+  memcpy(entry->key, key, key_length);
+  entry->last_used = ++tls_context->session_clock;
+  return entry;
 }
 
 
-static iotjs_tls_t *iotjs_tls_create(const jerry_value_t jobject,
-                                     iotjs_tls_context_t *tls_context) {
-  iotjs_tls_t *tls_data = IOTJS_ALLOC(iotjs_tls_t);
+static void iotjs_tls_session_remove(iotjs_tls_context_t *tls_context,
+                                     const char *key) {
+  iotjs_tls_session_t *entry = iotjs_tls_session_find(tls_context, key);
 
-  tls_context->ref_count++;
+  if (entry != NULL) {
+    mbedtls_ssl_session_free(&entry->session);
+    IOTJS_RELEASE(entry->key);
+    entry->last_used = 0;
+  }
+}
 
-  tls_data->tls_context = tls_context;
-  mbedtls_ssl_config_init(&tls_data->conf);
-  mbedtls_ssl_init(&tls_data->ssl);
-  tls_data->state = TLS_HANDSHAKE_READY;
 
-  tls_data->jobject = jobject;
-  jerry_set_object_native_pointer(jobject, tls_data, &this_module_native_info);
+/* The session cache and ticket callbacks are called by the server
+ * side handshake, they record whether the client resumed a session. */
+#if defined(MBEDTLS_SSL_CACHE_C)
+static int iotjs_tls_cache_get(void *data, mbedtls_ssl_session *session) {
+  iotjs_tls_context_t *tls_context = (iotjs_tls_context_t *)data;
+  int ret = mbedtls_ssl_cache_get(&tls_context->session_cache, session);
 
-  return tls_data;
+  if (ret == 0) {
+    tls_context->session_resumed = true;
+  }
+  return ret;
 }
 
 
-static void iotjs_bio_init(iotjs_bio_t *bio, size_t size) {
-  bio->mem = (char *)iotjs_buffer_allocate(size);
-  bio->size = size;
-  bio->read_index = 0;
-  bio->write_index = 0;
+static int iotjs_tls_cache_set(void *data,
+                               const mbedtls_ssl_session *session) {
+  iotjs_tls_context_t *tls_context = (iotjs_tls_context_t *)data;
+  return mbedtls_ssl_cache_set(&tls_context->session_cache, session);
+}
+#endif
+
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+static int iotjs_tls_ticket_write(void *data,
+                                  const mbedtls_ssl_session *session,
+                                  unsigned char *start,
+                                  const unsigned char *end, size_t *tlen,
+                                  uint32_t *lifetime) {
+  iotjs_tls_context_t *tls_context = (iotjs_tls_context_t *)data;
+  return mbedtls_ssl_ticket_write(&tls_context->ticket, session, start, end,
+                                  tlen, lifetime);
 }
 
 
-static size_t iotjs_bio_pending(iotjs_bio_t *bio) {
-  if (bio->read_index <= bio->write_index) {
-    return bio->write_index - bio->read_index;
-  }
+static int iotjs_tls_ticket_parse(void *data, mbedtls_ssl_session *session,
+                                  unsigned char *buf, size_t len) {
+  iotjs_tls_context_t *tls_context = (iotjs_tls_context_t *)data;
+  int ret = mbedtls_ssl_ticket_parse(&tls_context->ticket, session, buf, len);
 
-  return bio->write_index + bio->size - bio->read_index;
+  if (ret == 0) {
+    tls_context->session_resumed = true;
+  }
+  return ret;
 }
+#endif
 
 
-static size_t iotjs_bio_remaining(iotjs_bio_t *bio) {
-  if (bio->write_index < bio->read_index) {
-    return bio->read_index - bio->write_index - 1;
+static int iotjs_tls_context_setup_sessions(iotjs_tls_context_t *tls_context) {
+  if (tls_context->context_flags & SSL_CONTEXT_HAS_SESSION_CACHE) {
+    return 0;
   }
 
-  return bio->read_index + bio->size - bio->write_index - 1;
+#if defined(MBEDTLS_SSL_CACHE_C)
+  mbedtls_ssl_cache_set_max_entries(&tls_context->session_cache,
+                                    IOTJS_TLS_SERVER_SESSIONS);
+  mbedtls_ssl_cache_set_timeout(&tls_context->session_cache,
+                                (int)tls_context->session_timeout);
+#endif
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+  int ret = mbedtls_ssl_ticket_setup(&tls_context->ticket,
+                                     mbedtls_ctr_drbg_random,
+                                     &tls_context->ctr_drbg,
+                                     MBEDTLS_CIPHER_AES_256_GCM,
+                                     tls_context->session_timeout);
+  if (ret != 0) {
+    return ret;
+  }
+#endif
+
+  tls_context->context_flags |= SSL_CONTEXT_HAS_SESSION_CACHE;
+  return 0;
 }
 
 
-static void iotjs_bio_read(iotjs_bio_t *bio, char *buf, size_t size) {
-  IOTJS_ASSERT(size <= iotjs_bio_pending(bio));
+static const char *iotjs_tls_context_setup_config(
+    iotjs_tls_context_t *tls_context, mbedtls_ssl_config *conf, int endpoint,
+    int auth_mode) {
+  if (tls_context->context_flags & SSL_CONTEXT_HAS_KEY) {
+    if (mbedtls_ssl_conf_own_cert(conf, &tls_context->own_cert,
+                                  &tls_context->pkey) != 0) {
+      return "certificate/private key cannot be set";
+    }
+  }
+
+  mbedtls_ssl_conf_ca_chain(conf, &tls_context->trust_store->certs, NULL);
+
+  mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &tls_context->ctr_drbg);
+
+  if (mbedtls_ssl_config_defaults(conf, endpoint, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT)) {
+    return "SSL Configuration failed";
+  }
+
+  mbedtls_ssl_conf_authmode(conf, auth_mode);
 
-  if (bio->read_index + size > bio->size) {
-    size_t copy_size = bio->size - bio->read_index;
+  if (endpoint == MBEDTLS_SSL_IS_SERVER) {
+    // Resumed sessions skip the key exchange of a full handshake
+    if (iotjs_tls_context_setup_sessions(tls_context) != 0) {
+      return "session ticket setup failed";
+    }
 
-    memcpy(buf, bio->mem + bio->read_index, copy_size);
-    size -= copy_size;
-    buf += copy_size;
-    bio->read_index = 0;
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_conf_session_cache(conf, tls_context, iotjs_tls_cache_get,
+                                   iotjs_tls_cache_set);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_conf_session_tickets_cb(conf, iotjs_tls_ticket_write,
+                                        iotjs_tls_ticket_parse, tls_context);
+#endif
   }
 
-  memcpy(buf, bio->mem + bio->read_index, size);
-  bio->read_index += size;
+  return NULL;
 }
 
 
-static void iotjs_bio_write(iotjs_bio_t *bio, const char *buf, size_t size) {
-  IOTJS_ASSERT(size <= iotjs_bio_remaining(bio));
+/* The configuration is built when the first connection of its endpoint
+ * and authentication mode is created, and shared by all connections of
+ * the context afterwards. */
+static mbedtls_ssl_config *iotjs_tls_context_get_config(
+    iotjs_tls_context_t *tls_context, int endpoint, int auth_mode,
+    const char **error) {
+  IOTJS_ASSERT(endpoint >= 0 && endpoint < IOTJS_TLS_ENDPOINTS);
+  IOTJS_ASSERT(auth_mode >= 0 && auth_mode < IOTJS_TLS_AUTH_MODES);
 
-  if (bio->write_index + size > bio->size) {
-    size_t copy_size = bio->size - bio->write_index;
+  mbedtls_ssl_config *conf = tls_context->configs[endpoint][auth_mode];
 
-    memcpy(bio->mem + bio->write_index, buf, copy_size);
-    size -= copy_size;
-    buf += copy_size;
-    bio->write_index = 0;
+  if (conf != NULL) {
+    return conf;
   }
 
-  memcpy(bio->mem + bio->write_index, buf, size);
-  bio->write_index += size;
+  conf = IOTJS_ALLOC(mbedtls_ssl_config);
+  mbedtls_ssl_config_init(conf);
+
+  *error =
+      iotjs_tls_context_setup_config(tls_context, conf, endpoint, auth_mode);
+
+  if (*error != NULL) {
+    mbedtls_ssl_config_free(conf);
+    IOTJS_RELEASE(conf);
+    return NULL;
+  }
+
+  tls_context->configs[endpoint][auth_mode] = conf;
+  return conf;
 }
 
 
-static int iotjs_bio_net_send(void *ctx, const unsigned char *buf, size_t len) {
-  iotjs_bio_t *send_bio = &(((iotjs_bio_pair_t *)ctx)->send_bio);
+IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(tls);
 
-  size_t remaining = iotjs_bio_remaining(send_bio);
 
-  if (remaining == 0) {
-    return MBEDTLS_ERR_SSL_WANT_WRITE;
+static void iotjs_tls_destroy(iotjs_tls_t *tls_data) {
+  mbedtls_ssl_free(&tls_data->ssl);
+  iotjs_tls_context_destroy(tls_data->tls_context);
+
+  IOTJS_RELEASE(tls_data->session_key);
+  memset(tls_data->session_master, 0, sizeof(tls_data->session_master));
+
+  jerry_release_value(tls_data->bio.jsend_buffer);
+
+  IOTJS_RELEASE(tls_data);
+}
+
+
+static iotjs_tls_t *iotjs_tls_create(const jerry_value_t jobject,
+                                     iotjs_tls_context_t *tls_context) {
+  iotjs_tls_t *tls_data = IOTJS_ALLOC(iotjs_tls_t);
+
+  tls_context->ref_count++;
+
+  tls_data->tls_context = tls_context;
+  mbedtls_ssl_init(&tls_data->ssl);
+  tls_data->state = TLS_HANDSHAKE_READY;
+
+  tls_data->session_key = NULL;
+  tls_data->session_offered = false;
+  tls_data->session_reused = false;
+
+  tls_data->bio.receive_data = NULL;
+  tls_data->bio.receive_length = 0;
+  tls_data->bio.jsend_buffer = jerry_create_undefined();
+
+  tls_data->jobject = jobject;
+  jerry_set_object_native_pointer(jobject, tls_data, &this_module_native_info);
+
+  return tls_data;
+}
+
+
+/* Records written by mbedtls are encrypted into a Buffer which is
+ * passed to the socket when the mbedtls call returns. Data is usually
+ * flushed after every record, so the Buffer has the size of a single
+ * record. The messages of a handshake flight are merged into one Buffer. */
+static int iotjs_bio_net_send(void *ctx, const unsigned char *buf, size_t len) {
+  iotjs_bio_t *bio = (iotjs_bio_t *)ctx;
+  iotjs_bufferwrap_t *pending_wrap = NULL;
+  size_t pending = 0;
+
+  if (!jerry_value_is_undefined(bio->jsend_buffer)) {
+    pending_wrap = iotjs_bufferwrap_from_jbuffer(bio->jsend_buffer);
+    pending = iotjs_bufferwrap_length(pending_wrap);
   }
 
-  if (len > remaining) {
-    len = remaining;
+  jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(pending + len);
+  iotjs_bufferwrap_t *buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+
+  if (pending > 0) {
+    memcpy(buffer_wrap->buffer, pending_wrap->buffer, pending);
   }
+  memcpy(buffer_wrap->buffer + pending, buf, len);
 
-  iotjs_bio_write(send_bio, (const char *)buf, len);
+  jerry_release_value(bio->jsend_buffer);
+  bio->jsend_buffer = jbuffer;
   return (int)len;
 }
 
-static int iotjs_bio_net_receive(void *ctx, unsigned char *buf, size_t len) {
-  iotjs_bio_t *receive_bio = &(((iotjs_bio_pair_t *)ctx)->receive_bio);
 
-  size_t pending = iotjs_bio_pending(receive_bio);
+/* Encrypted data is read directly from the Buffer received by the
+ * socket, which is only available during the Read call. */
+static int iotjs_bio_net_receive(void *ctx, unsigned char *buf, size_t len) {
+  iotjs_bio_t *bio = (iotjs_bio_t *)ctx;
 
-  if (pending == 0) {
+  if (bio->receive_length == 0) {
     return MBEDTLS_ERR_SSL_WANT_READ;
   }
 
-  if (len > pending) {
-    len = pending;
+  if (len > bio->receive_length) {
+    len = bio->receive_length;
   }
 
-  iotjs_bio_read(receive_bio, (char *)buf, len);
+  memcpy(buf, bio->receive_data, len);
+  bio->receive_data += len;
+  bio->receive_length -= len;
   return (int)len;
 }
 
@@ -260,27 +602,38 @@ JS_FUNCTION(TlsContext) {
   if (iotjs_jbuffer_as_string(jcert_auth, &cert_auth_string)) {
     const char *cert_auth_chars = iotjs_string_data(&cert_auth_string);
 
-    ret = mbedtls_x509_crt_parse(&tls_context->cert_auth,
-                                 (const unsigned char *)cert_auth_chars,
-                                 (size_t)iotjs_string_size(&cert_auth_string) +
-                                     1);
+    tls_context->trust_store = iotjs_tls_trust_store_acquire(
+        (const unsigned char *)cert_auth_chars,
+        (size_t)iotjs_string_size(&cert_auth_string));
 
     iotjs_string_destroy(&cert_auth_string);
-  } else if (!jerry_value_is_undefined(jcert_auth)) {
-    ret = -1;
-  } else {
-    // Parse the default certificate authority
-    ret = mbedtls_x509_crt_parse(&tls_context->cert_auth,
-                                 (const unsigned char *)SSL_CA_PEM,
-                                 sizeof(SSL_CA_PEM));
+  } else if (jerry_value_is_undefined(jcert_auth)) {
+    // Use the default certificate authority
+    tls_context->trust_store =
+        iotjs_tls_trust_store_acquire((const unsigned char *)SSL_CA_PEM,
+                                      sizeof(SSL_CA_PEM) - 1);
   }
 
   jerry_release_value(jcert_auth);
 
-  if (ret) {
+  if (tls_context->trust_store == NULL) {
     return JS_CREATE_ERROR(COMMON, "certificate authority (CA) parsing failed");
   }
 
+  // Lifetime of server side sessions and tickets
+  jerry_value_t jsession_timeout =
+      iotjs_jval_get_property(joptions, IOTJS_MAGIC_STRING_SESSIONTIMEOUT);
+
+  if (jerry_value_is_number(jsession_timeout)) {
+    double session_timeout = jerry_get_number_value(jsession_timeout);
+
+    if (session_timeout >= 0 && session_timeout <= UINT32_MAX) {
+      tls_context->session_timeout = (uint32_t)session_timeout;
+    }
+  }
+
+  jerry_release_value(jsession_timeout);
+
   return jerry_create_undefined();
 }
 
@@ -307,26 +660,8 @@ JS_FUNCTION(TlsInit) {
   bool is_server = jerry_value_to_boolean(jis_server);
   jerry_release_value(jis_server);
 
-  if (tls_context->context_flags & SSL_CONTEXT_HAS_KEY) {
-    if (mbedtls_ssl_conf_own_cert(&tls_data->conf, &tls_context->own_cert,
-                                  &tls_context->pkey) != 0) {
-      return JS_CREATE_ERROR(COMMON, "certificate/private key cannot be set");
-    }
-  }
-
-  mbedtls_ssl_conf_ca_chain(&tls_data->conf, &tls_context->cert_auth, NULL);
-
-  mbedtls_ssl_conf_rng(&tls_data->conf, mbedtls_ctr_drbg_random,
-                       &tls_context->ctr_drbg);
-
   int endpoint = is_server ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT;
 
-  if (mbedtls_ssl_config_defaults(&tls_data->conf, endpoint,
-                                  MBEDTLS_SSL_TRANSPORT_STREAM,
-                                  MBEDTLS_SSL_PRESET_DEFAULT)) {
-    return JS_CREATE_ERROR(COMMON, "SSL Configuration failed");
-  }
-
   // if true, verifies CAs, must emit error if fails
   int auth_mode =
       is_server ? MBEDTLS_SSL_VERIFY_NONE : MBEDTLS_SSL_VERIFY_REQUIRED;
@@ -344,15 +679,19 @@ JS_FUNCTION(TlsInit) {
 
   jerry_release_value(jauth_mode);
 
-  mbedtls_ssl_conf_authmode(&tls_data->conf, auth_mode);
+  const char *error = NULL;
+  mbedtls_ssl_config *conf =
+      iotjs_tls_context_get_config(tls_context, endpoint, auth_mode, &error);
+
+  if (conf == NULL) {
+    return JS_CREATE_ERROR(COMMON, error);
+  }
 
-  if (mbedtls_ssl_setup(&tls_data->ssl, &tls_data->conf)) {
+  if (mbedtls_ssl_setup(&tls_data->ssl, conf)) {
     return JS_CREATE_ERROR(COMMON, "SSL setup failed");
   }
 
   // Connect mbedtls with iotjs_net_send and iotjs_net_recv functions
-  iotjs_bio_init(&(tls_data->bio.receive_bio), SSL_BIO_SIZE);
-  iotjs_bio_init(&(tls_data->bio.send_bio), SSL_BIO_SIZE);
   mbedtls_ssl_set_bio(&tls_data->ssl, &(tls_data->bio), iotjs_bio_net_send,
                       iotjs_bio_net_receive, NULL);
 
@@ -368,24 +707,49 @@ JS_FUNCTION(Connect) {
     iotjs_string_t server_name = JS_GET_ARG(0, string);
     mbedtls_ssl_set_hostname(&tls_data->ssl, iotjs_string_data(&server_name));
     iotjs_string_destroy(&server_name);
+
+    // Offer the session of an earlier connection to the same host:port
+    if (jargc >= 2 && jerry_value_is_string(jargv[1]) &&
+        tls_data->session_key == NULL) {
+      iotjs_string_t session_key = JS_GET_ARG(1, string);
+      size_t key_length = iotjs_string_size(&session_key);
+
+      tls_data->session_key = IOTJS_CALLOC(key_length + 1, char);
+      memcpy(tls_data->session_key, iotjs_string_data(&session_key),
+             key_length);
+      iotjs_string_destroy(&session_key);
+
+      iotjs_tls_session_t *entry =
+          iotjs_tls_session_find(tls_data->tls_context, tls_data->session_key);
+
+      if (entry != NULL &&
+          mbedtls_ssl_set_session(&tls_data->ssl, &entry->session) == 0) {
+        memcpy(tls_data->session_master, entry->session.master,
+               sizeof(tls_data->session_master));
+        tls_data->session_offered = true;
+      }
+    }
   }
 
   return jerry_create_undefined();
 }
 
 
+static jerry_value_t iotjs_tls_take_pending(iotjs_tls_t *tls_data) {
+  jerry_value_t jbuffer = tls_data->bio.jsend_buffer;
+
+  tls_data->bio.jsend_buffer = jerry_create_undefined();
+  return jbuffer;
+}
+
+
 static void iotjs_tls_send_pending(iotjs_tls_t *tls_data) {
-  iotjs_bio_t *send_bio = &(tls_data->bio.send_bio);
-  size_t pending = iotjs_bio_pending(send_bio);
+  jerry_value_t jbuffer = iotjs_tls_take_pending(tls_data);
 
-  if (pending == 0) {
+  if (jerry_value_is_undefined(jbuffer)) {
     return;
   }
 
-  jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(pending);
-  iotjs_bufferwrap_t *buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
-  iotjs_bio_read(send_bio, buffer_wrap->buffer, pending);
-
   jerry_value_t jthis = tls_data->jobject;
   jerry_value_t fn = iotjs_jval_get_property(jthis, IOTJS_MAGIC_STRING_ONWRITE);
 
@@ -473,22 +837,58 @@ JS_FUNCTION(Write) {
   }
 
   /* Last package is returned as a buffer. */
-  iotjs_bio_t *send_bio = &(tls_data->bio.send_bio);
-  size_t pending = iotjs_bio_pending(send_bio);
+  jerry_value_t jbuffer = iotjs_tls_take_pending(tls_data);
 
-  jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(pending);
-  iotjs_bufferwrap_t *buf = iotjs_bufferwrap_from_jbuffer(jbuffer);
-  iotjs_bio_read(send_bio, buf->buffer, pending);
+  if (jerry_value_is_undefined(jbuffer)) {
+    return iotjs_bufferwrap_create_buffer(0);
+  }
 
   return jbuffer;
 }
 
 
+static void tls_handshake_done(iotjs_tls_t *tls_data) {
+  if (tls_data->session_key == NULL) {
+    return;
+  }
+
+  iotjs_tls_context_t *tls_context = tls_data->tls_context;
+
+  // A resumed session keeps the master secret of the offered one
+  if (tls_data->session_offered &&
+      memcmp(tls_data->ssl.session->master, tls_data->session_master,
+             sizeof(tls_data->session_master)) == 0) {
+    tls_data->session_reused = true;
+  }
+
+  // A resumed session skips the certificate check, so only the sessions
+  // of verified servers are offered again
+  if (mbedtls_ssl_get_verify_result(&tls_data->ssl) != 0) {
+    return;
+  }
+
+  iotjs_tls_session_t *entry =
+      iotjs_tls_session_insert(tls_context, tls_data->session_key);
+
+  if (mbedtls_ssl_get_session(&tls_data->ssl, &entry->session) != 0) {
+    iotjs_tls_session_remove(tls_context, tls_data->session_key);
+  }
+}
+
+
 static void tls_handshake(iotjs_tls_t *tls_data, jerry_value_t jthis) {
+  iotjs_tls_context_t *tls_context = tls_data->tls_context;
+
   tls_data->state = TLS_HANDSHAKE_IN_PROGRESS;
+  tls_context->session_resumed = false;
+
   // Continue handshaking process
   int ret_val = mbedtls_ssl_handshake(&tls_data->ssl);
 
+  if (tls_context->session_resumed) {
+    tls_data->session_reused = true;
+  }
+
   iotjs_tls_send_pending(tls_data);
 
   bool error;
@@ -499,12 +899,18 @@ static void tls_handshake(iotjs_tls_t *tls_data, jerry_value_t jthis) {
     tls_data->state = TLS_CONNECTED;
     error = false;
     authorized = mbedtls_ssl_get_verify_result(&tls_data->ssl) == 0;
+    tls_handshake_done(tls_data);
   } else {
     if (ret_val == MBEDTLS_ERR_SSL_WANT_READ ||
         ret_val == MBEDTLS_ERR_SSL_WANT_WRITE) {
       return;
     }
 
+    // Do not offer the session again if the handshake failed
+    if (tls_data->session_offered) {
+      iotjs_tls_session_remove(tls_context, tls_data->session_key);
+    }
+
     tls_data->state = TLS_CLOSED;
     error = true;
     authorized = false;
@@ -524,102 +930,100 @@ static void tls_handshake(iotjs_tls_t *tls_data, jerry_value_t jthis) {
 }
 
 
-JS_FUNCTION(Read) {
-  JS_DECLARE_THIS_PTR(tls, tls_data);
+static bool tls_read(iotjs_tls_t *tls_data, jerry_value_t jthis) {
+  if (tls_data->state != TLS_CONNECTED) {
+    IOTJS_ASSERT(tls_data->state == TLS_HANDSHAKE_READY ||
+                 tls_data->state == TLS_HANDSHAKE_IN_PROGRESS);
+    tls_handshake(tls_data, jthis);
 
-  if (tls_data->state == TLS_CLOSED) {
-    return jerry_create_boolean(false);
+    if (tls_data->state != TLS_CONNECTED) {
+      IOTJS_ASSERT(tls_data->state == TLS_HANDSHAKE_IN_PROGRESS ||
+                   tls_data->state == TLS_CLOSED);
+
+      return tls_data->state != TLS_CLOSED;
+    }
   }
 
-  iotjs_bio_t *receive_bio = &(tls_data->bio.receive_bio);
-  const char *data = NULL;
-  size_t length = 0;
+  while (true) {
+    int ret_val = mbedtls_ssl_read(&tls_data->ssl, NULL, 0);
+    iotjs_tls_send_pending(tls_data);
 
-  if (jargc >= 1 && jerry_value_to_boolean(jargv[0])) {
-    jerry_value_t jbuffer = JS_GET_ARG(0, object);
+    if (ret_val == 0) {
+      size_t pending = mbedtls_ssl_get_bytes_avail(&tls_data->ssl);
 
-    iotjs_bufferwrap_t *buf = iotjs_bufferwrap_from_jbuffer(jbuffer);
-    data = buf->buffer;
-    length = iotjs_bufferwrap_length(buf);
-  }
+      if (pending == 0) {
+        continue;
+      }
 
-  do {
-    size_t copy_size = iotjs_bio_remaining(receive_bio);
+      jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(pending);
+      iotjs_bufferwrap_t *buf = iotjs_bufferwrap_from_jbuffer(jbuffer);
+      ret_val = mbedtls_ssl_read(&tls_data->ssl, (unsigned char *)buf->buffer,
+                                 pending);
 
-    if (copy_size > length) {
-      copy_size = length;
-    }
+      IOTJS_ASSERT(ret_val == (int)pending);
+      IOTJS_UNUSED(ret_val);
 
-    iotjs_bio_write(receive_bio, data, copy_size);
-    data += copy_size;
-    length -= copy_size;
+      jerry_value_t fn =
+          iotjs_jval_get_property(jthis, IOTJS_MAGIC_STRING_ONREAD);
+      iotjs_invoke_callback(fn, jthis, &jbuffer, 1);
 
-    if (tls_data->state != TLS_CONNECTED) {
-      IOTJS_ASSERT(tls_data->state == TLS_HANDSHAKE_READY ||
-                   tls_data->state == TLS_HANDSHAKE_IN_PROGRESS);
-      tls_handshake(tls_data, jthis);
+      jerry_release_value(jbuffer);
+      jerry_release_value(fn);
+      continue;
+    }
 
-      if (tls_data->state != TLS_CONNECTED) {
-        IOTJS_ASSERT(tls_data->state == TLS_HANDSHAKE_IN_PROGRESS ||
-                     tls_data->state == TLS_CLOSED);
+    if (ret_val == MBEDTLS_ERR_SSL_WANT_READ) {
+      return true;
+    }
 
-        if (length > 0 && tls_data->state == TLS_HANDSHAKE_IN_PROGRESS) {
-          continue;
-        }
+    if (ret_val == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      continue;
+    }
 
-        bool result = (tls_data->state != TLS_CLOSED);
-        return jerry_create_boolean(result);
-      }
+    tls_data->state = TLS_CLOSED;
+
+    if (ret_val == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+      return true;
     }
 
-    while (true) {
-      int ret_val = mbedtls_ssl_read(&tls_data->ssl, NULL, 0);
-      iotjs_tls_send_pending(tls_data);
+    iotjs_tls_notify_error(tls_data);
+    return false;
+  }
+}
 
-      if (ret_val == 0) {
-        size_t pending = mbedtls_ssl_get_bytes_avail(&tls_data->ssl);
 
-        if (pending == 0) {
-          continue;
-        }
+JS_FUNCTION(Read) {
+  JS_DECLARE_THIS_PTR(tls, tls_data);
 
-        jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(pending);
-        iotjs_bufferwrap_t *buf = iotjs_bufferwrap_from_jbuffer(jbuffer);
-        ret_val = mbedtls_ssl_read(&tls_data->ssl, (unsigned char *)buf->buffer,
-                                   pending);
+  if (tls_data->state == TLS_CLOSED) {
+    return jerry_create_boolean(false);
+  }
 
-        IOTJS_ASSERT(ret_val == (int)pending);
-        IOTJS_UNUSED(ret_val);
+  iotjs_bio_t *bio = &(tls_data->bio);
 
-        jerry_value_t fn =
-            iotjs_jval_get_property(jthis, IOTJS_MAGIC_STRING_ONREAD);
-        iotjs_invoke_callback(fn, jthis, &jbuffer, 1);
+  if (jargc >= 1 && jerry_value_to_boolean(jargv[0])) {
+    jerry_value_t jbuffer = JS_GET_ARG(0, object);
 
-        jerry_release_value(jbuffer);
-        jerry_release_value(fn);
-        continue;
-      }
+    iotjs_bufferwrap_t *buf = iotjs_bufferwrap_from_jbuffer(jbuffer);
+    bio->receive_data = (const unsigned char *)buf->buffer;
+    bio->receive_length = iotjs_bufferwrap_length(buf);
+  }
 
-      if (ret_val == MBEDTLS_ERR_SSL_WANT_READ) {
-        break;
-      }
+  // mbedtls consumes all input before it reports MBEDTLS_ERR_SSL_WANT_READ,
+  // incomplete records are kept in its own input buffer.
+  bool result = tls_read(tls_data, jthis);
 
-      if (ret_val == MBEDTLS_ERR_SSL_WANT_WRITE) {
-        continue;
-      }
+  bio->receive_data = NULL;
+  bio->receive_length = 0;
 
-      tls_data->state = TLS_CLOSED;
+  return jerry_create_boolean(result);
+}
 
-      if (ret_val == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
-        return jerry_create_boolean(true);
-      }
 
-      iotjs_tls_notify_error(tls_data);
-      return jerry_create_boolean(false);
-    }
-  } while (length > 0);
+JS_FUNCTION(IsSessionReused) {
+  JS_DECLARE_THIS_PTR(tls, tls_data);
 
-  return jerry_create_boolean(true);
+  return jerry_create_boolean(tls_data->session_reused);
 }
 
 
@@ -627,6 +1031,8 @@ jerry_value_t InitTls() {
   jerry_value_t jtls = jerry_create_object();
 
   iotjs_jval_set_method(jtls, IOTJS_MAGIC_STRING_CONNECT, Connect);
+  iotjs_jval_set_method(jtls, IOTJS_MAGIC_STRING_ISSESSIONREUSED,
+                        IsSessionReused);
   iotjs_jval_set_method(jtls, IOTJS_MAGIC_STRING_READ, Read);
   iotjs_jval_set_method(jtls, IOTJS_MAGIC_STRING_TLSCONTEXT, TlsContext);
   iotjs_jval_set_method(jtls, IOTJS_MAGIC_STRING_TLSINIT, TlsInit);
@@ -23,7 +23,10 @@
 #include "mbedtls/entropy.h"
 #include "mbedtls/net.h"
 #include "mbedtls/net_sockets.h"
+#include "mbedtls/sha256.h"
 #include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
 
 // Default certificate
 const char SSL_CA_PEM[] =
@@ -57,25 +60,52 @@ enum {
 };
 
 typedef struct {
-  char *mem;
-  size_t size;
-  size_t read_index;
-  size_t write_index;
+  // Encrypted data of the Buffer being read
+  const unsigned char *receive_data;
+  size_t receive_length;
+  // Encrypted data not yet passed to the socket
+  jerry_value_t jsend_buffer;
 } iotjs_bio_t;
 
-typedef struct {
-  iotjs_bio_t receive_bio;
-  iotjs_bio_t send_bio;
-} iotjs_bio_pair_t;
-
 enum {
-  SSL_BIO_SUCCESS = 0,
-  SSL_BIO_ERROR = -1,
-  SSL_BIO_UNSET = -2,
-  SSL_BIO_SIZE = 4096
+  SSL_CONTEXT_HAS_KEY = (1 << 0),
+  SSL_CONTEXT_HAS_SESSION_CACHE = (1 << 1)
 };
 
-enum { SSL_CONTEXT_HAS_KEY = (1 << 0) };
+// Number of client sessions kept by a context
+#ifndef IOTJS_TLS_CLIENT_SESSIONS
+#define IOTJS_TLS_CLIENT_SESSIONS 4
+#endif
+
+// Number of sessions kept by the server session cache
+#ifndef IOTJS_TLS_SERVER_SESSIONS
+#define IOTJS_TLS_SERVER_SESSIONS 16
+#endif
+
+// Default lifetime of sessions and tickets in seconds
+#define IOTJS_TLS_SESSION_TIMEOUT 300
+
+// Client and server endpoints
+#define IOTJS_TLS_ENDPOINTS 2
+// MBEDTLS_SSL_VERIFY_NONE, MBEDTLS_SSL_VERIFY_OPTIONAL and
+// MBEDTLS_SSL_VERIFY_REQUIRED
+#define IOTJS_TLS_AUTH_MODES 3
+
+#define IOTJS_TLS_TRUST_STORE_DIGEST_SIZE 32
+
+typedef struct iotjs_tls_trust_store_s {
+  struct iotjs_tls_trust_store_s *next;
+  int ref_count;
+  // SHA-256 digest of the bundle
+  unsigned char digest[IOTJS_TLS_TRUST_STORE_DIGEST_SIZE];
+  mbedtls_x509_crt certs;
+} iotjs_tls_trust_store_t;
+
+typedef struct {
+  char *key;
+  uint32_t last_used;
+  mbedtls_ssl_session session;
+} iotjs_tls_session_t;
 
 typedef struct {
   int ref_count;
@@ -84,7 +114,25 @@ typedef struct {
   mbedtls_ctr_drbg_context ctr_drbg;
   mbedtls_pk_context pkey;
   mbedtls_x509_crt own_cert;
-  mbedtls_x509_crt cert_auth;
+  iotjs_tls_trust_store_t *trust_store;
+
+  // Configurations shared by the connections of the context, indexed by
+  // endpoint and authentication mode
+  mbedtls_ssl_config *configs[IOTJS_TLS_ENDPOINTS][IOTJS_TLS_AUTH_MODES];
+
+  // Client sessions keyed by host:port
+  iotjs_tls_session_t sessions[IOTJS_TLS_CLIENT_SESSIONS];
+  uint32_t session_clock;
+
+  // Server session cache and ticket keys
+  uint32_t session_timeout;
+  bool session_resumed;
+#if defined(MBEDTLS_SSL_CACHE_C)
+  mbedtls_ssl_cache_context session_cache;
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+  mbedtls_ssl_ticket_context ticket;
+#endif
 } iotjs_tls_context_t;
 
 typedef struct {
@@ -92,10 +140,16 @@ typedef struct {
   int state;
 
   iotjs_tls_context_t *tls_context;
-  mbedtls_ssl_config conf;
   mbedtls_ssl_context ssl;
 
-  iotjs_bio_pair_t bio;
+  // Session key (host:port) of a client, NULL if sessions are not cached
+  char *session_key;
+  // Master secret of the session offered to the server
+  unsigned char session_master[48];
+  bool session_offered;
+  bool session_reused;
+
+  iotjs_bio_t bio;
 } iotjs_tls_t;
 
 #endif /* IOTJS_MODULE_TLS_H */
@@ -13,7 +13,9 @@
  * limitations under the License.
  */
 
+#include <ctype.h>
 #include <stdlib.h>
+#include <strings.h>
 #include <time.h>
 
 #include "iotjs_def.h"
@@ -25,9 +27,16 @@
 IOTJS_DEFINE_NATIVE_HANDLE_INFO_THIS_MODULE(wsclient);
 
 static void iotjs_wsclient_destroy(iotjs_wsclient_t *wsclient) {
-  IOTJS_RELEASE(wsclient->tcp_buff.buffer);
-  IOTJS_RELEASE(wsclient->ws_buff.data);
+  IOTJS_RELEASE(wsclient->tcp_buff.data);
+  IOTJS_RELEASE(wsclient->ws_buff.buffer.data);
+  jerry_release_value(wsclient->pending.jbuffer);
   IOTJS_RELEASE(wsclient->generated_key);
+  IOTJS_RELEASE(wsclient->deflate_offer);
+  if (wsclient->deflate != NULL) {
+    iotjs_ws_deflate_stream_destroy(&wsclient->deflate->deflate);
+    iotjs_ws_deflate_stream_destroy(&wsclient->deflate->inflate);
+    IOTJS_RELEASE(wsclient->deflate);
+  }
   IOTJS_RELEASE(wsclient);
 }
 
@@ -38,6 +47,88 @@ iotjs_wsclient_t *iotjs_wsclient_create(const jerry_value_t jobject) {
   return wsclient;
 }
 
+void iotjs_ws_buffer_reserve(iotjs_ws_buffer_t *buff, size_t size) {
+  size_t required = buff->length + size;
+
+  if (required <= buff->capacity) {
+    return;
+  }
+
+  size_t capacity = buff->capacity ? buff->capacity : WS_BUFFER_MIN_SIZE;
+  while (capacity < required) {
+    capacity *= 2;
+  }
+
+  if (buff->data == NULL) {
+    buff->data = iotjs_buffer_allocate(capacity);
+  } else {
+    buff->data = iotjs_buffer_reallocate(buff->data, capacity);
+  }
+  buff->capacity = capacity;
+}
+
+
+void iotjs_ws_buffer_append(iotjs_ws_buffer_t *buff, const char *data,
+                            size_t size) {
+  iotjs_ws_buffer_reserve(buff, size);
+  memcpy(buff->data + buff->length, data, size);
+  buff->length += size;
+}
+
+
+// Drops the first `size` bytes, keeping the unprocessed tail.
+void iotjs_ws_buffer_consume(iotjs_ws_buffer_t *buff, size_t size) {
+  IOTJS_ASSERT(size <= buff->length);
+  buff->length -= size;
+
+  if (buff->length > 0) {
+    memmove(buff->data, buff->data + size, buff->length);
+  } else if (buff->capacity > WS_BUFFER_KEEP_SIZE) {
+    // Do not hold on to the memory of an occasional large message.
+    IOTJS_RELEASE(buff->data);
+    buff->capacity = 0;
+  }
+}
+
+
+// XORs `length` bytes of `data` with the masking key. The `offset` is the
+// position of `data` within the payload, so a payload can be processed in
+// chunks. The bulk of the data is processed a 64-bit word at a time.
+static void iotjs_websocket_mask(char *data, size_t length,
+                                 const uint8_t mask_key[4], size_t offset) {
+  uint8_t *ptr = (uint8_t *)data;
+  uint8_t *end = ptr + length;
+
+  while (ptr < end && ((uintptr_t)ptr & (sizeof(uint64_t) - 1))) {
+    *ptr++ ^= mask_key[offset++ & 0x3];
+  }
+
+  if ((size_t)(end - ptr) >= sizeof(uint64_t)) {
+    uint8_t key_bytes[sizeof(uint64_t)];
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+      key_bytes[i] = mask_key[(offset + i) & 0x3];
+    }
+
+    uint64_t key;
+    memcpy(&key, key_bytes, sizeof(uint64_t));
+
+    // The word size is a multiple of the key size, so the offset of the
+    // key does not change in this loop.
+    do {
+      uint64_t word;
+      memcpy(&word, ptr, sizeof(uint64_t));
+      word ^= key;
+      memcpy(ptr, &word, sizeof(uint64_t));
+      ptr += sizeof(uint64_t);
+    } while ((size_t)(end - ptr) >= sizeof(uint64_t));
+  }
+
+  while (ptr < end) {
+    *ptr++ ^= mask_key[offset++ & 0x3];
+  }
+}
+
+
 static const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
 
 /**
@@ -57,6 +148,8 @@ static const char upgrade[] = "Upgrade: websocket\r\n";
 static const char connection[] = "Connection: Upgrade\r\n";
 static const char sec_websocket_key[] = "Sec-WebSocket-Key: ";
 static const char sec_websocket_ver[] = "Sec-WebSocket-Version: 13\r\n\r\n";
+static const char sec_websocket_ext[] = "Sec-WebSocket-Extensions: ";
+static const char permessage_deflate[] = "permessage-deflate";
 static const char handshake_response[] =
     "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: "
     "Upgrade\r\nSec-WebSocket-Accept: ";
@@ -161,6 +254,388 @@ static bool iotjs_check_handshake_key(char *server_key, jerry_value_t jsref) {
 }
 
 
+// Size of a formatted permessage-deflate extension.
+#define WS_DEFLATE_EXTENSION_SIZE 160
+
+
+static bool iotjs_ws_token_equals(const char *token, size_t length,
+                                  const char *name) {
+  return length == strlen(name) && strncasecmp(token, name, length) == 0;
+}
+
+
+static void iotjs_ws_trim(const char **start, const char **end) {
+  while (*start < *end && isspace((unsigned char)**start)) {
+    (*start)++;
+  }
+  while (*end > *start && isspace((unsigned char)(*end)[-1])) {
+    (*end)--;
+  }
+}
+
+
+static uint8_t iotjs_ws_parse_window_bits(const char *value, const char *end) {
+  if (end - value >= 2 && *value == '"' && end[-1] == '"') {
+    value++;
+    end--;
+  }
+
+  if (value == end || end - value > 2) {
+    return 0;
+  }
+
+  uint8_t bits = 0;
+  for (; value < end; value++) {
+    if (!isdigit((unsigned char)*value)) {
+      return 0;
+    }
+    bits = (uint8_t)(bits * 10 + (*value - '0'));
+  }
+
+  if (bits < WS_DEFLATE_MIN_WINDOW_BITS || bits > WS_DEFLATE_MAX_WINDOW_BITS) {
+    return 0;
+  }
+  return bits;
+}
+
+
+// Parses one extension of a Sec-WebSocket-Extensions header. Returns
+// false if it is not a valid permessage-deflate extension.
+static bool iotjs_ws_deflate_parse(const char *data, size_t length,
+                                   iotjs_ws_deflate_params_t *params) {
+  const char *end = data + length;
+  const char *token = data;
+  bool first = true;
+
+  memset(params, 0, sizeof(iotjs_ws_deflate_params_t));
+
+  for (;;) {
+    const char *token_end = memchr(token, ';', (size_t)(end - token));
+    if (token_end == NULL) {
+      token_end = end;
+    }
+
+    const char *name = token;
+    const char *name_end = token_end;
+    const char *value = NULL;
+    const char *value_end = NULL;
+
+    const char *eq = memchr(name, '=', (size_t)(name_end - name));
+    if (eq != NULL) {
+      value = eq + 1;
+      value_end = name_end;
+      name_end = eq;
+      iotjs_ws_trim(&value, &value_end);
+    }
+    iotjs_ws_trim(&name, &name_end);
+
+    size_t name_len = (size_t)(name_end - name);
+
+    if (first) {
+      if (!iotjs_ws_token_equals(name, name_len, permessage_deflate) ||
+          value != NULL) {
+        return false;
+      }
+      first = false;
+    } else if (iotjs_ws_token_equals(name, name_len,
+                                     "server_no_context_takeover")) {
+      if (value != NULL || params->server_no_context_takeover) {
+        return false;
+      }
+      params->server_no_context_takeover = true;
+    } else if (iotjs_ws_token_equals(name, name_len,
+                                     "client_no_context_takeover")) {
+      if (value != NULL || params->client_no_context_takeover) {
+        return false;
+      }
+      params->client_no_context_takeover = true;
+    } else if (iotjs_ws_token_equals(name, name_len,
+                                     "server_max_window_bits")) {
+      if (value == NULL || params->server_max_window_bits) {
+        return false;
+      }
+      params->server_max_window_bits =
+          iotjs_ws_parse_window_bits(value, value_end);
+      if (params->server_max_window_bits == 0) {
+        return false;
+      }
+    } else if (iotjs_ws_token_equals(name, name_len,
+                                     "client_max_window_bits")) {
+      if (params->client_max_window_bits_offered) {
+        return false;
+      }
+      params->client_max_window_bits_offered = true;
+      if (value != NULL) {
+        params->client_max_window_bits =
+            iotjs_ws_parse_window_bits(value, value_end);
+        if (params->client_max_window_bits == 0) {
+          return false;
+        }
+      }
+    } else {
+      return false;
+    }
+
+    if (token_end == end) {
+      return true;
+    }
+    token = token_end + 1;
+  }
+}
+
+
+static size_t iotjs_ws_deflate_format(const iotjs_ws_deflate_params_t *params,
+                                      char *buffer) {
+  size_t size = WS_DEFLATE_EXTENSION_SIZE;
+  size_t length = (size_t)snprintf(buffer, size, "%s", permessage_deflate);
+
+  if (params->server_no_context_takeover) {
+    length += (size_t)snprintf(buffer + length, size - length,
+                               "; server_no_context_takeover");
+  }
+  if (params->client_no_context_takeover) {
+    length += (size_t)snprintf(buffer + length, size - length,
+                               "; client_no_context_takeover");
+  }
+  if (params->server_max_window_bits) {
+    length += (size_t)snprintf(buffer + length, size - length,
+                               "; server_max_window_bits=%d",
+                               params->server_max_window_bits);
+  }
+  if (params->client_max_window_bits) {
+    length += (size_t)snprintf(buffer + length, size - length,
+                               "; client_max_window_bits=%d",
+                               params->client_max_window_bits);
+  } else if (params->client_max_window_bits_offered) {
+    length += (size_t)snprintf(buffer + length, size - length,
+                               "; client_max_window_bits");
+  }
+
+  return length;
+}
+
+
+// Reads the perMessageDeflate option of a client or a server, `true`
+// selects the defaults.
+static void iotjs_ws_deflate_read_options(jerry_value_t joptions,
+                                          iotjs_ws_deflate_params_t *params) {
+  memset(params, 0, sizeof(iotjs_ws_deflate_params_t));
+
+  if (!jerry_value_is_object(joptions)) {
+    return;
+  }
+
+  const char *bool_names[2] = { IOTJS_MAGIC_STRING_SERVERNOCONTEXTTAKEOVER,
+                                IOTJS_MAGIC_STRING_CLIENTNOCONTEXTTAKEOVER };
+  bool *bool_values[2] = { &params->server_no_context_takeover,
+                           &params->client_no_context_takeover };
+
+  for (uint8_t i = 0; i < 2; i++) {
+    jerry_value_t jvalue = iotjs_jval_get_property(joptions, bool_names[i]);
+    *bool_values[i] = jerry_value_to_boolean(jvalue);
+    jerry_release_value(jvalue);
+  }
+
+  const char *bits_names[2] = { IOTJS_MAGIC_STRING_SERVERMAXWINDOWBITS,
+                                IOTJS_MAGIC_STRING_CLIENTMAXWINDOWBITS };
+  uint8_t *bits_values[2] = { &params->server_max_window_bits,
+                              &params->client_max_window_bits };
+
+  for (uint8_t i = 0; i < 2; i++) {
+    jerry_value_t jvalue = iotjs_jval_get_property(joptions, bits_names[i]);
+    if (jerry_value_is_number(jvalue)) {
+      double bits = iotjs_jval_as_number(jvalue);
+      if (bits >= WS_DEFLATE_MIN_WINDOW_BITS &&
+          bits <= WS_DEFLATE_MAX_WINDOW_BITS) {
+        *bits_values[i] = (uint8_t)bits;
+      }
+    }
+    jerry_release_value(jvalue);
+  }
+}
+
+
+static bool iotjs_ws_deflate_options_enabled(jerry_value_t joptions) {
+  return jerry_value_is_object(joptions) ||
+         (jerry_value_is_boolean(joptions) &&
+          jerry_get_boolean_value(joptions));
+}
+
+
+static void iotjs_ws_deflate_stream_init(iotjs_ws_deflate_stream_t *stream,
+                                         uint8_t window_bits,
+                                         bool no_context_takeover) {
+  stream->window.data = NULL;
+  stream->window.length = 0;
+  stream->window.capacity = 0;
+  stream->window_bits = window_bits ? window_bits : WS_DEFLATE_MAX_WINDOW_BITS;
+  stream->no_context_takeover = no_context_takeover;
+  stream->matcher = NULL;
+}
+
+
+// Sets up the compression of a connection with the negotiated params.
+static void iotjs_ws_deflate_enable(iotjs_wsclient_t *wsclient,
+                                    const iotjs_ws_deflate_params_t *params,
+                                    bool is_server) {
+  iotjs_ws_deflate_t *deflate = IOTJS_ALLOC(iotjs_ws_deflate_t);
+  deflate->params = *params;
+
+  uint8_t own_bits = params->client_max_window_bits;
+  uint8_t peer_bits = params->server_max_window_bits;
+  bool own_no_context_takeover = params->client_no_context_takeover;
+  bool peer_no_context_takeover = params->server_no_context_takeover;
+
+  if (is_server) {
+    own_bits = params->server_max_window_bits;
+    peer_bits = params->client_max_window_bits;
+    own_no_context_takeover = params->server_no_context_takeover;
+    peer_no_context_takeover = params->client_no_context_takeover;
+  }
+
+  // Some compressors do not support 8 bit windows and use 9 bits
+  // instead, so the decompressor always keeps 9 bits of history.
+  if (peer_bits != 0 && peer_bits < WS_DEFLATE_MIN_WINDOW_BITS + 1) {
+    peer_bits = WS_DEFLATE_MIN_WINDOW_BITS + 1;
+  }
+
+  iotjs_ws_deflate_stream_init(&deflate->deflate, own_bits,
+                               own_no_context_takeover);
+  iotjs_ws_deflate_matcher_init(&deflate->deflate);
+  iotjs_ws_deflate_stream_init(&deflate->inflate, peer_bits,
+                               peer_no_context_takeover);
+
+  wsclient->deflate = deflate;
+}
+
+
+static uint8_t iotjs_ws_min_window_bits(uint8_t a, uint8_t b) {
+  if (a == 0 || (b != 0 && b < a)) {
+    return b;
+  }
+  return a;
+}
+
+
+// Selects the first acceptable permessage-deflate offer of a client.
+// Returns the length of the extension written to `response`, or 0 if
+// compression is not used.
+static size_t iotjs_ws_deflate_accept(iotjs_wsclient_t *wsclient,
+                                      const char *offers, size_t length,
+                                      jerry_value_t joptions, char *response) {
+  iotjs_ws_deflate_params_t options;
+  iotjs_ws_deflate_read_options(joptions, &options);
+
+  const char *end = offers + length;
+  const char *offer = offers;
+
+  while (offer < end) {
+    const char *offer_end = memchr(offer, ',', (size_t)(end - offer));
+    if (offer_end == NULL) {
+      offer_end = end;
+    }
+
+    iotjs_ws_deflate_params_t params;
+    if (iotjs_ws_deflate_parse(offer, (size_t)(offer_end - offer), &params) &&
+        (options.client_max_window_bits == 0 ||
+         params.client_max_window_bits_offered)) {
+      params.server_no_context_takeover |= options.server_no_context_takeover;
+      params.client_no_context_takeover |= options.client_no_context_takeover;
+      params.server_max_window_bits =
+          iotjs_ws_min_window_bits(params.server_max_window_bits,
+                                   options.server_max_window_bits);
+      params.client_max_window_bits =
+          iotjs_ws_min_window_bits(params.client_max_window_bits,
+                                   options.client_max_window_bits);
+      params.client_max_window_bits_offered = false;
+
+      iotjs_ws_deflate_enable(wsclient, &params, true);
+      return iotjs_ws_deflate_format(&params, response);
+    }
+
+    offer = offer_end + 1;
+  }
+
+  return 0;
+}
+
+
+// Returns the value of a header of an HTTP response, or NULL if the
+// header is not present.
+static const char *iotjs_ws_find_header(const char *data, const char *end,
+                                        const char *name, size_t *length) {
+  size_t name_len = strlen(name);
+  const char *line = data;
+
+  while (line < end) {
+    const char *line_end = line;
+    while (line_end + 1 < end &&
+           !(line_end[0] == '\r' && line_end[1] == '\n')) {
+      line_end++;
+    }
+    if (line_end + 1 >= end) {
+      line_end = end;
+    }
+
+    if ((size_t)(line_end - line) > name_len && line[name_len] == ':' &&
+        strncasecmp(line, name, name_len) == 0) {
+      const char *value = line + name_len + 1;
+      iotjs_ws_trim(&value, &line_end);
+      *length = (size_t)(line_end - value);
+      return value;
+    }
+
+    line = line_end + 2;
+  }
+
+  return NULL;
+}
+
+
+// Completes the negotiation of the client with the response of the
+// server. Returns false if the server selected invalid parameters.
+static bool iotjs_ws_deflate_confirm(iotjs_wsclient_t *wsclient,
+                                     const char *data, const char *end) {
+  size_t length = 0;
+  const char *extensions =
+      iotjs_ws_find_header(data, end, "Sec-WebSocket-Extensions", &length);
+
+  iotjs_ws_deflate_params_t *offer = wsclient->deflate_offer;
+  wsclient->deflate_offer = NULL;
+
+  if (extensions == NULL || length == 0) {
+    IOTJS_RELEASE(offer);
+    return true;
+  }
+
+  // RFC 7692 7.1: the response may only tighten what the client offered.
+  iotjs_ws_deflate_params_t params;
+  if (offer == NULL || !iotjs_ws_deflate_parse(extensions, length, &params) ||
+      (offer->server_max_window_bits != 0 &&
+       (params.server_max_window_bits == 0 ||
+        params.server_max_window_bits > offer->server_max_window_bits)) ||
+      (params.client_max_window_bits_offered &&
+       (!offer->client_max_window_bits_offered ||
+        params.client_max_window_bits == 0)) ||
+      (offer->server_no_context_takeover &&
+       !params.server_no_context_takeover)) {
+    IOTJS_RELEASE(offer);
+    return false;
+  }
+
+  // The client may use a smaller window or drop its context on its own.
+  params.client_max_window_bits =
+      iotjs_ws_min_window_bits(params.client_max_window_bits,
+                               offer->client_max_window_bits);
+  params.client_no_context_takeover |= offer->client_no_context_takeover;
+  params.client_max_window_bits_offered = false;
+
+  iotjs_ws_deflate_enable(wsclient, &params, false);
+  IOTJS_RELEASE(offer);
+  return true;
+}
+
+
 static jerry_value_t iotjs_websocket_encode_frame(uint8_t opcode, bool mask,
                                                   bool compress, char *payload,
                                                   size_t payload_len) {
@@ -221,19 +696,41 @@ static jerry_value_t iotjs_websocket_encode_frame(uint8_t opcode, bool mask,
       }
 
       buff_ptr = iotjs_ws_write_data(buff_ptr, key, sizeof(key));
-
-      for (size_t i = 0; i < payload_len; i++) {
-        payload[i] ^= key[i % 4];
-      }
+      memcpy(buff_ptr, payload, payload_len);
+      iotjs_websocket_mask(buff_ptr, payload_len, key, 0);
+    } else {
+      memcpy(buff_ptr, payload, payload_len);
     }
-
-    buff_ptr = iotjs_ws_write_data(buff_ptr, payload, payload_len);
   }
 
   return jframe;
 }
 
 
+// Encodes a data frame, the payload is compressed if permessage-deflate
+// is negotiated on the connection.
+static jerry_value_t iotjs_websocket_encode_data(iotjs_wsclient_t *wsclient,
+                                                 uint8_t opcode, bool mask,
+                                                 bool compress, char *payload,
+                                                 size_t payload_len) {
+  if (!compress || wsclient == NULL || wsclient->deflate == NULL) {
+    return iotjs_websocket_encode_frame(opcode, mask, false, payload,
+                                        payload_len);
+  }
+
+  iotjs_ws_buffer_t compressed = { NULL, 0, 0 };
+  iotjs_ws_deflate(&wsclient->deflate->deflate, payload, payload_len,
+                   &compressed);
+
+  jerry_value_t ret_val =
+      iotjs_websocket_encode_frame(opcode, mask, true, compressed.data,
+                                   compressed.length);
+
+  IOTJS_RELEASE(compressed.data);
+  return ret_val;
+}
+
+
 static void iotjs_websocket_create_buffer_and_cb(char **buff_ptr,
                                                  uint32_t payload_len,
                                                  char *cb_type,
@@ -254,6 +751,21 @@ static void iotjs_websocket_create_buffer_and_cb(char **buff_ptr,
 }
 
 
+static uint16_t iotjs_websocket_close_status(uint8_t code) {
+  switch (code) {
+    case WS_ERR_INVALID_UTF8:
+    case WS_ERR_INVALID_COMPRESSED_DATA:
+      return 1007;
+    case WS_ERR_FRAME_SIZE_LIMIT:
+      return 1009;
+    case WS_ERR_NATIVE_POINTER_ERR:
+      return 1011;
+    default:
+      return 1002;
+  }
+}
+
+
 static jerry_value_t iotjs_websocket_check_error(uint8_t code) {
   switch (code) {
     case WS_ERR_INVALID_UTF8: {
@@ -273,7 +785,19 @@ static jerry_value_t iotjs_websocket_check_error(uint8_t code) {
     }
 
     case WS_ERR_FRAME_SIZE_LIMIT: {
-      return JS_CREATE_ERROR(COMMON, "Frame size received exceeds limit");
+      return JS_CREATE_ERROR(COMMON, "Message size received exceeds limit");
+    }
+
+    case WS_ERR_UNEXPECTED_CONTINUATION: {
+      return JS_CREATE_ERROR(COMMON, "Unexpected continuation frame received");
+    }
+
+    case WS_ERR_INVALID_COMPRESSED_DATA: {
+      return JS_CREATE_ERROR(COMMON, "Invalid compressed message received");
+    }
+
+    case WS_ERR_INVALID_CONTROL_FRAME: {
+      return JS_CREATE_ERROR(COMMON, "Invalid control frame received");
     }
 
     default: { return jerry_create_undefined(); };
@@ -287,6 +811,7 @@ JS_FUNCTION(PrepareHandshakeRequest) {
   jerry_value_t jsref = JS_GET_ARG(0, object);
   jerry_value_t jhost = JS_GET_ARG(1, any);
   jerry_value_t jendpoint = JS_GET_ARG(2, any);
+  jerry_value_t joptions = JS_GET_ARG_IF_EXIST(3, any);
 
   iotjs_string_t l_host;
   iotjs_string_t l_endpoint;
@@ -304,9 +829,28 @@ JS_FUNCTION(PrepareHandshakeRequest) {
   size_t generated_key_len = 0;
   wsclient->generated_key = ws_generate_key(jsref, &generated_key_len);
 
+  char extension[WS_DEFLATE_EXTENSION_SIZE];
+  size_t extension_len = 0;
+
+  IOTJS_RELEASE(wsclient->deflate_offer);
+  if (iotjs_ws_deflate_options_enabled(joptions)) {
+    iotjs_ws_deflate_params_t *offer = IOTJS_ALLOC(iotjs_ws_deflate_params_t);
+    iotjs_ws_deflate_read_options(joptions, offer);
+    offer->client_max_window_bits_offered = true;
+    extension_len = iotjs_ws_deflate_format(offer, extension);
+    wsclient->deflate_offer = offer;
+  }
+
+  size_t extension_header_len = 0;
+  if (extension_len > 0) {
+    extension_header_len =
+        strlen(sec_websocket_ext) + extension_len + strlen(line_end);
+  }
+
   jerry_value_t jfinal = iotjs_bufferwrap_create_buffer(
       header_fixed_size + iotjs_string_size(&l_endpoint) +
-      iotjs_string_size(&l_host) + (sizeof(line_end) * 2) + generated_key_len);
+      iotjs_string_size(&l_host) + (sizeof(line_end) * 2) + generated_key_len +
+      extension_header_len);
 
   iotjs_bufferwrap_t *final_wrap = iotjs_bufferwrap_from_jbuffer(jfinal);
 
@@ -326,6 +870,11 @@ JS_FUNCTION(PrepareHandshakeRequest) {
   memcpy(buff_ptr, wsclient->generated_key, generated_key_len);
   buff_ptr += generated_key_len;
   buff_ptr = iotjs_ws_write_header(buff_ptr, line_end);
+  if (extension_len > 0) {
+    buff_ptr = iotjs_ws_write_header(buff_ptr, sec_websocket_ext);
+    buff_ptr = iotjs_ws_write_data(buff_ptr, extension, extension_len);
+    buff_ptr = iotjs_ws_write_header(buff_ptr, line_end);
+  }
   buff_ptr = iotjs_ws_write_header(buff_ptr, sec_websocket_ver);
 
   iotjs_string_destroy(&l_endpoint);
@@ -340,12 +889,16 @@ JS_FUNCTION(PrepareHandshakeRequest) {
  * Upgrade: websocket
  * Connection: Upgrade
  * Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=
+ * Sec-WebSocket-Extensions: permessage-deflate (if negotiated)
  */
 JS_FUNCTION(ReceiveHandshakeData) {
   DJS_CHECK_THIS();
   DJS_CHECK_ARGS(1, string);
 
   iotjs_string_t client_key = JS_GET_ARG(0, string);
+  jerry_value_t jextensions = JS_GET_ARG_IF_EXIST(1, string);
+  jerry_value_t jclient = JS_GET_ARG_IF_EXIST(2, object);
+  jerry_value_t joptions = JS_GET_ARG_IF_EXIST(3, any);
 
   size_t key_len = 0;
   unsigned char *key;
@@ -354,8 +907,32 @@ JS_FUNCTION(ReceiveHandshakeData) {
     return JS_CREATE_ERROR(COMMON, "mbedtls base64 encode failed");
   }
 
+  char extension[WS_DEFLATE_EXTENSION_SIZE];
+  size_t extension_len = 0;
+
+  iotjs_wsclient_t *wsclient = NULL;
+  if (jerry_value_is_string(jextensions) &&
+      iotjs_ws_deflate_options_enabled(joptions) &&
+      jerry_get_object_native_pointer(jclient, (void **)&wsclient,
+                                      &this_module_native_info) &&
+      wsclient->deflate == NULL) {
+    iotjs_string_t offers = iotjs_jval_as_string(jextensions);
+    extension_len =
+        iotjs_ws_deflate_accept(wsclient, iotjs_string_data(&offers),
+                                iotjs_string_size(&offers), joptions,
+                                extension);
+    iotjs_string_destroy(&offers);
+  }
+
+  size_t extension_header_len = 0;
+  if (extension_len > 0) {
+    extension_header_len =
+        strlen(sec_websocket_ext) + extension_len + strlen(line_end);
+  }
+
   jerry_value_t jfinal = iotjs_bufferwrap_create_buffer(
-      sizeof(handshake_response) - 1 + key_len + sizeof(line_end) * 2);
+      sizeof(handshake_response) - 1 + key_len + sizeof(line_end) * 2 +
+      extension_header_len);
 
   iotjs_bufferwrap_t *final_wrap = iotjs_bufferwrap_from_jbuffer(jfinal);
   char *buff_ptr = final_wrap->buffer;
@@ -363,6 +940,11 @@ JS_FUNCTION(ReceiveHandshakeData) {
   memcpy(buff_ptr, key, key_len);
   buff_ptr += key_len;
   buff_ptr = iotjs_ws_write_header(buff_ptr, line_end);
+  if (extension_len > 0) {
+    buff_ptr = iotjs_ws_write_header(buff_ptr, sec_websocket_ext);
+    buff_ptr = iotjs_ws_write_data(buff_ptr, extension, extension_len);
+    buff_ptr = iotjs_ws_write_header(buff_ptr, line_end);
+  }
   buff_ptr = iotjs_ws_write_header(buff_ptr, line_end);
 
   iotjs_string_destroy(&client_key);
@@ -393,6 +975,13 @@ JS_FUNCTION(ParseHandshakeData) {
     return JS_CREATE_ERROR(COMMON, "WebSocket handshake key comparison failed");
   }
 
+  iotjs_wsclient_t *wsclient = NULL;
+  if (jerry_get_object_native_pointer(jsref, (void **)&wsclient,
+                                      &this_module_native_info) &&
+      !iotjs_ws_deflate_confirm(wsclient, buff_wrap->buffer, frame_end)) {
+    return JS_CREATE_ERROR(COMMON, "WebSocket extension negotiation failed");
+  }
+
   size_t header_size = (size_t)(frame_end - buff_wrap->buffer);
   if (buff_wrap->length > header_size) {
     size_t remaining_length = buff_wrap->length - header_size;
@@ -410,85 +999,112 @@ JS_FUNCTION(ParseHandshakeData) {
 }
 
 
-static void iotjs_websocket_concat_tcp_buffers(iotjs_wsclient_t *wsclient,
-                                               iotjs_bufferwrap_t *buff_recv) {
-  char *tmp_buf = wsclient->tcp_buff.buffer;
-  wsclient->tcp_buff.buffer =
-      IOTJS_CALLOC(wsclient->tcp_buff.length + buff_recv->length, char);
-  memcpy(wsclient->tcp_buff.buffer, tmp_buf, wsclient->tcp_buff.length);
-  memcpy(wsclient->tcp_buff.buffer + wsclient->tcp_buff.length,
-         buff_recv->buffer, buff_recv->length);
-  wsclient->tcp_buff.length += buff_recv->length;
-  IOTJS_RELEASE(tmp_buf);
+static uint8_t iotjs_websocket_deliver_message(iotjs_wsclient_t *wsclient,
+                                               char first_byte, char *data,
+                                               size_t length,
+                                               jerry_value_t jsref,
+                                               jerry_value_t client) {
+  if (first_byte & WS_RSV1_BIT) {
+    // Compressed message, it is inflated into the window of the stream.
+    if (wsclient->deflate == NULL) {
+      return WS_ERR_INVALID_COMPRESSED_DATA;
+    }
+
+    iotjs_ws_deflate_stream_t *inflate = &wsclient->deflate->inflate;
+    size_t offset = 0;
+    uint8_t inflate_ret = iotjs_ws_inflate(inflate, data, length,
+                                           wsclient->max_payload, &offset);
+    if (inflate_ret) {
+      return inflate_ret;
+    }
+
+    uint8_t ret_val =
+        iotjs_websocket_deliver_message(wsclient,
+                                        (char)(first_byte & ~WS_RSV1_BIT),
+                                        inflate->window.data + offset,
+                                        inflate->window.length - offset, jsref,
+                                        client);
+    iotjs_ws_deflate_stream_end(inflate);
+    return ret_val;
+  }
+
+  if ((first_byte & 0x0F) == WS_OP_UTF8 &&
+      !jerry_is_valid_utf8_string((unsigned char *)data, length)) {
+    return WS_ERR_INVALID_UTF8;
+  }
+
+  if (length == 0) {
+    iotjs_websocket_create_callback(jsref, jerry_create_undefined(),
+                                    IOTJS_MAGIC_STRING_ONMESSAGE, client);
+    return 0;
+  }
+
+  jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(length);
+  iotjs_bufferwrap_t *buff_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+  memcpy(buff_wrap->buffer, data, length);
+  iotjs_websocket_create_callback(jsref, jbuffer, IOTJS_MAGIC_STRING_ONMESSAGE,
+                                  client);
+  jerry_release_value(jbuffer);
+
+  return 0;
+}
+
+
+static uint8_t iotjs_websocket_deliver_fragments(iotjs_wsclient_t *wsclient,
+                                                 jerry_value_t jsref,
+                                                 jerry_value_t client) {
+  iotjs_ws_buffer_t *buffer = &wsclient->ws_buff.buffer;
+  uint8_t ret_val =
+      iotjs_websocket_deliver_message(wsclient, wsclient->ws_buff.first_byte,
+                                      buffer->data, buffer->length, jsref,
+                                      client);
+
+  iotjs_ws_buffer_consume(buffer, buffer->length);
+  wsclient->ws_buff.first_byte = 0;
+
+  return ret_val;
 }
 
 
+// Handles a frame whose payload is complete and already unmasked.
 static uint8_t iotjs_websocket_decode_frame(iotjs_wsclient_t *wsclient,
-                                            char *first_byte, char *buff_ptr,
+                                            char first_byte, char *buff_ptr,
                                             uint32_t payload_len,
-                                            jerry_value_t jsref, bool mask,
+                                            jerry_value_t jsref,
                                             jerry_value_t client) {
-  uint8_t fin_bit = (first_byte[0] >> 7) & 0x01;
-  uint8_t opcode = first_byte[0] & 0x0F;
-
-  uint32_t *mask_key = NULL;
-  if (mask) {
-    mask_key = (uint32_t *)buff_ptr;
-    buff_ptr += sizeof(uint32_t);
-
-    for (uint64_t i = 0; i < payload_len; i++) {
-      buff_ptr[i] ^= ((unsigned char *)(mask_key))[i % 4];
-    }
-  }
+  uint8_t fin_bit = (first_byte >> 7) & 0x01;
+  uint8_t opcode = first_byte & 0x0F;
 
   switch (opcode) {
     case WS_OP_CONTINUE: {
-      if (wsclient->ws_buff.length == 0) {
-        wsclient->ws_buff.masked = mask;
-        wsclient->ws_buff.first_byte = first_byte[0];
-        wsclient->ws_buff.data = IOTJS_CALLOC(payload_len, char);
-        memcpy(wsclient->ws_buff.data, buff_ptr, payload_len);
-        wsclient->ws_buff.length = payload_len;
-        break;
+      if (wsclient->ws_buff.first_byte == 0) {
+        return WS_ERR_UNEXPECTED_CONTINUATION;
       }
 
-      char *tmp_ptr = wsclient->ws_buff.data;
-      uint32_t tmp_len = wsclient->ws_buff.length;
-      wsclient->ws_buff.data =
-          IOTJS_CALLOC(wsclient->ws_buff.length + payload_len, char);
-      memcpy(wsclient->ws_buff.data, tmp_ptr, tmp_len);
-      memcpy(wsclient->ws_buff.data + tmp_len, buff_ptr, payload_len);
-      wsclient->ws_buff.length += payload_len;
-      IOTJS_RELEASE(tmp_ptr);
-
+      iotjs_ws_buffer_append(&wsclient->ws_buff.buffer, buff_ptr, payload_len);
 
       if (fin_bit) {
-        uint8_t ret_val =
-            iotjs_websocket_decode_frame(wsclient,
-                                         &wsclient->ws_buff.first_byte,
-                                         wsclient->ws_buff.data,
-                                         wsclient->ws_buff.length, jsref,
-                                         wsclient->ws_buff.masked, client);
-
-        IOTJS_RELEASE(wsclient->ws_buff.data);
-        wsclient->ws_buff.length = 0;
-        wsclient->ws_buff.first_byte = 0;
-
-        return ret_val;
+        return iotjs_websocket_deliver_fragments(wsclient, jsref, client);
       }
       break;
     }
 
     case WS_OP_UTF8:
     case WS_OP_BINARY: {
-      if (opcode == WS_OP_UTF8 &&
-          !jerry_is_valid_utf8_string((unsigned char *)buff_ptr, payload_len)) {
-        return WS_ERR_INVALID_UTF8;
+      if (!fin_bit) {
+        // First fragment of a message, the opcode and the compression
+        // bit are kept for delivery.
+        wsclient->ws_buff.first_byte =
+            (char)(WS_FIN_BIT | (first_byte & WS_RSV1_BIT) | opcode);
+        iotjs_ws_buffer_consume(&wsclient->ws_buff.buffer,
+                                wsclient->ws_buff.buffer.length);
+        iotjs_ws_buffer_append(&wsclient->ws_buff.buffer, buff_ptr,
+                               payload_len);
+        break;
       }
-      iotjs_websocket_create_buffer_and_cb(&buff_ptr, payload_len,
-                                           IOTJS_MAGIC_STRING_ONMESSAGE, jsref,
-                                           client);
-      break;
+
+      return iotjs_websocket_deliver_message(wsclient, first_byte, buff_ptr,
+                                             payload_len, jsref, client);
     }
 
     case WS_OP_TERMINATE: {
@@ -546,115 +1162,293 @@ static uint8_t iotjs_websocket_decode_frame(iotjs_wsclient_t *wsclient,
 }
 
 
-JS_FUNCTION(WsReceive) {
-  DJS_CHECK_THIS();
-  DJS_CHECK_ARGS(3, object, object, object);
+// Starts receiving the payload of a data frame which is not complete yet.
+// Unfragmented messages get their final Buffer right away, fragments and
+// compressed messages are written to the end of the reassembly buffer.
+static uint8_t iotjs_websocket_start_pending(iotjs_wsclient_t *wsclient,
+                                             char first_byte,
+                                             const char *mask_key,
+                                             uint32_t payload_len) {
+  uint8_t fin_bit = (first_byte >> 7) & 0x01;
+  uint8_t opcode = first_byte & 0x0F;
 
-  jerry_value_t jsref = JS_GET_ARG(0, object);
+  if (opcode == WS_OP_CONTINUE && wsclient->ws_buff.first_byte == 0) {
+    return WS_ERR_UNEXPECTED_CONTINUATION;
+  }
 
-  iotjs_wsclient_t *wsclient = NULL;
-  if (!jerry_get_object_native_pointer(jsref, (void **)&wsclient,
-                                       &this_module_native_info)) {
-    return iotjs_websocket_check_error(WS_ERR_NATIVE_POINTER_ERR);
+  iotjs_ws_buffer_t *buffer = &wsclient->ws_buff.buffer;
+
+  if (opcode != WS_OP_CONTINUE) {
+    if (fin_bit && !(first_byte & WS_RSV1_BIT)) {
+      jerry_value_t jbuffer = iotjs_bufferwrap_create_buffer(payload_len);
+      wsclient->pending.jbuffer = jbuffer;
+      wsclient->pending.data = iotjs_bufferwrap_from_jbuffer(jbuffer)->buffer;
+    } else {
+      wsclient->ws_buff.first_byte =
+          (char)(WS_FIN_BIT | (first_byte & WS_RSV1_BIT) | opcode);
+      iotjs_ws_buffer_consume(buffer, buffer->length);
+    }
   }
 
-  jerry_value_t jbuffer = JS_GET_ARG(1, object);
-  iotjs_bufferwrap_t *buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+  if (wsclient->pending.data == NULL) {
+    iotjs_ws_buffer_reserve(buffer, payload_len);
+    wsclient->pending.data = buffer->data + buffer->length;
+  }
 
-  jerry_value_t client = JS_GET_ARG(2, object);
+  wsclient->pending.first_byte = first_byte;
+  wsclient->pending.offset = 0;
+  wsclient->pending.length = payload_len;
+  wsclient->pending.masked = mask_key != NULL;
+  if (mask_key != NULL) {
+    memcpy(wsclient->pending.mask_key, mask_key, 4);
+  }
 
-  if (buffer_wrap->length == 0) {
-    return jerry_create_undefined();
+  return 0;
+}
+
+
+// Copies received bytes to the pending frame. Returns the number of
+// bytes consumed.
+static size_t iotjs_websocket_feed_pending(iotjs_wsclient_t *wsclient,
+                                           const char *data, size_t length,
+                                           jerry_value_t jsref,
+                                           jerry_value_t client,
+                                           uint8_t *ret_val) {
+  size_t remaining = wsclient->pending.length - wsclient->pending.offset;
+  if (length > remaining) {
+    length = remaining;
   }
 
-  char *current_buffer = buffer_wrap->buffer;
-  char *current_buffer_end = current_buffer + buffer_wrap->length;
+  char *dst = wsclient->pending.data + wsclient->pending.offset;
+  memcpy(dst, data, length);
 
-  if (wsclient->tcp_buff.length > 0) {
-    iotjs_websocket_concat_tcp_buffers(wsclient, buffer_wrap);
-    current_buffer = wsclient->tcp_buff.buffer;
-    current_buffer_end = current_buffer + wsclient->tcp_buff.length;
+  if (wsclient->pending.masked) {
+    iotjs_websocket_mask(dst, length, wsclient->pending.mask_key,
+                         wsclient->pending.offset);
   }
 
+  wsclient->pending.offset += length;
 
-  while (true) {
-    if (current_buffer >= current_buffer_end) {
-      if (wsclient->tcp_buff.length > 0) {
-        IOTJS_RELEASE(wsclient->tcp_buff.buffer);
-        wsclient->tcp_buff.length = 0;
-      }
-      return jerry_create_undefined();
+  if (wsclient->pending.offset < wsclient->pending.length) {
+    return length;
+  }
+
+  char first_byte = wsclient->pending.first_byte;
+  jerry_value_t jbuffer = wsclient->pending.jbuffer;
+
+  wsclient->pending.jbuffer = jerry_create_undefined();
+  wsclient->pending.data = NULL;
+
+  if (jerry_value_is_object(jbuffer)) {
+    // Complete unfragmented message, the Buffer is delivered as is.
+    iotjs_bufferwrap_t *buff_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+    if ((first_byte & 0x0F) == WS_OP_UTF8 &&
+        !jerry_is_valid_utf8_string((unsigned char *)buff_wrap->buffer,
+                                    buff_wrap->length)) {
+      *ret_val = WS_ERR_INVALID_UTF8;
+    } else {
+      iotjs_websocket_create_callback(jsref, jbuffer,
+                                      IOTJS_MAGIC_STRING_ONMESSAGE, client);
+    }
+    jerry_release_value(jbuffer);
+    return length;
+  }
+
+  wsclient->ws_buff.buffer.length += wsclient->pending.length;
+
+  if ((first_byte >> 7) & 0x01) {
+    *ret_val = iotjs_websocket_deliver_fragments(wsclient, jsref, client);
+  }
+
+  return length;
+}
+
+
+// Rejects a frame by the length in its header, before the payload is
+// received or any space is reserved for it.
+static uint8_t iotjs_websocket_check_length(iotjs_wsclient_t *wsclient,
+                                            char first_byte,
+                                            uint32_t payload_len) {
+  uint8_t opcode = first_byte & 0x0F;
+
+  if (opcode >= WS_OP_TERMINATE) {
+    // Control frames must not be fragmented (RFC 6455, section 5.5).
+    if (payload_len > WS_ONE_BYTE_LENGTH || !(first_byte & WS_FIN_BIT)) {
+      return WS_ERR_INVALID_CONTROL_FRAME;
+    }
+    return 0;
+  }
+
+  // The fragments received so far count towards the message length.
+  size_t received = 0;
+  if (opcode == WS_OP_CONTINUE) {
+    received = wsclient->ws_buff.buffer.length;
+  }
+
+  if (payload_len > wsclient->max_payload ||
+      received > wsclient->max_payload - payload_len) {
+    return WS_ERR_FRAME_SIZE_LIMIT;
+  }
+
+  return 0;
+}
+
+
+// Processes the frames in `buffer`. Returns the number of bytes consumed,
+// the unprocessed tail is an incomplete frame header or control frame.
+static size_t iotjs_websocket_process(iotjs_wsclient_t *wsclient, char *buffer,
+                                      size_t length, jerry_value_t jsref,
+                                      jerry_value_t client, uint8_t *ret_val) {
+  char *current_buffer = buffer;
+  char *current_buffer_end = buffer + length;
+
+  while (current_buffer < current_buffer_end && *ret_val == 0) {
+    if (wsclient->pending.data != NULL) {
+      current_buffer +=
+          iotjs_websocket_feed_pending(wsclient, current_buffer,
+                                       (size_t)(current_buffer_end -
+                                                current_buffer),
+                                       jsref, client, ret_val);
+      continue;
     }
 
     if (current_buffer + 2 > current_buffer_end) {
       break;
     }
 
-    char *first_byte = current_buffer;
-    uint8_t payload_byte = (current_buffer[1]) & WS_THREE_BYTES_LENGTH;
-    uint8_t mask = (first_byte[1] >> 7) & 0x01;
-
-    current_buffer += 2;
+    char *frame_start = current_buffer;
+    char first_byte = frame_start[0];
+    uint8_t payload_byte = (frame_start[1]) & WS_THREE_BYTES_LENGTH;
+    uint8_t mask = (frame_start[1] >> 7) & 0x01;
+    const unsigned char *len_ptr = (const unsigned char *)(frame_start + 2);
+    size_t header_size = 2;
 
     uint32_t payload_len;
-    if (!(payload_byte ^ WS_TWO_BYTES_LENGTH)) {
-      if (current_buffer + sizeof(uint16_t) > current_buffer_end) {
+    if (payload_byte == WS_TWO_BYTES_LENGTH) {
+      header_size += sizeof(uint16_t);
+      if (frame_start + header_size > current_buffer_end) {
         break;
       }
-      payload_len = (uint16_t)(current_buffer[0] << 8 | current_buffer[1]);
-      current_buffer += sizeof(uint16_t);
-    } else if (!(payload_byte ^ WS_THREE_BYTES_LENGTH)) {
-      uint64_t payload_64bit_len;
-      if (current_buffer + sizeof(uint64_t) > current_buffer_end) {
+      payload_len = (uint32_t)(len_ptr[0] << 8 | len_ptr[1]);
+    } else if (payload_byte == WS_THREE_BYTES_LENGTH) {
+      header_size += sizeof(uint64_t);
+      if (frame_start + header_size > current_buffer_end) {
         break;
       }
+
+      uint64_t payload_64bit_len = 0;
       for (uint8_t i = 0; i < sizeof(uint64_t); i++) {
-        memcpy((uint8_t *)&payload_64bit_len + i,
-               current_buffer + sizeof(uint64_t) - 1 - i, sizeof(uint8_t));
+        payload_64bit_len = (payload_64bit_len << 8) | len_ptr[i];
       }
 
       if (payload_64bit_len > UINT32_MAX) {
-        return WS_ERR_FRAME_SIZE_LIMIT;
+        *ret_val = WS_ERR_FRAME_SIZE_LIMIT;
+        break;
       }
       payload_len = (uint32_t)payload_64bit_len;
-
-      current_buffer += sizeof(uint64_t);
     } else {
       payload_len = payload_byte;
     }
 
-    if (mask && ((current_buffer + 4 > current_buffer_end) ||
-                 (current_buffer + 4 + payload_len > current_buffer_end))) {
-      break;
-    } else if (!mask && (current_buffer + payload_len > current_buffer_end)) {
+    char *mask_key = NULL;
+    if (mask) {
+      mask_key = frame_start + header_size;
+      header_size += 4;
+      if (frame_start + header_size > current_buffer_end) {
+        break;
+      }
+    }
+
+    *ret_val = iotjs_websocket_check_length(wsclient, first_byte,
+                                            payload_len);
+    if (*ret_val) {
       break;
     }
 
-    uint8_t ret_val =
-        iotjs_websocket_decode_frame(wsclient, first_byte, current_buffer,
-                                     payload_len, jsref, mask, client);
-    if (ret_val) {
-      return iotjs_websocket_check_error(ret_val);
+    char *payload = frame_start + header_size;
+    size_t available = (size_t)(current_buffer_end - payload);
+    uint8_t opcode = first_byte & 0x0F;
+
+    if (available < payload_len) {
+      // Only data frames are streamed, control frames are small
+      // and wait in the tcp buffer until they are complete.
+      if (opcode != WS_OP_CONTINUE && opcode != WS_OP_UTF8 &&
+          opcode != WS_OP_BINARY) {
+        break;
+      }
+
+      *ret_val = iotjs_websocket_start_pending(wsclient, first_byte, mask_key,
+                                               payload_len);
+      current_buffer = payload;
+      continue;
     }
 
-    current_buffer += mask ? 4 : 0;
-    current_buffer += payload_len;
+    if (mask) {
+      iotjs_websocket_mask(payload, payload_len, (uint8_t *)mask_key, 0);
+    }
+
+    *ret_val = iotjs_websocket_decode_frame(wsclient, first_byte, payload,
+                                            payload_len, jsref, client);
+    current_buffer = payload + payload_len;
   }
 
-  if (current_buffer == wsclient->tcp_buff.buffer) {
-    return jerry_create_undefined();
+  return (size_t)(current_buffer - buffer);
+}
+
+
+JS_FUNCTION(WsReceive) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(3, object, object, object);
+
+  jerry_value_t jsref = JS_GET_ARG(0, object);
+  jerry_value_t client = JS_GET_ARG(2, object);
+
+  // Every connection keeps its own receive state, server side connections
+  // are initialized on the client object.
+  iotjs_wsclient_t *wsclient = NULL;
+  if (!jerry_get_object_native_pointer(client, (void **)&wsclient,
+                                       &this_module_native_info) &&
+      !jerry_get_object_native_pointer(jsref, (void **)&wsclient,
+                                       &this_module_native_info)) {
+    return iotjs_websocket_check_error(WS_ERR_NATIVE_POINTER_ERR);
   }
 
-  uint32_t remaining_size = (uint32_t)(current_buffer_end - current_buffer);
-  char *buffer = IOTJS_CALLOC(remaining_size, char);
-  memcpy(buffer, current_buffer, remaining_size);
+  jerry_value_t jbuffer = JS_GET_ARG(1, object);
+  iotjs_bufferwrap_t *buffer_wrap = iotjs_bufferwrap_from_jbuffer(jbuffer);
+
+  if (buffer_wrap->length == 0) {
+    return jerry_create_undefined();
+  }
 
-  if (wsclient->tcp_buff.buffer != NULL) {
-    IOTJS_RELEASE(wsclient->tcp_buff.buffer);
+  char *data = buffer_wrap->buffer;
+  size_t length = buffer_wrap->length;
+  uint8_t ret_val = 0;
+  iotjs_ws_buffer_t *tcp_buff = &wsclient->tcp_buff;
+
+  if (tcp_buff->length > 0) {
+    // Complete the partial frame kept from the previous read.
+    iotjs_ws_buffer_append(tcp_buff, data, length);
+    size_t consumed =
+        iotjs_websocket_process(wsclient, tcp_buff->data, tcp_buff->length,
+                                jsref, client, &ret_val);
+    iotjs_ws_buffer_consume(tcp_buff, consumed);
+  } else {
+    size_t consumed =
+        iotjs_websocket_process(wsclient, data, length, jsref, client,
+                                &ret_val);
+    if (consumed < length && ret_val == 0) {
+      iotjs_ws_buffer_append(tcp_buff, data + consumed, length - consumed);
+    }
   }
 
-  wsclient->tcp_buff.buffer = buffer;
-  wsclient->tcp_buff.length = remaining_size;
+  if (ret_val) {
+    // The error carries the status code the connection is closed with.
+    jerry_value_t jerror =
+        jerry_get_value_from_error(iotjs_websocket_check_error(ret_val), true);
+    iotjs_jval_set_property_number(jerror, IOTJS_MAGIC_STRING_CODE,
+                                   iotjs_websocket_close_status(ret_val));
+    return jerry_create_error_from_value(jerror, true);
+  }
 
   return jerry_create_undefined();
 }
@@ -666,13 +1460,30 @@ JS_FUNCTION(WsInit) {
   const jerry_value_t jws = JS_GET_ARG(0, object);
 
   iotjs_wsclient_t *wsclient = iotjs_wsclient_create(jws);
-  wsclient->tcp_buff.buffer = NULL;
+  wsclient->tcp_buff.data = NULL;
   wsclient->tcp_buff.length = 0;
-
-  wsclient->ws_buff.data = NULL;
-  wsclient->ws_buff.length = 0;
+  wsclient->tcp_buff.capacity = 0;
+
+  wsclient->ws_buff.buffer.data = NULL;
+  wsclient->ws_buff.buffer.length = 0;
+  wsclient->ws_buff.buffer.capacity = 0;
+  wsclient->ws_buff.first_byte = 0;
+
+  wsclient->pending.jbuffer = jerry_create_undefined();
+  wsclient->pending.data = NULL;
+
+  wsclient->max_payload = WS_DEFAULT_MAX_PAYLOAD;
+  jerry_value_t jmax_payload = JS_GET_ARG_IF_EXIST(1, number);
+  if (jerry_value_is_number(jmax_payload)) {
+    double max_payload = jerry_get_number_value(jmax_payload);
+    if (max_payload >= 0 && max_payload < (double)UINT32_MAX) {
+      wsclient->max_payload = (size_t)max_payload;
+    }
+  }
 
   wsclient->generated_key = NULL;
+  wsclient->deflate_offer = NULL;
+  wsclient->deflate = NULL;
 
   return jerry_create_undefined();
 }
@@ -728,22 +1539,39 @@ JS_FUNCTION(WsSendData) {
   DJS_CHECK_THIS();
 
   jerry_value_t jmsg = JS_GET_ARG(0, any);
+  bool binary = jerry_value_to_boolean(JS_GET_ARG_IF_EXIST(1, boolean));
+  bool mask = jerry_value_to_boolean(JS_GET_ARG_IF_EXIST(2, boolean));
+  bool compress = jerry_value_to_boolean(JS_GET_ARG_IF_EXIST(3, boolean));
+  jerry_value_t jhandle = JS_GET_ARG_IF_EXIST(4, object);
+
+  // Compression state of the connection the frame is sent on.
+  iotjs_wsclient_t *wsclient = NULL;
+  if (compress &&
+      !jerry_get_object_native_pointer(jhandle, (void **)&wsclient,
+                                       &this_module_native_info)) {
+    wsclient = NULL;
+  }
+
+  uint8_t opcode = binary ? WS_OP_BINARY : WS_OP_UTF8;
+
+  // Buffer payloads are encoded straight from their backing store.
+  iotjs_bufferwrap_t *buffer_wrap = iotjs_jbuffer_get_bufferwrap_ptr(jmsg);
+  if (buffer_wrap != NULL && buffer_wrap->length > 0) {
+    return iotjs_websocket_encode_data(wsclient, opcode, mask, compress,
+                                       buffer_wrap->buffer,
+                                       buffer_wrap->length);
+  }
+
   iotjs_string_t msg = iotjs_string_create();
 
   if (!iotjs_jbuffer_as_string(jmsg, &msg)) {
     return jerry_create_undefined();
   }
 
-  bool binary = jerry_get_boolean_value(jargv[1]);
-  bool mask = jerry_get_boolean_value(jargv[2]);
-  bool compress = jerry_get_boolean_value(jargv[3]);
-
-  uint8_t opcode = binary ? WS_OP_BINARY : WS_OP_UTF8;
-
   jerry_value_t ret_val =
-      iotjs_websocket_encode_frame(opcode, mask, compress,
-                                   (char *)iotjs_string_data(&msg),
-                                   iotjs_string_size(&msg));
+      iotjs_websocket_encode_data(wsclient, opcode, mask, compress,
+                                  (char *)iotjs_string_data(&msg),
+                                  iotjs_string_size(&msg));
 
   iotjs_string_destroy(&msg);
   return ret_val;
@@ -776,10 +1604,33 @@ JS_FUNCTION(WsPingOrPong) {
 }
 
 
+JS_FUNCTION(WsExtensions) {
+  DJS_CHECK_THIS();
+  DJS_CHECK_ARGS(1, object);
+
+  jerry_value_t jsref = JS_GET_ARG(0, object);
+
+  iotjs_wsclient_t *wsclient = NULL;
+  if (!jerry_get_object_native_pointer(jsref, (void **)&wsclient,
+                                       &this_module_native_info) ||
+      wsclient->deflate == NULL) {
+    return jerry_create_string((const jerry_char_t *)"");
+  }
+
+  char extension[WS_DEFLATE_EXTENSION_SIZE];
+  size_t extension_len =
+      iotjs_ws_deflate_format(&wsclient->deflate->params, extension);
+
+  return jerry_create_string_sz((const jerry_char_t *)extension,
+                                (jerry_size_t)extension_len);
+}
+
+
 jerry_value_t InitWebsocket() {
   IOTJS_UNUSED(WS_GUID);
   jerry_value_t jws = jerry_create_object();
   iotjs_jval_set_method(jws, IOTJS_MAGIC_STRING_CLOSE, WsClose);
+  iotjs_jval_set_method(jws, IOTJS_MAGIC_STRING_EXTENSIONS, WsExtensions);
   iotjs_jval_set_method(jws, IOTJS_MAGIC_STRING_PARSEHANDSHAKEDATA,
                         ParseHandshakeData);
   iotjs_jval_set_method(jws, IOTJS_MAGIC_STRING_PING, WsPingOrPong);
@@ -15,7 +15,7 @@
 #ifndef IOTJS_MODULE_WEBSOCKET_H
 #define IOTJS_MODULE_WEBSOCKET_H
 
-enum {
+typedef enum {
   WS_OP_CONTINUE = 0x00,
   WS_OP_UTF8 = 0x01,
   WS_OP_BINARY = 0x02,
@@ -24,39 +24,160 @@ enum {
   WS_OP_PONG = 0x0a,
 } iotjs_websocket_opcodes;
 
-enum {
+typedef enum {
   WS_FIN_BIT = 0x80,
+  WS_RSV1_BIT = 0x40,
   WS_MASK_BIT = WS_FIN_BIT,
 } iotjs_websocket_header_bits;
 
-enum {
+typedef enum {
   WS_ERR_INVALID_UTF8 = 1,
   WS_ERR_INVALID_TERMINATE_CODE = 2,
   WS_ERR_UNKNOWN_OPCODE = 3,
   WS_ERR_NATIVE_POINTER_ERR = 4,
   WS_ERR_FRAME_SIZE_LIMIT = 5,
+  WS_ERR_UNEXPECTED_CONTINUATION = 6,
+  WS_ERR_INVALID_COMPRESSED_DATA = 7,
+  WS_ERR_INVALID_CONTROL_FRAME = 8,
 } iotjs_websocket_err_codes;
 
-enum {
+typedef enum {
   WS_ONE_BYTE_LENGTH = 125,
   WS_TWO_BYTES_LENGTH,
   WS_THREE_BYTES_LENGTH,
 } iotjs_websocket_frame_len_types;
 
 
+typedef enum {
+  // Initial capacity of the receive buffers.
+  WS_BUFFER_MIN_SIZE = 256,
+  // Receive buffers larger than this are released once they are drained.
+  WS_BUFFER_KEEP_SIZE = 4096,
+  // Default upper limit of a received message, compressed messages are
+  // limited after they are inflated.
+  WS_DEFAULT_MAX_PAYLOAD = 16 * 1024 * 1024,
+} iotjs_websocket_buffer_sizes;
+
+
+// Growable byte buffer, the capacity is doubled when it runs out of space
+// so appending partial reads costs amortized O(1) per byte.
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+} iotjs_ws_buffer_t;
+
+
+typedef enum {
+  // Window sizes allowed by permessage-deflate (RFC 7692).
+  WS_DEFLATE_MIN_WINDOW_BITS = 8,
+  WS_DEFLATE_MAX_WINDOW_BITS = 15,
+} iotjs_websocket_deflate_limits;
+
+
+// Parameters of a permessage-deflate offer or response. A window
+// size of 0 means that the parameter is not present.
+typedef struct {
+  uint8_t server_max_window_bits;
+  uint8_t client_max_window_bits;
+  bool client_max_window_bits_offered;
+  bool server_no_context_takeover;
+  bool client_no_context_takeover;
+} iotjs_ws_deflate_params_t;
+
+
+// Hash chains of the compressor, allocated once when compression is
+// negotiated. Positions are counted from the start of the stream, so the
+// chains stay valid while the window slides over the messages.
+typedef struct {
+  uint32_t *head;
+  uint32_t *prev;
+  uint8_t hash_bits;
+  // Stream position of the first byte of the window.
+  uint32_t base;
+  // Stream position of the first byte not added to the chains yet.
+  uint32_t next_insert;
+} iotjs_ws_deflate_matcher_t;
+
+
+// One direction of a compressed connection. The window keeps the data
+// of the previous messages when the context is taken over.
+typedef struct {
+  iotjs_ws_buffer_t window;
+  uint8_t window_bits;
+  bool no_context_takeover;
+  // Only used by the compressing direction.
+  iotjs_ws_deflate_matcher_t *matcher;
+} iotjs_ws_deflate_stream_t;
+
+
+typedef struct {
+  iotjs_ws_deflate_params_t params;
+  iotjs_ws_deflate_stream_t deflate;
+  iotjs_ws_deflate_stream_t inflate;
+} iotjs_ws_deflate_t;
+
+
 typedef struct {
+  // Bytes of a frame header (or of a small control frame) that
+  // arrived split across multiple TCP reads.
+  iotjs_ws_buffer_t tcp_buff;
+
+  // Reassembly buffer of a fragmented message.
   struct {
-    uint32_t length;
-    char *buffer;
-  } tcp_buff;
+    iotjs_ws_buffer_t buffer;
+    char first_byte;
+  } ws_buff;
 
+  // Data frame whose payload is still arriving. The payload is copied
+  // straight to its final place: a Buffer that is delivered to JS as is,
+  // or the end of the fragmented message reassembly buffer.
   struct {
-    uint32_t length;
+    jerry_value_t jbuffer;
     char *data;
-    char first_byte;
+    size_t offset;
+    size_t length;
+    uint8_t mask_key[4];
     bool masked;
-  } ws_buff;
+    char first_byte;
+  } pending;
+
+  // Frames or messages longer than this are rejected before any space
+  // is allocated for them.
+  size_t max_payload;
+
   unsigned char *generated_key;
+
+  // The permessage-deflate offer sent by a client, and the compression
+  // state once the extension is negotiated.
+  iotjs_ws_deflate_params_t *deflate_offer;
+  iotjs_ws_deflate_t *deflate;
 } iotjs_wsclient_t;
 
+
+void iotjs_ws_buffer_reserve(iotjs_ws_buffer_t *buff, size_t size);
+void iotjs_ws_buffer_append(iotjs_ws_buffer_t *buff, const char *data,
+                            size_t size);
+void iotjs_ws_buffer_consume(iotjs_ws_buffer_t *buff, size_t size);
+
+// Allocates the hash chains of a compressing stream, sized from its window.
+void iotjs_ws_deflate_matcher_init(iotjs_ws_deflate_stream_t *stream);
+
+// Compresses a message and appends it to `out` without the trailing
+// 0x00 0x00 0xff 0xff bytes of the flush.
+void iotjs_ws_deflate(iotjs_ws_deflate_stream_t *stream, const char *data,
+                      size_t length, iotjs_ws_buffer_t *out);
+
+// Decompresses a message of at most `max_length` bytes into the window of
+// the stream, the message starts at `message_offset`. Returns 0 or one of
+// the WS_ERR codes. Call iotjs_ws_deflate_stream_end after the message is
+// processed.
+uint8_t iotjs_ws_inflate(iotjs_ws_deflate_stream_t *stream, const char *data,
+                         size_t length, size_t max_length,
+                         size_t *message_offset);
+
+// Drops the data which is not needed by the next message.
+void iotjs_ws_deflate_stream_end(iotjs_ws_deflate_stream_t *stream);
+void iotjs_ws_deflate_stream_destroy(iotjs_ws_deflate_stream_t *stream);
+
 #endif /* IOTJS_MODULE_WEBSOCKET_H */
@@ -0,0 +1,813 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * A small DEFLATE (RFC 1951) implementation for the permessage-deflate
+ * WebSocket extension (RFC 7692).
+ *
+ * The compressor looks up repeated strings with hash chains bounded by
+ * the negotiated window and emits them with the fixed Huffman codes.
+ * Incompressible messages are sent in stored blocks. The decompressor
+ * accepts every block type.
+ */
+
+#include "iotjs_def.h"
+#include "iotjs_module_websocket.h"
+
+
+enum {
+  WS_DEFLATE_MIN_MATCH = 3,
+  WS_DEFLATE_MAX_MATCH = 258,
+  // Number of hash chain entries checked for a match.
+  WS_DEFLATE_MAX_CHAIN = 32,
+  // Upper limit of the hash table size, smaller windows use fewer bits.
+  WS_DEFLATE_MAX_HASH_BITS = 12,
+  WS_DEFLATE_MAX_STORED = 65535,
+  WS_DEFLATE_END_OF_BLOCK = 256,
+};
+
+enum {
+  WS_HUFFMAN_MAX_BITS = 15,
+  WS_HUFFMAN_MAX_LITERALS = 288,
+  WS_HUFFMAN_MAX_DISTANCES = 30,
+  WS_HUFFMAN_MAX_LENGTHS = 19,
+};
+
+
+static const uint16_t ws_length_base[29] = {
+  3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t ws_length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                             1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                             4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+static const uint16_t ws_distance_base[30] = {
+  1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+  33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t ws_distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2,  2,
+                                               3, 3, 4, 4, 5, 5, 6,  6,
+                                               7, 7, 8, 8, 9, 9, 10, 10,
+                                               11, 11, 12, 12, 13, 13 };
+
+// The flush which ends every message is removed by the sender.
+static const uint8_t ws_flush_trailer[4] = { 0x00, 0x00, 0xff, 0xff };
+
+
+// Stream positions are restarted before they could overflow.
+#define WS_DEFLATE_MAX_POSITION 0x80000000u
+
+
+static void iotjs_ws_deflate_slide(iotjs_ws_deflate_stream_t *stream,
+                                   size_t size) {
+  iotjs_ws_buffer_consume(&stream->window, size);
+
+  iotjs_ws_deflate_matcher_t *matcher = stream->matcher;
+  if (matcher == NULL) {
+    return;
+  }
+
+  matcher->base += (uint32_t)size;
+  if (matcher->base >= WS_DEFLATE_MAX_POSITION) {
+    // The history of the window is forgotten, the data of the next
+    // message is still compressed against itself.
+    memset(matcher->head, 0, sizeof(uint32_t) << matcher->hash_bits);
+    matcher->base = 0;
+    matcher->next_insert = (uint32_t)stream->window.length;
+  }
+}
+
+
+void iotjs_ws_deflate_stream_end(iotjs_ws_deflate_stream_t *stream) {
+  iotjs_ws_buffer_t *window = &stream->window;
+  size_t window_size = (size_t)1 << stream->window_bits;
+
+  if (stream->no_context_takeover) {
+    iotjs_ws_deflate_slide(stream, window->length);
+    return;
+  }
+
+  if (window->length > window_size) {
+    iotjs_ws_deflate_slide(stream, window->length - window_size);
+  }
+
+  // Do not hold on to the memory of an occasional large message.
+  if (window->capacity > WS_BUFFER_KEEP_SIZE &&
+      window->capacity > 2 * window_size) {
+    window->data = iotjs_buffer_reallocate(window->data, window_size);
+    window->capacity = window_size;
+  }
+}
+
+
+void iotjs_ws_deflate_stream_destroy(iotjs_ws_deflate_stream_t *stream) {
+  IOTJS_RELEASE(stream->window.data);
+  stream->window.length = 0;
+  stream->window.capacity = 0;
+
+  if (stream->matcher != NULL) {
+    IOTJS_RELEASE(stream->matcher->head);
+    IOTJS_RELEASE(stream->matcher->prev);
+    IOTJS_RELEASE(stream->matcher);
+  }
+}
+
+
+/* Compressor */
+
+typedef struct {
+  iotjs_ws_buffer_t *out;
+  uint32_t bits;
+  uint8_t count;
+} iotjs_ws_bit_writer_t;
+
+
+// The window of a stream being compressed, positions are relative to the
+// start of `data`.
+typedef struct {
+  const uint8_t *data;
+  size_t length;
+  size_t window_size;
+  iotjs_ws_deflate_matcher_t *state;
+} iotjs_ws_matcher_t;
+
+
+void iotjs_ws_deflate_matcher_init(iotjs_ws_deflate_stream_t *stream) {
+  iotjs_ws_deflate_matcher_t *matcher = IOTJS_ALLOC(iotjs_ws_deflate_matcher_t);
+  size_t window_size = (size_t)1 << stream->window_bits;
+
+  matcher->hash_bits = stream->window_bits;
+  if (matcher->hash_bits > WS_DEFLATE_MAX_HASH_BITS) {
+    matcher->hash_bits = WS_DEFLATE_MAX_HASH_BITS;
+  }
+  matcher->head = IOTJS_CALLOC((size_t)1 << matcher->hash_bits, uint32_t);
+  matcher->prev = IOTJS_CALLOC(window_size, uint32_t);
+  matcher->base = 0;
+  matcher->next_insert = 0;
+
+  stream->matcher = matcher;
+}
+
+
+// The output must have room for the completed bytes.
+static void iotjs_ws_put_bits(iotjs_ws_bit_writer_t *writer, uint32_t value,
+                              uint8_t count) {
+  iotjs_ws_buffer_t *out = writer->out;
+
+  writer->bits |= value << writer->count;
+  writer->count = (uint8_t)(writer->count + count);
+
+  while (writer->count >= 8) {
+    out->data[out->length++] = (char)(writer->bits & 0xff);
+    writer->bits >>= 8;
+    writer->count = (uint8_t)(writer->count - 8);
+  }
+}
+
+
+// Huffman codes are stored starting from the most significant bit.
+static void iotjs_ws_put_code(iotjs_ws_bit_writer_t *writer, uint32_t code,
+                              uint8_t length) {
+  uint32_t reversed = 0;
+  for (uint8_t i = 0; i < length; i++) {
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+  iotjs_ws_put_bits(writer, reversed, length);
+}
+
+
+static void iotjs_ws_put_symbol(iotjs_ws_bit_writer_t *writer,
+                                uint32_t symbol) {
+  if (symbol < 144) {
+    iotjs_ws_put_code(writer, 0x30 + symbol, 8);
+  } else if (symbol < 256) {
+    iotjs_ws_put_code(writer, 0x190 + symbol - 144, 9);
+  } else if (symbol < 280) {
+    iotjs_ws_put_code(writer, symbol - 256, 7);
+  } else {
+    iotjs_ws_put_code(writer, 0xc0 + symbol - 280, 8);
+  }
+}
+
+
+static void iotjs_ws_put_match(iotjs_ws_bit_writer_t *writer, size_t length,
+                               size_t distance) {
+  uint8_t i = 28;
+  while (ws_length_base[i] > length) {
+    i--;
+  }
+  iotjs_ws_put_symbol(writer, 257u + i);
+  iotjs_ws_put_bits(writer, (uint32_t)(length - ws_length_base[i]),
+                    ws_length_extra[i]);
+
+  uint8_t j = 29;
+  while (ws_distance_base[j] > distance) {
+    j--;
+  }
+  iotjs_ws_put_code(writer, j, 5);
+  iotjs_ws_put_bits(writer, (uint32_t)(distance - ws_distance_base[j]),
+                    ws_distance_extra[j]);
+}
+
+
+static uint32_t iotjs_ws_hash(const uint8_t *data, uint8_t bits) {
+  uint32_t value =
+      (uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | (uint32_t)data[2];
+  return (value * 2654435761u) >> (32 - bits);
+}
+
+
+// Chains are kept in a ring of the window size, stream positions are
+// stored off by one so zero marks an empty entry. The last bytes of the
+// window are added once the following data arrives.
+static void iotjs_ws_insert(iotjs_ws_matcher_t *matcher, size_t position) {
+  if (position + WS_DEFLATE_MIN_MATCH > matcher->length) {
+    return;
+  }
+
+  iotjs_ws_deflate_matcher_t *state = matcher->state;
+  uint32_t stream_position = state->base + (uint32_t)position;
+  uint32_t hash = iotjs_ws_hash(matcher->data + position, state->hash_bits);
+
+  state->prev[stream_position & (matcher->window_size - 1)] = state->head[hash];
+  state->head[hash] = stream_position + 1;
+  state->next_insert = stream_position + 1;
+}
+
+
+static size_t iotjs_ws_find_match(iotjs_ws_matcher_t *matcher,
+                                  size_t position, size_t *distance) {
+  const uint8_t *data = matcher->data;
+  size_t max_length = matcher->length - position;
+  if (max_length > WS_DEFLATE_MAX_MATCH) {
+    max_length = WS_DEFLATE_MAX_MATCH;
+  }
+
+  if (max_length < WS_DEFLATE_MIN_MATCH) {
+    return 0;
+  }
+
+  iotjs_ws_deflate_matcher_t *state = matcher->state;
+  size_t best = 0;
+  uint32_t candidate =
+      state->head[iotjs_ws_hash(data + position, state->hash_bits)];
+
+  for (int chain = WS_DEFLATE_MAX_CHAIN; candidate != 0 && chain > 0;
+       chain--) {
+    // Entries before the window are left from the previous messages.
+    if (candidate - 1 < state->base) {
+      break;
+    }
+
+    size_t match = candidate - 1 - state->base;
+    if (match >= position || position - match > matcher->window_size) {
+      break;
+    }
+
+    if (data[match + best] == data[position + best]) {
+      size_t length = 0;
+      while (length < max_length &&
+             data[match + length] == data[position + length]) {
+        length++;
+      }
+
+      if (length > best) {
+        best = length;
+        *distance = position - match;
+        if (length == max_length) {
+          break;
+        }
+      }
+    }
+
+    candidate = state->prev[(candidate - 1) & (matcher->window_size - 1)];
+  }
+
+  return best >= WS_DEFLATE_MIN_MATCH ? best : 0;
+}
+
+
+static void iotjs_ws_deflate_stored(iotjs_ws_buffer_t *out, const char *data,
+                                    size_t length) {
+  do {
+    size_t block = length;
+    if (block > WS_DEFLATE_MAX_STORED) {
+      block = WS_DEFLATE_MAX_STORED;
+    }
+
+    iotjs_ws_buffer_reserve(out, block + 5);
+    char *ptr = out->data + out->length;
+    // BFINAL = 0, BTYPE = 00, padded to a byte boundary.
+    ptr[0] = 0;
+    ptr[1] = (char)(block & 0xff);
+    ptr[2] = (char)(block >> 8);
+    ptr[3] = (char)(~block & 0xff);
+    ptr[4] = (char)((~block >> 8) & 0xff);
+    memcpy(ptr + 5, data, block);
+    out->length += block + 5;
+
+    data += block;
+    length -= block;
+  } while (length > 0);
+
+  // Header of the empty stored block of the flush.
+  iotjs_ws_buffer_reserve(out, 1);
+  out->data[out->length++] = 0;
+}
+
+
+void iotjs_ws_deflate(iotjs_ws_deflate_stream_t *stream, const char *data,
+                      size_t length, iotjs_ws_buffer_t *out) {
+  iotjs_ws_buffer_t *window = &stream->window;
+  size_t start = window->length;
+
+  // The message follows the data of the previous messages, so matches
+  // can refer back to them.
+  if (length > 0) {
+    iotjs_ws_buffer_append(window, data, length);
+  }
+
+  iotjs_ws_deflate_matcher_t *state = stream->matcher;
+  iotjs_ws_matcher_t matcher;
+  matcher.data = (const uint8_t *)window->data;
+  matcher.length = window->length;
+  matcher.window_size = (size_t)1 << stream->window_bits;
+  matcher.state = state;
+
+  // The previous messages are already in the chains, except for their
+  // last bytes which needed the data of this message.
+  if (state->next_insert < state->base) {
+    state->next_insert = state->base;
+  }
+  size_t position = state->next_insert - state->base;
+  for (; position < start; position++) {
+    iotjs_ws_insert(&matcher, position);
+  }
+  position = start;
+
+  size_t out_start = out->length;
+  iotjs_ws_bit_writer_t writer = { out, 0, 0 };
+
+  // BFINAL = 0, BTYPE = 01 (fixed Huffman codes).
+  iotjs_ws_buffer_reserve(out, 1);
+  iotjs_ws_put_bits(&writer, 0x2, 3);
+
+  while (position < matcher.length) {
+    // A match takes at most 31 bits.
+    iotjs_ws_buffer_reserve(out, 8);
+
+    size_t distance = 0;
+    size_t match = iotjs_ws_find_match(&matcher, position, &distance);
+
+    if (match > 0) {
+      iotjs_ws_put_match(&writer, match, distance);
+    } else {
+      iotjs_ws_put_symbol(&writer, matcher.data[position]);
+      match = 1;
+    }
+
+    for (size_t end = position + match; position < end; position++) {
+      iotjs_ws_insert(&matcher, position);
+    }
+  }
+
+  iotjs_ws_buffer_reserve(out, 8);
+  iotjs_ws_put_symbol(&writer, WS_DEFLATE_END_OF_BLOCK);
+
+  // Header of the empty stored block of the flush, the length fields
+  // are the trailer which is not sent.
+  iotjs_ws_put_bits(&writer, 0, 3);
+  if (writer.count > 0) {
+    iotjs_ws_put_bits(&writer, 0, (uint8_t)(8 - writer.count));
+  }
+
+  size_t stored_length =
+      length + (length / WS_DEFLATE_MAX_STORED + 1) * 5 + 1;
+  if (out->length - out_start > stored_length) {
+    out->length = out_start;
+    iotjs_ws_deflate_stored(out, data, length);
+  }
+
+  iotjs_ws_deflate_stream_end(stream);
+}
+
+
+/* Decompressor */
+
+typedef struct {
+  uint16_t count[WS_HUFFMAN_MAX_BITS + 1];
+  uint16_t symbol[WS_HUFFMAN_MAX_LITERALS];
+} iotjs_ws_huffman_t;
+
+
+typedef struct {
+  const uint8_t *data;
+  size_t data_length;
+  // Length of the data with the flush trailer.
+  size_t length;
+  size_t position;
+  uint32_t bits;
+  uint8_t count;
+  bool error;
+  iotjs_ws_buffer_t *out;
+  size_t limit;
+  bool too_large;
+} iotjs_ws_inflater_t;
+
+
+static iotjs_ws_huffman_t ws_fixed_literals;
+static iotjs_ws_huffman_t ws_fixed_distances;
+static bool ws_fixed_ready = false;
+
+
+static uint32_t iotjs_ws_next_byte(iotjs_ws_inflater_t *inflater) {
+  size_t position = inflater->position;
+
+  if (position >= inflater->length) {
+    inflater->error = true;
+    return 0;
+  }
+
+  inflater->position++;
+
+  if (position < inflater->data_length) {
+    return inflater->data[position];
+  }
+  return ws_flush_trailer[position - inflater->data_length];
+}
+
+
+static uint32_t iotjs_ws_get_bits(iotjs_ws_inflater_t *inflater,
+                                  uint8_t count) {
+  uint32_t value = inflater->bits;
+
+  while (inflater->count < count) {
+    if (inflater->position >= inflater->length) {
+      inflater->error = true;
+      return 0;
+    }
+    value |= iotjs_ws_next_byte(inflater) << inflater->count;
+    inflater->count = (uint8_t)(inflater->count + 8);
+  }
+
+  inflater->bits = value >> count;
+  inflater->count = (uint8_t)(inflater->count - count);
+
+  return value & ((1u << count) - 1);
+}
+
+
+// Builds the canonical Huffman code of the given code lengths. Returns
+// false if the lengths are over-subscribed.
+static bool iotjs_ws_huffman_build(iotjs_ws_huffman_t *huffman,
+                                   const uint8_t *lengths, uint16_t n) {
+  memset(huffman->count, 0, sizeof(huffman->count));
+
+  for (uint16_t i = 0; i < n; i++) {
+    huffman->count[lengths[i]]++;
+  }
+
+  if (huffman->count[0] == n) {
+    return true;
+  }
+
+  int left = 1;
+  for (uint8_t len = 1; len <= WS_HUFFMAN_MAX_BITS; len++) {
+    left <<= 1;
+    left -= huffman->count[len];
+    if (left < 0) {
+      return false;
+    }
+  }
+
+  uint16_t offsets[WS_HUFFMAN_MAX_BITS + 1];
+  offsets[1] = 0;
+  for (uint8_t len = 1; len < WS_HUFFMAN_MAX_BITS; len++) {
+    offsets[len + 1] = (uint16_t)(offsets[len] + huffman->count[len]);
+  }
+
+  for (uint16_t i = 0; i < n; i++) {
+    if (lengths[i] != 0) {
+      huffman->symbol[offsets[lengths[i]]++] = i;
+    }
+  }
+
+  return true;
+}
+
+
+static int iotjs_ws_decode_symbol(iotjs_ws_inflater_t *inflater,
+                                  const iotjs_ws_huffman_t *huffman) {
+  int code = 0;
+  int first = 0;
+  int index = 0;
+
+  for (uint8_t len = 1; len <= WS_HUFFMAN_MAX_BITS; len++) {
+    code |= (int)iotjs_ws_get_bits(inflater, 1);
+    if (inflater->error) {
+      return -1;
+    }
+
+    int count = huffman->count[len];
+    if (code - count < first) {
+      return huffman->symbol[index + (code - first)];
+    }
+
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+
+  return -1;
+}
+
+
+static bool iotjs_ws_inflate_stored(iotjs_ws_inflater_t *inflater) {
+  // Skip to the byte boundary.
+  inflater->bits = 0;
+  inflater->count = 0;
+
+  uint32_t length = iotjs_ws_next_byte(inflater);
+  length |= iotjs_ws_next_byte(inflater) << 8;
+  uint32_t nlength = iotjs_ws_next_byte(inflater);
+  nlength |= iotjs_ws_next_byte(inflater) << 8;
+
+  if (inflater->error || length != (~nlength & 0xffff) ||
+      inflater->position + length > inflater->length) {
+    return false;
+  }
+
+  if (inflater->out->length + length > inflater->limit) {
+    inflater->too_large = true;
+    return false;
+  }
+
+  iotjs_ws_buffer_t *out = inflater->out;
+  iotjs_ws_buffer_reserve(out, length);
+
+  if (inflater->position + length <= inflater->data_length) {
+    memcpy(out->data + out->length, inflater->data + inflater->position,
+           length);
+    inflater->position += length;
+    out->length += length;
+  } else {
+    for (uint32_t i = 0; i < length; i++) {
+      out->data[out->length++] = (char)iotjs_ws_next_byte(inflater);
+    }
+  }
+
+  return true;
+}
+
+
+static bool iotjs_ws_inflate_codes(iotjs_ws_inflater_t *inflater,
+                                   const iotjs_ws_huffman_t *literals,
+                                   const iotjs_ws_huffman_t *distances) {
+  iotjs_ws_buffer_t *out = inflater->out;
+
+  for (;;) {
+    int symbol = iotjs_ws_decode_symbol(inflater, literals);
+
+    if (symbol < 0) {
+      return false;
+    }
+
+    if (symbol < WS_DEFLATE_END_OF_BLOCK) {
+      if (out->length >= inflater->limit) {
+        inflater->too_large = true;
+        return false;
+      }
+      iotjs_ws_buffer_reserve(out, 1);
+      out->data[out->length++] = (char)symbol;
+      continue;
+    }
+
+    if (symbol == WS_DEFLATE_END_OF_BLOCK) {
+      return true;
+    }
+
+    symbol -= 257;
+    if (symbol >= 29) {
+      return false;
+    }
+
+    size_t length = ws_length_base[symbol] +
+                    iotjs_ws_get_bits(inflater, ws_length_extra[symbol]);
+
+    int dsymbol = iotjs_ws_decode_symbol(inflater, distances);
+    if (dsymbol < 0 || dsymbol >= WS_HUFFMAN_MAX_DISTANCES) {
+      return false;
+    }
+
+    size_t distance = ws_distance_base[dsymbol] +
+                      iotjs_ws_get_bits(inflater, ws_distance_extra[dsymbol]);
+
+    if (inflater->error || distance > out->length) {
+      return false;
+    }
+
+    if (out->length + length > inflater->limit) {
+      inflater->too_large = true;
+      return false;
+    }
+
+    iotjs_ws_buffer_reserve(out, length);
+
+    // The source and the destination may overlap.
+    char *dst = out->data + out->length;
+    const char *src = dst - distance;
+    for (size_t i = 0; i < length; i++) {
+      dst[i] = src[i];
+    }
+    out->length += length;
+  }
+}
+
+
+static bool iotjs_ws_inflate_fixed(iotjs_ws_inflater_t *inflater) {
+  if (!ws_fixed_ready) {
+    uint8_t lengths[WS_HUFFMAN_MAX_LITERALS];
+    uint16_t symbol = 0;
+
+    for (; symbol < 144; symbol++) {
+      lengths[symbol] = 8;
+    }
+    for (; symbol < 256; symbol++) {
+      lengths[symbol] = 9;
+    }
+    for (; symbol < 280; symbol++) {
+      lengths[symbol] = 7;
+    }
+    for (; symbol < WS_HUFFMAN_MAX_LITERALS; symbol++) {
+      lengths[symbol] = 8;
+    }
+    iotjs_ws_huffman_build(&ws_fixed_literals, lengths,
+                           WS_HUFFMAN_MAX_LITERALS);
+
+    for (symbol = 0; symbol < WS_HUFFMAN_MAX_DISTANCES; symbol++) {
+      lengths[symbol] = 5;
+    }
+    iotjs_ws_huffman_build(&ws_fixed_distances, lengths,
+                           WS_HUFFMAN_MAX_DISTANCES);
+
+    ws_fixed_ready = true;
+  }
+
+  return iotjs_ws_inflate_codes(inflater, &ws_fixed_literals,
+                                &ws_fixed_distances);
+}
+
+
+static bool iotjs_ws_inflate_dynamic(iotjs_ws_inflater_t *inflater) {
+  static const uint8_t order[WS_HUFFMAN_MAX_LENGTHS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+  };
+
+  uint16_t nliterals = (uint16_t)(iotjs_ws_get_bits(inflater, 5) + 257);
+  uint16_t ndistances = (uint16_t)(iotjs_ws_get_bits(inflater, 5) + 1);
+  uint16_t nlengths = (uint16_t)(iotjs_ws_get_bits(inflater, 4) + 4);
+
+  if (inflater->error || nliterals > 286 ||
+      ndistances > WS_HUFFMAN_MAX_DISTANCES) {
+    return false;
+  }
+
+  uint8_t lengths[WS_HUFFMAN_MAX_LITERALS + WS_HUFFMAN_MAX_DISTANCES];
+  memset(lengths, 0, sizeof(lengths));
+
+  for (uint16_t i = 0; i < nlengths; i++) {
+    lengths[order[i]] = (uint8_t)iotjs_ws_get_bits(inflater, 3);
+  }
+
+  iotjs_ws_huffman_t literals;
+  iotjs_ws_huffman_t distances;
+
+  if (inflater->error ||
+      !iotjs_ws_huffman_build(&literals, lengths, WS_HUFFMAN_MAX_LENGTHS)) {
+    return false;
+  }
+
+  uint16_t total = (uint16_t)(nliterals + ndistances);
+  uint16_t index = 0;
+
+  while (index < total) {
+    int symbol = iotjs_ws_decode_symbol(inflater, &literals);
+
+    if (symbol < 0) {
+      return false;
+    }
+
+    if (symbol < 16) {
+      lengths[index++] = (uint8_t)symbol;
+      continue;
+    }
+
+    uint8_t length = 0;
+    uint32_t repeat;
+
+    if (symbol == 16) {
+      if (index == 0) {
+        return false;
+      }
+      length = lengths[index - 1];
+      repeat = 3 + iotjs_ws_get_bits(inflater, 2);
+    } else if (symbol == 17) {
+      repeat = 3 + iotjs_ws_get_bits(inflater, 3);
+    } else {
+      repeat = 11 + iotjs_ws_get_bits(inflater, 7);
+    }
+
+    if (inflater->error || index + repeat > total) {
+      return false;
+    }
+
+    while (repeat-- > 0) {
+      lengths[index++] = length;
+    }
+  }
+
+  // The end of block code is required.
+  if (lengths[WS_DEFLATE_END_OF_BLOCK] == 0) {
+    return false;
+  }
+
+  if (!iotjs_ws_huffman_build(&literals, lengths, nliterals) ||
+      !iotjs_ws_huffman_build(&distances, lengths + nliterals, ndistances)) {
+    return false;
+  }
+
+  return iotjs_ws_inflate_codes(inflater, &literals, &distances);
+}
+
+
+uint8_t iotjs_ws_inflate(iotjs_ws_deflate_stream_t *stream, const char *data,
+                         size_t length, size_t max_length,
+                         size_t *message_offset) {
+  iotjs_ws_buffer_t *window = &stream->window;
+  *message_offset = window->length;
+
+  iotjs_ws_inflater_t inflater;
+  inflater.data = (const uint8_t *)data;
+  inflater.data_length = length;
+  inflater.length = length + sizeof(ws_flush_trailer);
+  inflater.position = 0;
+  inflater.bits = 0;
+  inflater.count = 0;
+  inflater.error = false;
+  inflater.out = window;
+  inflater.limit = window->length + max_length;
+  inflater.too_large = false;
+
+  bool last = false;
+  bool ok = true;
+
+  while (ok && !last && inflater.position < inflater.length) {
+    last = iotjs_ws_get_bits(&inflater, 1);
+    uint32_t type = iotjs_ws_get_bits(&inflater, 2);
+
+    if (inflater.error) {
+      ok = false;
+      break;
+    }
+
+    switch (type) {
+      case 0:
+        ok = iotjs_ws_inflate_stored(&inflater);
+        break;
+      case 1:
+        ok = iotjs_ws_inflate_fixed(&inflater);
+        break;
+      case 2:
+        ok = iotjs_ws_inflate_dynamic(&inflater);
+        break;
+      default:
+        ok = false;
+        break;
+    }
+  }
+
+  if (!ok || inflater.error) {
+    window->length = *message_offset;
+    return inflater.too_large ? WS_ERR_FRAME_SIZE_LIMIT
+                              : WS_ERR_INVALID_COMPRESSED_DATA;
+  }
+
+  return 0;
+}
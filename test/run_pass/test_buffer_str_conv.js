@@ -59,6 +59,13 @@ assert.throws(function () {
   testWrite('xxxxxxxx', 'MTIzNA=!', 2, 2, 'base64', 'xx12xxxx');
 });
 
+/* A malformed string leaves the buffer untouched. */
+var untouched = new Buffer('xxxxxxxx');
+assert.throws(function () {
+  untouched.write('MTIz*A==', 2, 16, 'base64');
+});
+assert.equal(untouched.toString(), 'xxxxxxxx');
+
 
 assert.equal((new Buffer('buff')).toString('base64'), 'YnVmZg==');
 assert.equal((new Buffer('buffe')).toString('base64'), 'YnVmZmU=');
@@ -98,3 +105,22 @@ assert.equal((new Buffer('ghijklmnop')).toString('hex'),
 
 assert.equal((new Buffer('ghijklmnop')).toString('hex', 2, 8),
              '696a6b6c6d6e');
+
+
+/* Round trip of every byte value and every padding length. */
+
+for (var length = 0; length < 300; length++) {
+  var bytes = new Buffer(length);
+  for (var i = 0; i < length; i++) {
+    bytes[i] = (i * 113 + length) & 0xff;
+  }
+
+  var base64 = bytes.toString('base64');
+  var hex = bytes.toString('hex');
+
+  assert.equal(base64.length, Math.ceil(length / 3) * 4);
+  assert.equal(hex.length, length * 2);
+  assert.equal(new Buffer(base64, 'base64').compare(bytes), 0);
+  assert.equal(new Buffer(hex, 'hex').compare(bytes), 0);
+  assert.equal(new Buffer(hex.toUpperCase(), 'hex').compare(bytes), 0);
+}
@@ -0,0 +1,45 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var crypto = require('crypto');
+
+var message = 'The quick brown fox jumps over the lazy dog';
+
+var hmac = crypto.createHmac('sha1', 'key');
+hmac.update(message);
+assert.equal(hmac.digest('hex'), 'de7c9b85b8b78aa6bc8a7a36f70a90701c9db4d9');
+assert.throws(function() { hmac.digest('hex'); });
+
+// Keys longer than the block size are hashed first
+var long_key = new Buffer(100);
+long_key.fill('k');
+var long_hmac = crypto.createHmac('sha1', long_key);
+assert.equal(long_hmac.update(message).digest('hex'),
+             '6ad5f2e3c41e556456962df51e3e016bdb9a86e5');
+
+assert.throws(function() { crypto.createHmac('sha1'); }, TypeError);
+assert.throws(function() { crypto.createHmac('sadf', 'key'); });
+
+// Data is hashed chunk by chunk, crossing the block boundaries
+var chunk = new Buffer('0123456789abcdef');
+var hash = crypto.createHash('sha1');
+for (var i = 0; i < 1000; i++) {
+  hash.update(i % 2 ? chunk : chunk.toString());
+}
+assert.equal(hash.digest('hex'), '2ac8d4a3d6714912252c0e177b6e15643cec8732');
+
+assert.throws(function() { crypto.createHash('sha1').update(42); }, TypeError);
+assert.throws(function() { hash.update(chunk); });
@@ -64,3 +64,30 @@ var res = verify.verify(pubKey, 'JkFnOrBQGXYlpmlcMuS5EwyJ44WY/kW5sFwb8DRgAoo7' +
                                 '+rP9oLKiFUeoM6jrE10LxGnIpelvyNV+MHfo11I1GAMK' +
                                 'jsOuye9JZ8/hQPg+KLWH/l/xZlUD2fZNNg==');
 assert.equal(res, true);
+
+var md5 = crypto.createHash('md5').update('Hello IoT.js').digest('hex');
+assert.equal(md5, '431326cde55770bd16e4a5ee4670855a');
+
+var sha512 = crypto.createHash('sha512').update('Hello IoT.js').digest('hex');
+assert.equal(sha512,
+             '433902ccd0e59de3c8befca4075784ca' +
+             'b4304ea799f34d4b5717632c8558939c' +
+             '64ef625031a9cf5fe44dd6dcf71884ea' +
+             '7dda93ffd019055d075b7442276b07ce');
+
+var hmac = crypto.createHmac('sha256', 'key');
+hmac.update('The quick brown fox ');
+hmac.update(new Buffer('jumps over the lazy dog'));
+assert.equal(hmac.digest('hex'),
+             'f7bc83f430538424b13298e6aa6fb143' +
+             'ef4d59a14946175997479dbc2d1a3cd8');
+
+// Large inputs are hashed chunk by chunk
+var chunk = new Buffer('0123456789abcdef');
+var stream_hash = crypto.createHash('sha256');
+for (var i = 0; i < 1000; i++) {
+  stream_hash.update(chunk);
+}
+assert.equal(stream_hash.digest('hex'),
+             '0c7cdca23b2eaad05f07c63161c74160' +
+             '9a847b8a87a32accee995ec9cf546856');
@@ -0,0 +1,88 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var file = process.cwd() + '/resources/large_offset.bin';
+
+// Just beyond the range of a 32 bit signed integer. The file is sparse on
+// the usual file systems, so it does not use 2 GB of disk space.
+var position = 2147483648 + 5;
+var data = new Buffer('large offset');
+
+var fd = fs.openSync(file, 'w+');
+
+assert.equal(fs.writeSync(fd, data, 0, data.length, position), data.length);
+assert.equal(fs.fstatSync(fd).size, position + data.length);
+
+var read = new Buffer(data.length);
+assert.equal(fs.readSync(fd, read, 0, read.length, position), data.length);
+assert.equal(read.toString(), data.toString());
+
+fs.fsyncSync(fd);
+fs.fdatasyncSync(fd);
+
+fs.ftruncateSync(fd, 10);
+assert.equal(fs.fstatSync(fd).size, 10);
+
+fs.fallocateSync(fd, 0, 4096);
+assert.equal(fs.fstatSync(fd).size, 4096);
+
+assert.throws(function() {
+  fs.readSync(fd, read, 0, read.length, Math.pow(2, 54));
+}, RangeError);
+
+assert.throws(function() {
+  fs.fallocateSync(fd, -1, 10);
+}, RangeError);
+
+// Ranges beyond a 32 bit off_t are rejected instead of being truncated,
+// other targets allocate a single block of the sparse file.
+try {
+  fs.fallocateSync(fd, position, 1);
+  assert.equal(fs.fstatSync(fd).size, position + 1);
+} catch (e) {
+  assert.notEqual(e.message.indexOf('file too large'), -1);
+  assert.equal(fs.fstatSync(fd).size, 4096);
+}
+
+var async_done = false;
+
+fs.ftruncate(fd, function(err) {
+  assert.equal(err, null);
+  assert.equal(fs.fstatSync(fd).size, 0);
+
+  fs.fallocate(fd, 100, 100, function(err) {
+    assert.equal(err, null);
+    assert.equal(fs.fstatSync(fd).size, 200);
+
+    fs.fsync(fd, function(err) {
+      assert.equal(err, null);
+
+      fs.fdatasync(fd, function(err) {
+        assert.equal(err, null);
+
+        fs.closeSync(fd);
+        fs.unlinkSync(file);
+        async_done = true;
+      });
+    });
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(async_done, true);
+});
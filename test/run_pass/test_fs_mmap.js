@@ -0,0 +1,51 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var file = process.cwd() + '/resources/tobeornottobe.txt';
+var empty = process.cwd() + '/resources/mmap_empty.txt';
+
+if (process.platform === 'tizenrt') {
+  empty = '/mnt/mmap_empty.txt';
+}
+
+var contents = fs.readFileSync(file);
+var mapped = fs.mmapSync(file);
+
+assert.equal(mapped.length, contents.length);
+assert.equal(mapped.compare(contents), 0);
+assert.equal(mapped.toString(), contents.toString());
+
+// Writes to the mapping are private to the Buffer
+var first = mapped[0];
+mapped[0] = first ^ 0xff;
+assert.equal(mapped[0], first ^ 0xff);
+assert.equal(fs.readFileSync(file)[0], first);
+
+mapped = null;
+
+fs.writeFileSync(empty, '');
+assert.equal(fs.mmapSync(empty).length, 0);
+fs.unlinkSync(empty);
+
+assert.throws(function() {
+  fs.mmapSync(process.cwd() + '/resources/mmap_missing.txt');
+});
+
+assert.throws(function() {
+  fs.mmapSync(42);
+}, TypeError);
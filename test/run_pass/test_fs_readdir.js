@@ -40,3 +40,37 @@ fs.readdir(path, function(err, items) {
     res += items[i] + '\n';
   assert.equal(res, ans);
 });
+
+// Types of the entries come with the listing.
+var dirents = fs.readdirSync(path, { withFileTypes: true });
+dirents.sort(function(a, b) {
+  return a.name < b.name ? -1 : 1;
+});
+assert.equal(dirents.length, 4);
+for (i = 0; i < dirents.length; i++) {
+  assert(dirents[i] instanceof fs.Dirent);
+  assert.equal(dirents[i].path, path);
+  assert.equal(dirents[i].isDirectory(), i === 1 || i === 2);
+  assert.equal(dirents[i].isFile(), !dirents[i].isDirectory());
+}
+assert.equal(dirents[1].name, 'This_is_a_directory');
+assert(dirents[1].isDirectory());
+assert(!dirents[1].isSymbolicLink());
+assert.equal(dirents[3].name, 'regular.txt');
+assert(dirents[3].isFile());
+
+fs.readdir(path, { withFileTypes: true }, function(err, dirents) {
+  assert.equal(err, null);
+  assert.equal(dirents.length, 4);
+});
+
+// Names of a recursive listing are relative to the directory.
+items = fs.readdirSync(path, { recursive: true });
+items.sort();
+assert.equal(items.join('\n') + '\n',
+             ans.replace('This_is_a_directory\n',
+                         'This_is_a_directory\n' +
+                         'This_is_a_directory/.gitkeep\n')
+                .replace('This_is_another_directory\n',
+                         'This_is_another_directory\n' +
+                         'This_is_another_directory/.gitkeep\n'));
@@ -0,0 +1,62 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var file = process.cwd() + '/resources/readfile_large.txt';
+var missing = process.cwd() + '/resources/readfile_missing.txt';
+
+if (process.platform === 'tizenrt') {
+  file = '/mnt/readfile_large.txt';
+}
+
+var size = 1024 * 1024 + 3;
+var data = new Buffer(size);
+for (var i = 0; i < size; i++) {
+  data[i] = (i * 7) & 0xff;
+}
+
+var read_async = false;
+
+fs.writeFile(file, data, function(err) {
+  assert.equal(err, null);
+
+  fs.readFile(file, function(err, buf) {
+    assert.equal(err, null);
+    assert.equal(buf.length, size);
+    assert.equal(buf.compare(data), 0);
+
+    assert.equal(fs.readFileSync(file).compare(data), 0);
+    assert.equal(fs.writeFileSync(file, ''), 0);
+    assert.equal(fs.readFileSync(file).length, 0);
+
+    fs.unlinkSync(file);
+    read_async = true;
+  });
+});
+
+fs.readFile(missing, function(err, buf) {
+  assert.notEqual(err, null);
+  assert.equal(buf, undefined);
+});
+
+assert.throws(function() {
+  fs.readFileSync(missing);
+});
+
+process.on('exit', function() {
+  assert.equal(read_async, true);
+});
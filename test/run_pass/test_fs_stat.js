@@ -55,3 +55,26 @@ try {
   assert.equal(e instanceof Error, true);
   assert.equal(e instanceof assert.AssertionError, false);
 }
+
+// The fields are read from the native stat buffer by getters.
+var file = process.cwd() + '/run_pass/test_fs_stat.js';
+var stats4 = fs.statSync(file);
+assert.equal(stats4.size, fs.readFileSync(file).length);
+assert.equal(typeof stats4.mode, 'number');
+assert.equal(typeof stats4.ino, 'number');
+assert(stats4.mtimeMs > 0);
+assert(stats4.ctimeMs > 0);
+assert.equal(stats4.hasOwnProperty('size'), false);
+assert.equal('size' in stats4, true);
+
+var fd = fs.openSync(file, 'r');
+assert.equal(fs.fstatSync(fd).size, stats4.size);
+assert.equal(fs.fstatSync(fd).ino, stats4.ino);
+fs.closeSync(fd);
+
+// Object.keys sees no fields, JSON.stringify gets them from toJSON.
+assert.equal(Object.keys(stats4).length, 0);
+var json = JSON.parse(JSON.stringify(stats4));
+assert.equal(json.size, stats4.size);
+assert.equal(json.ino, stats4.ino);
+assert.equal(json.mtimeMs, stats4.mtimeMs);
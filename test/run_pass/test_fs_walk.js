@@ -0,0 +1,139 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var dir = (process.platform === 'tizenrt') ? '/mnt/' : process.cwd() + '/tmp/';
+var root = dir + 'test_fs_walk';
+
+// root/a.log, root/b.txt, root/sub/c.log, root/sub/deep/d.log
+var files = {
+  'a.log': 'a',
+  'b.txt': 'bb',
+  'sub/c.log': 'ccc',
+  'sub/deep/d.log': 'dddd',
+};
+
+fs.mkdirSync(root);
+fs.mkdirSync(root + '/sub');
+fs.mkdirSync(root + '/sub/deep');
+for (var file in files) {
+  fs.writeFileSync(root + '/' + file, files[file]);
+}
+
+function relative(entry) {
+  return (entry.path + '/' + entry.name).slice(root.length + 1);
+}
+
+function relatives(entries) {
+  return entries.map(relative).sort().join(',');
+}
+
+// Whole tree
+var entries = fs.walkSync(root);
+assert.equal(relatives(entries),
+             'a.log,b.txt,sub,sub/c.log,sub/deep,sub/deep/d.log');
+entries.forEach(function(entry) {
+  assert(entry instanceof fs.Dirent);
+  assert.equal(entry.isDirectory(), !(relative(entry) in files));
+  assert.equal(entry.isFile(), relative(entry) in files);
+  assert.equal(entry.size, undefined);
+});
+
+// Depth limit
+assert.equal(relatives(fs.walkSync(root, { maxDepth: 0 })),
+             'a.log,b.txt,sub');
+assert.equal(relatives(fs.walkSync(root, { maxDepth: 1 })),
+             'a.log,b.txt,sub,sub/c.log,sub/deep');
+
+// Patterns without '/' match the names, others the relative paths
+assert.equal(relatives(fs.walkSync(root, { pattern: '*.log' })),
+             'a.log,sub/c.log,sub/deep/d.log');
+assert.equal(relatives(fs.walkSync(root, { pattern: 'sub/*' })),
+             'sub/c.log,sub/deep');
+assert.equal(relatives(fs.walkSync(root, { pattern: 'sub/**/?.log' })),
+             'sub/c.log,sub/deep/d.log');
+assert.equal(fs.walkSync(root, { pattern: 'none' }).length, 0);
+
+// Stats of the matching entries
+fs.walkSync(root, { pattern: '*.log', stats: true }).forEach(function(entry) {
+  assert.equal(entry.size, files[relative(entry)].length);
+  assert(entry.mtimeMs > 0);
+});
+
+assert.throws(function() {
+  fs.walkSync(root + '/missing');
+}, Error);
+
+// An unreadable directory fails the walk, unless the user may read anything.
+var locked = dir + 'test_fs_walk_locked';
+fs.mkdirSync(locked);
+fs.writeFileSync(locked + '/e.log', 'e');
+fs.mkdirSync(locked + '/none', 0);
+
+var lockedEntries = null;
+try {
+  lockedEntries = fs.walkSync(locked, { pattern: '*', stats: true });
+} catch (e) {
+  assert(e instanceof Error);
+}
+if (lockedEntries) {
+  assert.equal(lockedEntries.map(function(entry) {
+    return entry.name;
+  }).sort().join(','), 'e.log,none');
+}
+assert.equal(fs.walkSync(locked, { maxDepth: 0, stats: true }).length, 2);
+
+var lockedWalked = false;
+fs.walk(locked, { stats: true }, function(err, entries) {
+  assert.equal(!err, !!lockedEntries);
+  fs.rmdirSync(locked + '/none');
+  fs.unlinkSync(locked + '/e.log');
+  fs.rmdirSync(locked);
+  lockedWalked = true;
+});
+
+var walked = false;
+fs.walk(root, { pattern: '*.txt', stats: true }, function(err, entries) {
+  assert.equal(err, null);
+  assert.equal(relatives(entries), 'b.txt');
+  assert.equal(entries[0].size, 2);
+
+  fs.walk(root, function(err, entries) {
+    assert.equal(err, null);
+    assert.equal(entries.length, 6);
+
+    // Cleans the tree up with the entries, deepest first.
+    entries.sort(function(a, b) {
+      return relative(b).length - relative(a).length;
+    });
+    entries.forEach(function(entry) {
+      var path = entry.path + '/' + entry.name;
+      if (entry.isDirectory()) {
+        fs.rmdirSync(path);
+      } else {
+        fs.unlinkSync(path);
+      }
+    });
+    fs.rmdirSync(root);
+    walked = true;
+  });
+});
+
+process.on('exit', function() {
+  assert(walked);
+  assert(lockedWalked);
+});
@@ -0,0 +1,125 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var root = process.cwd() + '/tmp/test_fs_watch';
+var fileA = root + '/a.txt';
+var fileB = root + '/b.txt';
+var config = root + '/config.json';
+
+// Time to wait for the coalesced events of a step.
+var settle = 300;
+
+assert.throws(function() {
+  fs.watch(root + '/missing');
+}, Error);
+
+fs.mkdirSync(root);
+
+var events = [];
+var closed = false;
+var watcher = fs.watch(root, { debounce: 100 }, function(eventType, filename) {
+  events.push(eventType + ':' + filename);
+});
+assert(watcher instanceof fs.FSWatcher);
+
+watcher.on('close', function() {
+  closed = true;
+});
+
+function expect(expected, next) {
+  setTimeout(function() {
+    assert.equal(events.sort().join(','), expected);
+    events = [];
+    next();
+  }, settle);
+}
+
+var steps = [
+  // Several events of a new file are coalesced into one 'rename'.
+  function(next) {
+    fs.writeFileSync(fileA, 'first');
+    fs.writeFileSync(fileA, 'second');
+    expect('rename:a.txt', next);
+  },
+  // Modifications are coalesced into one 'change'.
+  function(next) {
+    fs.writeFileSync(fileA, 'third');
+    fs.writeFileSync(fileA, 'fourth');
+    expect('change:a.txt', next);
+  },
+  function(next) {
+    fs.renameSync(fileA, fileB);
+    expect('rename:a.txt,rename:b.txt', next);
+  },
+  function(next) {
+    fs.unlinkSync(fileB);
+    expect('rename:b.txt', next);
+  },
+  // No events are delivered after the watcher is closed.
+  function(next) {
+    watcher.close();
+    fs.writeFileSync(fileA, 'closed');
+    fs.unlinkSync(fileA);
+    expect('', next);
+  },
+  // watchFile reports the stats of the file before and after a change.
+  function(next) {
+    fs.writeFileSync(config, '{}');
+
+    var changes = 0;
+    var listener = function(curr, prev) {
+      changes++;
+      if (changes === 1) {
+        assert.equal(prev.size, 2);
+        assert.equal(curr.size, 12);
+        // Replaced by a rename, as editors do on save.
+        fs.writeFileSync(config + '.new', '{"a": 1}');
+        fs.renameSync(config + '.new', config);
+      } else if (changes === 2) {
+        assert.equal(curr.size, 8);
+        fs.unlinkSync(config);
+      } else {
+        assert.equal(curr, null);
+        assert.equal(prev.size, 8);
+        fs.unwatchFile(config, listener);
+        next();
+      }
+    };
+
+    fs.watchFile(config, listener);
+    setTimeout(function() {
+      fs.writeFileSync(config, '{"a": true}\n');
+    }, settle);
+  },
+];
+
+function run() {
+  var step = steps.shift();
+  if (step) {
+    step(run);
+  } else {
+    fs.rmdirSync(root);
+  }
+}
+
+run();
+
+process.on('exit', function() {
+  assert.equal(steps.length, 0);
+  assert(closed);
+});
@@ -0,0 +1,126 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var dir = (process.platform === 'tizenrt') ? '/mnt/' : process.cwd() + '/tmp/';
+var syncFile = dir + 'test_fs_writev_sync.txt';
+var asyncFile = dir + 'test_fs_writev_async.txt';
+var streamFile = dir + 'test_fs_writev_stream.txt';
+
+// Synchronous round trip.
+var fd = fs.openSync(syncFile, 'w+');
+var parts = [new Buffer('IoT'), new Buffer(''), new Buffer('.js')];
+assert.equal(fs.writevSync(fd, parts, 0), 6);
+assert.equal(fs.writevSync(fd, [new Buffer('!')]), 1);
+
+var head = new Buffer(4);
+var tail = new Buffer(8);
+assert.equal(fs.readvSync(fd, [head, tail], 0), 7);
+assert.equal(head.toString(), 'IoT.');
+assert.equal(tail.slice(0, 3).toString(), 'js!');
+
+assert.throws(function() {
+  fs.writevSync(fd, ['not a buffer']);
+}, TypeError);
+assert.throws(function() {
+  fs.writevSync(fd, new Buffer('abc'));
+}, TypeError);
+fs.closeSync(fd);
+fs.unlinkSync(syncFile);
+
+// Asynchronous round trip.
+var asyncDone = false;
+fs.open(asyncFile, 'w+', function(err, fd) {
+  assert.equal(err, null);
+  var data = [new Buffer('hello '), new Buffer('writev')];
+  fs.writev(fd, data, null, function(err, written, buffers) {
+    assert.equal(err, null);
+    assert.equal(written, 12);
+    assert.equal(buffers, data);
+
+    var a = new Buffer(6);
+    var b = new Buffer(6);
+    fs.readv(fd, [a, b], 0, function(err, bytesRead, buffers) {
+      assert.equal(err, null);
+      assert.equal(bytesRead, 12);
+      assert.equal(buffers[0].toString() + buffers[1].toString(),
+                   'hello writev');
+      fs.closeSync(fd);
+      fs.unlinkSync(asyncFile);
+      asyncDone = true;
+    });
+  });
+});
+
+// Records queued while a write is in progress are written by writev, in
+// batches within the native limit of 1024 buffers.
+var records = 1500;
+var expected = '';
+var callbacks = 0;
+var writevCalls = 0;
+var maxBatch = 0;
+var shortWrites = 0;
+
+var stream = fs.createWriteStream(streamFile);
+var writev = stream._writev;
+stream._writev = function(reqs, onwrite) {
+  writevCalls++;
+  writev.call(this, reqs, onwrite);
+};
+
+// Every other batch only writes part of its first buffer, the stream has to
+// write the rest itself.
+var fsWritev = fs.writev;
+fs.writev = function(fd, buffers, position, callback) {
+  if (fd === stream._fd) {
+    maxBatch = Math.max(maxBatch, buffers.length);
+    if (buffers[0].length > 1 && (shortWrites++ % 2) == 0) {
+      buffers = [buffers[0].slice(0, 1)];
+    }
+  }
+  fsWritev(fd, buffers, position, callback);
+};
+
+stream.on('ready', function() {
+  for (var i = 0; i < records; i++) {
+    var record = 'record ' + i + '\n';
+    expected += record;
+    stream.write(record, function() {
+      callbacks++;
+    });
+  }
+  stream.end();
+});
+
+var streamDone = false;
+stream.on('close', function() {
+  fs.writev = fsWritev;
+  assert.equal(stream.bytesWritten, expected.length);
+  assert.equal(fs.readFileSync(streamFile).toString(), expected);
+  fs.unlinkSync(streamFile);
+  streamDone = true;
+});
+
+process.on('exit', function() {
+  assert(asyncDone);
+  assert(streamDone);
+  assert.equal(callbacks, records);
+  assert(writevCalls > 1);
+  assert(maxBatch > 1);
+  assert(maxBatch <= 1024);
+  assert(shortWrites > 1);
+});
@@ -0,0 +1,67 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* A writev of a non-empty batch which writes no bytes fails the stream
+ * instead of being retried forever. */
+
+var fs = require('fs');
+var assert = require('assert');
+
+var dir = (process.platform === 'tizenrt') ? '/mnt/' : process.cwd() + '/tmp/';
+var streamFile = dir + 'test_fs_writev_zero.txt';
+
+var writevCalls = 0;
+var errors = [];
+var closed = false;
+
+var stream = fs.createWriteStream(streamFile);
+
+var fsWritev = fs.writev;
+fs.writev = function(fd, buffers, position, callback) {
+  if (fd !== stream._fd) {
+    fsWritev(fd, buffers, position, callback);
+    return;
+  }
+
+  writevCalls++;
+  process.nextTick(function() {
+    callback(null, 0, buffers);
+  });
+};
+
+process.on('uncaughtException', function(err) {
+  errors.push(err);
+});
+
+stream.on('ready', function() {
+  // The first record is written by write, the queued ones by writev.
+  for (var i = 0; i < 3; i++) {
+    stream.write('record ' + i + '\n');
+  }
+});
+
+stream.on('close', function() {
+  fs.writev = fsWritev;
+  closed = true;
+  fs.unlinkSync(streamFile);
+});
+
+process.on('exit', function() {
+  process.removeAllListeners('uncaughtException');
+  assert.equal(writevCalls, 1);
+  assert.equal(errors.length, 1);
+  assert(errors[0] instanceof Error);
+  assert(closed);
+});
@@ -0,0 +1,51 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var Module = require('module');
+
+var dir = (process.platform === 'tizenrt') ? '/mnt/' : process.cwd() + '/tmp/';
+var file = dir + 'test_module_resolve_cache_mod';
+
+if (fs.existsSync(file + '.js')) {
+  fs.unlinkSync(file + '.js');
+}
+
+// A failed lookup is remembered.
+assert.throws(function() {
+  require(file);
+}, Error);
+
+fs.writeFileSync(file + '.js', 'module.exports = 42;');
+
+assert.throws(function() {
+  require(file);
+}, Error);
+
+// Until the cache is cleared.
+Module.clearResolveCache();
+assert.equal(require(file), 42);
+
+fs.unlinkSync(file + '.js');
+
+// Loaded modules stay in the module cache, resolution is cached as well.
+assert.equal(require(file), 42);
+
+// Packages resolve the same from every requiring directory.
+var pkgDir = process.cwd() + '/run_pass/require1/';
+var pkg = require(pkgDir + 'test_pkg');
+assert.equal(require(pkgDir + '../require1/test_pkg'), pkg);
+assert.equal(pkg.add(22, 44), 66);
@@ -99,10 +99,10 @@ duplex._write = function(chunk, callback, onwrite) {
 
   case 1:
     assert.equal(chunk.toString('hex'),
-                 '82120000000d67656e6572616c2f746f70696300');
+                 '82120001000d67656e6572616c2f746f70696300');
 
     process.nextTick(function() {
-      duplex.push(new Buffer('9003000002', 'hex'));
+      duplex.push(new Buffer('9003000102', 'hex'));
       process.nextTick(send_fragment);
     });
     break;
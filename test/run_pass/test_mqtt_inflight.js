@@ -0,0 +1,104 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* QoS 1 publishing through an in-flight window of two packets. The first
+ * message is lost once and must be retransmitted with the dup flag. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+
+var duplex = new stream.Duplex();
+
+var message_count = 5;
+var results = [];
+var completed = [];
+var transmissions = [];
+var drain_count = 0;
+var lost = false;
+
+duplex._write = function(chunk, callback, onwrite) {
+  onwrite();
+
+  var first_byte = chunk.readUInt8(0);
+
+  if ((first_byte >> 4) == 1) {
+    // CONNECT
+    process.nextTick(function() {
+      duplex.push(new Buffer('20020000', 'hex'));
+    });
+    return;
+  }
+
+  if ((first_byte >> 4) != 3) {
+    return;
+  }
+
+  // PUBLISH with QoS 1, the topic is 'inflight'.
+  assert.equal(first_byte & 0x06, 0x02);
+
+  var packet_id = (chunk.readUInt8(12) << 8) | chunk.readUInt8(13);
+  var message = chunk.toString('utf8', 14);
+  var dup = (first_byte & 0x08) != 0;
+
+  assert(packet_id == 1 || packet_id == 2);
+  transmissions.push(message + (dup ? ':dup' : ''));
+
+  if (message == 'm0' && !lost) {
+    lost = true;
+    return;
+  }
+
+  var puback = new Buffer('40020000', 'hex');
+  chunk.copy(puback, 2, 12, 14);
+
+  process.nextTick(function() {
+    duplex.push(puback);
+  });
+};
+
+duplex._readyToWrite();
+
+var mqtt_client = mqtt.connect({
+  clientId: 'cli',
+  keepalive: 30,
+  receiveMaximum: 2,
+  socket: duplex,
+}, function() {
+  for (var i = 0; i < message_count; i++) {
+    results.push(mqtt_client.publish('inflight', 'm' + i, { qos: 1 },
+                                     onpublished.bind(null, 'm' + i)));
+  }
+});
+
+mqtt_client.on('drain', function() {
+  drain_count++;
+});
+
+function onpublished(message, error) {
+  assert.equal(error, undefined);
+  completed.push(message);
+
+  if (completed.length == message_count) {
+    mqtt_client.end();
+  }
+}
+
+process.on('exit', function() {
+  assert.equal(results.join(), 'true,true,false,false,false');
+  assert.equal(drain_count, 1);
+  assert.equal(completed.join(), 'm1,m2,m3,m4,m0');
+  assert.equal(transmissions.join(), 'm0,m1,m2,m3,m4,m0:dup');
+});
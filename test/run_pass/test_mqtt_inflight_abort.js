@@ -0,0 +1,73 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* The in-flight and the queued packets fail with an error when the
+ * connection ends before the broker acknowledges them. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+
+var duplex = new stream.Duplex();
+
+var message_count = 4;
+var errors = [];
+var ended = false;
+
+duplex._write = function(chunk, callback, onwrite) {
+  onwrite();
+
+  if ((chunk.readUInt8(0) >> 4) == 1) {
+    // CONNECT, nothing else is acknowledged.
+    process.nextTick(function() {
+      duplex.push(new Buffer('20020000', 'hex'));
+    });
+  }
+};
+
+duplex._readyToWrite();
+
+var mqtt_client = mqtt.connect({
+  clientId: 'cli',
+  keepalive: 30,
+  receiveMaximum: 2,
+  socket: duplex,
+}, function() {
+  // Two packets are in flight, the others are queued.
+  for (var i = 0; i < message_count; i++) {
+    mqtt_client.publish('abort', 'm' + i, { qos: 1 },
+                        onpublished.bind(null, 'm' + i));
+  }
+
+  process.nextTick(function() {
+    duplex.end();
+  });
+});
+
+mqtt_client.on('end', function() {
+  ended = true;
+  assert.equal(mqtt_client._handle.storageCount, 0);
+  assert.equal(mqtt_client._handle.pending.length, 0);
+});
+
+function onpublished(message, error) {
+  assert(error instanceof Error);
+  errors.push(message);
+}
+
+process.on('exit', function() {
+  assert(ended);
+  assert.equal(errors.join(), 'm0,m1,m2,m3');
+});
@@ -0,0 +1,160 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Messages published while offline are kept in a spool file, the oldest
+ * ones are evicted when it is full and the rest is replayed by the next
+ * client which uses the same spool file. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+var fs = require('fs');
+
+var spool = process.cwd() + '/resources/mqtt_spool.dat';
+
+if (fs.existsSync(spool)) {
+  fs.unlinkSync(spool);
+}
+
+var message_count = 6;
+var spooled_callbacks = 0;
+var replayed = [];
+var publish_chunks = 0;
+var finished = false;
+
+function message(i) {
+  // Every packet is 33 bytes long, so the 256 byte spool holds four.
+  var padding = (i & 1) ? 18 : 20;
+  var str = 'm' + i;
+
+  while (padding-- > 0) {
+    str += 'x';
+  }
+
+  return str;
+}
+
+function createDuplex(onpublish) {
+  var duplex = new stream.Duplex();
+
+  duplex._write = function(chunk, callback, onwrite) {
+    onwrite();
+
+    var type = chunk.readUInt8(0) >> 4;
+
+    if (type == 1) {
+      // CONNECT
+      if (onpublish) {
+        process.nextTick(function() {
+          duplex.push(new Buffer('20020000', 'hex'));
+        });
+      }
+    } else if (type == 3) {
+      onpublish(chunk);
+    }
+  };
+
+  duplex._readyToWrite();
+  return duplex;
+}
+
+// The first client never gets connected.
+var offline_client = mqtt.connect({
+  clientId: 'cli',
+  keepalive: 30,
+  socket: createDuplex(null),
+  spool: spool,
+  spoolSize: 256,
+});
+
+for (var i = 0; i < message_count; i++) {
+  var result = offline_client.publish('spool/a', message(i), { qos: i & 1 },
+                                      function() {
+    spooled_callbacks++;
+  });
+  assert.equal(result, false);
+}
+
+offline_client.on('end', replay);
+offline_client.end(true);
+
+function replay() {
+  var duplex;
+  var client = mqtt.connect({
+    clientId: 'cli',
+    keepalive: 30,
+    socket: duplex = createDuplex(function(chunk) {
+      publish_chunks++;
+
+      // The replayed packets arrive in one batch.
+      var offset = 0;
+
+      while (offset < chunk.length) {
+        var first_byte = chunk.readUInt8(offset);
+        var end = offset + 2 + chunk.readUInt8(offset + 1);
+        var qos = (first_byte >> 1) & 0x3;
+        var payload = offset + 4 + 7;
+
+        assert.equal(first_byte & 0x08, 0);
+        assert.equal(chunk.toString('utf8', offset + 4, payload), 'spool/a');
+
+        if (qos > 0) {
+          var puback = new Buffer('40020000', 'hex');
+          chunk.copy(puback, 2, payload, payload + 2);
+          process.nextTick(function(puback) {
+            duplex.push(puback);
+          }.bind(null, puback));
+
+          assert.notEqual(chunk.readUInt16LE(payload), 0);
+          payload += 2;
+        }
+
+        replayed.push(chunk.toString('utf8', payload, end));
+        offset = end;
+      }
+    }),
+    spool: spool,
+  }, function() {
+    process.nextTick(function() {
+      client.end();
+    });
+  });
+
+  client.on('end', verifyEmpty);
+}
+
+function verifyEmpty() {
+  var client = mqtt.connect({
+    clientId: 'cli',
+    keepalive: 30,
+    socket: createDuplex(function() {
+      assert.fail('The spool should be empty');
+    }),
+    spool: spool,
+  }, function() {
+    client.end(true);
+    finished = true;
+  });
+}
+
+process.on('exit', function() {
+  assert(finished);
+  assert.equal(spooled_callbacks, message_count);
+  assert.equal(publish_chunks, 1);
+  assert.equal(replayed.join(),
+               [message(2), message(3), message(4), message(5)].join());
+
+  fs.unlinkSync(spool);
+});
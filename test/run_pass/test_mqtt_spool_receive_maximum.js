@@ -0,0 +1,142 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* The spooled QoS 1 packets are replayed within the Receive Maximum of the
+ * broker, the rest stays spooled until packets are acknowledged. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+var fs = require('fs');
+
+var spool = process.cwd() + '/resources/mqtt_spool_receive_max.dat';
+
+if (fs.existsSync(spool)) {
+  fs.unlinkSync(spool);
+}
+
+var message_count = 5;
+var receive_maximum = 2;
+var replayed = [];
+var in_flight_ids = {};
+var in_flight = 0;
+var max_in_flight = 0;
+var finished = false;
+
+function createDuplex(onpublish) {
+  var duplex = new stream.Duplex();
+
+  duplex._write = function(chunk, callback, onwrite) {
+    onwrite();
+
+    var type = chunk.readUInt8(0) >> 4;
+
+    if (type == 1) {
+      // CONNECT, answered with a CONNACK of Receive Maximum 2.
+      if (onpublish) {
+        process.nextTick(function() {
+          duplex.push(new Buffer('2006000003210002', 'hex'));
+        });
+      }
+    } else if (type == 3) {
+      onpublish(duplex, chunk);
+    }
+  };
+
+  duplex._readyToWrite();
+  return duplex;
+}
+
+function readUInt16(buffer, offset) {
+  return (buffer.readUInt8(offset) << 8) | buffer.readUInt8(offset + 1);
+}
+
+function onpublish(duplex, chunk) {
+  var acked = [];
+  var offset = 0;
+
+  while (offset < chunk.length) {
+    var end = offset + 2 + chunk.readUInt8(offset + 1);
+    var topic_end = offset + 4 + readUInt16(chunk, offset + 2);
+    var id = readUInt16(chunk, topic_end);
+
+    // Every packet in flight has its own id.
+    assert.notEqual(id, 0);
+    assert.equal(in_flight_ids[id], undefined);
+    in_flight_ids[id] = true;
+    in_flight++;
+    max_in_flight = Math.max(max_in_flight, in_flight);
+    acked.push(id);
+
+    // The property length follows the packet id.
+    replayed.push(chunk.toString('utf8', topic_end + 3, end));
+    offset = end;
+  }
+
+  // The acknowledgements come later.
+  setTimeout(function() {
+    acked.forEach(function(id) {
+      var puback = new Buffer('40020000', 'hex');
+      puback.writeUInt8(id >> 8, 2);
+      puback.writeUInt8(id & 0xff, 3);
+      delete in_flight_ids[id];
+      in_flight--;
+      duplex.push(puback);
+    });
+  }, 10);
+}
+
+// The first client never gets connected.
+var offline_client = mqtt.connect({
+  clientId: 'cli',
+  keepalive: 30,
+  protocolVersion: 5,
+  socket: createDuplex(null),
+  spool: spool,
+  spoolSize: 1024,
+});
+
+for (var i = 0; i < message_count; i++) {
+  offline_client.publish('spool/rm', 'm' + i, { qos: 1 });
+}
+
+offline_client.on('end', replay);
+offline_client.end(true);
+
+function replay() {
+  var client = mqtt.connect({
+    clientId: 'cli',
+    keepalive: 30,
+    protocolVersion: 5,
+    socket: createDuplex(onpublish),
+    spool: spool,
+  });
+
+  var timer = setInterval(function() {
+    if (replayed.length == message_count && in_flight == 0) {
+      clearInterval(timer);
+      client.end(true);
+      finished = true;
+    }
+  }, 10);
+}
+
+process.on('exit', function() {
+  assert(finished);
+  assert.equal(max_in_flight, receive_maximum);
+  assert.equal(replayed.join(), 'm0,m1,m2,m3,m4');
+
+  fs.unlinkSync(spool);
+});
@@ -0,0 +1,137 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Large messages arriving in many small reads, mixed with small packets. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+
+var duplex = new stream.Duplex();
+
+var connect_state = 0;
+var recv_count = 0;
+var pingresp_count = 0;
+var message_count = 8;
+var chunk_size = 97;
+
+function publishPacket(size) {
+  var topic = 'general/topic';
+  var remaining = 2 + topic.length + size;
+  var length_bytes = [];
+
+  do {
+    var byte = remaining & 0x7f;
+    remaining >>= 7;
+    length_bytes.push(remaining > 0 ? (byte | 0x80) : byte);
+  } while (remaining > 0);
+
+  var header = new Buffer(1 + length_bytes.length + 2);
+  header.writeUInt8(0x30, 0);
+  for (var i = 0; i < length_bytes.length; i++) {
+    header.writeUInt8(length_bytes[i], i + 1);
+  }
+  header.writeUInt8(0, i + 1);
+  header.writeUInt8(topic.length, i + 2);
+
+  var payload = new Buffer(size);
+  for (i = 0; i < size; i++) {
+    payload.writeUInt8(0x61 + (i % 26), i);
+  }
+
+  return Buffer.concat([header, new Buffer(topic), payload]);
+}
+
+function messageSize(index) {
+  // Covers one, two and three byte long remaining lengths.
+  return [5, 200, 20000, 1, 16500, 3000, 127, 70000][index];
+}
+
+var data = [];
+for (var i = 0; i < message_count; i++) {
+  data.push(publishPacket(messageSize(i)));
+  // PINGRESP packets between the messages.
+  data.push(new Buffer('d000', 'hex'));
+}
+data = Buffer.concat(data);
+
+var offset = 0;
+
+function send_chunk() {
+  var end = Math.min(offset + chunk_size, data.length);
+  duplex.push(data.slice(offset, end));
+  offset = end;
+
+  if (offset < data.length) {
+    process.nextTick(send_chunk);
+  } else {
+    duplex.end();
+  }
+}
+
+duplex._write = function(chunk, callback, onwrite) {
+  onwrite();
+
+  switch (connect_state) {
+  case 0:
+    process.nextTick(function() {
+      duplex.push(new Buffer('20020000', 'hex'));
+    });
+    break;
+
+  case 1:
+    process.nextTick(function() {
+      duplex.push(new Buffer('9003000100', 'hex'));
+      process.nextTick(send_chunk);
+    });
+    break;
+
+  default:
+    throw new RangeError('Unknown connection state');
+  }
+
+  connect_state++;
+};
+
+duplex._readyToWrite();
+
+var mqtt_client = mqtt.connect({
+  clientId: 'cli',
+  keepalive: 30,
+  socket: duplex,
+}, function() {
+  mqtt_client.subscribe('general/topic');
+});
+
+mqtt_client._handle.onpingresp = function() {
+  pingresp_count++;
+};
+
+mqtt_client.on('message', function(data) {
+  var size = messageSize(recv_count);
+
+  assert.equal(data.topic, 'general/topic');
+  assert.equal(data.message.length, size);
+  assert.equal(data.message.readUInt8(0), 0x61);
+  assert.equal(data.message.readUInt8(size - 1), 0x61 + ((size - 1) % 26));
+  assert.equal(pingresp_count, recv_count);
+
+  recv_count++;
+});
+
+process.on('exit', function() {
+  assert.equal(recv_count, message_count);
+  assert.equal(pingresp_count, message_count);
+});
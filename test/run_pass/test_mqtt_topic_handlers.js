@@ -0,0 +1,141 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+
+var duplex = new stream.Duplex();
+
+var filters = ['home/+/temp', 'home/#', '$SYS/#', '#', 'home/plain'];
+var suback_count = 0;
+var calls = [];
+var messages = [];
+
+function publishPacket(topic) {
+  var header = new Buffer(4);
+  header.writeUInt8(0x30, 0);
+  header.writeUInt8(2 + topic.length + 1, 1);
+  header.writeUInt8(0, 2);
+  header.writeUInt8(topic.length, 3);
+
+  return Buffer.concat([header, new Buffer(topic), new Buffer('x')]);
+}
+
+function publish(topics) {
+  process.nextTick(function() {
+    duplex.push(Buffer.concat(topics.map(publishPacket)));
+  });
+}
+
+duplex._write = function(chunk, callback, onwrite) {
+  onwrite();
+
+  var type = chunk.readUInt8(0) >> 4;
+
+  if (type == 1) {
+    // CONNECT
+    process.nextTick(function() {
+      duplex.push(new Buffer('20020000', 'hex'));
+    });
+  } else if (type == 8) {
+    // SUBSCRIBE
+    var suback = new Buffer('9003000000', 'hex');
+    chunk.copy(suback, 2, 2, 4);
+
+    process.nextTick(function() {
+      duplex.push(suback);
+    });
+  } else if (type == 10) {
+    // UNSUBSCRIBE
+    var unsuback = new Buffer('b0020000', 'hex');
+    chunk.copy(unsuback, 2, 2, 4);
+
+    process.nextTick(function() {
+      duplex.push(unsuback);
+    });
+  }
+};
+
+duplex._readyToWrite();
+
+function handler(name) {
+  return function(data) {
+    assert.equal(this, mqtt_client);
+    calls.push(name + ':' + data.topic);
+  };
+}
+
+var mqtt_client = mqtt.connect({
+  clientId: 'cli',
+  keepalive: 30,
+  socket: duplex,
+}, function() {
+  assert.throws(function() {
+    mqtt_client.subscribe('home/#/temp', { handler: handler('X') });
+  });
+  assert.throws(function() {
+    mqtt_client.subscribe('home/temp+', { handler: handler('X') });
+  });
+
+  filters.forEach(function(filter, i) {
+    var options = {};
+
+    if (filter != 'home/plain') {
+      options.handler = handler(String.fromCharCode(0x41 + i));
+    }
+
+    mqtt_client.subscribe(filter, options, onsuback);
+  });
+});
+
+function onsuback(error) {
+  assert.equal(error, undefined);
+
+  if (++suback_count < filters.length) {
+    return;
+  }
+
+  publish(['home/kitchen/temp', 'home', '$SYS/load', 'office',
+           'home/plain']);
+
+  process.nextTick(function() {
+    mqtt_client.unsubscribe('#', function() {
+      publish(['office', 'home/attic/temp']);
+      process.nextTick(function() {
+        duplex.end();
+      });
+    });
+  });
+}
+
+mqtt_client.on('message', function(data) {
+  messages.push(data.topic);
+});
+
+process.on('exit', function() {
+  // The order of the handlers of a single message is not specified.
+  assert.equal(calls.sort().join(), [
+    'A:home/attic/temp', 'A:home/kitchen/temp',
+    'B:home', 'B:home/attic/temp', 'B:home/kitchen/temp', 'B:home/plain',
+    'C:$SYS/load',
+    'D:home', 'D:home/kitchen/temp', 'D:home/plain', 'D:office',
+  ].join());
+
+  // The message event is emitted for every message.
+  assert.equal(messages.join(), ['home/kitchen/temp', 'home', '$SYS/load',
+                                 'office', 'home/plain', 'office',
+                                 'home/attic/temp'].join());
+});
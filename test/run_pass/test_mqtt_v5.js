@@ -0,0 +1,160 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* MQTT 5 session with a broker stand-in: CONNECT and CONNACK properties,
+ * topic aliases in both directions, the receive maximum and the maximum
+ * packet size of the broker, and reason codes of the acknowledgements. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+
+function hex(str) {
+  return new Buffer(str).toString('hex');
+}
+
+var long_topic = 'sensors/room/temperature';
+
+var expected_publishes = [
+  // The first packet sets topic alias 1.
+  '301f0018' + hex(long_topic) + '03230001' + hex('a'),
+  '3007000003230001' + hex('b'),
+  // The broker allows one alias only.
+  '30190015' + hex('sensors/room/humidity') + '00' + hex('c'),
+  '320a00000001' + '03230001' + hex('q0'),
+  '320a00000002' + '03230001' + hex('q1'),
+  // Sent when the first id is released.
+  '320a00000001' + '03230001' + hex('q2'),
+];
+
+var publishes = [];
+var results = [];
+var completed = [];
+var messages = [];
+var drain_count = 0;
+
+var duplex = new stream.Duplex();
+
+duplex._write = function(chunk, callback, onwrite) {
+  onwrite();
+
+  var type = chunk.readUInt8(0) >> 4;
+
+  if (type == 1) {
+    // CONNECT with protocol level 5, session expiry interval 60, topic
+    // alias maximum 2 and maximum packet size 1024.
+    assert.equal(chunk.toString('hex'),
+                 '101c00044d5154540502001e0d110000003c220002270000040000' +
+                 '02' + hex('v5'));
+
+    // CONNACK with receive maximum 2, topic alias maximum 1 and maximum
+    // packet size 64.
+    process.nextTick(function() {
+      duplex.push(new Buffer('200e00000b2100022200012700000040', 'hex'));
+    });
+    return;
+  }
+
+  if (type != 3) {
+    return;
+  }
+
+  publishes.push(chunk.toString('hex'));
+
+  if (publishes.length == 5) {
+    // Only two QoS 1 packets are in flight. The first one is refused with
+    // reason code 0x87 (not authorized).
+    process.nextTick(function() {
+      duplex.push(new Buffer('4003000187', 'hex'));
+    });
+  } else if (publishes.length == 6) {
+    process.nextTick(function() {
+      duplex.push(new Buffer('40020002', 'hex'));
+      duplex.push(new Buffer('40020001', 'hex'));
+
+      // The first message sets alias 1 of the client, the second one
+      // only refers to it.
+      duplex.push(new Buffer('30150006' + hex('down/x') + '0a030004' +
+                             hex('text') + '230001' + hex('p1'), 'hex'));
+      duplex.push(new Buffer('3008000003230001' + hex('p2'), 'hex'));
+    });
+  }
+};
+
+duplex._readyToWrite();
+
+var mqtt_client = mqtt.connect({
+  clientId: 'v5',
+  keepalive: 30,
+  protocolVersion: 5,
+  properties: {
+    sessionExpiryInterval: 60,
+    topicAliasMaximum: 2,
+    maximumPacketSize: 1024,
+  },
+  socket: duplex,
+}, function(properties) {
+  assert.equal(properties.receiveMaximum, 2);
+  assert.equal(properties.topicAliasMaximum, 1);
+  assert.equal(properties.maximumPacketSize, 64);
+
+  mqtt_client.publish(long_topic, 'a');
+  mqtt_client.publish(long_topic, 'b');
+  mqtt_client.publish('sensors/room/humidity', 'c');
+
+  assert.throws(function() {
+    mqtt_client.publish(long_topic, new Buffer(100));
+  }, Error);
+
+  for (var i = 0; i < 3; i++) {
+    results.push(mqtt_client.publish(long_topic, 'q' + i, { qos: 1 },
+                                     onpublished.bind(null, 'q' + i)));
+  }
+});
+
+mqtt_client.on('drain', function() {
+  drain_count++;
+});
+
+mqtt_client.on('message', function(data) {
+  assert.equal(data.topic, 'down/x');
+  assert.equal(data.properties.topicAlias, 1);
+  messages.push(data.message.toString());
+
+  if (messages.length == 1) {
+    assert.equal(data.properties.contentType, 'text');
+  } else {
+    mqtt_client.end();
+  }
+});
+
+function onpublished(message, error) {
+  if (message == 'q0') {
+    assert.equal(error.message, 'Not authorized');
+    assert.equal(error.reasonCode, 0x87);
+  } else {
+    assert.equal(error, undefined);
+  }
+
+  completed.push(message);
+}
+
+process.on('exit', function() {
+  assert.equal(publishes.join(), expected_publishes.join());
+  assert.equal(results.join(), 'true,true,false');
+  assert.equal(drain_count, 1);
+  assert.equal(completed.join(), 'q0,q1,q2');
+  assert.equal(messages.join(), 'p1,p2');
+});
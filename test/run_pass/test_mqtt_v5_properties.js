@@ -0,0 +1,96 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* String properties may be 65535 bytes long, and only user properties and
+ * subscription identifiers may be repeated in a packet. */
+
+var stream = require('stream');
+var mqtt = require('mqtt');
+var assert = require('assert');
+
+var long_string = new Buffer(65535).fill(0x61).toString();
+var connected = false;
+var rejected = false;
+var published = null;
+
+function createDuplex(connack, onpublish) {
+  var duplex = new stream.Duplex();
+
+  duplex._write = function(chunk, callback, onwrite) {
+    onwrite();
+
+    var type = chunk.readUInt8(0) >> 4;
+
+    if (type == 1) {
+      process.nextTick(function() {
+        if (onpublish) {
+          duplex.push(new Buffer(connack, 'hex'));
+          return;
+        }
+
+        assert.throws(function() {
+          duplex.push(new Buffer(connack, 'hex'));
+        }, Error);
+        rejected = true;
+        duplicate_client.end(true);
+      });
+    } else if (type == 3) {
+      onpublish(chunk);
+    }
+  };
+
+  duplex._readyToWrite();
+  return duplex;
+}
+
+// CONNACK with the same user property twice.
+var client = mqtt.connect({
+  clientId: 'v5p',
+  keepalive: 30,
+  protocolVersion: 5,
+  socket: createDuplex('201100000e260001' + '6b0001' + '61' +
+                       '260001' + '6b0001' + '62', function(chunk) {
+    published = chunk;
+  }),
+}, function() {
+  connected = true;
+
+  client.publish('t', 'x', { properties: { contentType: long_string } });
+
+  assert.throws(function() {
+    client.publish('t', 'x', {
+      properties: { contentType: long_string + 'a' },
+    });
+  }, Error);
+
+  client.end();
+});
+
+// CONNACK with the receive maximum twice.
+var duplicate_client = mqtt.connect({
+  clientId: 'v5d',
+  keepalive: 30,
+  protocolVersion: 5,
+  socket: createDuplex('2009000006210002210003', null),
+}, function() {
+  assert.fail('connected with duplicate properties');
+});
+
+process.on('exit', function() {
+  assert(connected);
+  assert(rejected);
+  assert.notEqual(published, null);
+  assert.notEqual(published.toString().indexOf(long_string), -1);
+});
@@ -0,0 +1,138 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var http = require('http');
+var net = require('net');
+
+var filePath = process.cwd() + '/resources/tobeornottobe.txt';
+var content = fs.readFileSync(filePath).toString();
+
+var netPort = 3013;
+var httpPort = 3014;
+
+// socket.sendFile() keeps its place among the other writes.
+var netBody = '';
+var offsetError = null;
+
+var netServer = net.createServer(function(socket) {
+  var fd = fs.openSync(filePath, 'r');
+
+  socket.write('head:');
+  socket.sendFile(fd, 0, content.length, function(err, bytesSent) {
+    assert.equal(err, null);
+    assert.equal(bytesSent, content.length);
+  });
+  // An offset no file can have fails without sending anything.
+  socket.sendFile(fd, 1e30, 1, function(err, bytesSent) {
+    offsetError = err;
+    assert.equal(bytesSent, 0);
+    fs.closeSync(fd);
+  });
+  socket.end(':tail');
+});
+
+netServer.listen(netPort, function() {
+  var client = net.connect(netPort, function() {
+    client.on('data', function(data) {
+      netBody += data;
+    });
+    client.on('end', function() {
+      netServer.close();
+      startHttp();
+    });
+  });
+});
+
+assert.throws(function() {
+  new net.Socket().sendFile(-1, 0, 1);
+}, TypeError);
+assert.throws(function() {
+  new net.Socket().sendFile(0, 0, 'all');
+}, TypeError);
+
+
+// res.sendFile() writes the headers and the file as the response body.
+var fd = fs.openSync(filePath, 'r');
+var missingError = null;
+
+var httpServer = http.createServer(function(req, res) {
+  if (req.url === '/whole') {
+    res.sendFile(filePath, function(err) {
+      assert.equal(err, null);
+    });
+  } else if (req.url === '/range') {
+    res.sendFile(fd, { start: 3, end: 17 }, function(err) {
+      assert.equal(err, null);
+    });
+  } else {
+    res.sendFile(filePath + '.missing', function(err) {
+      // Nothing was sent yet, a regular response can still be written.
+      missingError = err;
+      res.writeHead(404);
+      res.end();
+    });
+  }
+});
+
+assert.throws(function() {
+  http.ServerResponse.prototype.sendFile.call({}, {});
+}, TypeError);
+
+var expected = [
+  ['/whole', 200, content],
+  ['/range', 200, content.substring(3, 18)],
+  ['/missing', 404, ''],
+];
+
+var responses = 0;
+
+function sendRequest(idx) {
+  http.get({ port: httpPort, path: expected[idx][0] }, function(res) {
+    var body = '';
+    res.on('data', function(chunk) {
+      body += chunk;
+    });
+    res.on('end', function() {
+      assert.equal(res.statusCode, expected[idx][1]);
+      assert.equal(body, expected[idx][2]);
+      if (res.statusCode === 200) {
+        assert.equal(res.headers['content-length'], body.length);
+      }
+      responses++;
+
+      if (idx + 1 < expected.length) {
+        sendRequest(idx + 1);
+      } else {
+        httpServer.close();
+      }
+    });
+  });
+}
+
+function startHttp() {
+  httpServer.listen(httpPort, function() {
+    sendRequest(0);
+  });
+}
+
+process.on('exit', function() {
+  fs.closeSync(fd);
+  assert.equal(netBody, 'head:' + content + ':tail');
+  assert(offsetError instanceof Error);
+  assert.equal(responses, expected.length);
+  assert(missingError instanceof Error);
+});
@@ -0,0 +1,122 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var http = require('http');
+
+var ROUTE_COUNT = 100;
+var port = 3012;
+
+var unrouted = 0;
+var server = http.createServer(function(req, res) {
+  unrouted++;
+  res.writeHead(404);
+  res.end(req.url);
+});
+
+// A hundred literal routes, each with a named parameter.
+function makeHandler(idx) {
+  return function(req, res, params) {
+    assert.equal(req.params, params);
+    res.end('sensor' + idx + ':' + params.field);
+  };
+}
+
+for (var i = 0; i < ROUTE_COUNT; i++) {
+  server.route('GET', '/sensors/' + i + '/:field', makeHandler(i));
+}
+
+server.route('POST', '/sensors/:id/:field', function(req, res, params) {
+  res.end('post:' + params.id + ':' + params.field);
+});
+
+server.route('*', '/static/*', function(req, res, params) {
+  res.end(req.method + ':' + params['*']);
+});
+
+assert.throws(function() {
+  server.route('GET', 'no/leading/slash', function() {});
+}, TypeError);
+assert.throws(function() {
+  server.route('NOPE', '/', function() {});
+}, TypeError);
+assert.throws(function() {
+  server.route('GET', '/', null);
+}, TypeError);
+
+var expected = [
+  ['GET', '/sensors/0/temp', 200, 'sensor0:temp'],
+  ['GET', '/sensors/57/humidity?unit=pct', 200, 'sensor57:humidity'],
+  ['GET', '/sensors/99/light/', 200, 'sensor99:light'],
+  ['POST', '/sensors/12/temp', 200, 'post:12:temp'],
+  ['PUT', '/static/css/main.css', 200, 'PUT:css/main.css'],
+  ['GET', '/sensors/100/temp', 404, '/sensors/100/temp'],
+  ['GET', '/sensors/1', 404, '/sensors/1'],
+  ['GET', '/sensors/7/a%20b', 200, 'sensor7:a b'],
+  ['GET', '/sensors/7/%E0%A4%A', 400, ''],
+  ['GET', '/late/x%2Fy', 200, 'late:x/y'],
+];
+
+// Connections accepted before a route is added still see the route.
+var lateRoute = false;
+server.on('connection', function() {
+  if (!lateRoute) {
+    lateRoute = true;
+    server.route('GET', '/late/:name', function(req, res, params) {
+      res.end('late:' + params.name);
+    });
+  }
+});
+
+var responses = 0;
+
+function sendRequest(idx) {
+  var options = {
+    method: expected[idx][0],
+    port: port,
+    path: expected[idx][1],
+  };
+
+  var req = http.request(options, function(res) {
+    var body = '';
+    res.on('data', function(chunk) {
+      body += chunk;
+    });
+    res.on('end', function() {
+      assert.equal(res.statusCode, expected[idx][2]);
+      assert.equal(body, expected[idx][3]);
+      responses++;
+
+      // The late route is checked first, on the very first connection.
+      if (idx === expected.length - 1) {
+        sendRequest(0);
+      } else if (idx + 1 < expected.length - 1) {
+        sendRequest(idx + 1);
+      } else {
+        server.close();
+      }
+    });
+  });
+  req.end();
+}
+
+server.listen(port, function() {
+  sendRequest(expected.length - 1);
+});
+
+process.on('exit', function() {
+  assert.equal(responses, expected.length);
+  assert.equal(unrouted, 2);
+});
@@ -0,0 +1,74 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Requests skipping the certificate check do not share their secure
+ * context with verifying requests, so the verifying request to the same
+ * server still fails. */
+
+var assert = require('assert');
+var https = require('https');
+var fs = require('fs');
+
+var port = 8000;
+
+var server_options = {
+  key: fs.readFileSync(process.cwd() + '/resources/my_key.key').toString(),
+  cert: fs.readFileSync(process.cwd() + '/resources/my_crt.crt').toString(),
+};
+
+var server = https.createServer(server_options, function(req, res) {
+  res.writeHead(200);
+  res.end('hello world\n');
+}).listen(port, getUnverified);
+
+var unverified_body = '';
+var verified_response = false;
+var verified_error = null;
+
+function getUnverified() {
+  https.get({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: false,
+  }, function(res) {
+    assert.equal(res.statusCode, 200);
+
+    res.on('data', function(chunk) {
+      unverified_body += chunk.toString();
+    });
+    res.on('end', getVerified);
+  });
+}
+
+function getVerified() {
+  var req = https.get({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: true,
+  }, function() {
+    verified_response = true;
+  });
+
+  req.on('error', function(error) {
+    verified_error = error;
+    server.close();
+  });
+}
+
+process.on('exit', function() {
+  assert.equal(unverified_body, 'hello world\n');
+  assert.equal(verified_response, false);
+  assert(verified_error instanceof Error);
+});
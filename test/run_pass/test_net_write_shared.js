@@ -0,0 +1,99 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var net = require('net');
+
+var port = 3015;
+var clientCount = 4;
+var sockets = [];
+var received = [];
+var shared = false;
+
+var server = net.createServer(function(socket) {
+  sockets.push(socket);
+  if (sockets.length < clientCount) {
+    return;
+  }
+
+  // The first socket has a write in progress, its shared write is queued
+  // behind it. The others get the native shared write.
+  sockets[0].write('busy:');
+  net.writeShared(sockets, 'shared', function() {
+    shared = true;
+    sockets.forEach(function(socket) {
+      var expected = socket === sockets[0] ? 'busy:shared' : 'shared';
+      assert.equal(socket.bytesWritten, expected.length);
+    });
+    for (var i = 0; i < sockets.length; i++) {
+      sockets[i].end(':end');
+    }
+    server.close();
+  });
+});
+
+function connectClient(idx) {
+  received[idx] = '';
+  var client = net.connect(port, function() {
+    client.on('data', function(data) {
+      received[idx] += data;
+    });
+  });
+}
+
+server.listen(port, function() {
+  for (var i = 0; i < clientCount; i++) {
+    connectClient(i);
+  }
+});
+
+// A handle which is not connected fails to start the write, the error
+// reaches the socket.
+var Tcp = require('tcp');
+var unconnected = new net.Socket({ handle: new Tcp() });
+var writeError = null;
+unconnected._readyToWrite();
+unconnected.on('error', function(err) {
+  writeError = err;
+});
+var failedCalled = false;
+net.writeShared([unconnected], 'lost', function() {
+  failedCalled = true;
+});
+assert.equal(writeError, null);
+
+assert.throws(function() {
+  net.writeShared(null, 'data');
+}, TypeError);
+assert.throws(function() {
+  net.writeShared([], 42);
+}, TypeError);
+
+process.on('exit', function() {
+  assert(shared);
+  assert(failedCalled);
+  assert(writeError instanceof Error);
+  assert.equal(unconnected.bytesWritten, 0);
+  // Connections may be accepted in any order, one of them got the
+  // regular write first.
+  var busy = received.filter(function(data) {
+    return data === 'busy:shared:end';
+  });
+  var idle = received.filter(function(data) {
+    return data === 'shared:end';
+  });
+  assert.equal(busy.length, 1);
+  assert.equal(idle.length, clientCount - 1);
+});
@@ -0,0 +1,79 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var tls = require('tls');
+
+var port = 8080;
+
+// Chunks larger than a TLS record are split into several records
+var chunk_size = 40000;
+var chunk_count = 8;
+
+var client_received = 0;
+var client_mismatch = -1;
+
+var server_options = {
+  key: fs.readFileSync(process.cwd() + '/resources/my_key.key').toString(),
+  cert: fs.readFileSync(process.cwd() + '/resources/my_crt.crt'),
+  isServer: true,
+};
+
+function createChunk(index) {
+  var chunk = new Buffer(chunk_size);
+  for (var i = 0; i < chunk_size; i++) {
+    chunk[i] = (i + index) & 0xff;
+  }
+  return chunk;
+}
+
+var server = tls.createServer(server_options, function(socket) {
+  for (var i = 0; i < chunk_count; i++) {
+    socket.write(createChunk(i));
+  }
+  socket.end();
+}).listen(port, function() {
+  var received = 0;
+  var mismatch = 0;
+
+  var socket = tls.connect({
+    host: '127.0.0.1',
+    port: port,
+    rejectUnauthorized: false,
+  });
+
+  socket.on('data', function(data) {
+    for (var i = 0; i < data.length; i++) {
+      var offset = received + i;
+      var index = (offset / chunk_size) | 0;
+      if (data[i] !== ((offset % chunk_size + index) & 0xff)) {
+        mismatch++;
+      }
+    }
+    received += data.length;
+  });
+
+  socket.on('end', function() {
+    client_received = received;
+    client_mismatch = mismatch;
+    server.close();
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(client_received, chunk_size * chunk_count);
+  assert.equal(client_mismatch, 0);
+});
@@ -0,0 +1,78 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var tls = require('tls');
+
+var port = 8080;
+
+function readCertificate(name) {
+  return fs.readFileSync(process.cwd() + '/resources/' + name).toString();
+}
+
+function pemToDer(pem) {
+  var base64 = pem.replace(/-----[^-]+-----/g, '').replace(/\s/g, '');
+  return new Buffer(base64, 'base64');
+}
+
+// A DER bundle of two concatenated certificates
+var ca_der = pemToDer(readCertificate('my_ca.crt'));
+var bundle = Buffer.concat([pemToDer(readCertificate('my_crt.crt')), ca_der]);
+
+assert.throws(function() {
+  tls.createSecureContext({ ca: ca_der.slice(0, ca_der.length - 1) });
+});
+
+assert.throws(function() {
+  tls.createSecureContext({ ca: Buffer.concat([ca_der, new Buffer([0x30])]) });
+});
+
+var options = {
+  key: readCertificate('my_key.key'),
+  cert: readCertificate('my_crt.crt'),
+};
+
+var messages = [];
+
+var server = tls.createServer(options, function(socket) {
+  socket.end('Server hello');
+}).listen(port, function() {
+  connect(function() {
+    // A second context with the same bundle shares its trust store
+    connect(function() {
+      server.close();
+    });
+  });
+});
+
+function connect(callback) {
+  var socket = tls.connect({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: true,
+    ca: bundle,
+  });
+
+  socket.on('data', function(data) {
+    messages.push(data.toString());
+  });
+
+  socket.on('end', callback);
+}
+
+process.on('exit', function() {
+  assert.equal(messages.join(), 'Server hello,Server hello');
+});
@@ -0,0 +1,94 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var tls = require('tls');
+
+var port = 8080;
+var connections = 4;
+
+var server_options = {
+  key: fs.readFileSync(process.cwd() + '/resources/my_key.key').toString(),
+  cert: fs.readFileSync(process.cwd() + '/resources/my_crt.crt'),
+  isServer: true,
+};
+
+var ca = fs.readFileSync(process.cwd() + '/resources/my_ca.crt');
+
+var server_reused = [];
+var client_reused = [];
+
+var server = tls.createServer(server_options, function(socket) {
+  server_reused.push(socket.isSessionReused());
+  socket.end('done');
+}).listen(port, function() {
+  connectNext();
+});
+
+// Only the sessions of verified servers are resumed
+var client_context = tls.createSecureContext({ ca: ca });
+
+var unshared_reused;
+
+function connectNext() {
+  if (client_reused.length === connections) {
+    connectUnshared();
+    return;
+  }
+
+  var socket = tls.connect({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: true,
+    secureContext: client_context,
+  }, function() {
+    client_reused.push(socket.isSessionReused());
+  });
+
+  socket.on('data', function() {});
+  socket.on('end', connectNext);
+}
+
+// A connection with its own context always does a full handshake
+function connectUnshared() {
+  var socket = tls.connect({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: true,
+    ca: ca,
+  }, function() {
+    unshared_reused = socket.isSessionReused();
+  });
+
+  socket.on('data', function() {});
+  socket.on('end', function() {
+    server.close();
+  });
+}
+
+process.on('exit', function() {
+  assert.equal(client_reused.length, connections);
+  assert.equal(client_reused[0], false);
+  assert.equal(server_reused[0], false);
+
+  for (var i = 1; i < connections; i++) {
+    assert.equal(client_reused[i], true);
+    assert.equal(server_reused[i], true);
+  }
+
+  assert.equal(unshared_reused, false);
+  assert.equal(server_reused[connections], false);
+});
@@ -0,0 +1,76 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* A session of an unverified connection is not offered to a later
+ * connection which verifies the server, that one must fail. */
+
+var assert = require('assert');
+var fs = require('fs');
+var tls = require('tls');
+
+var port = 8080;
+
+var server_options = {
+  key: fs.readFileSync(process.cwd() + '/resources/my_key.key').toString(),
+  cert: fs.readFileSync(process.cwd() + '/resources/my_crt.crt'),
+  isServer: true,
+};
+
+var server = tls.createServer(server_options, function(socket) {
+  socket.end('done');
+}).listen(port, connectUnverified);
+
+// The default certificate authorities do not trust the test server
+var client_context = tls.createSecureContext({});
+
+var unverified_authorized;
+var verified_connected = false;
+var verified_error = null;
+
+function connectUnverified() {
+  var socket = tls.connect({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: false,
+    secureContext: client_context,
+  }, function() {
+    unverified_authorized = socket.authorized;
+  });
+
+  socket.on('data', function() {});
+  socket.on('end', connectVerified);
+}
+
+function connectVerified() {
+  var socket = tls.connect({
+    host: 'localhost',
+    port: port,
+    rejectUnauthorized: true,
+    secureContext: client_context,
+  }, function() {
+    verified_connected = true;
+  });
+
+  socket.on('error', function(error) {
+    verified_error = error;
+    server.close();
+  });
+}
+
+process.on('exit', function() {
+  assert.equal(unverified_authorized, false);
+  assert.equal(verified_connected, false);
+  assert(verified_error instanceof Error);
+});
@@ -0,0 +1,89 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var tls = require('tls');
+
+var port = 8080;
+
+// The server and all clients share one context
+var context = tls.createSecureContext({
+  key: fs.readFileSync(process.cwd() + '/resources/my_key.key').toString(),
+  cert: fs.readFileSync(process.cwd() + '/resources/my_crt.crt'),
+});
+
+var server_messages = [];
+var client_messages = [];
+var client_errors = 0;
+var pending = 3;
+
+var server = tls.createServer({
+  secureContext: context,
+}, function(socket) {
+  socket.on('data', function(data) {
+    server_messages.push(data.toString());
+    socket.end('pong');
+  });
+}).listen(port, function() {
+  connect('a', false);
+  connect('b', false);
+  // The certificate of the server is self-signed, so a client which
+  // verifies it cannot connect.
+  connect('c', true);
+});
+
+function done() {
+  if (--pending === 0) {
+    server.close();
+  }
+}
+
+function connect(name, rejectUnauthorized) {
+  var finished = false;
+
+  function finish() {
+    if (!finished) {
+      finished = true;
+      done();
+    }
+  }
+
+  var socket = tls.connect({
+    host: '127.0.0.1',
+    port: port,
+    rejectUnauthorized: rejectUnauthorized,
+    secureContext: context,
+  }, function() {
+    socket.write(name);
+  });
+
+  socket.on('data', function(data) {
+    client_messages.push(name + ':' + data.toString());
+  });
+
+  socket.on('error', function() {
+    client_errors++;
+    finish();
+  });
+
+  socket.on('end', finish);
+}
+
+process.on('exit', function() {
+  assert.equal(server_messages.sort().join(), 'a,b');
+  assert.equal(client_messages.sort().join(), 'a:pong,b:pong');
+  assert.equal(client_errors, 1);
+});
@@ -0,0 +1,87 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var websocket = require('websocket');
+var assert = require('assert');
+var net = require('net');
+
+var port = 8084;
+var clientCount = 3;
+var connections = 0;
+var messages = [];
+var raw = new Buffer(0);
+
+var wss = new websocket.Server({port: port}, function(ws) {
+  if (++connections < clientCount + 1) {
+    return;
+  }
+
+  var frame = wss.prepareFrame('prepared');
+  wss.broadcast(frame);
+  wss.broadcast('plain', {binary: false});
+
+  setTimeout(function() {
+    wss.close();
+  }, 200);
+});
+
+function connectClient(idx) {
+  var client = new websocket.Websocket();
+  messages[idx] = [];
+  client.connect('ws://localhost', port, '/', function() {
+    this.on('message', function(msg) {
+      messages[idx].push(msg.toString());
+    });
+  });
+}
+
+for (var i = 0; i < clientCount; i++) {
+  connectClient(i);
+}
+
+// Inspect the frames seen on the wire by a plain TCP client.
+var socket = net.connect(port, 'localhost', function() {
+  socket.write('GET / HTTP/1.1\r\n' +
+               'Host: localhost\r\n' +
+               'Upgrade: websocket\r\n' +
+               'Connection: Upgrade\r\n' +
+               'Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n' +
+               'Sec-WebSocket-Version: 13\r\n\r\n');
+});
+
+socket.on('data', function(data) {
+  raw = Buffer.concat([raw, data]);
+});
+
+socket.on('error', function() {});
+
+process.on('exit', function() {
+  assert.equal(connections, clientCount + 1);
+
+  for (var i = 0; i < clientCount; i++) {
+    assert.deepEqual(messages[i], ['prepared', 'plain']);
+  }
+
+  var str = raw.toString();
+  var offset = str.indexOf('\r\n\r\n') + 4;
+  assert(offset > 4);
+
+  // Server frames are unmasked: FIN + text opcode, length without mask bit.
+  assert.equal(raw[offset], 0x81);
+  assert.equal(raw[offset + 1], 'prepared'.length);
+  assert.equal(raw.slice(offset + 2, offset + 10).toString(), 'prepared');
+  assert.equal(raw[offset + 10], 0x81);
+  assert.equal(raw[offset + 11], 'plain'.length);
+});
@@ -0,0 +1,108 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var websocket = require('websocket');
+var assert = require('assert');
+
+var port = 8085;
+var count = 20;
+var serverReceived = [];
+var clientReceived = [];
+var plainReceived = [];
+var serverExtensions = null;
+
+function telemetry(i) {
+  return JSON.stringify({
+    device: 'sensor-' + (i % 3),
+    temperature: 20 + i,
+    humidity: 40 + i,
+    status: 'ok',
+  });
+}
+
+var large = '';
+for (var i = 0; i < 2000; i++) {
+  large += 'sample ' + (i % 100) + ';';
+}
+
+var wss = new websocket.Server({
+  port: port,
+  perMessageDeflate: {serverMaxWindowBits: 10},
+}, function(ws) {
+  if (!ws.extensions) {
+    // Client without compression.
+    return;
+  }
+  serverExtensions = ws.extensions;
+  ws.on('message', function(msg) {
+    serverReceived.push(msg.toString());
+    // Echo the message compressed.
+    ws.send(msg, {compress: true});
+  });
+});
+
+var client = new websocket.Websocket({perMessageDeflate: true});
+client.connect('ws://localhost', port, '/', function() {
+  assert.notEqual(this.extensions.indexOf('permessage-deflate'), -1);
+  assert.notEqual(this.extensions.indexOf('server_max_window_bits=10'), -1);
+
+  var idx = 0;
+  this.on('message', function(msg) {
+    clientReceived.push(msg.toString());
+    if (++idx < count) {
+      client.send(telemetry(idx), {mask: true, compress: true});
+    } else if (idx === count) {
+      client.send(large, {mask: true, compress: true});
+    } else if (idx === count + 1) {
+      connectPlain();
+    }
+  });
+
+  this.send(telemetry(idx), {mask: true, compress: true});
+});
+
+// A client which does not offer compression receives plain frames.
+function connectPlain() {
+  var plain = new websocket.Websocket();
+  plain.connect('ws://localhost', port, '/', function() {
+    assert.equal(this.extensions, '');
+
+    this.on('message', function(msg) {
+      plainReceived.push(msg.toString());
+      if (plainReceived.length === 2) {
+        wss.close();
+      }
+    });
+
+    var frame = wss.prepareFrame('broadcast', {compress: true});
+    wss.broadcast(frame);
+    wss.broadcast('broadcast', {compress: true});
+  });
+}
+
+process.on('exit', function() {
+  var expected = [];
+  for (var i = 0; i < count; i++) {
+    expected.push(telemetry(i));
+  }
+  expected.push(large);
+
+  assert.equal(serverExtensions.indexOf('permessage-deflate'), 0);
+  assert.deepEqual(serverReceived, expected);
+  assert.deepEqual(clientReceived.slice(0, count + 1), expected);
+  assert.deepEqual(clientReceived.slice(count + 1),
+                   ['broadcast', 'broadcast']);
+  assert.deepEqual(plainReceived, ['broadcast', 'broadcast']);
+});
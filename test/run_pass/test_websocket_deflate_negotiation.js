@@ -0,0 +1,85 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var assert = require('assert');
+var crypto = require('crypto');
+var net = require('net');
+var websocket = require('websocket');
+
+var port = 8087;
+
+// The client offers serverMaxWindowBits 10 and server_no_context_takeover,
+// the response may only tighten them (RFC 7692 7.1).
+var responses = [
+  // A larger server window than offered.
+  'permessage-deflate; server_max_window_bits=12; server_no_context_takeover',
+  // The requested server_no_context_takeover is missing.
+  'permessage-deflate; server_max_window_bits=10',
+  // client_max_window_bits without a value.
+  'permessage-deflate; server_max_window_bits=10; ' +
+    'server_no_context_takeover; client_max_window_bits',
+  // Valid, both windows are smaller.
+  'permessage-deflate; server_max_window_bits=9; ' +
+    'server_no_context_takeover; client_max_window_bits=12',
+];
+
+var results = [];
+
+var server = net.createServer(function(socket) {
+  var response = responses[results.length];
+  socket.on('data', function(data) {
+    var key = /Sec-WebSocket-Key: (\S+)/.exec(data.toString())[1];
+    var accept = crypto.createHash('sha1')
+      .update(key + '258EAFA5-E914-47DA-95CA-C5AB0DC85B11')
+      .digest('base64');
+    socket.write('HTTP/1.1 101 Switching Protocols\r\n' +
+                 'Upgrade: websocket\r\n' +
+                 'Connection: Upgrade\r\n' +
+                 'Sec-WebSocket-Accept: ' + accept + '\r\n' +
+                 'Sec-WebSocket-Extensions: ' + response + '\r\n\r\n');
+  });
+  socket.on('error', function() {});
+});
+
+function connect() {
+  var client = new websocket.Websocket({
+    perMessageDeflate: { serverMaxWindowBits: 10,
+                         serverNoContextTakeover: true },
+  });
+  var done = function(result) {
+    results.push(result);
+    client._socket.destroy();
+    if (results.length < responses.length) {
+      connect();
+    } else {
+      server.close();
+    }
+  };
+
+  client.on('error', function(err) {
+    assert.equal(err.message, 'WebSocket extension negotiation failed');
+    done('error');
+  });
+  client.connect('ws://localhost', port, '/', function() {
+    assert.notEqual(this.extensions.indexOf('server_max_window_bits=9'), -1);
+    done('open');
+  });
+}
+
+server.listen(port, connect);
+
+process.on('exit', function() {
+  assert.deepEqual(results, ['error', 'error', 'error', 'open']);
+});
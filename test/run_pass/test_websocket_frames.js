@@ -0,0 +1,126 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var websocket = require('websocket');
+var assert = require('assert');
+var net = require('net');
+
+var port = 8083;
+var sizes = [1024, 64 * 1024, 1024 * 1024];
+var received = [];
+var fragmented = null;
+
+function makePayload(size) {
+  var pattern = new Buffer(1024);
+  for (var i = 0; i < pattern.length; i++) {
+    pattern[i] = (i * 7) & 0xff;
+  }
+
+  var chunks = [];
+  for (var offset = 0; offset < size; offset += pattern.length) {
+    chunks.push(pattern);
+  }
+  return Buffer.concat(chunks).slice(0, size);
+}
+
+function checkPayload(msg, size) {
+  assert.equal(msg.length, size);
+  for (var i = 0; i < size; i += 997) {
+    assert.equal(msg[i], ((i % 1024) * 7) & 0xff);
+  }
+}
+
+var wss = new websocket.Server({port: port}, function(ws) {
+  ws.on('message', function(msg) {
+    if (msg.length < 64) {
+      // Message reassembled from fragments by the raw client.
+      fragmented = msg.toString();
+      return;
+    }
+    // Echo large messages unmasked.
+    ws.send(msg, {binary: true});
+  });
+});
+
+// Large masked messages are received in many TCP reads.
+var client = new websocket.Websocket();
+client.connect('ws://localhost', port, '/', function() {
+  var idx = 0;
+
+  this.on('message', function(msg) {
+    checkPayload(msg, sizes[idx]);
+    received.push(sizes[idx]);
+
+    if (++idx < sizes.length) {
+      client.send(makePayload(sizes[idx]), {mask: true, binary: true});
+    } else {
+      sendFragments();
+    }
+  });
+
+  this.send(makePayload(sizes[idx]), {mask: true, binary: true});
+});
+
+function maskedFrame(firstByte, text) {
+  var payload = new Buffer(text);
+  var key = [0x12, 0x34, 0x56, 0x78];
+  var frame = new Buffer(6 + payload.length);
+  frame[0] = firstByte;
+  frame[1] = 0x80 | payload.length;
+  for (var i = 0; i < 4; i++) {
+    frame[2 + i] = key[i];
+  }
+  for (var j = 0; j < payload.length; j++) {
+    frame[6 + j] = payload[j] ^ key[j % 4];
+  }
+  return frame;
+}
+
+// A fragmented text message written in small pieces.
+function sendFragments() {
+  var socket = net.connect(port, 'localhost', function() {
+    socket.write('GET / HTTP/1.1\r\n' +
+                 'Host: localhost\r\n' +
+                 'Upgrade: websocket\r\n' +
+                 'Connection: Upgrade\r\n' +
+                 'Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n' +
+                 'Sec-WebSocket-Version: 13\r\n\r\n');
+  });
+
+  socket.once('data', function() {
+    var frames = Buffer.concat([maskedFrame(0x01, 'Hello '),
+                                maskedFrame(0x80, 'IoT.js')]);
+    var pieces = [frames.slice(0, 1), frames.slice(1, 9),
+                  frames.slice(9, 15), frames.slice(15)];
+
+    (function writePiece(i) {
+      if (i === pieces.length) {
+        setTimeout(function() {
+          wss.close();
+        }, 100);
+        return;
+      }
+      socket.write(pieces[i]);
+      setTimeout(function() {
+        writePiece(i + 1);
+      }, 10);
+    })(0);
+  });
+}
+
+process.on('exit', function() {
+  assert.deepEqual(received, sizes);
+  assert.equal(fragmented, 'Hello IoT.js');
+});
@@ -0,0 +1,120 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+var websocket = require('websocket');
+var assert = require('assert');
+var net = require('net');
+
+var port = 8086;
+var closeCodes = [];
+var clientClose = null;
+
+var wss = new websocket.Server({port: port, maxPayload: 1024}, function(ws) {
+  ws.on('message', function(msg) {
+    // Only the small message of the websocket client is accepted, the
+    // server answers it with a message above the client's limit.
+    assert.equal(msg.toString(), 'small');
+    ws.send(new Buffer(100), {binary: true});
+  });
+});
+
+function handshake(socket) {
+  socket.write('GET / HTTP/1.1\r\n' +
+               'Host: localhost\r\n' +
+               'Upgrade: websocket\r\n' +
+               'Connection: Upgrade\r\n' +
+               'Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n' +
+               'Sec-WebSocket-Version: 13\r\n\r\n');
+}
+
+function maskedHeader(firstByte, length) {
+  // The mask key is left zero, the payload never follows.
+  var header = new Buffer(14);
+  header.fill(0);
+  header[0] = firstByte;
+  header[1] = 0x80 | 127;
+  for (var i = 0; i < 8; i++) {
+    header[9 - i] = (length / Math.pow(2, i * 8)) & 0xff;
+  }
+  return header;
+}
+
+function maskedFrame(firstByte, size) {
+  var frame = new Buffer(6 + size);
+  frame.fill(0);
+  frame[0] = firstByte;
+  frame[1] = 0x80 | 126;
+  frame[2] = size >> 8;
+  frame[3] = size & 0xff;
+  return frame;
+}
+
+// Returns the status code of the close frame following the handshake.
+function closeCode(data) {
+  for (var i = 0; i + 3 < data.length; i++) {
+    if (data[i] === 13 && data[i + 1] === 10 &&
+        data[i + 2] === 13 && data[i + 3] === 10) {
+      var frame = data.slice(i + 4);
+      assert.equal(frame[0], 0x88);
+      return frame[2] << 8 | frame[3];
+    }
+  }
+  return -1;
+}
+
+// Sends `frames` after the handshake and expects the server to close
+// the connection instead of allocating the announced payload.
+function rawClient(frames, next) {
+  var received = [];
+  var socket = net.connect(port, 'localhost', function() {
+    handshake(socket);
+  });
+
+  socket.once('data', function() {
+    socket.write(Buffer.concat(frames));
+  });
+  socket.on('data', function(data) {
+    received.push(data);
+  });
+  socket.on('end', function() {
+    closeCodes.push(closeCode(Buffer.concat(received)));
+    next();
+  });
+}
+
+// A single frame announcing almost 2 GiB.
+rawClient([maskedHeader(0x82, 0x7fffffff)], function() {
+  // Fragments which are only too large together.
+  rawClient([maskedFrame(0x02, 600), maskedFrame(0x80, 600)], function() {
+    // Control frames are limited to 125 bytes.
+    rawClient([maskedFrame(0x89, 200)], testClient);
+  });
+});
+
+function testClient() {
+  var client = new websocket.Websocket({maxPayload: 16});
+  client.connect('ws://localhost', port, '/', function() {
+    client.send('small', {mask: true});
+  });
+  client.on('close', function(msg) {
+    clientClose = msg;
+    wss.close();
+  });
+}
+
+process.on('exit', function() {
+  assert.deepEqual(closeCodes, [1009, 1009, 1002]);
+  assert.equal(clientClose.code, 1009);
+});
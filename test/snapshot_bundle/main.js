@@ -0,0 +1,30 @@
+/* Copyright 2018-present Samsung Electronics Co., Ltd. and other contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Run by tools/build.py with IOTJS_SNAPSHOT_BUNDLE set. The sources of the
+// lib directory are removed once the bundle is created, so the modules can
+// only be loaded from the bundle.
+var assert = require('assert');
+var fs = require('fs');
+
+var greeting = require('./lib/greeting');
+
+assert(!fs.existsSync(greeting.filename));
+assert.equal(greeting.filename.slice(-16), '/lib/greeting.js');
+assert.equal(greeting.greet('snapshot'), 'Hello snapshot!');
+
+// Modules of the bundle are cached like the ones loaded from source.
+assert.equal(require('./lib/greeting.js'), greeting);
+assert.equal(require('./lib/words').hello, 'Hello');
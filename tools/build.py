@@ -26,6 +26,7 @@ import json
 import sys
 import re
 import os
+import subprocess
 
 from common_py import path
 from common_py.system.filesystem import FileSystem as fs
@@ -417,6 +418,39 @@ def run_checktest(options):
         if code != 0:
             ex.fail('Failed to pass unit tests in valgrind environment')
 
+    if not options.no_snapshot:
+        run_snapshot_bundle_test(options)
+
+
+def run_snapshot_bundle_test(options):
+    # Precompile test/snapshot_bundle with the snapshot tool of this build,
+    # then run it with the sources of its modules removed.
+    print_progress('Run snapshot bundle test')
+
+    iotjs = fs.join(options.build_root, 'bin', 'iotjs')
+    snapshot_tool = fs.join(options.build_root, 'deps', 'jerry-host', 'bin',
+                            'jerry-snapshot')
+    app_dir = fs.join(options.build_root, 'snapshot_bundle')
+    bundle = fs.join(app_dir, 'app.snapshot')
+
+    fs.rmtree(app_dir)
+    fs.copytree(fs.join(path.TEST_ROOT, 'snapshot_bundle'), app_dir)
+
+    ex.check_run_cmd('python', [fs.join(path.TOOLS_ROOT, 'js2c.py'),
+                                '--app', app_dir,
+                                '--output', bundle,
+                                '--snapshot-tool', snapshot_tool])
+
+    fs.remove(fs.join(app_dir, 'lib', 'greeting.js'))
+    fs.remove(fs.join(app_dir, 'lib', 'words.js'))
+
+    env = dict(os.environ)
+    env['IOTJS_SNAPSHOT_BUNDLE'] = bundle
+    ex.print_cmd_line(iotjs, [fs.join(app_dir, 'main.js')])
+    code = subprocess.call([iotjs, fs.join(app_dir, 'main.js')], env=env)
+    if code != 0:
+        ex.fail('Failed to run the snapshot bundle test')
+
 
 if __name__ == '__main__':
     # Initialize build option object.
@@ -18,6 +18,8 @@
 # And this file also generates magic string list in src/iotjs_string_ext.inl.h
 # file to reduce JerryScript heap usage.
 
+import codecs
+import json
 import os
 import re
 import subprocess
@@ -162,8 +164,9 @@ def format_code(code, indent):
     return "\n".join(lines)
 
 
-def merge_snapshots(snapshot_infos, snapshot_tool):
-    output_path = fs.join(path.SRC_ROOT, 'js','merged.modules')
+def merge_snapshots(snapshot_infos, snapshot_tool, output_path=None):
+    if output_path is None:
+        output_path = fs.join(path.SRC_ROOT, 'js','merged.modules')
     cmd = [snapshot_tool, "merge", "-o", output_path]
     cmd.extend([item['path'] for item in snapshot_infos])
 
@@ -184,21 +187,23 @@ def merge_snapshots(snapshot_infos, snapshot_tool):
     return code
 
 
-def get_snapshot_contents(js_path, snapshot_tool, literals=None):
+def get_snapshot_contents(js_path, snapshot_tool, literals=None, wrap=None):
     """ Convert the given module with the snapshot generator
         and return the resulting bytes.
     """
     wrapped_path = js_path + ".wrapped"
     snapshot_path = js_path + ".snapshot"
     module_name = os.path.splitext(os.path.basename(js_path))[0]
+    if wrap is None:
+        wrap = (module_name != "iotjs")
 
     with open(wrapped_path, 'w') as fwrapped, open(js_path, "r") as fmodule:
-        if module_name != "iotjs":
+        if wrap:
             fwrapped.write("(function(exports, require, module, native) {\n")
 
         fwrapped.write(fmodule.read())
 
-        if module_name != "iotjs":
+        if wrap:
             fwrapped.write("});\n")
     cmd = [snapshot_tool, "generate", "-o", snapshot_path]
     if literals:
@@ -391,6 +396,80 @@ def js2c(options, js_modules):
         fout_magic_str.write(EMPTY_LINE)
 
 
+APP_BUNDLE_MAGIC = b'IJSB'
+APP_BUNDLE_VERSION = 1
+
+
+def read_magic_strings(magic_str_path):
+    """ Read the external magic strings the engine was built with. """
+    magic_def_regex = re.compile(r'MAGICSTR_EX_DEF\(MAGIC_STR_\d+, "(.*)"\)')
+    magic_strings = set()
+    with open(magic_str_path, 'r') as fin:
+        for line in fin:
+            result = magic_def_regex.search(line)
+            if result:
+                text = result.group(1).replace('\\"', '"')
+                text = text.encode('latin-1', 'backslashreplace')
+                magic_strings.add(codecs.decode(text, 'unicode_escape'))
+
+    return magic_strings
+
+
+def js2c_app(options):
+    """ Precompile the JS files of an application directory into a snapshot
+        bundle which is loaded through IOTJS_SNAPSHOT_BUNDLE.
+    """
+    snapshot_tool = options.snapshot_tool
+    verbose = options.verbose
+    app_dir = os.path.abspath(options.app)
+    output = os.path.abspath(options.output or fs.join(app_dir,
+                                                       'app.snapshot'))
+
+    js_files = []
+    for root, dirs, files in os.walk(app_dir):
+        dirs.sort()
+        js_files.extend(fs.join(root, name) for name in sorted(files)
+                        if name.endswith('.js'))
+
+    if not js_files:
+        print("No JS files found in '%s'" % app_dir)
+        exit(1)
+
+    # Static snapshots may only refer to the literals the engine was built
+    # with, modules using others fall back to a regular snapshot.
+    literals_path = output + '.literals'
+    write_literals_to_file(read_magic_strings(options.magic_strings),
+                           literals_path)
+
+    snapshot_infos = []
+    module_names = []
+    for idx, js_path in enumerate(js_files):
+        name = os.path.relpath(js_path, app_dir).replace(os.sep, '/')
+        module_names.append(name)
+        if verbose:
+            print('Processing module: %s' % name)
+
+        code_path = get_snapshot_contents(js_path, snapshot_tool, wrap=True)
+        get_snapshot_contents(js_path, snapshot_tool, literals_path, wrap=True)
+        snapshot_infos.append({'name': name, 'path': code_path, 'idx': idx})
+    fs.remove(literals_path)
+
+    code = merge_snapshots(snapshot_infos, snapshot_tool, output + '.merged')
+
+    # The snapshot follows the index, keep it aligned to 4 bytes.
+    index = json.dumps({'modules': module_names}).encode('utf-8')
+    index += b' ' * (-len(index) % 4)
+
+    with open(output, 'wb') as fout:
+        fout.write(APP_BUNDLE_MAGIC)
+        fout.write(struct.pack('<II', APP_BUNDLE_VERSION, len(index)))
+        fout.write(index)
+        fout.write(code)
+
+    print('Created snapshot bundle of %d modules: %s'
+          % (len(module_names), output))
+
+
 if __name__ == "__main__":
     import argparse
     parser = argparse.ArgumentParser()
@@ -398,9 +477,20 @@ if __name__ == "__main__":
     parser.add_argument('--buildtype',
         choices=['debug', 'release'], default='debug',
         help='Specify the build type: %(choices)s (default: %(default)s)')
-    parser.add_argument('--modules', required=True,
+    parser.add_argument('--modules',
         help='List of JS files to process. Format: '
              '<module_name1>=<js_file1>,<module_name2>=<js_file2>,...')
+    parser.add_argument('--app', default=None,
+        help='Application directory to precompile into a snapshot bundle '
+             'instead of generating the builtin modules. '
+             'Requires --snapshot-tool.')
+    parser.add_argument('--output', default=None,
+        help='Output file of --app (default: <app>/app.snapshot)')
+    parser.add_argument('--magic-strings',
+        default=fs.join(path.SRC_ROOT, 'iotjs_string_ext.inl.h'),
+        help='The iotjs_string_ext.inl.h of the target IoT.js build, used '
+             'to create static snapshots with --app '
+             '(default: %(default)s)')
     parser.add_argument('--snapshot-tool', default=None,
         help='Executable to use for generating snapshots and merging them '
              '(ex.: the JerryScript snapshot tool). '
@@ -410,6 +500,15 @@ if __name__ == "__main__":
 
     options = parser.parse_args()
 
+    if options.app:
+        if not options.snapshot_tool:
+            parser.error('--app requires --snapshot-tool')
+        js2c_app(options)
+        exit(0)
+
+    if not options.modules:
+        parser.error('--modules is required')
+
     if not options.snapshot_tool:
         print('Converting JS modules to C arrays (no snapshot)')
     else: